@@ -89,6 +89,11 @@ namespace BuildXL.ProcessPipExecutor
         /// </summary>
         public const int OutputChunkInLines = 10000;
 
+        /// <summary>
+        /// Directory, under the engine cache directory, where the Linux sandbox keeps per-pip state from one run to the next
+        /// </summary>
+        private const string LinuxSandboxPipStateDirectory = "LinuxSandbox";
+
         private static readonly ConcurrentDictionary<ExpandedRegexDescriptor, Lazy<Task<Regex>>> s_regexTasks = new();
 
         /// <summary>
@@ -337,6 +342,18 @@ namespace BuildXL.ProcessPipExecutor
                     EnableLinuxSandboxLogging = m_verboseProcessLoggingEnabled,
                     AlwaysRemoteInjectDetoursFrom32BitProcess = m_sandboxConfig.AlwaysRemoteInjectDetoursFrom32BitProcess,
                     UnconditionallyEnableLinuxPTraceSandbox = m_sandboxConfig.UnconditionallyEnableLinuxPTraceSandbox,
+                    LinuxSandboxReportChannelCount = (uint)Math.Max(1, m_sandboxConfig.LinuxSandboxReportChannelCount),
+                    EnableLinuxSandboxReportTimestamps = m_sandboxConfig.EnableLinuxSandboxReportTimestamps,
+                    EnableLinuxSandboxReportLogs = m_sandboxConfig.EnableLinuxSandboxReportLogs,
+                    EnableLinuxSandboxObserveOnly = m_sandboxConfig.EnableLinuxSandboxObserveOnly,
+                    EnableLinuxSandboxAccessSummary = m_sandboxConfig.EnableLinuxSandboxAccessSummary,
+                    LinuxSandboxUnmonitoredExecutables = m_sandboxConfig.LinuxSandboxUnmonitoredExecutables,
+                    LinuxSandboxInputPrefetchList = m_sandboxConfig.EnableLinuxSandboxInputPrefetch
+                        ? GetLinuxSandboxPipStateFile(configuration, pip, m_pathTable, "InputPrefetch")
+                        : null,
+                    LinuxSandboxResolutionSnapshot = m_sandboxConfig.EnableLinuxSandboxResolutionSnapshot
+                        ? GetLinuxSandboxPipStateFile(configuration, pip, m_pathTable, "ResolutionSnapshot")
+                        : null,
                     IgnoreDeviceIoControlGetReparsePoint = m_sandboxConfig.IgnoreDeviceIoControlGetReparsePoint,
                 };
 
@@ -526,6 +543,31 @@ namespace BuildXL.ProcessPipExecutor
         private static bool EnableFullReparsePointResolving(IConfiguration configuration, Process process) =>
             configuration.EnableFullReparsePointResolving() && !process.DisableFullReparsePointResolving;
 
+        /// <summary>
+        /// A file the Linux sandbox keeps for the given pip from one run to the next (e.g., what the pip read), under the engine cache directory.
+        /// Files are named after the semistable hash of the pip, so pips without one don't get any. Returns null if the pip doesn't get a file.
+        /// </summary>
+        private static string GetLinuxSandboxPipStateFile(IConfiguration configuration, Process pip, PathTable pathTable, string kind)
+        {
+            if (!OperatingSystemHelper.IsLinuxOS || pip.SemiStableHash == 0 || configuration.Layout == null || !configuration.Layout.EngineCacheDirectory.IsValid)
+            {
+                return null;
+            }
+
+            string directory = Path.Combine(configuration.Layout.EngineCacheDirectory.ToString(pathTable), LinuxSandboxPipStateDirectory, kind);
+            try
+            {
+                FileUtilities.CreateDirectory(directory);
+            }
+            catch (BuildXLException)
+            {
+                // The state only makes the pip faster: the pip runs without it
+                return null;
+            }
+
+            return Path.Combine(directory, pip.FormattedSemiStableHash);
+        }
+
         private string GetDetoursInternalErrorFilePath()
         {
             string tempDir = null;
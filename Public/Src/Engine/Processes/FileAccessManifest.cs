@@ -107,6 +107,14 @@ namespace BuildXL.Processes
             AlwaysRemoteInjectDetoursFrom32BitProcess = false;
             UnconditionallyEnableLinuxPTraceSandbox = false;
             IgnoreDeviceIoControlGetReparsePoint = true; // TODO: Change this when customers onboard the feature.
+            EnableLinuxSandboxReportTimestamps = false;
+            EnableLinuxSandboxReportLogs = false;
+            EnableLinuxSandboxObserveOnly = false;
+            EnableLinuxSandboxAccessSummary = false;
+            LinuxSandboxReportChannelCount = 1;
+            LinuxSandboxUnmonitoredExecutables = Array.Empty<string>();
+            LinuxSandboxInputPrefetchList = null;
+            LinuxSandboxResolutionSnapshot = null;
         }
 
         private bool GetFlag(FileAccessManifestFlag flag) => (m_fileAccessManifestFlag & flag) != 0;
@@ -541,6 +549,93 @@ namespace BuildXL.Processes
             set => SetExtraFlag(FileAccessManifestExtraFlag.IgnoreDeviceIoControlGetReparsePoint, value);
         }
 
+        /// <summary>
+        /// When enabled, every report sent by the Linux sandbox carries the time at which the access was observed and a per-process sequence number
+        /// </summary>
+        /// <remarks>
+        /// Diagnostics mode, used to measure the lag between an access and its report.
+        /// </remarks>
+        public bool EnableLinuxSandboxReportTimestamps
+        {
+            get => GetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxReportTimestamps);
+            set => SetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxReportTimestamps, value);
+        }
+
+        /// <summary>
+        /// When enabled, processes under the Linux sandbox append their file access reports to a per-process log instead of writing them to the reports FIFO
+        /// </summary>
+        /// <remarks>
+        /// Process start and exit reports still go over the FIFO. The logs are merged into the report stream once the process tree is done.
+        /// </remarks>
+        public bool EnableLinuxSandboxReportLogs
+        {
+            get => GetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxReportLogs);
+            set => SetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxReportLogs, value);
+        }
+
+        /// <summary>
+        /// When enabled, the Linux sandbox doesn't evaluate the policy for read-only accesses: it sends what it observed and the policy is evaluated out of process
+        /// </summary>
+        /// <remarks>
+        /// Ignored by the sandbox when <see cref="FailUnexpectedFileAccesses"/> is set, since an access can't be blocked after the fact.
+        /// </remarks>
+        public bool EnableLinuxSandboxObserveOnly
+        {
+            get => GetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxObserveOnly);
+            set => SetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxObserveOnly, value);
+        }
+
+        /// <summary>
+        /// When enabled, the Linux sandbox collapses the allowed read-only accesses a process makes to a path into a single report,
+        /// sent when the process execs or exits
+        /// </summary>
+        /// <remarks>
+        /// A process that dies before it can send its summarized accesses (e.g., it is killed) makes the sandboxed process report a sandbox failure.
+        /// </remarks>
+        public bool EnableLinuxSandboxAccessSummary
+        {
+            get => GetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxAccessSummary);
+            set => SetExtraFlag(FileAccessManifestExtraFlag.EnableLinuxSandboxAccessSummary, value);
+        }
+
+        /// <summary>
+        /// Number of FIFOs the Linux sandbox reports accesses on.
+        /// </summary>
+        /// <remarks>
+        /// Channel 0 is the reports path of the manifest, channel N > 0 is that path suffixed with '.N'.
+        /// CODESYNC: Public/Src/Sandbox/Linux/report_channels.hpp
+        /// </remarks>
+        public uint LinuxSandboxReportChannelCount { get; set; }
+
+        /// <summary>
+        /// Executables the Linux sandbox lets run unmonitored when they are exec'd.
+        /// </summary>
+        /// <remarks>
+        /// Each entry is a path, optionally followed by '|' and the SHA256 of the executable.
+        /// CODESYNC: Public/Src/Sandbox/Linux/unmonitored_executables.hpp
+        /// </remarks>
+        public IReadOnlyList<string> LinuxSandboxUnmonitoredExecutables { get; set; }
+
+        /// <summary>
+        /// A file listing the inputs a previous run of the pip read, which the root process of the pip prefetches while the tool starts up.
+        /// Null if the pip does not prefetch its inputs.
+        /// </summary>
+        /// <remarks>
+        /// The file does not need to exist: <see cref="SandboxedProcessUnix"/> writes it once the pip is done, for the next run.
+        /// CODESYNC: Public/Src/Sandbox/Linux/input_prefetcher.hpp
+        /// </remarks>
+        public string? LinuxSandboxInputPrefetchList { get; set; }
+
+        /// <summary>
+        /// A file holding the paths a previous run of the pip resolved, which the sandbox validates and reuses instead of resolving them again.
+        /// Null if the pip does not keep a resolution snapshot.
+        /// </summary>
+        /// <remarks>
+        /// The file does not need to exist: the root process of the pip saves it when it exits, for the next run.
+        /// CODESYNC: Public/Src/Sandbox/Linux/resolution_snapshot.hpp
+        /// </remarks>
+        public string? LinuxSandboxResolutionSnapshot { get; set; }
+
         /// <summary>
         /// A location for a file where Detours to log failure messages.
         /// </summary>
@@ -772,6 +867,7 @@ namespace BuildXL.Processes
             public const uint ErrorDumpLocation             = 0xABCDEF03;
             public const uint SubstituteProcessShim         = 0xABCDEF04;
             public const uint ChildProcessesBreakAwayString = 0xABCDEF05;
+            public const uint LinuxSandbox                  = 0xABCDEF06;
             public const uint Flags                         = 0xF1A6B10C;
             public const uint PipId                         = 0xF1A6B10E;
             public const uint DebugOn                       = 0xDB600001;
@@ -1092,6 +1188,34 @@ namespace BuildXL.Processes
             }
         }
 
+        private static void WriteLinuxSandboxBlock(
+            BinaryWriter writer,
+            uint reportChannelCount,
+            IReadOnlyList<string> unmonitoredExecutables,
+            string? inputPrefetchList,
+            string? resolutionSnapshot)
+        {
+#if DEBUG
+            writer.Write(CheckedCode.LinuxSandbox);
+#endif
+            writer.Write(reportChannelCount);
+            WriteChars(writer, unmonitoredExecutables.Count > 0 ? string.Join(";", unmonitoredExecutables) : null);
+            WriteChars(writer, inputPrefetchList);
+            WriteChars(writer, resolutionSnapshot);
+        }
+
+        private static (uint reportChannelCount, IReadOnlyList<string> unmonitoredExecutables, string? inputPrefetchList, string? resolutionSnapshot) ReadLinuxSandboxBlock(BinaryReader reader)
+        {
+#if DEBUG
+            CheckedCode.EnsureRead(reader, CheckedCode.LinuxSandbox);
+#endif
+            uint reportChannelCount = reader.ReadUInt32();
+            string? unmonitoredExecutables = ReadChars(reader);
+            string? inputPrefetchList = ReadChars(reader);
+            string? resolutionSnapshot = ReadChars(reader);
+            return (reportChannelCount, unmonitoredExecutables?.Split(';') ?? Array.Empty<string>(), inputPrefetchList, resolutionSnapshot);
+        }
+
         private void WriteManifestTreeBlock(BinaryWriter writer)
         {
             if (m_sealedManifestTreeBlock is not null)
@@ -1133,6 +1257,13 @@ namespace BuildXL.Processes
                 WriteReportBlock(writer, setup);
                 WriteDllBlock(writer, setup);
                 WriteSubstituteProcessShimBlock(writer);
+
+                // Only the Linux sandbox knows about this block
+                if (OperatingSystemHelper.IsLinuxOS)
+                {
+                    WriteLinuxSandboxBlock(writer, LinuxSandboxReportChannelCount, LinuxSandboxUnmonitoredExecutables, LinuxSandboxInputPrefetchList, LinuxSandboxResolutionSnapshot);
+                }
+
                 WriteManifestTreeBlock(writer);
 
                 return new ArraySegment<byte>(stream.GetBuffer(), 0, (int)stream.Position);
@@ -1184,6 +1315,11 @@ namespace BuildXL.Processes
                 WriteChars(writer, m_messageSentCountSemaphoreName);
             }
 
+            if (OperatingSystemHelper.IsLinuxOS)
+            {
+                WriteLinuxSandboxBlock(writer, LinuxSandboxReportChannelCount, LinuxSandboxUnmonitoredExecutables, LinuxSandboxInputPrefetchList, LinuxSandboxResolutionSnapshot);
+            }
+
             // The manifest tree block has to be serialized the last.
             WriteManifestTreeBlock(writer);
         }
@@ -1206,6 +1342,9 @@ namespace BuildXL.Processes
             long pipId = ReadPipId(reader);
             string? messageCountSemaphoreName = ReadChars(reader);
             string? messageSentCountSemaphoreName = OperatingSystemHelper.IsWindowsOS ? ReadChars(reader) : null;
+            var (linuxSandboxReportChannelCount, linuxSandboxUnmonitoredExecutables, linuxSandboxInputPrefetchList, linuxSandboxResolutionSnapshot) = OperatingSystemHelper.IsLinuxOS
+                ? ReadLinuxSandboxBlock(reader)
+                : (1, Array.Empty<string>(), null, null);
 
             byte[] sealedManifestTreeBlock;
 
@@ -1225,6 +1364,10 @@ namespace BuildXL.Processes
                 m_sealedManifestTreeBlock = sealedManifestTreeBlock,
                 m_messageCountSemaphoreName = messageCountSemaphoreName,
                 m_messageSentCountSemaphoreName = messageSentCountSemaphoreName,
+                LinuxSandboxReportChannelCount = linuxSandboxReportChannelCount,
+                LinuxSandboxUnmonitoredExecutables = linuxSandboxUnmonitoredExecutables,
+                LinuxSandboxInputPrefetchList = linuxSandboxInputPrefetchList,
+                LinuxSandboxResolutionSnapshot = linuxSandboxResolutionSnapshot,
             };
         }
 
@@ -1325,6 +1468,10 @@ namespace BuildXL.Processes
             AlwaysRemoteInjectDetoursFrom32BitProcess = 0x10,
             UnconditionallyEnableLinuxPTraceSandbox = 0x20,
             IgnoreDeviceIoControlGetReparsePoint = 0x40,
+            EnableLinuxSandboxReportTimestamps = 0x80,
+            EnableLinuxSandboxReportLogs = 0x100,
+            EnableLinuxSandboxObserveOnly = 0x200,
+            EnableLinuxSandboxAccessSummary = 0x400,
         }
 
         private readonly struct FileAccessScope
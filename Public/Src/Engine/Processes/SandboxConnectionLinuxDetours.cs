@@ -49,6 +49,16 @@ namespace BuildXL.Processes
         /// </summary>
         public static readonly string DetoursLibFile = SandboxedProcessUnix.EnsureDeploymentFile("libDetours.so");
 
+        /// <summary>
+        /// Name of the audit module, loaded through LD_AUDIT next to <see cref="DetoursLibFile"/> when <see cref="BuildXLLibraryAudit"/> is set.
+        /// </summary>
+        public const string AuditLibFileName = "libBxlAudit.so";
+
+        /// <summary>
+        /// Location of the audit module.
+        /// </summary>
+        public static readonly Lazy<string> AuditLibFile = new(() => SandboxedProcessUnix.EnsureDeploymentFile(AuditLibFileName));
+
         /// <summary>
         /// Environment variable containing the path to the file access manifest to be read by the detoured process.
         /// </summary>
@@ -64,6 +74,39 @@ namespace BuildXL.Processes
         /// </summary>
         public static readonly string BuildXLTracedProcessPath = "__BUILDXL_TRACED_PATH";
 
+        /// <summary>
+        /// Environment variable that, when set to 1 for a pip, makes the ptracerunner observe the statically linked processes of the pip
+        /// with fanotify instead of ptrace, if fanotify is available to it.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/common.h
+        /// </remarks>
+        public static readonly string BuildXLFanotifyBackend = "__BUILDXL_FANOTIFY_BACKEND";
+
+        /// <summary>
+        /// Environment variable that, when set to 1 for a pip, makes the ptracerunner observe the statically linked processes of the pip
+        /// with eBPF programs instead of ptrace, if eBPF is available to it. Takes precedence over <see cref="BuildXLFanotifyBackend"/>.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/common.h
+        /// </remarks>
+        public static readonly string BuildXLEbpfBackend = "__BUILDXL_EBPF_BACKEND";
+
+        /// <summary>
+        /// Environment variable that, when set to 1 for a pip, makes the sandbox report the shared libraries the dynamic loader searches for
+        /// and maps (at startup and on dlopen), which it opens without going through libc. The audit module (<see cref="AuditLibFileName"/>)
+        /// is loaded into the processes of the pip through LD_AUDIT to do so.
+        /// </summary>
+        public static readonly string BuildXLLibraryAudit = "__BUILDXL_LIBRARY_AUDIT";
+
+        /// <summary>
+        /// Environment variable containing the path to the audit module, which only reports libraries when it is set.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/common.h
+        /// </remarks>
+        public static readonly string BuildXLAuditPath = "__BUILDXL_AUDIT_PATH";
+
         internal sealed class Info : IDisposable
         {
             /// <summary>
@@ -95,7 +138,7 @@ namespace BuildXL.Processes
                 /// </summary>
                 internal bool IsReadHandleDisposed() => m_readHandleDisposed;
 
-                public ReportProcessor(Info info, string fifoName, Lazy<SafeFileHandle> fifoHandle)
+                public ReportProcessor(Info info, string fifoName, Lazy<SafeFileHandle> fifoHandle, bool isReportChannel)
                 {
                     Info = info;
                     m_fifoName = fifoName;
@@ -112,7 +155,7 @@ namespace BuildXL.Processes
                         singleProducedConstrained: true // Only m_workerThread posts to the action block
                     );
 
-                    IsPrimaryFifoProcessor = m_fifoWriteHandle == info.m_lazyWriteHandle;
+                    IsReportChannel = isReportChannel;
                 }
 
                 internal void Start() => m_workerThread.Start();
@@ -122,12 +165,23 @@ namespace BuildXL.Processes
                     LogDebug($"Complete action requested for {GetFifoName()}");
 
                     // Send the end of report sentinel, so we can exit the report loop
-                    Info.WriteSentinel(m_fifoWriteHandle, s_endOfReportsSentinelAsBytes);
+                    Info.WriteSentinel(this, s_endOfReportsSentinelAsBytes);
                 }
 
                 internal string GetFifoName() => m_fifoName;
 
-                internal bool IsPrimaryFifoProcessor { get; }
+                /// <summary>
+                /// Whether this processor reads one of the report channels, as opposed to the secondary FIFO
+                /// </summary>
+                internal bool IsReportChannel { get; }
+
+                /// <nodoc />
+                internal Lazy<SafeFileHandle> WriteHandle => m_fifoWriteHandle;
+
+                /// <summary>
+                /// Number of <see cref="NoActiveProcessesSentinel"/> this processor went through. Only accessed under <see cref="Info.m_completionRoundLock"/>.
+                /// </summary>
+                internal int ProcessedCompletionRounds { get; set; }
 
                 internal void CompleteAccessReportProcessing()
                 {
@@ -173,7 +227,7 @@ namespace BuildXL.Processes
                 /// <remarks>
                 /// The way we deal with the decision about when to stop reading messages from the FIFO deserves some details:
                 /// * Messages are read from the FIFO and posted to an action block <see cref="m_processingBlock"/>, which processes them async.
-                /// * A write handle <see cref="m_lazyWriteHandle"/> is kept open to avoid reaching EOF if other writers (running tools) happen to close the FIFO
+                /// * A write handle <see cref="m_fifoWriteHandle"/> is kept open to avoid reaching EOF if other writers (running tools) happen to close the FIFO
                 /// * The potential end of the receive loop is triggered by removing the last active process from <see cref="m_activeProcesses"/>. This
                 ///   can happen because the <see cref="m_activeProcessesChecker"/> detected than an active process is no longer alive or because 
                 ///   a process exited report is seen. When this case is reached a special message <see cref="NoActiveProcessesSentinel"/> is sent from this
@@ -184,13 +238,15 @@ namespace BuildXL.Processes
                 ///   processing the sentinel and if 'start process' reports had arrived, we just ignore the sentinel and keep processing messages. We will eventually
                 ///   reach again 0 processes and the sentinel will be sent another time.
                 /// * If <see cref="NoActiveProcessesSentinel"/> arrives and we see 0 active processes, we can safely exit the loop. In this case we send another
-                ///   sentinel <see cref="EndOfReportsSentinel"/>. Instead of this we could just close <see cref="m_lazyWriteHandle"/> and let the receiving loop reach an EOF,
+                ///   sentinel <see cref="EndOfReportsSentinel"/>. Instead of this we could just close <see cref="m_fifoWriteHandle"/> and let the receiving loop reach an EOF,
                 ///   but this proved to be slow in some cases (since it is likely depending on some GC process). So instead we send a sentinel. The loop can safely exit when we
                 ///   see this since no pending messages can be left to be processed (we saw the <see cref="NoActiveProcessesSentinel"/> on the other end of the pipe at the 
                 ///   same pipe there were 0 active processes).
+                /// * A note on report channels: when the pip reports on more than one FIFO, <see cref="NoActiveProcessesSentinel"/> is sent to all of them and the decision
+                ///   is only made once every channel processed it, since a start process report may still be pending on any of them (see <see cref="Info.OnNoActiveProcessesSentinel"/>).
                 /// * A note on the secondary FIFO: the processing loop for the secondary FIFO (used to communicate ptrace specific messages) goes through the same flow, with the 
-                ///   caveat that we only initiate the tear down process of the seconday FIFO once the decide to exit the primary FIFO via <see cref="EndOfReportsSentinel"/>. The reason
-                ///   is that we want the secondary FIFO to be alive throughout the lifetime of the first FIFO. 
+                ///   caveat that we only initiate the tear down process of the seconday FIFO once the decide to exit all the report channels via <see cref="EndOfReportsSentinel"/>. The reason
+                ///   is that we want the secondary FIFO to be alive throughout the lifetime of the report channels. 
                 /// </remarks>
                 private void StartReceivingAccessReports(string fifoName, Lazy<SafeFileHandle> fifoHandle)
                 {
@@ -206,7 +262,7 @@ namespace BuildXL.Processes
                             return;
                         }
 
-                        // make sure that m_lazyWriteHandle has been created
+                        // make sure that m_fifoWriteHandle has been created
                         Analysis.IgnoreResult(fifoHandle.Value);
 
                         byte[] messageLengthBytes = new byte[sizeof(int)];
@@ -243,10 +299,10 @@ namespace BuildXL.Processes
                             {
                                 LogDebug($"End of reports sentinel arrived on FIFO {fifoName}. Exiting 'receive reports' loop.");
 
-                                // The primary FIFO has no more reports. Terminate the secondary FIFO.
-                                if (IsPrimaryFifoProcessor && !string.IsNullOrEmpty(Info.SecondaryFifoPath))
+                                // The report channels have no more reports. Terminate the secondary FIFO once the last of them is done.
+                                if (IsReportChannel && Interlocked.Decrement(ref Info.m_liveReportChannels) == 0 && Info.m_secondaryReportProcessor != null)
                                 {
-                                    Info.WriteSentinel(Info.m_lazySecondaryFifoWriteHandle, s_noActiveProcessesSentinelAsBytes);
+                                    Info.WriteSentinel(Info.m_secondaryReportProcessor, s_noActiveProcessesSentinelAsBytes);
 
                                     LogDebug("NoProcessesSentinel sent to secondary FIFO");
                                 }
@@ -304,9 +360,22 @@ namespace BuildXL.Processes
             internal string SecondaryFifoPath { get; }
             internal string FamPath { get; }
 
+            /// <summary>
+            /// Directory the processes of the pip append their report logs to, or null if report logs are disabled (see <see cref="FileAccessManifest.EnableLinuxSandboxReportLogs"/>)
+            /// </summary>
+            internal string ReportLogDirectory { get; }
+
             private readonly ManagedFailureCallback m_failureCallback;
             private readonly bool m_isInTestMode;
 
+            /// <summary>
+            /// Whether reports carry the time at which the access was observed and a sequence number (see <see cref="FileAccessManifest.EnableLinuxSandboxReportTimestamps"/>)
+            /// </summary>
+            private readonly bool m_reportTimestamps;
+            private long m_timestampedReportCount;
+            private long m_maxReportLagNs;
+            private static readonly double s_nanosecondsPerStopwatchTick = 1_000_000_000.0 / Stopwatch.Frequency;
+
             /// <remarks>
             /// This dictionary is accessed both from the report processor threads as well as the thread
             /// backing <see cref="m_activeProcessesChecker"/>, hence it must be thread-safe.
@@ -335,11 +404,40 @@ namespace BuildXL.Processes
             private bool m_ptraceRunnerWasRequestedForPip = false; 
 
             private readonly CancellableTimedAction m_activeProcessesChecker;
-            private readonly Lazy<SafeFileHandle> m_lazyWriteHandle;
+
+            /// <summary>
+            /// Evaluates the policy for the accesses observed by processes running in observe-only mode (see OpObservation).
+            /// Lazily started on the first observation. Observations arrive on every report channel, so it is only accessed under <see cref="m_observationEvaluatorLock"/>.
+            /// </summary>
+            private AsyncProcessExecutor m_observationEvaluator;
+            private readonly object m_observationEvaluatorLock = new object();
+
             private readonly Lazy<SafeFileHandle> m_lazySecondaryFifoWriteHandle;
 
-            private readonly ReportProcessor m_reportProcessor;
+            /// <summary>
+            /// One processor per report channel. The first one reads <see cref="ReportsFifoPath"/>.
+            /// </summary>
+            private readonly ReportProcessor[] m_reportProcessors;
             private readonly ReportProcessor m_secondaryReportProcessor;
+
+            /// <summary>
+            /// Number of report channels that did not see <see cref="EndOfReportsSentinel"/> yet
+            /// </summary>
+            private int m_liveReportChannels;
+
+            /// <summary>
+            /// Every time the active process count reaches 0 a completion round starts: <see cref="NoActiveProcessesSentinel"/> is sent to every report channel,
+            /// and the reports are done once all the channels processed it without any process start in between (see <see cref="OnNoActiveProcessesSentinel"/>).
+            /// </summary>
+            private readonly object m_completionRoundLock = new object();
+            private int m_completionRound;
+            private int m_completionRoundChannels;
+            private long m_completionRoundGeneration;
+
+            /// <summary>
+            /// Incremented on every process start report
+            /// </summary>
+            private long m_processStartGeneration;
             private static readonly TimeSpan s_activeProcessesCheckerInterval = TimeSpan.FromSeconds(1);
 
             // These are just the byte representations of the sentinel values, so we don't need to compute them over and over
@@ -348,28 +446,32 @@ namespace BuildXL.Processes
 
             private static ArrayPool<byte> ByteArrayPool { get; } = new ArrayPool<byte>(4096);
 
-            private ReportProcessor GetReportProcessorFor(Lazy<SafeFileHandle> lazyWriteHandle) => lazyWriteHandle == m_lazyWriteHandle ? m_reportProcessor : m_secondaryReportProcessor;
-
-            internal Info(ManagedFailureCallback failureCallback, SandboxedProcessUnix process, string reportsFifoPath, string secondaryFifoPath, string famPath, bool isInTestMode)
+            internal Info(ManagedFailureCallback failureCallback, SandboxedProcessUnix process, string reportsFifoPath, string secondaryFifoPath, string famPath, bool isInTestMode, int reportChannelCount = 1, bool reportTimestamps = false, string reportLogDirectory = null)
             {
                 m_isInTestMode = isInTestMode;
+                m_reportTimestamps = reportTimestamps;
                 m_failureCallback = failureCallback;
                 Process = process;
                 ReportsFifoPath = reportsFifoPath;
                 SecondaryFifoPath = secondaryFifoPath;
                 FamPath = famPath;
+                ReportLogDirectory = reportLogDirectory;
 
                 m_activeProcesses = new ConcurrentDictionary<int, byte>();
                 m_activeProcessesChecker = new CancellableTimedAction(
                     CheckActiveProcesses,
                     intervalMs: Math.Min((int)process.ChildProcessTimeout.TotalMilliseconds, (int)s_activeProcessesCheckerInterval.TotalMilliseconds));
 
-                // create a write handle (used to keep the fifo open, i.e.,
-                // the 'read' syscall won't receive EOF until we close this writer
-                m_lazyWriteHandle = GetLazyWriteHandle(ReportsFifoPath);
+                // Processes report on the channel selected by their pid. Each channel gets a write handle (used to keep the fifo open, i.e.,
+                // the 'read' syscall won't receive EOF until we close this writer) and a background thread for reading from it
+                m_reportProcessors = new ReportProcessor[reportChannelCount];
+                for (int i = 0; i < reportChannelCount; i++)
+                {
+                    string channelPath = GetReportChannelPath(ReportsFifoPath, i);
+                    m_reportProcessors[i] = new ReportProcessor(this, channelPath, GetLazyWriteHandle(channelPath), isReportChannel: true);
+                }
 
-                // will start a background thread for reading from the FIFO
-                m_reportProcessor = new ReportProcessor(this, ReportsFifoPath, m_lazyWriteHandle);
+                m_liveReportChannels = reportChannelCount;
 
                 // Second thread for reading the secondary FIFO
                 // The secondary pipe is used here to allow for messages that are higher priority (such as ptrace notifications)
@@ -378,12 +480,12 @@ namespace BuildXL.Processes
                 if (!string.IsNullOrEmpty(SecondaryFifoPath))
                 {
                     m_lazySecondaryFifoWriteHandle = GetLazyWriteHandle(SecondaryFifoPath);
-                    m_secondaryReportProcessor = new ReportProcessor(this, SecondaryFifoPath, m_lazySecondaryFifoWriteHandle);
+                    m_secondaryReportProcessor = new ReportProcessor(this, SecondaryFifoPath, m_lazySecondaryFifoWriteHandle, isReportChannel: false);
                     secondaryCompletion = m_secondaryReportProcessor.Completion;
                 }
 
                 // Post the process tree completion after we process all reports
-                Task.WhenAll(m_reportProcessor.Completion, secondaryCompletion).ContinueWith(t =>
+                Task.WhenAll(m_reportProcessors.Select(processor => processor.Completion).Concat(new[] { secondaryCompletion })).ContinueWith(t =>
                 {
                     LogDebug("Posting OpProcessTreeCompleted message");
                     Process.PostAccessReport(new AccessReport
@@ -408,7 +510,11 @@ namespace BuildXL.Processes
             /// </summary>
             internal void Start()
             {
-                m_reportProcessor.Start();
+                foreach (var reportProcessor in m_reportProcessors)
+                {
+                    reportProcessor.Start();
+                }
+
                 m_secondaryReportProcessor?.Start();
             }
 
@@ -430,10 +536,13 @@ namespace BuildXL.Processes
             /// </summary>
             internal void RequestStop()
             {
-                LogDebug($"RequestStop: closing the write handle for FIFO '{ReportsFifoPath}'");
+                foreach (var reportProcessor in m_reportProcessors)
+                {
+                    LogDebug($"RequestStop: closing the write handle for FIFO '{reportProcessor.GetFifoName()}'");
 
-                m_lazyWriteHandle.Value.Close();
-                m_lazyWriteHandle.Value.Dispose();
+                    reportProcessor.WriteHandle.Value.Close();
+                    reportProcessor.WriteHandle.Value.Dispose();
+                }
 
                 if (!string.IsNullOrEmpty(SecondaryFifoPath))
                 {
@@ -444,9 +553,9 @@ namespace BuildXL.Processes
                 m_activeProcessesChecker.Cancel();
             }
 
-            private void WriteSentinel(Lazy<SafeFileHandle> writeHandle, byte[] sentinelBytes)
+            private void WriteSentinel(ReportProcessor reportProcessor, byte[] sentinelBytes)
             {
-                var reportProcessor = GetReportProcessorFor(writeHandle);
+                var writeHandle = reportProcessor.WriteHandle;
 
                 // If the read or write handles are already closed, no need to send a sentinel
                 if (reportProcessor.IsReadHandleDisposed() || writeHandle.Value.IsClosed || writeHandle.Value.IsInvalid)
@@ -499,6 +608,8 @@ namespace BuildXL.Processes
             /// <summary>Adds <paramref name="pid" /> to the set of active processes</summary>
             internal void AddPid(int pid)
             {
+                // Bump the generation before the process becomes active, so an in-flight completion round can't miss it (see OnNoActiveProcessesSentinel)
+                Interlocked.Increment(ref m_processStartGeneration);
                 bool added = m_activeProcesses.TryAdd(pid, 1);
                 LogDebug($"AddPid({pid}) :: added: {added}; size: {m_activeProcesses.Count}");
             }
@@ -545,13 +656,13 @@ namespace BuildXL.Processes
 
                 if (removed && m_activeProcesses.IsEmpty)
                 {
-                    LogDebug($"Removed {pid} and the active count is 0. Sending sentinel on primary FIFO");
-                    // We just reached 0 active processes. Notify this through the FIFO so we can check on the other end
+                    LogDebug($"Removed {pid} and the active count is 0. Sending sentinel on the report channels");
+                    // We just reached 0 active processes. Notify this through the FIFOs so we can check on the other end
                     // whether this means we are done processing reports. There might be reports still to be processed, including start process reports,
                     // so pushing this sentinel makes sure we process all pending reports before reaching a decision
                     
-                    // We only send the sentinel on the primary FIFO. The secondary one will be terminated once we decide the primary can terminate.
-                    WriteSentinel(m_lazyWriteHandle, s_noActiveProcessesSentinelAsBytes);
+                    // We only send the sentinel on the report channels. The secondary FIFO will be terminated once we decide the report channels can terminate.
+                    StartCompletionRound();
                 }
                 else if (removed && pid == Process.ProcessId)
                 {
@@ -569,6 +680,81 @@ namespace BuildXL.Processes
                 }
             }
 
+            private void StartCompletionRound()
+            {
+                // Sentinels are written under the lock, so every channel sees the sentinels of consecutive rounds in the same order
+                lock (m_completionRoundLock)
+                {
+                    m_completionRound++;
+                    m_completionRoundChannels = 0;
+                    m_completionRoundGeneration = Interlocked.Read(ref m_processStartGeneration);
+
+                    foreach (var reportProcessor in m_reportProcessors)
+                    {
+                        WriteSentinel(reportProcessor, s_noActiveProcessesSentinelAsBytes);
+                    }
+                }
+            }
+
+            /// <summary>
+            /// Handles a <see cref="NoActiveProcessesSentinel"/> once all the reports that arrived before it on the same FIFO are processed.
+            /// </summary>
+            /// <remarks>
+            /// Reports are sharded by pid, so the start process report for a child can be pending on a different channel than the exit report of its
+            /// parent that got us to 0 active processes. Reports are only done once every channel got through the sentinel of the latest round
+            /// (so every report written before the round started was processed), no process started since the round started, and there are still no active processes.
+            /// The sentinels of a stale round are ignored: a new round started when the active count went back to 0.
+            /// </remarks>
+            private void OnNoActiveProcessesSentinel(ReportProcessor processor)
+            {
+                if (!processor.IsReportChannel)
+                {
+                    // The secondary FIFO is only sent this sentinel once all the report channels are done
+                    if (m_activeProcesses.IsEmpty)
+                    {
+                        LogDebug($"NoActiveProcessesSentinel received for fifo {processor.GetFifoName()} and 0 active processes found. Requesting completion to the report processor.");
+                        processor.Complete();
+                    }
+                    else
+                    {
+                        LogDebug($"NoActiveProcessesSentinel received for fifo {processor.GetFifoName()} but {m_activeProcesses.Count} processes were detected. The sentinel is ignored.");
+                    }
+
+                    return;
+                }
+
+                bool done = false;
+                lock (m_completionRoundLock)
+                {
+                    processor.ProcessedCompletionRounds++;
+                    if (processor.ProcessedCompletionRounds == m_completionRound && ++m_completionRoundChannels == m_reportProcessors.Length)
+                    {
+                        done = m_activeProcesses.IsEmpty && Interlocked.Read(ref m_processStartGeneration) == m_completionRoundGeneration;
+                    }
+                }
+
+                if (!done)
+                {
+                    // In this case we just ignore the message. The sentinel will be sent again once we reach 0
+                    // active processes
+                    LogDebug($"NoActiveProcessesSentinel received for fifo {processor.GetFifoName()} but either other report channels did not get to it yet or new start process reports arrived. The sentinel is ignored.");
+                    return;
+                }
+
+                // Logged reports can be observations too, so the logs are merged before the evaluator is drained. The evaluator itself
+                // never logs (see observation_evaluator.cpp): what it reports comes over the FIFOs, which are read until it exits
+                MergeReportLogs();
+
+                // The reports for all observations have to be in the FIFOs before the end of reports sentinel
+                DrainObservationEvaluator();
+
+                LogDebug($"NoActiveProcessesSentinel processed on all {m_reportProcessors.Length} report channels and 0 active processes found. Requesting completion to the report processors.");
+                foreach (var reportProcessor in m_reportProcessors)
+                {
+                    reportProcessor.Complete();
+                }
+            }
+
             internal void LogError(string message)
             {
                 message = $"{message} (errno: {Marshal.GetLastWin32Error()})";
@@ -595,8 +781,49 @@ namespace BuildXL.Processes
                 }
 
                 m_activeProcesses.Clear();
-                Analysis.IgnoreResult(FileUtilities.TryDeleteFile(ReportsFifoPath, retryOnFailure: false));
+
+                if (m_reportTimestamps)
+                {
+                    LogDebug($"Report timestamps: {Interlocked.Read(ref m_timestampedReportCount)} reports, max lag {Interlocked.Read(ref m_maxReportLagNs) / 1000.0:F1}us");
+                }
+
+                // The evaluator is normally drained when the process tree completes. If we got here first, the pip is being torn down.
+                lock (m_observationEvaluatorLock)
+                {
+                    if (m_observationEvaluator != null)
+                    {
+                        m_observationEvaluator.KillAsync(dumpProcessTree: false).GetAwaiter().GetResult();
+                        m_observationEvaluator.Dispose();
+                        m_observationEvaluator = null;
+                    }
+                }
+
+                foreach (var reportProcessor in m_reportProcessors)
+                {
+                    Analysis.IgnoreResult(FileUtilities.TryDeleteFile(reportProcessor.GetFifoName(), retryOnFailure: false));
+                }
+
                 Analysis.IgnoreResult(FileUtilities.TryDeleteFile(FamPath, retryOnFailure: false));
+                // CODESYNC: Public/Src/Sandbox/Linux/first_write_registry.hpp
+                Analysis.IgnoreResult(FileUtilities.TryDeleteFile(FamPath + ".writes", retryOnFailure: false));
+                // CODESYNC: Public/Src/Sandbox/Linux/process_tree_tracker.hpp
+                Analysis.IgnoreResult(FileUtilities.TryDeleteFile(FamPath + ".tree", retryOnFailure: false));
+                // CODESYNC: Public/Src/Sandbox/Linux/resolution_snapshot.hpp
+                Analysis.IgnoreResult(FileUtilities.TryDeleteFile(FamPath + ".snapshot", retryOnFailure: false));
+                Analysis.IgnoreResult(FileUtilities.TryDeleteFile(FamPath + ".snapshot.log", retryOnFailure: false));
+                if (ReportLogDirectory != null)
+                {
+                    // Logs are sparse files of a fixed size, they are never truncated by the sandbox
+                    try
+                    {
+                        FileUtilities.DeleteDirectoryContents(ReportLogDirectory, deleteRootDirectory: true, bestEffort: true);
+                    }
+                    catch (BuildXLException e)
+                    {
+                        LogDebug($"Could not delete the report log directory '{ReportLogDirectory}': {e}");
+                    }
+                }
+
                 if (m_isInTestMode)
                 {
                     // The worker thread should complete in all but most extreme cases.  One such extreme case
@@ -604,8 +831,12 @@ namespace BuildXL.Processes
                     // especially if that's a custom-implemented filesystem running in user space).  When that
                     // happens, some write handled to the created FIFO may remain open, so the 'read' call in
                     // 'StartReceivingAccessReports' may remain stuck forever.
-                    LogDebug("Waiting for the worker thread to complete");
-                    m_reportProcessor.JoinReceivingThread();
+                    LogDebug("Waiting for the worker threads to complete");
+                    foreach (var reportProcessor in m_reportProcessors)
+                    {
+                        reportProcessor.JoinReceivingThread();
+                    }
+
                     m_secondaryReportProcessor?.JoinReceivingThread();
                 }
             }
@@ -622,18 +853,7 @@ namespace BuildXL.Processes
                     // happened the create process report should have bumped the active process count.
                     if (item.length == NoActiveProcessesSentinel)
                     {
-                        if (m_activeProcesses.IsEmpty)
-                        {
-                            LogDebug($"NoActiveProcessesSentinel received for fifo {item.processor.GetFifoName()} and 0 active processes found. Requesting completion to the report processor.");
-                            item.processor.Complete();
-                        }
-                        else
-                        {
-                            // In this case we just ignore the message. The sentinel will be sent again once we reach 0
-                            // active processes
-                            LogDebug($"NoActiveProcessesSentinel received for fifo {item.processor.GetFifoName()} but {m_activeProcesses.Count} processes were detected. This means new start process reports arrived afterwards. The sentinel is ignored.");
-                        }
-
+                        OnNoActiveProcessesSentinel(item.processor);
                         return;
                     }
 
@@ -644,6 +864,9 @@ namespace BuildXL.Processes
 
                     // parse the message, consuming the span field by field. The format is:
                     //  "%s|%d|%d|%d|%d|%d|%d|%d|%d|%s\n", __progname, getpid(), access, status, explicitLogging, err, opcode, isDirectory, unexpectedReport, reportPath
+                    // When report timestamps are enabled, the observation time and the sequence number are inserted before the path:
+                    //  "%s|%d|%d|%d|%d|%d|%d|%d|%d|%lu|%lu|%s\n"
+                    // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.hpp (BuildReport)
                     var restOfMessage = message;
                     _ = nextField(restOfMessage, out restOfMessage);  // ignore progname
                     var pid = AssertInt(nextField(restOfMessage, out restOfMessage));
@@ -654,6 +877,13 @@ namespace BuildXL.Processes
                     var opCode = AssertInt(nextField(restOfMessage, out restOfMessage));
                     var isDirectory = AssertInt(nextField(restOfMessage, out restOfMessage));
                     var unexpectedReport = AssertInt(nextField(restOfMessage, out restOfMessage));
+                    if (m_reportTimestamps)
+                    {
+                        var observedTimeNs = AssertULong(nextField(restOfMessage, out restOfMessage));
+                        _ = nextField(restOfMessage, out restOfMessage); // the sequence number is only used by the report_lag tool
+                        RecordReportLag(observedTimeNs);
+                    }
+
                     var path = nextField(restOfMessage, out restOfMessage);
                     Contract.Assert(restOfMessage.IsEmpty);  // We should have reached the end of the message
 
@@ -671,6 +901,15 @@ namespace BuildXL.Processes
                         UnexpectedReport = unexpectedReport,
                     };
 
+                    // Processes running in observe-only mode don't evaluate the policy for some of their accesses: they send a raw observation instead.
+                    // Observations are not posted. The observation evaluator turns them into regular reports and sends those over the reports FIFO.
+                    if (report.Operation == FileOperation.OpObservation)
+                    {
+                        Process.ConsumeMessageCount(report, path.ToString());
+                        EvaluateObservation(message);
+                        return;
+                    }
+
                     // Flag that a ptrace runner was requested for this pip at least once.
                     // Observe the first time this is set to true, it is guaranteed that ptrace is not tracing any part
                     // of the process tree since this just-created report has yet to be posted in order for the ptrace runner to start.
@@ -679,12 +918,22 @@ namespace BuildXL.Processes
                         m_ptraceRunnerWasRequestedForPip = true;
                     }
 
+                    // The sandbox saw the last process of the tree exit. Processes that died without reporting their exit (e.g., killed) are otherwise
+                    // only found by the active processes checker, which runs periodically once the root process is gone: check them right away instead.
+                    // This report is not posted: the tree is only considered completed once all reports are processed (see the constructor).
+                    if (report.Operation == FileOperation.OpProcessTreeCompleted)
+                    {
+                        LogDebug($"Received FileOperation.OpProcessTreeCompleted from pid {report.Pid}. Checking for active processes.");
+                        CheckActiveProcesses();
+                        return;
+                    }
+
                     // update active processes
                     if (report.Operation == FileOperation.OpProcessStart)
                     {
-                        // We should never get process start messages in the secondary FIFO. We run the risk of having exited the primary FIFO already,
-                        // and never sending the sentinel to the secondary one.
-                        Contract.Assert(item.processor.IsPrimaryFifoProcessor, "Process start messages can only arrive to the primary FIFO");
+                        // Process start messages arrive on the report channel of the process they are about, but never in the secondary FIFO.
+                        // We run the risk of having exited the report channels already, and never sending the sentinel to the secondary one.
+                        Contract.Assert(item.processor.IsReportChannel, "Process start messages can only arrive to a report channel");
 
                         LogDebug($"Received FileOperation.OpProcessStart for pid {report.Pid})");
                         AddPid(report.Pid);
@@ -723,6 +972,195 @@ namespace BuildXL.Processes
                 }
             }
 
+            private void EvaluateObservation(ReadOnlySpan<char> observation)
+            {
+                lock (m_observationEvaluatorLock)
+                {
+                    try
+                    {
+                        var evaluator = GetOrStartObservationEvaluator();
+                        evaluator.Process.StandardInput.Write(observation);
+                        evaluator.Process.StandardInput.Write('\n');
+                    }
+                    catch (Exception e) when (e is IOException || e is BuildXLException)
+                    {
+                        LogError($"Could not send an observation to the observation evaluator. Exception details: {e}");
+                    }
+                }
+            }
+
+            private AsyncProcessExecutor GetOrStartObservationEvaluator()
+            {
+                if (m_observationEvaluator != null)
+                {
+                    return m_observationEvaluator;
+                }
+
+                var executable = SandboxedProcessUnix.ObservationEvaluatorExecutable.Value;
+                var process = new System.Diagnostics.Process
+                {
+                    StartInfo = new ProcessStartInfo(executable)
+                    {
+                        CreateNoWindow = true,
+                        UseShellExecute = false,
+                        RedirectStandardInput = true,
+                        RedirectStandardError = true,
+                        RedirectStandardOutput = true,
+                        WorkingDirectory = Path.GetDirectoryName(executable)
+                    },
+                    EnableRaisingEvents = true
+                };
+
+                // The evaluator parses the FAM of the pip and sends its reports like any other process of the pip
+                process.StartInfo.Environment[BuildXLFamPathEnvVarName] = FamPath;
+
+                m_observationEvaluator = new AsyncProcessExecutor(
+                    process,
+                    Timeout.InfiniteTimeSpan,
+                    // The evaluator only writes to stderr if there's a problem
+                    errorBuilder: line => { if (line != null) { LogDebug($"Observation evaluator: {line}"); } });
+
+                LogDebug("Starting the observation evaluator");
+                m_observationEvaluator.Start();
+
+                // Observations are evaluated in bulk: there is no need to push every single one through the pipe right away
+                m_observationEvaluator.Process.StandardInput.AutoFlush = false;
+
+                return m_observationEvaluator;
+            }
+
+            /// <summary>
+            /// Waits until the observation evaluator sent the reports for all the observations it got.
+            /// </summary>
+            private void DrainObservationEvaluator()
+            {
+                AsyncProcessExecutor evaluator;
+                lock (m_observationEvaluatorLock)
+                {
+                    evaluator = m_observationEvaluator;
+                    m_observationEvaluator = null;
+                }
+
+                if (evaluator == null)
+                {
+                    return;
+                }
+
+                LogDebug("Waiting for the observation evaluator to exit");
+                try
+                {
+                    // The evaluator exits once its input is closed and all of its reports are written to the FIFO
+                    evaluator.Process.StandardInput.Close();
+                }
+                catch (IOException e)
+                {
+                    LogDebug($"Could not close the input of the observation evaluator: {e}");
+                }
+
+                evaluator.WaitForExitAsync().GetAwaiter().GetResult();
+                evaluator.WaitForStdOutAndStdErrAsync().GetAwaiter().GetResult();
+
+                if (evaluator.Process.ExitCode != 0)
+                {
+                    LogError($"The observation evaluator exited with code {evaluator.Process.ExitCode}. Reports for some file accesses may be missing.");
+                }
+
+                evaluator.Dispose();
+            }
+
+            /// <summary>
+            /// Merges the report logs written by the processes of the pip and processes the result as if it arrived on the first report channel.
+            /// </summary>
+            /// <remarks>
+            /// Only called once the process tree is done, so no process is appending to a log anymore. Process start and exit reports are left out
+            /// of the merge: the sandbox sent them over the reports FIFO too. The sandbox posted the message counting semaphore for every logged report.
+            /// </remarks>
+            private void MergeReportLogs()
+            {
+                if (ReportLogDirectory == null)
+                {
+                    return;
+                }
+
+                var executable = SandboxedProcessUnix.ReportLogMergeExecutable.Value;
+                LogDebug($"Merging the report logs in '{ReportLogDirectory}'");
+
+                try
+                {
+                    using (var process = new System.Diagnostics.Process
+                    {
+                        StartInfo = new ProcessStartInfo(executable, $"-d \"{ReportLogDirectory}\" -s")
+                        {
+                            CreateNoWindow = true,
+                            UseShellExecute = false,
+                            RedirectStandardError = true,
+                            RedirectStandardOutput = true,
+                            WorkingDirectory = Path.GetDirectoryName(executable)
+                        },
+                    })
+                    {
+                        process.Start();
+                        var errors = process.StandardError.ReadToEndAsync();
+
+                        // The merged stream uses the same framing as the reports FIFO
+                        var output = process.StandardOutput.BaseStream;
+                        byte[] messageLengthBytes = new byte[sizeof(int)];
+                        int mergedReports = 0;
+                        while (readExactly(output, messageLengthBytes, messageLengthBytes.Length))
+                        {
+                            int messageLength = BitConverter.ToInt32(messageLengthBytes, startIndex: 0);
+                            if (messageLength <= 0)
+                            {
+                                LogError($"The report log merger sent a report of length {messageLength}.");
+                                break;
+                            }
+
+                            PooledObjectWrapper<byte[]> messageBytes = ByteArrayPool.GetInstance(messageLength);
+                            if (!readExactly(output, messageBytes.Instance, messageLength))
+                            {
+                                messageBytes.Dispose();
+                                LogError($"Could not read a merged report of length {messageLength} from the report log merger.");
+                                break;
+                            }
+
+                            ProcessBytes((m_reportProcessors[0], messageBytes, messageLength));
+                            mergedReports++;
+                        }
+
+                        process.WaitForExit();
+                        if (process.ExitCode != 0)
+                        {
+                            LogError($"The report log merger exited with code {process.ExitCode}: {errors.GetAwaiter().GetResult()}. Reports for some file accesses may be missing.");
+                        }
+                        else
+                        {
+                            LogDebug($"Processed {mergedReports} reports from the report logs. {errors.GetAwaiter().GetResult()}");
+                        }
+                    }
+                }
+                catch (Exception e) when (e is IOException || e is Win32Exception || e is BuildXLException)
+                {
+                    LogError($"Could not merge the report logs in '{ReportLogDirectory}'. Exception details: {e}");
+                }
+
+                static bool readExactly(Stream stream, byte[] buffer, int length)
+                {
+                    int totalRead = 0;
+                    while (totalRead < length)
+                    {
+                        int numRead = stream.Read(buffer, totalRead, length - totalRead);
+                        if (numRead <= 0)
+                        {
+                            return false;
+                        }
+
+                        totalRead += numRead;
+                    }
+
+                    return true;
+                }
+            }
+
             private bool IgnoreLinuxSpecificReports(ReportProcessor reportProcessor, ReadOnlySpan<char> path, AccessReport report)
             {
                 // We have an inherent race when we the ptrace sandbox starts tracing a process and we are still interposing that same process.
@@ -734,9 +1172,7 @@ namespace BuildXL.Processes
                 // but also because those are not real files (so hashing those will make bxl crash).
                 // Here we are checking first whether ptrace was requested at least once for this pip just as a minor optimization to avoid path comparisons if ptrace is not even present. 
                 // Something finer-grained could be done as well, but these path comparison operations are probably very cheap to begin with, so it is probably not worth it.
-                if (m_ptraceRunnerWasRequestedForPip &&
-                    (System.MemoryExtensions.Equals(path, reportProcessor.Info.ReportsFifoPath.AsSpan(), StringComparison.Ordinal)
-                    || System.MemoryExtensions.Equals(path, reportProcessor.Info.SecondaryFifoPath.AsSpan(), StringComparison.Ordinal)))
+                if (m_ptraceRunnerWasRequestedForPip && IsReportsFifoPath(path))
                 {
                     return true;
                 }
@@ -751,6 +1187,63 @@ namespace BuildXL.Processes
                 return false;
             }
 
+            private bool IsReportsFifoPath(ReadOnlySpan<char> path)
+            {
+                if (System.MemoryExtensions.Equals(path, SecondaryFifoPath.AsSpan(), StringComparison.Ordinal))
+                {
+                    return true;
+                }
+
+                foreach (var reportProcessor in m_reportProcessors)
+                {
+                    if (System.MemoryExtensions.Equals(path, reportProcessor.GetFifoName().AsSpan(), StringComparison.Ordinal))
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            /// <summary>
+            /// Keeps track of the largest lag between an access being observed and its report being processed.
+            /// </summary>
+            /// <remarks>
+            /// On Linux, <see cref="Stopwatch"/> is backed by CLOCK_MONOTONIC, the same clock the sandbox timestamps reports with.
+            /// </remarks>
+            private void RecordReportLag(ulong observedTimeNs)
+            {
+                Interlocked.Increment(ref m_timestampedReportCount);
+
+                long nowNs = (long)(Stopwatch.GetTimestamp() * s_nanosecondsPerStopwatchTick);
+                long lagNs = nowNs - (long)observedTimeNs;
+                long currentMax;
+                while (lagNs > (currentMax = Interlocked.Read(ref m_maxReportLagNs)))
+                {
+                    if (Interlocked.CompareExchange(ref m_maxReportLagNs, lagNs, currentMax) == currentMax)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            private ulong AssertULong(ReadOnlySpan<char> str)
+            {
+#if NETCOREAPP
+                if (ulong.TryParse(str, out ulong result))
+#else // .NET 472 - no ReadOnlySpan<char> overloads. We don't really care about perf for .NET472 here
+                if (ulong.TryParse(str.ToString(), out ulong result))
+#endif
+                {
+                    return result;
+                }
+                else
+                {
+                    LogError($"Could not parse long from '{str.ToString()}'");
+                    return 0;
+                }
+            }
+
             private uint AssertInt(ReadOnlySpan<char> str)
             {
 #if NETCOREAPP
@@ -780,6 +1273,24 @@ namespace BuildXL.Processes
         /// </summary>
         public const string PTraceRunnerFileName = "ptracerunner";
 
+        /// <summary>
+        /// Name of the observation evaluator file.
+        /// </summary>
+        public const string ObservationEvaluatorFileName = "observationevaluator";
+
+        /// <summary>
+        /// Name of the report log merger file.
+        /// </summary>
+        public const string ReportLogMergeFileName = "report_log_merge";
+
+        /// <summary>
+        /// Suffix of the directory, next to the FAM, the processes of a pip append their report logs to.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/report_log.hpp
+        /// </remarks>
+        public const string ReportLogDirectorySuffix = ".logs";
+
         private readonly ConcurrentDictionary<long, Info> m_pipProcesses = new();
 
         private readonly ManagedFailureCallback m_failureCallback;
@@ -814,6 +1325,12 @@ namespace BuildXL.Processes
             yield return (BuildXLFamPathEnvVarName, famPath);
             yield return ("__BUILDXL_DETOURS_PATH", DetoursLibFile);
             yield return ("LD_PRELOAD", DetoursLibFile + ":" + info.EnvironmentVariables.TryGetValue("LD_PRELOAD", string.Empty));
+
+            if (info.EnvironmentVariables.TryGetValue(BuildXLLibraryAudit, string.Empty) == "1")
+            {
+                yield return (BuildXLAuditPath, AuditLibFile.Value);
+                yield return ("LD_AUDIT", AuditLibFile.Value + ":" + info.EnvironmentVariables.TryGetValue("LD_AUDIT", string.Empty));
+            }
         }
 
         /// <summary>
@@ -829,6 +1346,22 @@ namespace BuildXL.Processes
             return (fifo: fifoPath, secondaryFifo: secondaryFifoPath, fam: famPath);
         }
 
+        /// <summary>
+        /// Upper bound on the number of report channels of a pip.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/report_channels.hpp
+        /// </remarks>
+        public const int MaxReportChannels = 16;
+
+        /// <summary>
+        /// Returns the path of the given report channel. Channel 0 is the reports FIFO, channel N > 0 is that path suffixed with '.N'.
+        /// </summary>
+        /// <remarks>
+        /// CODESYNC: Public/Src/Sandbox/Linux/report_channels.hpp
+        /// </remarks>
+        public static string GetReportChannelPath(string fifoPath, int channel) => channel == 0 ? fifoPath : $"{fifoPath}.{channel}";
+
         /// <inheritdoc />
         public bool NotifyPipStarted(LoggingContext loggingContext, FileAccessManifest fam, SandboxedProcessUnix process) => true;
 
@@ -846,6 +1379,10 @@ namespace BuildXL.Processes
                 fam.EnableLinuxSandboxLogging = true;
             }
 
+            // The native side clamps the count the same way, this just makes sure we create a FIFO for every channel it may write to
+            int reportChannelCount = (int)Math.Min(Math.Max(fam.LinuxSandboxReportChannelCount, 1u), (uint)MaxReportChannels);
+            fam.LinuxSandboxReportChannelCount = (uint)reportChannelCount;
+
             // serialize FAM
             using (var wrapper = Pools.MemoryStreamPool.GetInstance())
             {
@@ -863,8 +1400,11 @@ namespace BuildXL.Processes
 
             process.LogDebug($"Saved FAM to '{famPath}'");
 
-            // create a FIFO (named pipe)
-            createNewFifo(fifoPath);
+            // create a FIFO (named pipe) per report channel
+            for (int i = 0; i < reportChannelCount; i++)
+            {
+                createNewFifo(GetReportChannelPath(fifoPath, i));
+            }
 
             // Secondary fifo is only used by the ptrace sandbox for now
             if (fam.EnableLinuxPTraceSandbox)
@@ -876,8 +1416,22 @@ namespace BuildXL.Processes
                 secondaryFifoPath = string.Empty;
             }
 
+            // The report logs of a previous run of the pip (if it could not clean up) must not be merged into this one
+            string reportLogDirectory = null;
+            if (fam.EnableLinuxSandboxReportLogs)
+            {
+                reportLogDirectory = famPath + ReportLogDirectorySuffix;
+                if (Directory.Exists(reportLogDirectory))
+                {
+                    FileUtilities.DeleteDirectoryContents(reportLogDirectory, deleteRootDirectory: true);
+                }
+
+                FileUtilities.CreateDirectory(reportLogDirectory);
+                process.LogDebug($"Created report log directory at '{reportLogDirectory}'");
+            }
+
             // create and save info for this pip
-            var info = new Info(m_failureCallback, process, fifoPath, secondaryFifoPath, famPath, IsInTestMode);
+            var info = new Info(m_failureCallback, process, fifoPath, secondaryFifoPath, famPath, IsInTestMode, reportChannelCount, fam.EnableLinuxSandboxReportTimestamps, reportLogDirectory);
             if (!m_pipProcesses.TryAdd(process.PipId, info))
             {
                 throw new BuildXLException($"Process with PidId {process.PipId} already exists");
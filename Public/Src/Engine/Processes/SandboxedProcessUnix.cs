@@ -2,6 +2,7 @@
 // Licensed under the MIT License.
 
 using System;
+using System.Collections.Concurrent;
 using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
 using System.Diagnostics.ContractsLight;
@@ -54,6 +55,9 @@ namespace BuildXL.Processes
 
         private readonly LoggingContext m_loggingContext;
 
+        // Values of the backend selection variables (e.g., __BUILDXL_FANOTIFY_BACKEND) set for the pip, passed on to the ptrace runners
+        private readonly List<KeyValuePair<string, string>> m_ptraceRunnerBackends;
+
         private readonly IList<Task<AsyncProcessExecutor>> m_ptraceRunners;
         private readonly TaskSourceSlim<bool> m_ptraceRunnersCancellation = TaskSourceSlim.Create<bool>();
 
@@ -100,8 +104,75 @@ namespace BuildXL.Processes
         /// </summary>
         internal static readonly Lazy<string> PTraceRunnerExecutable = new(() => EnsureDeploymentFile(SandboxConnectionLinuxDetours.PTraceRunnerFileName, setExecuteBit: true));
 
+        /// <summary>
+        /// Path to the observation evaluator to be used for pips running in observe-only mode.
+        /// </summary>
+        internal static readonly Lazy<string> ObservationEvaluatorExecutable = new(() => EnsureDeploymentFile(SandboxConnectionLinuxDetours.ObservationEvaluatorFileName, setExecuteBit: true));
+
+        /// <summary>
+        /// Path to the report log merger to be used for pips whose processes append their reports to logs.
+        /// </summary>
+        internal static readonly Lazy<string> ReportLogMergeExecutable = new(() => EnsureDeploymentFile(SandboxConnectionLinuxDetours.ReportLogMergeFileName, setExecuteBit: true));
+
         private readonly Dictionary<string, PathCacheRecord> m_pathCache; // TODO: use AbsolutePath instead of string
 
+        private readonly ConcurrentDictionary<string, OutputContentHash> m_outputContentHashes = new(StringComparer.Ordinal);
+
+        /// <summary>
+        /// Content hashes the sandbox computed while the pip wrote its files, keyed by path (only populated when output hashing is enabled
+        /// through __BUILDXL_OUTPUT_HASHING). A hash is only meaningful for a declared output whose size and modification time still match.
+        /// </summary>
+        internal IReadOnlyDictionary<string, OutputContentHash> OutputContentHashes => m_outputContentHashes;
+
+        private readonly ConcurrentDictionary<string, ClosedOutput> m_closedOutputs = new(StringComparer.Ordinal);
+
+        /// <summary>
+        /// Outputs the pip is done writing while it keeps running, keyed by path (only populated when output close notifications are enabled
+        /// through __BUILDXL_OUTPUT_CLOSE_NOTIFICATIONS), so they can be processed before the pip exits. An output leaves this set as soon as
+        /// it is written again.
+        /// </summary>
+        internal IReadOnlyDictionary<string, ClosedOutput> ClosedOutputs => m_closedOutputs;
+
+        /// <summary>
+        /// How input prefetching went for this pip, if the root process prefetched the inputs listed in <see cref="FileAccessManifest.LinuxSandboxInputPrefetchList"/>.
+        /// </summary>
+        internal InputPrefetchStatistics? PrefetchStatistics { get; private set; }
+
+        /// <summary>
+        /// Where the files the pip read go once it is done, for the next run of the pip to prefetch (see <see cref="FileAccessManifest.LinuxSandboxInputPrefetchList"/>).
+        /// Null if the pip does not prefetch its inputs.
+        /// </summary>
+        private readonly string? m_inputPrefetchList;
+
+        /// <summary>
+        /// The existing files the pip read, in the order it first read them. Only populated when <see cref="m_inputPrefetchList"/> is set.
+        /// </summary>
+        private readonly List<string>? m_inputsRead;
+
+        /// <summary>
+        /// Per pid, how many times the sandbox started holding summarized accesses (OpAccessSummaryHeld) minus how many times it sent them
+        /// (OpAccessSummaryFlushed). Only populated when <see cref="FileAccessManifest.EnableLinuxSandboxAccessSummary"/> is set. The markers of
+        /// a pid may be sent by different threads, so only the count once all reports are processed is meaningful: a pid left with held accesses
+        /// died before it could send them.
+        /// </summary>
+        private readonly ConcurrentDictionary<int, int> m_heldAccessSummaries = new();
+
+        /// <summary>
+        /// Whether a process died while holding summarized accesses that never reached this side, so the reported accesses may be incomplete.
+        /// </summary>
+        /// <remarks>
+        /// A pip that is killed is not checked: none of its processes get to send what they hold, and it fails regardless.
+        /// </remarks>
+        internal bool LostSummarizedAccesses => !Killed && m_heldAccessSummaries.Any(entry => entry.Value > 0);
+
+        private readonly ConcurrentDictionary<string, IoVolume> m_ioVolumes = new(StringComparer.Ordinal);
+
+        /// <summary>
+        /// How much the pip read from and wrote to each file, and how long it spent doing so, summed over all of its processes (only populated
+        /// when I/O accounting is enabled through __BUILDXL_IO_ACCOUNTING).
+        /// </summary>
+        internal IReadOnlyDictionary<string, IoVolume> IoVolumes => m_ioVolumes;
+
         internal static string GetDeploymentFileFullPath(string relativePath)
         {
             var deploymentDir = Path.GetDirectoryName(AssemblyHelper.GetThisProgramExeLocation()) ?? string.Empty;
@@ -148,6 +219,12 @@ namespace BuildXL.Processes
             m_loggingContext = info.LoggingContext;
             m_ptraceRunners = new List<Task<AsyncProcessExecutor>>();
             m_pathCache = new Dictionary<string, PathCacheRecord>();
+            m_inputPrefetchList = info.FileAccessManifest.LinuxSandboxInputPrefetchList;
+            m_inputsRead = m_inputPrefetchList != null ? new List<string>() : null;
+            m_ptraceRunnerBackends = new[] { SandboxConnectionLinuxDetours.BuildXLEbpfBackend, SandboxConnectionLinuxDetours.BuildXLFanotifyBackend }
+                .Select(name => new KeyValuePair<string, string>(name, info.EnvironmentVariables.TryGetValue(name, string.Empty)))
+                .Where(backend => !string.IsNullOrEmpty(backend.Value))
+                .ToList();
 
             if (info.MonitoringConfig is not null && info.MonitoringConfig.MonitoringEnabled)
             {
@@ -313,6 +390,9 @@ namespace BuildXL.Processes
         /// <inheritdoc />
         protected override bool Killed => Interlocked.Read(ref m_processKilledFlag) > 0;
 
+        /// <inheritdoc />
+        protected override bool HasSandboxFailures => base.HasSandboxFailures || LostSummarizedAccesses;
+
         /// <inheritdoc />
         protected override async Task KillAsyncInternal(bool dumpProcessTree)
         {
@@ -366,6 +446,11 @@ namespace BuildXL.Processes
             // in any case must wait for pending reports to complete, because we must not freeze m_reports before that happens
             await m_pendingReports.Completion;
 
+            if (!Killed)
+            {
+                await SaveInputPrefetchListAsync();
+            }
+
             // at this point this pip is done executing (it's only left to construct SandboxedProcessResult,
             // which is done by the base class) so notify the sandbox connection about it.
             SandboxConnection.NotifyPipFinished(PipId, this);
@@ -674,20 +759,54 @@ namespace BuildXL.Processes
                 // TODO: check if the tests are over specified because in practice BuildXL doesn't really rely much on the outcome of this check
                 var reportPath = report.DecodePath();
 
-                if (m_reports.GetMessageCountSemaphore() != null && ShouldCountReportType(report.Operation) && report.UnexpectedReport == 0)
+                ConsumeMessageCount(report, reportPath);
+
+                // Output hashes are not accesses: the write that produced the file was already reported
+                if (report.Operation == FileOperation.OpOutputContentHash)
                 {
-                    try
-                    {
-                        m_reports.GetMessageCountSemaphore().WaitOne(0);
-                    }
-                    catch (Exception e)
-                    {
-                        // Semaphore was zero.
-                        // We should not have to wait to be unblocked because the native side should have incremented
-                        // the semaphore as soon as it sent a message.
-                        // For now we don't consider this a failure, but in the future this should become a failure
-                        LogDebug($"[Pip{PipId}] Message counting semaphore mismatch for pid '{report.Pid}' with reported path '{reportPath}' with exception {e}");
-                    }
+                    HandleOutputContentHash(reportPath);
+                    return;
+                }
+
+                if (report.Operation == FileOperation.OpInputPrefetchStatistics)
+                {
+                    HandleInputPrefetchStatistics(reportPath);
+                    return;
+                }
+
+                if (report.Operation == FileOperation.OpOutputClosed)
+                {
+                    HandleOutputClosed(reportPath);
+                    return;
+                }
+
+                // I/O volumes are not accesses: the file was reported when it was opened
+                if (report.Operation == FileOperation.OpIoVolume)
+                {
+                    HandleIoVolume(reportPath);
+                    return;
+                }
+
+                // The summarized accesses themselves are reported as regular accesses
+                if (report.Operation == FileOperation.OpAccessSummaryHeld || report.Operation == FileOperation.OpAccessSummaryFlushed)
+                {
+                    int delta = report.Operation == FileOperation.OpAccessSummaryHeld ? 1 : -1;
+                    m_heldAccessSummaries.AddOrUpdate(report.Pid, delta, (_, count) => count + delta);
+                    return;
+                }
+
+                // A closed output is open for writing again, either by the process that closed it or by another one (whose first write is
+                // always reported). This must happen before the path cache is checked.
+                if (!m_closedOutputs.IsEmpty
+                    && (report.Operation == FileOperation.OpOutputReopened || ((RequestedAccess)report.RequestedAccess).HasFlag(RequestedAccess.Write))
+                    && m_closedOutputs.TryRemove(reportPath, out _))
+                {
+                    LogDebug($"Output reopened for writing: '{reportPath}'");
+                }
+
+                if (report.Operation == FileOperation.OpOutputReopened)
+                {
+                    return;
                 }
 
                 // ignore accesses to libDetours.so, because we injected that library
@@ -707,7 +826,19 @@ namespace BuildXL.Processes
                     && report.Operation != FileOperation.OpProcessCommandLine)
                 {
                     // check the path cache (only when the message is not about process tree)                        
-                    if (GetOrCreateCacheRecord(reportPath).CheckCacheHitAndUpdate((RequestedAccess)report.RequestedAccess))
+                    var cacheRecord = GetOrCreateCacheRecord(reportPath);
+
+                    // A file the pip wrote before reading it is one of its own outputs: only files it read first are worth prefetching
+                    if (m_inputsRead != null
+                        && report.IsDirectory == 0
+                        && report.Error == 0
+                        && ((RequestedAccess)report.RequestedAccess).HasFlag(RequestedAccess.Read)
+                        && !cacheRecord.RequestedAccess.HasFlag(RequestedAccess.Read))
+                    {
+                        m_inputsRead.Add(reportPath);
+                    }
+
+                    if (cacheRecord.CheckCacheHitAndUpdate((RequestedAccess)report.RequestedAccess))
                     {
                         LogDebug($"Cache hit for access report: ({reportPath}, {(RequestedAccess)report.RequestedAccess})");
                         return;
@@ -799,6 +930,161 @@ namespace BuildXL.Processes
             }
         }
 
+        /// <summary>
+        /// Replaces the input prefetch list with what this run of the pip read. The list is written next to the old one and moved over it,
+        /// so the next run never prefetches half of it.
+        /// </summary>
+        private async Task SaveInputPrefetchListAsync()
+        {
+            if (m_inputPrefetchList == null)
+            {
+                return;
+            }
+
+            string pendingList = I($"{m_inputPrefetchList}.{ProcessId}");
+            try
+            {
+                File.WriteAllLines(pendingList, m_inputsRead!);
+                await FileUtilities.MoveFileAsync(pendingList, m_inputPrefetchList, replaceExisting: true);
+            }
+            catch (Exception e) when (e is IOException || e is UnauthorizedAccessException || e is BuildXLException)
+            {
+                // The next run just prefetches what the previous list says, if anything
+                LogDebug($"Could not save the input prefetch list '{m_inputPrefetchList}': {e.Message}");
+            }
+        }
+
+        private void HandleOutputContentHash(string reportData)
+        {
+            // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.cpp (report_output_hash)
+            // <size>|<mtime in ns>|<hash type>:<hash>|<path>. The path goes last since it may contain the separator.
+            var parts = reportData.Split(new[] { '|' }, 4);
+            if (parts.Length != 4 || !long.TryParse(parts[0], out long size) || !long.TryParse(parts[1], out long mtimeNs))
+            {
+                LogDebug($"Malformed output content hash report: '{reportData}'");
+                return;
+            }
+
+            // The last close of a file wins: an earlier hash for the same path describes content that was since replaced
+            m_outputContentHashes[parts[3]] = new OutputContentHash(size, mtimeNs, parts[2]);
+        }
+
+        private void HandleOutputClosed(string reportData)
+        {
+            // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.cpp (report_output_closed)
+            // <size>|<mtime in ns>|<path>. The path goes last since it may contain the separator.
+            var parts = reportData.Split(new[] { '|' }, 3);
+            if (parts.Length != 3 || !long.TryParse(parts[0], out long size) || !long.TryParse(parts[1], out long mtimeNs))
+            {
+                LogDebug($"Malformed output closed report: '{reportData}'");
+                return;
+            }
+
+            m_closedOutputs[parts[2]] = new ClosedOutput(size, mtimeNs);
+        }
+
+        private void HandleIoVolume(string reportData)
+        {
+            // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.cpp (report_io_volumes)
+            // <bytes read>|<bytes written>|<reads>|<writes>|<read ns>|<write ns>|<path>. The path goes last since it may contain the separator.
+            var parts = reportData.Split(new[] { '|' }, 7);
+            if (parts.Length != 7
+                || !long.TryParse(parts[0], out long bytesRead)
+                || !long.TryParse(parts[1], out long bytesWritten)
+                || !long.TryParse(parts[2], out long reads)
+                || !long.TryParse(parts[3], out long writes)
+                || !long.TryParse(parts[4], out long readNs)
+                || !long.TryParse(parts[5], out long writeNs))
+            {
+                LogDebug($"Malformed I/O volume report: '{reportData}'");
+                return;
+            }
+
+            // Each process reports its own volume for a path when it exits (or execs)
+            var volume = new IoVolume(bytesRead, bytesWritten, reads, writes, readNs, writeNs);
+            m_ioVolumes.AddOrUpdate(parts[6], volume, (_, existing) => existing.Add(volume));
+        }
+
+        private void HandleInputPrefetchStatistics(string reportData)
+        {
+            // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.cpp (report_input_prefetch_statistics)
+            // <listed>|<prefetched>|<missing>|<bytes>|<elapsed ms>|<completed>|<list path>
+            var parts = reportData.Split(new[] { '|' }, 7);
+            if (parts.Length != 7
+                || !long.TryParse(parts[0], out long listed)
+                || !long.TryParse(parts[1], out long prefetched)
+                || !long.TryParse(parts[2], out long missing)
+                || !long.TryParse(parts[3], out long bytes)
+                || !long.TryParse(parts[4], out long elapsedMs))
+            {
+                LogDebug($"Malformed input prefetch statistics report: '{reportData}'");
+                return;
+            }
+
+            // The root process reports when it exits, so by now the path cache holds (almost) every path the pip read.
+            // A hit is a listed path the pip read, a miss is a path the pip read that was not listed.
+            var listedPaths = new HashSet<string>(StringComparer.Ordinal);
+            try
+            {
+                foreach (var line in File.ReadLines(parts[6]))
+                {
+                    if (line.Length > 0)
+                    {
+                        listedPaths.Add(line);
+                    }
+                }
+            }
+            catch (Exception e) when (e is IOException || e is UnauthorizedAccessException)
+            {
+                LogDebug($"Could not read the input prefetch list '{parts[6]}': {e.Message}");
+            }
+
+            long hits = 0;
+            long misses = 0;
+            foreach (var kvp in m_pathCache)
+            {
+                if (!kvp.Value.RequestedAccess.HasFlag(RequestedAccess.Read))
+                {
+                    continue;
+                }
+
+                if (listedPaths.Contains(kvp.Key))
+                {
+                    hits++;
+                }
+                else
+                {
+                    misses++;
+                }
+            }
+
+            PrefetchStatistics = new InputPrefetchStatistics(listed, prefetched, missing, bytes, elapsedMs, parts[5] == "1", hits, misses);
+            LogProcessState($"Input prefetch: {PrefetchStatistics}");
+        }
+
+        /// <summary>
+        /// Accounts for a report on the message counting semaphore. Reports that are not posted (e.g., observations, which are handed
+        /// to the observation evaluator instead) must be accounted for by the caller.
+        /// </summary>
+        internal void ConsumeMessageCount(AccessReport report, string reportPath)
+        {
+            if (m_reports.GetMessageCountSemaphore() != null && ShouldCountReportType(report.Operation) && report.UnexpectedReport == 0)
+            {
+                try
+                {
+                    m_reports.GetMessageCountSemaphore().WaitOne(0);
+                }
+                catch (Exception e)
+                {
+                    // Semaphore was zero.
+                    // We should not have to wait to be unblocked because the native side should have incremented
+                    // the semaphore as soon as it sent a message.
+                    // For now we don't consider this a failure, but in the future this should become a failure
+                    LogDebug($"[Pip{PipId}] Message counting semaphore mismatch for pid '{report.Pid}' with reported path '{reportPath}' with exception {e}");
+                }
+            }
+        }
+
         private bool ShouldCountReportType(FileOperation op)
         {
             // CODESYNC: Public/Src/Sandbox/Linux/bxl_observer.cpp
@@ -953,6 +1239,10 @@ namespace BuildXL.Processes
             process.StartInfo.Environment[SandboxConnectionLinuxDetours.BuildXLFamPathEnvVarName] = paths.fam;
             process.StartInfo.Environment[SandboxConnectionLinuxDetours.BuildXLTracedProcessPid] = pid.ToString();
             process.StartInfo.Environment[SandboxConnectionLinuxDetours.BuildXLTracedProcessPath] = path;
+            foreach (var backend in m_ptraceRunnerBackends)
+            {
+                process.StartInfo.Environment[backend.Key] = backend.Value;
+            }
 
             var ptraceRunner = new AsyncProcessExecutor
             (
@@ -1023,6 +1313,38 @@ namespace BuildXL.Processes
         }
 
         #region HelperClasses
+        /// <summary>
+        /// The content hash of a file as it was written by a pip, along with the size and modification time (in ns) the file had when it was closed.
+        /// </summary>
+        internal readonly record struct OutputContentHash(long Size, long ModificationTimeNs, string Hash);
+
+        /// <summary>
+        /// The size and modification time (in ns) of an output right after the pip closed it.
+        /// </summary>
+        internal readonly record struct ClosedOutput(long Size, long ModificationTimeNs);
+
+        /// <summary>
+        /// What a pip read from and wrote to a file: bytes, number of calls, and the time (in ns) spent in those calls.
+        /// </summary>
+        internal readonly record struct IoVolume(long BytesRead, long BytesWritten, long Reads, long Writes, long ReadNs, long WriteNs)
+        {
+            internal IoVolume Add(IoVolume other) => new(
+                BytesRead + other.BytesRead,
+                BytesWritten + other.BytesWritten,
+                Reads + other.Reads,
+                Writes + other.Writes,
+                ReadNs + other.ReadNs,
+                WriteNs + other.WriteNs);
+        }
+
+        /// <summary>
+        /// Statistics of input prefetching for a pip: how much of the list the sandbox went through before the root process exited
+        /// (<paramref name="Listed"/>, <paramref name="Prefetched"/>, <paramref name="Missing"/>, <paramref name="Bytes"/>, <paramref name="ElapsedMs"/>, <paramref name="Completed"/>),
+        /// and how it compares with what the pip read: <paramref name="Hits"/> are listed paths the pip read, <paramref name="Misses"/> are paths the pip read that were not listed.
+        /// Listed paths the pip didn't read are Listed - Hits.
+        /// </summary>
+        internal readonly record struct InputPrefetchStatistics(long Listed, long Prefetched, long Missing, long Bytes, long ElapsedMs, bool Completed, long Hits, long Misses);
+
         internal sealed class PathCacheRecord
         {
             internal RequestedAccess RequestedAccess { get; set; }
@@ -35,7 +35,10 @@ namespace Test.BuildXL.Processes.Detours
                     IgnoreCodeCoverage = false,
                     ReportFileAccesses = false,
                     ReportUnexpectedFileAccesses = false,
-                    MonitorChildProcesses = false
+                    MonitorChildProcesses = false,
+                    LinuxSandboxUnmonitoredExecutables = new[] { "/usr/bin/tool", "helper|E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855" },
+                    LinuxSandboxInputPrefetchList = "/cache/LinuxSandbox/InputPrefetch/Pip0123456789ABCDEF",
+                    LinuxSandboxResolutionSnapshot = "/cache/LinuxSandbox/ResolutionSnapshot/Pip0123456789ABCDEF",
                 };
 
             var vac = new ValidationDataCreator(fam, pt);
@@ -159,6 +162,14 @@ namespace Test.BuildXL.Processes.Detours
                 }
 
                 XAssert.AreEqual(info.CreateSandboxTraceFile, readInfo.CreateSandboxTraceFile);
+
+                if (OperatingSystemHelper.IsLinuxOS)
+                {
+                    // Only the Linux sandbox block carries the unmonitored executables, the input prefetch list and the resolution snapshot
+                    XAssert.ArrayEqual(fam.LinuxSandboxUnmonitoredExecutables.ToArray(), readInfo.FileAccessManifest.LinuxSandboxUnmonitoredExecutables.ToArray());
+                    XAssert.AreEqual(fam.LinuxSandboxInputPrefetchList, readInfo.FileAccessManifest.LinuxSandboxInputPrefetchList);
+                    XAssert.AreEqual(fam.LinuxSandboxResolutionSnapshot, readInfo.FileAccessManifest.LinuxSandboxResolutionSnapshot);
+                }
             }
         }
 
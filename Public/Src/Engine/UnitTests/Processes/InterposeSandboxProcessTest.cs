@@ -1,6 +1,7 @@
 ﻿// Copyright (c) Microsoft Corporation.
 // Licensed under the MIT License.
 
+using System;
 using System.Collections.Generic;
 using System.IO;
 using System.Linq;
@@ -126,7 +127,187 @@ namespace Test.BuildXL.Processes
             RunTest("observer_utilities_test");
         }
 
-        private SandboxedProcessResult RunTest(string testExeName, TempFileStorage? workingDirectoryStorage = null)
+        [Fact]
+        public void CallBoostReportChannelsTests()
+        {
+            RunTest("report_channels_test");
+        }
+
+        [Fact]
+        public void CallBoostReportLagTests()
+        {
+            RunTest("report_lag_test");
+        }
+
+        [Fact]
+        public void CallBoostFirstWriteRegistryTests()
+        {
+            RunTest("first_write_registry_test");
+        }
+
+        [Fact]
+        public void CallBoostReportLogTests()
+        {
+            RunTest("report_log_test");
+        }
+
+        [Fact]
+        public void CallBoostAccessSummaryTests()
+        {
+            RunTest("access_summary_test");
+        }
+
+        [Fact]
+        public void CallBoostPathCanonicalizerTests()
+        {
+            RunTest("path_canonicalizer_test");
+        }
+
+        [Fact]
+        public void CallBoostSymlinkFreeCheckTests()
+        {
+            RunTest("symlink_free_check_test");
+        }
+
+        [Fact]
+        public void CallBoostNativeRealpathTests()
+        {
+            RunTest("native_realpath_test");
+        }
+
+        [Fact]
+        public void CallBoostProcessTreeTrackerTests()
+        {
+            RunTest("process_tree_tracker_test");
+        }
+
+        [Fact]
+        public void CallBoostAccessCacheTests()
+        {
+            RunTest("access_cache_test");
+        }
+
+        [Fact]
+        public void CallBoostReportLineTests()
+        {
+            RunTest("report_line_test");
+        }
+
+        [Fact]
+        public void CallBoostContentHasherTests()
+        {
+            RunTest("content_hasher_test");
+        }
+
+        [Fact]
+        public void CallBoostOutputHashTrackerTests()
+        {
+            RunTest("output_hash_tracker_test");
+        }
+
+        [Fact]
+        public void CallBoostOutputCloseTrackerTests()
+        {
+            RunTest("output_close_tracker_test");
+        }
+
+        [Fact]
+        public void CallBoostInputPrefetcherTests()
+        {
+            RunTest("input_prefetcher_test");
+        }
+
+        [Fact]
+        public void CallBoostResolutionSnapshotTests()
+        {
+            RunTest("resolution_snapshot_test");
+        }
+
+        [Fact]
+        public void CallBoostSyscallTableTests()
+        {
+            RunTest("syscall_table_test");
+        }
+
+        [Fact]
+        public void CallBoostUnmonitoredExecutablesTests()
+        {
+            RunTest("unmonitored_executables_test");
+        }
+
+        [Fact]
+        public void CallBoostFanotifyEventsTests()
+        {
+            RunTest("fanotify_events_test");
+        }
+
+        [Fact]
+        public void CallBoostEbpfProgramsTests()
+        {
+            RunTest("ebpf_programs_test");
+        }
+
+        [Fact]
+        public void CallBoostIoVolumeTrackerTests()
+        {
+            RunTest("io_volume_tracker_test");
+        }
+
+        [Fact]
+        public void CallBoostCopyEngineTests()
+        {
+            RunTest("copy_engine_test");
+        }
+
+        [Fact]
+        public void CallBoostLibraryAuditTests()
+        {
+            RunTest("library_audit_test");
+        }
+
+        [Fact]
+        [Trait("Category", "Performance")]
+        public void CallInterpositionBenchmark()
+        {
+            // Only prints throughput numbers, so it is excluded from regular test runs
+            var result = RunTest("interposition_benchmark", arguments: new[] { "--", "--max-threads=32", "--iterations=100" });
+            TestOutput.WriteLine(result.StandardOutput.ReadValueAsync().Result);
+        }
+
+        [Fact]
+        public void CallInterpositionBenchmarkUnderThreadSanitizer()
+        {
+            // This one runs by default: the benchmark is only a multithreaded workload for ThreadSanitizer, which fails the process
+            // (exit code 66, which RunTest asserts against) if it finds a data race in the sandbox or in the benchmark
+            var detours = Path.Combine(TestBinRoot, "LinuxTestProcesses", "libDetoursTsan.so");
+            var result = RunTest("interposition_benchmark_tsan", arguments: new[] { "--", $"--detours={detours}", "--max-threads=16", "--iterations=50" });
+
+            // A race fails the test even if the environment tells ThreadSanitizer not to fail the process for it
+            var stderr = result.StandardError.ReadValueAsync().Result;
+            XAssert.IsFalse(stderr.Contains("WARNING: ThreadSanitizer"), stderr);
+        }
+
+        [Fact]
+        [Trait("Category", "Performance")]
+        public void CallCopyEngineBenchmark()
+        {
+            // Only prints copy throughput numbers, so it is excluded from regular test runs
+            var result = RunTest("copy_engine_benchmark", arguments: new[] { "--", "--max-size=16M", "--min-bytes=64M" });
+            TestOutput.WriteLine(result.StandardOutput.ReadValueAsync().Result);
+        }
+
+        [Fact]
+        [Trait("Category", "Performance")]
+        public void CallLibraryAuditBenchmark()
+        {
+            // Startup cost of the audit module: the benchmark starts a program with and without it. Only prints timings, so it is
+            // excluded from regular test runs
+            var audit = SandboxConnectionLinuxDetours.AuditLibFile.Value;
+            var result = RunTest("library_audit_benchmark", arguments: new[] { "--", $"--audit={audit}", "--iterations=100" });
+            TestOutput.WriteLine(result.StandardOutput.ReadValueAsync().Result);
+        }
+
+        private SandboxedProcessResult RunTest(string testExeName, TempFileStorage? workingDirectoryStorage = null, string[]? arguments = null)
         {
             var testExecutable = FileArtifact.CreateSourceFile(AbsolutePath.Create(Context.PathTable, Path.Combine(TestBinRoot, "LinuxTestProcesses", testExeName)));
             XAssert.IsTrue(File.Exists(testExecutable.Path.ToString(Context.PathTable)), $"Test executable '{testExecutable.Path.ToString(Context.PathTable)}' not found.");
@@ -135,7 +316,12 @@ namespace Test.BuildXL.Processes
             using (workingDirectoryStorage)
             {
                 var workingDirectoryAbsolutePath = AbsolutePath.Create(Context.PathTable, workingDirectoryStorage.RootDirectory);
-                var arguments = new PipDataBuilder(Context.PathTable.StringTable);
+                var pipArguments = new PipDataBuilder(Context.PathTable.StringTable);
+                foreach (var argument in arguments ?? Array.Empty<string>())
+                {
+                    pipArguments.Add(argument);
+                }
+
                 var allDependencies = new List<FileArtifact> { testExecutable };
                 var allOutputs = new List<FileArtifactWithAttributes>(1);
 
@@ -145,7 +331,7 @@ namespace Test.BuildXL.Processes
                 var pip = new Process(
                     testExecutable,
                     workingDirectoryAbsolutePath,
-                    arguments.ToPipData(" ", PipDataFragmentEscaping.NoEscaping),
+                    pipArguments.ToPipData(" ", PipDataFragmentEscaping.NoEscaping),
                     FileArtifact.Invalid,
                     PipData.Invalid,
                     ReadOnlyArray<EnvironmentVariable>.Empty,
@@ -177,7 +363,7 @@ namespace Test.BuildXL.Processes
 
                 var result = RunProcess(processInfo).Result;
 
-                XAssert.AreEqual(result.ExitCode, 0);
+                XAssert.AreEqual(0, result.ExitCode, $"stdout: {result.StandardOutput.ReadValueAsync().Result}{Environment.NewLine}stderr: {result.StandardError.ReadValueAsync().Result}");
 
                 return result;
             }
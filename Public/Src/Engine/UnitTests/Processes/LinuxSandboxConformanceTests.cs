@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using BuildXL.Processes;
+using BuildXL.Utilities.Core;
+using Test.BuildXL.TestUtilities.Xunit;
+using Xunit;
+using Xunit.Abstractions;
+
+namespace Test.BuildXL.Processes
+{
+    /// <summary>
+    /// Runs every syscall test of the native test process (see syscalltests.hpp) under the interposition sandbox and under another backend,
+    /// and checks that both report the same file accesses.
+    /// </summary>
+    /// <remarks>
+    /// The tests are the ones the test process lists with '-l', so a syscall test added to the test process is checked here without any
+    /// change on the managed side. Reports are compared on their operation, their path (only for paths under the working directory of the test,
+    /// or the test process itself, the rest is loader noise that depends on how each backend starts the process), and whether the access
+    /// succeeded. The error codes themselves are not compared: interposition reports errno, while the other backends derive it from the return
+    /// value of the syscall. Divergences fail the test unless they are in <see cref="s_allowedDivergences"/>. The output is a table with one row
+    /// per syscall and the wall-clock time of each run, as a rough measure of the overhead of each backend.
+    /// </remarks>
+    [TestClassIfSupported(requiresLinuxBasedOperatingSystem: true)]
+    public sealed class LinuxSandboxConformanceTests : LinuxSandboxProcessTestsBase
+    {
+        private const string Interpose = "interpose";
+        private const string PTrace = "ptrace";
+        private const string Ebpf = "ebpf";
+
+        private const string TestPrefix = "Test";
+        private const string AnySyscall = "*";
+        private const string RootToken = "{root}";
+        private const string ExeToken = "{exe}";
+
+        /// <summary>
+        /// Divergences that are expected: backend -> (syscall or <see cref="AnySyscall"/>, operation) -> why.
+        /// </summary>
+        /// <remarks>
+        /// Every entry must say why the backend can't report what interposition does. Keep this as short as possible: a divergence that
+        /// is not listed here is a bug in one of the backends.
+        /// </remarks>
+        private static readonly Dictionary<string, Dictionary<(string syscall, ReportedFileOperation operation), string>> s_allowedDivergences = new()
+        {
+            [PTrace] = GetSyscallTracerDivergences(),
+            [Ebpf] = GetSyscallTracerDivergences(),
+        };
+
+        /// <summary>
+        /// What a backend that observes syscalls (rather than libc calls) can't report the way interposition does.
+        /// </summary>
+        private static Dictionary<(string syscall, ReportedFileOperation operation), string> GetSyscallTracerDivergences()
+        {
+            const string FopenMode = "interposition classifies fopen from its mode string ('rw' contains a 'w'), the backend from the flags libc passes to openat, which have no O_CREAT or O_TRUNC";
+            const string LibcFstat = "libc fstat()s the descriptor internally (stdio buffers, opendir): a syscall, not a call interposition sees";
+            const string OpenDir = "the backend sees the openat(O_DIRECTORY) behind opendir";
+            const string ReadDir = "interposition reports the enumeration of the directory, getdents is not traced";
+            const string MissingTestFile = "the test first unlinks and probes a test file that doesn't exist, and the backend reports both when the syscall is made, before it fails";
+
+            var divergences = new Dictionary<(string syscall, ReportedFileOperation operation), string>
+            {
+                [(AnySyscall, ReportedFileOperation.ProcessRequiresPTrace)] = "this is how the process is handed over to the backend",
+                [("fdopen", ReportedFileOperation.KAuthVNodeWrite)] = "fdopen doesn't open anything, only interposition sees its mode string",
+                [("fread", ReportedFileOperation.KAuthVNodeProbe)] = LibcFstat,
+                [("fputs", ReportedFileOperation.KAuthVNodeProbe)] = LibcFstat,
+                [("fputs", ReportedFileOperation.KAuthReadFile)] = FopenMode,
+                [("realpath", ReportedFileOperation.KAuthVNodeProbe)] = "realpath(\"./\") only calls getcwd, the backend sees no syscall on the path",
+                [("mknod", ReportedFileOperation.KAuthDeleteFile)] = MissingTestFile,
+                [("mknod", ReportedFileOperation.MacLookup)] = MissingTestFile,
+            };
+
+            foreach (var syscall in new[] { "fopen", "fopen64", "fwrite", "fputc", "putc" })
+            {
+                divergences[(syscall, ReportedFileOperation.KAuthVNodeWrite)] = FopenMode;
+                divergences[(syscall, ReportedFileOperation.KAuthReadFile)] = FopenMode;
+            }
+
+            foreach (var syscall in new[] { "fprintf", "vfprintf", "dprintf", "vdprintf" })
+            {
+                divergences[(syscall, ReportedFileOperation.KAuthVNodeProbe)] = LibcFstat;
+            }
+
+            foreach (var syscall in new[] { "opendir", "closedir", "readdir", "readdir64", "readdir_r", "readdir64_r", "scandir", "scandir64", "scandirat", "scandirat64" })
+            {
+                divergences[(syscall, ReportedFileOperation.KAuthOpenDir)] = OpenDir;
+                divergences[(syscall, ReportedFileOperation.KAuthVNodeRead)] = ReadDir;
+                divergences[(syscall, ReportedFileOperation.KAuthVNodeProbe)] = LibcFstat;
+            }
+
+            return divergences;
+        }
+
+        public LinuxSandboxConformanceTests(ITestOutputHelper output)
+            : base(output)
+        {
+        }
+
+        [Theory]
+        [InlineData(PTrace)]
+        [InlineData(Ebpf)]
+        public void BackendReportsMatchInterposition(string backend)
+        {
+            if (backend == Ebpf && !CurrentProcess.IsElevated)
+            {
+                // Loading eBPF programs requires CAP_BPF and CAP_PERFMON: the runner would silently fall back to ptrace
+                TestOutput.WriteLine("Skipping the eBPF backend: the test is not running as root");
+                return;
+            }
+
+            var allowed = s_allowedDivergences[backend];
+            var failures = new List<string>();
+            var totalTime = new Dictionary<string, TimeSpan> { [Interpose] = TimeSpan.Zero, [backend] = TimeSpan.Zero };
+
+            TestOutput.WriteLine($"{"Syscall",-20} {"Reports",9} {"Ignored",9} {"Only " + Interpose,14} {"Only " + backend,14} {Interpose + " ms",12} {backend + " ms",12} {"Overhead",9}");
+            foreach (var test in ListNativeTests())
+            {
+                string syscall = test.Substring(TestPrefix.Length);
+                var expected = Run(test, Interpose);
+                var actual = Run(test, backend);
+                totalTime[Interpose] += expected.time;
+                totalTime[backend] += actual.time;
+
+                var onlyExpected = expected.accesses.Except(actual.accesses).ToList();
+                var onlyActual = actual.accesses.Except(expected.accesses).ToList();
+
+                TestOutput.WriteLine($"{syscall,-20} {expected.accesses.Count + "/" + actual.accesses.Count,9} {expected.ignored + "/" + actual.ignored,9} {onlyExpected.Count,14} {onlyActual.Count,14} {expected.time.TotalMilliseconds,12:F1} {actual.time.TotalMilliseconds,12:F1} {Overhead(actual.time, expected.time),9}");
+
+                foreach (var (access, reportedBy) in onlyExpected.Select(a => (a, Interpose)).Concat(onlyActual.Select(a => (a, backend))))
+                {
+                    string entry = $"  only {reportedBy}: {access.operation} {access.path} ({(access.succeeded ? "succeeded" : "failed")})";
+                    if (allowed.TryGetValue((syscall, access.operation), out var reason) || allowed.TryGetValue((AnySyscall, access.operation), out reason))
+                    {
+                        TestOutput.WriteLine($"{entry} [allowed: {reason}]");
+                    }
+                    else
+                    {
+                        TestOutput.WriteLine(entry);
+                        failures.Add($"{syscall}:{entry}");
+                    }
+                }
+            }
+
+            TestOutput.WriteLine($"Total: {Interpose} {totalTime[Interpose].TotalMilliseconds:F1} ms, {backend} {totalTime[backend].TotalMilliseconds:F1} ms, overhead {Overhead(totalTime[backend], totalTime[Interpose])}");
+
+            XAssert.IsTrue(failures.Count == 0, $"The {backend} backend diverges from {Interpose} on {failures.Count} report(s):{Environment.NewLine}{string.Join(Environment.NewLine, failures)}");
+        }
+
+        /// <summary>
+        /// The syscall tests of the test process (e.g., 'Teststat'), in the order it lists them.
+        /// </summary>
+        private List<string> ListNativeTests()
+        {
+            var startInfo = new ProcessStartInfo(TestProcessExe, "-l")
+            {
+                RedirectStandardOutput = true,
+                RedirectStandardError = true,
+                UseShellExecute = false,
+            };
+
+            using var testProcess = System.Diagnostics.Process.Start(startInfo);
+            var stderr = testProcess.StandardError.ReadToEndAsync();
+            var tests = testProcess.StandardOutput.ReadToEnd()
+                .Split(new[] { '\n' }, StringSplitOptions.RemoveEmptyEntries)
+                .Select(test => test.Trim())
+                .ToList();
+            testProcess.WaitForExit();
+
+            XAssert.AreEqual(0, testProcess.ExitCode, $"stderr: {stderr.Result}");
+            XAssert.IsTrue(tests.Count > 0 && tests.All(test => test.StartsWith(TestPrefix, StringComparison.Ordinal)), string.Join(", ", tests));
+
+            return tests;
+        }
+
+        private (HashSet<(ReportedFileOperation operation, string path, bool succeeded)> accesses, int ignored, TimeSpan time) Run(string test, string backend)
+        {
+            var environment = backend == Ebpf
+                ? new Dictionary<string, string> { [SandboxConnectionLinuxDetours.BuildXLEbpfBackend] = "1" }
+                : null;
+
+            var stopwatch = Stopwatch.StartNew();
+            var (result, rootDirectory) = RunNativeTest(test, unconditionallyEnableLinuxPTraceSandbox: backend != Interpose, environment: environment);
+            stopwatch.Stop();
+
+            var accesses = new HashSet<(ReportedFileOperation operation, string path, bool succeeded)>();
+            int ignored = 0;
+            foreach (var access in result.FileAccesses)
+            {
+                string path = access.GetPath(Context.PathTable);
+                if (path == TestProcessExe)
+                {
+                    path = ExeToken;
+                }
+                else if (path.StartsWith(rootDirectory, StringComparison.Ordinal))
+                {
+                    path = RootToken + path.Substring(rootDirectory.Length);
+                }
+                else
+                {
+                    ignored++;
+                    continue;
+                }
+
+                accesses.Add((access.Operation, path, access.Error == 0));
+            }
+
+            return (accesses, ignored, stopwatch.Elapsed);
+        }
+
+        private static string Overhead(TimeSpan time, TimeSpan baseline) => baseline.Ticks == 0 ? "-" : $"{(double)time.Ticks / baseline.Ticks:F2}x";
+    }
+}
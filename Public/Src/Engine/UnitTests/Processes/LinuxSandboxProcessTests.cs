@@ -150,5 +150,345 @@ namespace Test.BuildXL.Processes
             AssertLogContains(GetRegex("_readlink", link));
             AssertLogContains(GetRegex("_readlink", fileLink));
         }
+
+        [Fact]
+        public void DlopenChain()
+        {
+            // The native side dlopens libDlopenChain1.so, which dlopens libDlopenChain2.so, which dlopens libDlopenChain3.so.
+            // The loader opens them itself: only the audit module sees them.
+            var result = RunNativeTest(
+                "DlopenChain",
+                environment: new Dictionary<string, string> { [SandboxConnectionLinuxDetours.BuildXLLibraryAudit] = "1" });
+
+            var testProcessDirectory = Path.GetDirectoryName(TestProcessExe);
+            for (int level = 1; level <= 3; level++)
+            {
+                var library = Path.Combine(testProcessDirectory, $"libDlopenChain{level}.so");
+                AssertLogContains(GetRegex("la_objopen", library));
+
+                // Each library is reported once, however many times the loader goes through it
+                var accesses = result.result.FileAccesses.Where(access => access.ManifestPath.ToString(Context.PathTable) == library).ToList();
+                XAssert.AreEqual(1, accesses.Count, $"Unexpected accesses to {library}: {string.Join(", ", accesses.Select(access => access.Operation))}");
+            }
+        }
+
+        [Theory]
+        [InlineData(1, false, false)]
+        [InlineData(4, false, false)]
+        [InlineData(4, true, false)]
+        [InlineData(4, false, true)]
+        public void ProcessTreeOnReportChannels(uint reportChannelCount, bool reportTimestamps, bool reportLogs)
+        {
+            var result = RunNativeTest("ProcessTreeOnReportChannels", reportChannelCount: reportChannelCount, reportTimestamps: reportTimestamps, reportLogs: reportLogs);
+
+            // Every process of the tree reported its write, whatever channel (or report log) it landed on, and the sandbox only completed once all of them were processed.
+            // With report logs, the writes are only processed once the logs are merged, after the process tree is done.
+            for (int child = 0; child < 16; child++)
+            {
+                for (int level = 0; level < 2; level++)
+                {
+                    var path = Path.Combine(result.rootDirectory, $"processTree_{child}_{level}");
+                    XAssert.IsTrue(
+                        result.result.FileAccesses.Any(access => access.ManifestPath.ToString(Context.PathTable) == path && access.RequestedAccess.HasFlag(RequestedAccess.Write)),
+                        $"Missing write access to {path}");
+                }
+            }
+
+        }
+
+        [Theory]
+        [InlineData(false)]
+        [InlineData(true)]
+        public void ObservationsArriveWithReportLogs(bool reportLogs)
+        {
+            // The probe is evaluated by the observation evaluator, which is drained after the report logs are merged: its reports
+            // have to come over the FIFO even when the processes of the pip log theirs
+            var result = RunNativeTest("Teststat", reportLogs: reportLogs, observeOnly: true);
+
+            var path = Path.Combine(result.rootDirectory, "testfile");
+            XAssert.IsTrue(
+                result.result.FileAccesses.Any(access => access.Operation == ReportedFileOperation.KAuthVNodeProbe && access.ManifestPath.ToString(Context.PathTable) == path),
+                $"Missing probe of {path}. Reported accesses:{Environment.NewLine}{string.Join(Environment.NewLine, result.result.FileAccesses.Select(access => $"{access.Operation}:{access.ManifestPath.ToString(Context.PathTable)}"))}");
+        }
+
+        [Fact]
+        public void ObservationsAreEvaluatedLikeInProcessAccesses()
+        {
+            using var tempFiles = new TempFileStorage(canGetFileNames: true);
+            var root = tempFiles.RootDirectory;
+            var allowed = Path.Combine(root, "allowed");
+            var denied = Path.Combine(root, "denied");
+            var other = Path.Combine(root, "other");
+            foreach (var directory in new[] { allowed, denied, other })
+            {
+                Directory.CreateDirectory(Path.Combine(directory, "dir"));
+                File.WriteAllText(Path.Combine(directory, "file"), "content");
+            }
+
+            // The path is the last field of a report line, so it may contain the field separator
+            File.WriteAllText(Path.Combine(allowed, "a|b"), "content");
+
+            var fam = new FileAccessManifest(Context.PathTable)
+            {
+                FailUnexpectedFileAccesses = false,
+                ReportUnexpectedFileAccesses = true,
+                ReportFileAccesses = true,
+                MonitorChildProcesses = true,
+                EnableLinuxSandboxObserveOnly = true,
+            };
+
+            fam.AddScope(AbsolutePath.Invalid, FileAccessPolicy.MaskNothing, FileAccessPolicy.AllowRead | FileAccessPolicy.AllowReadIfNonExistent);
+            fam.AddScope(AbsolutePath.Create(Context.PathTable, allowed), FileAccessPolicy.MaskAll, FileAccessPolicy.AllowRead | FileAccessPolicy.AllowReadIfNonExistent | FileAccessPolicy.ReportAccess);
+            fam.AddScope(AbsolutePath.Create(Context.PathTable, denied), FileAccessPolicy.MaskAll, FileAccessPolicy.ReportAccess);
+
+            var famPath = Path.Combine(root, "fam");
+            using (var stream = new MemoryStream())
+            {
+                var debugFlags = true;
+                var manifestBytes = fam.GetPayloadBytes(
+                    LoggingContext,
+                    new FileAccessSetup { DllNameX64 = string.Empty, DllNameX86 = string.Empty, ReportPath = Path.Combine(root, "reports") },
+                    stream,
+                    timeoutMins: 10,
+                    debugFlagsMatch: ref debugFlags);
+                File.WriteAllBytes(famPath, manifestBytes.ToArray());
+            }
+
+            // CODESYNC: es_event_type_t in Public/Src/Sandbox/Linux/stdafx-linux.h
+            // Every event type the sandbox evaluates out of process (see BxlObserver::IsObservableEvent), plus a few that are always evaluated in-process
+            var observableEventTypes = new[] { 1, 10, 12, 38, 43, 51, 53, 54, 55, 64, 68 };
+            var inProcessEventTypes = new[] { 13, 32, 33 };
+            var accesses = new List<string>();
+            foreach (var eventType in observableEventTypes.Concat(inProcessEventTypes))
+            {
+                foreach (var directory in new[] { allowed, denied, other })
+                {
+                    accesses.Add($"{eventType}|0|{Path.Combine(directory, "file")}");
+                    accesses.Add($"{eventType}|0|{Path.Combine(directory, "dir")}");
+                    accesses.Add($"{eventType}|2|{Path.Combine(directory, "missing")}");
+                }
+
+                accesses.Add($"{eventType}|0|{Path.Combine(allowed, "a|b")}");
+            }
+
+            var streamPath = Path.Combine(root, "stream");
+            File.WriteAllLines(streamPath, accesses);
+
+            // The evaluator replays every access both ways against the same FAM, and fails if any of them produced different reports
+            var startInfo = new System.Diagnostics.ProcessStartInfo(SandboxedProcessUnix.ObservationEvaluatorExecutable.Value, $"--replay \"{streamPath}\"")
+            {
+                RedirectStandardOutput = true,
+                RedirectStandardError = true,
+                UseShellExecute = false,
+            };
+            startInfo.Environment[SandboxConnectionLinuxDetours.BuildXLFamPathEnvVarName] = famPath;
+
+            using var evaluator = System.Diagnostics.Process.Start(startInfo);
+            var stdout = evaluator.StandardOutput.ReadToEndAsync();
+            var stderr = evaluator.StandardError.ReadToEnd();
+            evaluator.WaitForExit();
+
+            XAssert.AreEqual(0, evaluator.ExitCode, $"stdout: {stdout.Result}{Environment.NewLine}stderr: {stderr}");
+            XAssert.Contains(stdout.Result, $"Replayed {accesses.Count} accesses");
+        }
+
+        [Fact]
+        public void OutputContentHashesAreComputedWhileWriting()
+        {
+            RunNativeTest(
+                "WriteOutputs",
+                environment: new Dictionary<string, string> { ["__BUILDXL_OUTPUT_HASHING"] = "SHA256" },
+                outputs: new[] { "outputWrittenOnce", "outputReopened" },
+                verifyProcess: process =>
+                {
+                    var writtenOnce = process.OutputContentHashes.Keys.FirstOrDefault(path => path.EndsWith("/outputWrittenOnce", StringComparison.Ordinal));
+                    XAssert.IsNotNull(writtenOnce, $"Missing hash of outputWrittenOnce. Hashes: {string.Join(", ", process.OutputContentHashes.Keys)}");
+                    var hash = process.OutputContentHashes[writtenOnce];
+                    XAssert.AreEqual(5, hash.Size);
+                    XAssert.AreEqual(Sha256("hello"), hash.Hash);
+
+                    XAssert.AreEqual(new FileInfo(writtenOnce).Length, hash.Size);
+
+                    // Appending to a file that is not empty can't be hashed while writing: what is left is the hash of the first close,
+                    // which the size of the file no longer matches
+                    var reopened = process.OutputContentHashes.Keys.FirstOrDefault(path => path.EndsWith("/outputReopened", StringComparison.Ordinal));
+                    XAssert.IsNotNull(reopened, $"Missing hash of outputReopened. Hashes: {string.Join(", ", process.OutputContentHashes.Keys)}");
+                    XAssert.AreEqual(5, process.OutputContentHashes[reopened].Size);
+                    XAssert.AreEqual(Sha256("hello"), process.OutputContentHashes[reopened].Hash);
+                    XAssert.AreEqual(11, new FileInfo(reopened).Length);
+                });
+        }
+
+        [Fact]
+        public void ClosedOutputsAreReportedInOrder()
+        {
+            RunNativeTest(
+                "WriteOutputs",
+                environment: new Dictionary<string, string> { ["__BUILDXL_OUTPUT_CLOSE_NOTIFICATIONS"] = "1" },
+                outputs: new[] { "outputWrittenOnce", "outputReopened" },
+                verifyProcess: process =>
+                {
+                    var closed = string.Join(", ", process.ClosedOutputs.Select(output => $"{output.Key}:{output.Value.Size}"));
+                    var writtenOnce = process.ClosedOutputs.FirstOrDefault(output => output.Key.EndsWith("/outputWrittenOnce", StringComparison.Ordinal));
+                    var reopened = process.ClosedOutputs.FirstOrDefault(output => output.Key.EndsWith("/outputReopened", StringComparison.Ordinal));
+                    XAssert.IsNotNull(writtenOnce.Key, $"Missing close of outputWrittenOnce. Closed outputs: {closed}");
+                    XAssert.IsNotNull(reopened.Key, $"Missing close of outputReopened. Closed outputs: {closed}");
+
+                    XAssert.AreEqual(5, writtenOnce.Value.Size);
+
+                    // The reopening took the output out of the set before its second close put it back: what is left is the final content
+                    XAssert.AreEqual(11, reopened.Value.Size);
+                    XAssert.AreEqual(new FileInfo(reopened.Key).Length, reopened.Value.Size);
+                    XAssert.IsTrue(reopened.Value.ModificationTimeNs >= writtenOnce.Value.ModificationTimeNs, closed);
+                });
+        }
+
+        [Fact]
+        public void IoVolumesAreAccountedPerPath()
+        {
+            RunNativeTest(
+                "WriteOutputs",
+                environment: new Dictionary<string, string> { ["__BUILDXL_IO_ACCOUNTING"] = "1" },
+                outputs: new[] { "outputWrittenOnce", "outputReopened" },
+                verifyProcess: process =>
+                {
+                    var volumes = string.Join(", ", process.IoVolumes.Select(volume => $"{volume.Key}:{volume.Value}"));
+                    var writtenOnce = process.IoVolumes.FirstOrDefault(volume => volume.Key.EndsWith("/outputWrittenOnce", StringComparison.Ordinal));
+                    var reopened = process.IoVolumes.FirstOrDefault(volume => volume.Key.EndsWith("/outputReopened", StringComparison.Ordinal));
+                    XAssert.IsNotNull(writtenOnce.Key, $"Missing I/O volume of outputWrittenOnce. Volumes: {volumes}");
+                    XAssert.IsNotNull(reopened.Key, $"Missing I/O volume of outputReopened. Volumes: {volumes}");
+
+                    // Written with one call, read back with another one
+                    XAssert.AreEqual(5, writtenOnce.Value.BytesWritten, volumes);
+                    XAssert.AreEqual(1, writtenOnce.Value.Writes, volumes);
+                    XAssert.AreEqual(5, writtenOnce.Value.BytesRead, volumes);
+                    XAssert.AreEqual(1, writtenOnce.Value.Reads, volumes);
+
+                    // Both opens count towards the same path
+                    XAssert.AreEqual(11, reopened.Value.BytesWritten, volumes);
+                    XAssert.AreEqual(2, reopened.Value.Writes, volumes);
+                    XAssert.AreEqual(0, reopened.Value.BytesRead, volumes);
+                    XAssert.AreEqual(0, reopened.Value.Reads, volumes);
+                });
+        }
+
+        [Fact]
+        public void IoVolumesAreNotInheritedAcrossClone()
+        {
+            RunNativeTest(
+                "IoVolumesAcrossClone",
+                environment: new Dictionary<string, string> { ["__BUILDXL_IO_ACCOUNTING"] = "1" },
+                outputs: new[] { "cloneOutput" },
+                verifyProcess: process =>
+                {
+                    var volumes = string.Join(", ", process.IoVolumes.Select(volume => $"{volume.Key}:{volume.Value}"));
+                    var output = process.IoVolumes.FirstOrDefault(volume => volume.Key.EndsWith("/cloneOutput", StringComparison.Ordinal));
+                    XAssert.IsNotNull(output.Key, $"Missing I/O volume of cloneOutput. Volumes: {volumes}");
+
+                    // The parent wrote the file before it cloned: had the child kept the parent's accounting, the write would be reported twice
+                    XAssert.AreEqual(5, output.Value.BytesWritten, volumes);
+                    XAssert.AreEqual(1, output.Value.Writes, volumes);
+                    XAssert.AreEqual(5, output.Value.BytesRead, volumes);
+                    XAssert.AreEqual(1, output.Value.Reads, volumes);
+                });
+        }
+
+        [Theory]
+        [InlineData(false)]
+        [InlineData(true)]
+        public void SummarizedAccessesOfKilledProcessesFailTheSandbox(bool killChild)
+        {
+            var result = RunNativeTest(
+                killChild ? "SummarizedReadInKilledChild" : "SummarizedReadInExitedChild",
+                accessSummary: true,
+                unreportedFiles: new[] { "summaryInput" });
+
+            // Only the child reads the file, and the read only reaches the managed side if the child got to send its summary
+            var summaryInput = Path.Combine(result.rootDirectory, "summaryInput");
+            var read = result.result.FileAccesses.Any(access =>
+                access.ManifestPath.ToString(Context.PathTable) == summaryInput && access.RequestedAccess.HasFlag(RequestedAccess.Read));
+            XAssert.AreEqual(!killChild, read);
+            XAssert.AreEqual(killChild, result.result.HasDetoursInjectionFailures);
+        }
+
+        [Fact]
+        public void ConcurrentFirstWritesToNewFilesAreAllowed()
+        {
+            // Must match the file count of the native test
+            var newOutputs = Enumerable.Range(0, 1000).Select(i => $"concurrentOutput_{i}").ToArray();
+            var result = RunNativeTest("ConcurrentWritesToNewFiles", newOutputs: newOutputs);
+
+            // Every file is created by one of the children while the others are checking whether it existed before the pip: a check
+            // that finds the file another child just created turns an allowed write into a denied one
+            var writes = result.result.FileAccesses
+                .Where(access => Path.GetFileName(access.ManifestPath.ToString(Context.PathTable)).StartsWith("concurrentOutput_", StringComparison.Ordinal)
+                    && access.RequestedAccess.HasFlag(RequestedAccess.Write))
+                .ToList();
+            XAssert.IsTrue(writes.Count >= newOutputs.Length, $"Expected a write for each of the {newOutputs.Length} files, got {writes.Count}");
+
+            var denied = writes.Where(access => access.Status == FileAccessStatus.Denied).Select(access => access.ManifestPath.ToString(Context.PathTable)).Distinct().ToList();
+            XAssert.AreEqual(0, denied.Count, $"Denied writes: {string.Join(", ", denied)}");
+        }
+
+        [Fact]
+        public void InputPrefetchListCarriesOverToTheNextRun()
+        {
+            // The input and the list must outlive the working directory of each run
+            using var state = new TempFileStorage(canGetFileNames: true);
+            var input = Path.Combine(state.RootDirectory, "prefetchInput");
+            var list = Path.Combine(state.RootDirectory, "prefetchList");
+            File.WriteAllText(input, "hello");
+
+            var environment = new Dictionary<string, string> { ["TEST_INPUT"] = input };
+
+            // Nothing to prefetch yet: the first run only leaves the list behind
+            RunNativeTest("ReadInput", environment: environment, unreportedFiles: new[] { input }, inputPrefetchList: list);
+            XAssert.IsTrue(File.Exists(list), "The first run did not save the input prefetch list");
+            XAssert.IsTrue(File.ReadAllLines(list).Contains(input), $"Missing '{input}' in the input prefetch list: {File.ReadAllText(list)}");
+
+            RunNativeTest(
+                "ReadInput",
+                environment: environment,
+                unreportedFiles: new[] { input },
+                inputPrefetchList: list,
+                verifyProcess: process =>
+                {
+                    XAssert.IsTrue(process.PrefetchStatistics.HasValue, "The second run did not report input prefetch statistics");
+                    var statistics = process.PrefetchStatistics.Value;
+                    XAssert.IsTrue(statistics.Listed >= 1, statistics.ToString());
+                    XAssert.IsTrue(statistics.Hits >= 1, statistics.ToString());
+                });
+        }
+
+        [Fact]
+        public void ResolutionSnapshotCarriesOverToTheNextRun()
+        {
+            // The symlink and the snapshot must outlive the working directory of each run
+            using var state = new TempFileStorage(canGetFileNames: true);
+            var input = Path.Combine(state.RootDirectory, "snapshotInput");
+            var link = Path.Combine(state.RootDirectory, "snapshotLink");
+            var snapshot = Path.Combine(state.RootDirectory, "resolutionSnapshot");
+            File.WriteAllText(input, "hello");
+            XAssert.IsTrue(FileUtilities.TryCreateSymbolicLink(link, input, isTargetFile: true).Succeeded);
+
+            // Only paths the pip can't write make it to the snapshot
+            var environment = new Dictionary<string, string> { ["TEST_INPUT"] = link };
+            var readOnlyFiles = new[] { input, link };
+
+            RunNativeTest("ReadInput", environment: environment, readOnlyFiles: readOnlyFiles, resolutionSnapshot: snapshot);
+            XAssert.IsTrue(File.Exists(snapshot), "The first run did not save the resolution snapshot");
+            XAssert.IsTrue(File.ReadAllText(snapshot).Contains(link), $"Missing '{link}' in the resolution snapshot: {File.ReadAllText(snapshot)}");
+
+            // The second run takes the symlink from the snapshot, and still reports it
+            var result = RunNativeTest("ReadInput", environment: environment, readOnlyFiles: readOnlyFiles, resolutionSnapshot: snapshot);
+            var accessedPaths = result.result.FileAccesses.Select(access => access.ManifestPath.ToString(Context.PathTable)).ToList();
+            XAssert.Contains(accessedPaths, link, input);
+        }
+
+        private static string Sha256(string content)
+        {
+            using var sha = System.Security.Cryptography.SHA256.Create();
+            return "SHA256:" + BitConverter.ToString(sha.ComputeHash(System.Text.Encoding.UTF8.GetBytes(content))).Replace("-", string.Empty);
+        }
     }
 }
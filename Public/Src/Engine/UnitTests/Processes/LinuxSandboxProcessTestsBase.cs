@@ -62,7 +62,36 @@ namespace Test.BuildXL.Processes
             return functionName.Replace("CallTest", "");
         }
 
-        protected (SandboxedProcessResult result, string rootDirectory) RunNativeTest(string testName, TempFileStorage workingDirectory = null, bool unconditionallyEnableLinuxPTraceSandbox = false)
+        /// <param name="environment">Variables to set for the test process (and the sandbox runners), on top of the ones of this process</param>
+        /// <param name="reportChannelCount">Number of FIFOs the sandbox reports accesses on</param>
+        /// <param name="reportTimestamps">Whether reports carry the time at which the access was observed and a sequence number</param>
+        /// <param name="reportLogs">Whether the processes of the test append their reports to logs, merged once the process tree is done</param>
+        /// <param name="observeOnly">Whether observable accesses are evaluated by the observation evaluator instead of in-process</param>
+        /// <param name="accessSummary">Whether the allowed read-only accesses of a process are collapsed per path and sent when it exits</param>
+        /// <param name="outputs">Files (relative to the working directory) the test may write, as the outputs of a pip</param>
+        /// <param name="unreportedFiles">Files (relative to the working directory) the test may read and write, which are only reported because the test reports all accesses</param>
+        /// <param name="newOutputs">Files (relative to the working directory) the test may only write if they did not exist before the pip started</param>
+        /// <param name="readOnlyFiles">Files (relative to the working directory) the test may only read</param>
+        /// <param name="inputPrefetchList">File the root process prefetches the inputs listed in, and that lists the inputs the test read once it is done</param>
+        /// <param name="resolutionSnapshot">File the sandbox takes the paths resolved by a previous run from, and saves the paths the test resolved to</param>
+        /// <param name="verifyProcess">Checks what the sandboxed process collected besides file accesses, once it exited successfully</param>
+        protected (SandboxedProcessResult result, string rootDirectory) RunNativeTest(
+            string testName,
+            TempFileStorage workingDirectory = null,
+            bool unconditionallyEnableLinuxPTraceSandbox = false,
+            Dictionary<string, string> environment = null,
+            uint reportChannelCount = 1,
+            bool reportTimestamps = false,
+            bool reportLogs = false,
+            bool observeOnly = false,
+            bool accessSummary = false,
+            string[] outputs = null,
+            string[] unreportedFiles = null,
+            string[] newOutputs = null,
+            string[] readOnlyFiles = null,
+            string inputPrefetchList = null,
+            string resolutionSnapshot = null,
+            Action<SandboxedProcessUnix> verifyProcess = null)
         {
             workingDirectory ??= new TempFileStorage(canGetFileNames: true);
             using (workingDirectory)
@@ -77,19 +106,61 @@ namespace Test.BuildXL.Processes
                     outputDirectories: ReadOnlyArray<DirectoryArtifact>.Empty,
                     untrackedScopes: ReadOnlyArray<AbsolutePath>.Empty);
 
-                var processInfo = ToProcessInfo(process, workingDirectory: workingDirectory.RootDirectory);
+                var processInfo = ToProcessInfo(process, overrideEnvVars: environment, workingDirectory: workingDirectory.RootDirectory);
                 processInfo.FileAccessManifest.ReportFileAccesses = true;
                 processInfo.FileAccessManifest.MonitorChildProcesses = true;
                 processInfo.FileAccessManifest.FailUnexpectedFileAccesses = false;
                 processInfo.FileAccessManifest.EnableLinuxSandboxLogging = true;
                 processInfo.FileAccessManifest.UnconditionallyEnableLinuxPTraceSandbox = unconditionallyEnableLinuxPTraceSandbox;
-
-                var result = RunProcess(processInfo).Result;
-
-                string message = $"Test terminated with exit code {result.ExitCode}.{Environment.NewLine}stdout: {result.StandardOutput.ReadValueAsync().Result}{Environment.NewLine}stderr: {result.StandardError.ReadValueAsync().Result}";
-                XAssert.IsTrue(result.ExitCode == 0, message);
-
-                return (result, workingDirectory.RootDirectory);
+                processInfo.FileAccessManifest.LinuxSandboxReportChannelCount = reportChannelCount;
+                processInfo.FileAccessManifest.EnableLinuxSandboxReportTimestamps = reportTimestamps;
+                processInfo.FileAccessManifest.EnableLinuxSandboxReportLogs = reportLogs;
+                processInfo.FileAccessManifest.EnableLinuxSandboxObserveOnly = observeOnly;
+                processInfo.FileAccessManifest.EnableLinuxSandboxAccessSummary = accessSummary;
+                processInfo.FileAccessManifest.LinuxSandboxInputPrefetchList = inputPrefetchList;
+                processInfo.FileAccessManifest.LinuxSandboxResolutionSnapshot = resolutionSnapshot;
+
+                foreach (var output in outputs ?? Array.Empty<string>())
+                {
+                    var outputPath = AbsolutePath.Create(Context.PathTable, Path.Combine(workingDirectory.RootDirectory, output));
+                    processInfo.FileAccessManifest.AddPath(outputPath, values: FileAccessPolicy.AllowAll | FileAccessPolicy.ReportAccess, mask: FileAccessPolicy.MaskNothing);
+                }
+
+                foreach (var file in unreportedFiles ?? Array.Empty<string>())
+                {
+                    var filePath = AbsolutePath.Create(Context.PathTable, Path.Combine(workingDirectory.RootDirectory, file));
+                    processInfo.FileAccessManifest.AddPath(filePath, values: FileAccessPolicy.AllowAll, mask: FileAccessPolicy.MaskNothing);
+                }
+
+                foreach (var output in newOutputs ?? Array.Empty<string>())
+                {
+                    var outputPath = AbsolutePath.Create(Context.PathTable, Path.Combine(workingDirectory.RootDirectory, output));
+                    processInfo.FileAccessManifest.AddPath(
+                        outputPath,
+                        values: FileAccessPolicy.AllowAll | FileAccessPolicy.ReportAccess | FileAccessPolicy.OverrideAllowWriteForExistingFiles,
+                        mask: FileAccessPolicy.MaskNothing);
+                }
+
+                foreach (var file in readOnlyFiles ?? Array.Empty<string>())
+                {
+                    var filePath = AbsolutePath.Create(Context.PathTable, Path.Combine(workingDirectory.RootDirectory, file));
+                    processInfo.FileAccessManifest.AddPath(
+                        filePath,
+                        values: FileAccessPolicy.AllowRead | FileAccessPolicy.AllowReadIfNonexistent | FileAccessPolicy.ReportAccess,
+                        mask: FileAccessPolicy.MaskNothing);
+                }
+
+                using (var sandboxedProcess = StartProcessAsync(processInfo).Result)
+                {
+                    var result = sandboxedProcess.GetResultAsync().Result;
+
+                    string message = $"Test terminated with exit code {result.ExitCode}.{Environment.NewLine}stdout: {result.StandardOutput.ReadValueAsync().Result}{Environment.NewLine}stderr: {result.StandardError.ReadValueAsync().Result}";
+                    XAssert.IsTrue(result.ExitCode == 0, message);
+
+                    verifyProcess?.Invoke((SandboxedProcessUnix)sandboxedProcess);
+
+                    return (result, workingDirectory.RootDirectory);
+                }
             }
         }
 
@@ -10,6 +10,7 @@ namespace common {
 FileAccessManifest::FileAccessManifest(char *payload, size_t payload_size) {
     payload_ = std::unique_ptr<char []>(payload);
     payload_size_ = payload_size;
+    report_channel_count_ = 1;
 
     ParseFileAccessManifest();
 }
@@ -114,7 +115,14 @@ bool FileAccessManifest::ParseFileAccessManifest() {
         }
     }
 
-    // 12. Manifest Tree
+    // 12. Linux sandbox block
+    auto linux_sandbox = ParseAndAdvancePointer<PCManifestLinuxSandbox>(offset);
+    report_channel_count_ = linux_sandbox->ReportChannelCount;
+    ParseUtf16CharArrayToString(offset, unmonitored_executables_);
+    ParseUtf16CharArrayToString(offset, input_prefetch_list_);
+    ParseUtf16CharArrayToString(offset, resolution_snapshot_);
+
+    // 13. Manifest Tree
     manifest_tree_ = Parse<PCManifestRecord>(offset);
     manifest_tree_->AssertValid();
 
@@ -92,6 +92,10 @@ private:
     PCManifestDllBlock dll_;
     PCManifestSubstituteProcessExecutionShim shim_info_;
     std::basic_string<PathChar> shim_path_;
+    uint32_t report_channel_count_;
+    std::basic_string<PathChar> unmonitored_executables_;
+    std::basic_string<PathChar> input_prefetch_list_;
+    std::basic_string<PathChar> resolution_snapshot_;
     PCManifestRecord manifest_tree_;
 
     /**
@@ -122,6 +126,10 @@ public:
     inline PCManifestReport GetReport() const                               { return report_; }
     inline PCManifestDllBlock GetDll() const                                { return dll_; }
     inline PCManifestSubstituteProcessExecutionShim GetShimInfo() const     { return shim_info_; }
+    inline uint32_t GetReportChannelCount() const                           { return report_channel_count_; }
+    inline const char *GetUnmonitoredExecutables() const                    { return unmonitored_executables_.c_str(); }
+    inline const char *GetInputPrefetchList() const                         { return input_prefetch_list_.c_str(); }
+    inline const char *GetResolutionSnapshot() const                        { return resolution_snapshot_.c_str(); }
     inline PCManifestRecord GetManifestTreeRoot() const                     { return manifest_tree_; }
     inline PCManifestRecord GetUnixManifestTreeRoot() const                 { return manifest_tree_->BucketCount > 0 ? manifest_tree_->GetChildRecord(0) : manifest_tree_; }
     // TODO [pgunasekara]: accept a length argument as reference instead of a pointer.
@@ -0,0 +1,708 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "EbpfSandbox.hpp"
+#include "PTraceSandbox.hpp"
+#include <sys/epoll.h>
+
+using buildxl::linux::EbpfRecord;
+using buildxl::linux::EbpfSyscallEntry;
+using buildxl::linux::TracepointField;
+
+#define SYSCALL_NAME_TO_NUMBER(name) __NR_##name
+#define SYSCALL_NAME_STRING(name) #name
+
+#define HANDLER_FUNCTION(syscallName) void EbpfSandbox::Handle##syscallName()
+
+#define CONFIGURE_CUSTOM_SYSCALL(syscallName, pathArg, secondPathArg) \
+        { SYSCALL_NAME_TO_NUMBER(syscallName), buildxl::linux::EncodeEbpfSyscall(pathArg, secondPathArg) },
+#define CONFIGURE_DECLARATIVE_SYSCALL(syscallName, shape, event, fdArg, pathArg, flagsArg, resolution) \
+        { SYSCALL_NAME_TO_NUMBER(syscallName), buildxl::linux::EncodeEbpfSyscall(pathArg, 0) },
+
+#define CHECK_AND_CALL_HANDLER(syscallName, pathArg, secondPathArg) \
+        case SYSCALL_NAME_TO_NUMBER(syscallName): \
+            Handle##syscallName(); \
+            break;
+#define CHECK_AND_CALL_DECLARATIVE_HANDLER(syscallName, shape, event, fdArg, pathArg, flagsArg, resolution) \
+        case SYSCALL_NAME_TO_NUMBER(syscallName): \
+            HandleDeclarativeSyscall<buildxl::linux::shape, event, fdArg, pathArg, flagsArg, buildxl::linux::resolution>(SYSCALL_NAME_STRING(syscallName)); \
+            break;
+
+// Records that don't fit in the ring buffer are dropped (and counted, see m_drops): this holds about 2000 records with paths
+static const uint32_t kRingBufferSize = 16 * 1024 * 1024;
+static const uint32_t kMaxThreads = 64 * 1024;
+
+// How long the runner waits for records before checking that the threads it knows about are still alive
+static const int kLivenessCheckMilliseconds = 1000;
+
+EbpfSandbox::EbpfSandbox(BxlObserver *bxl)
+{
+    m_bxl = bxl;
+}
+
+EbpfSandbox::~EbpfSandbox()
+{
+    // Closing the perf events detaches the programs
+    for (int fd : m_fds)
+    {
+        close(fd);
+    }
+
+    for (int fd : { m_maps.tree, m_maps.syscalls, m_maps.events, m_maps.drops, m_epollFd })
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+}
+
+bool EbpfSandbox::Initialize()
+{
+    std::string tracefs = buildxl::linux::FindTracefs();
+    if (tracefs.empty())
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not find %s", "tracefs");
+        return false;
+    }
+
+    m_maps.tree = buildxl::linux::CreateEbpfMap(BPF_MAP_TYPE_HASH, sizeof(uint32_t), sizeof(uint32_t), kMaxThreads);
+    m_maps.syscalls = buildxl::linux::CreateEbpfMap(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), sizeof(uint32_t), buildxl::linux::kEbpfMaxSyscalls);
+    m_maps.events = buildxl::linux::CreateEbpfMap(BPF_MAP_TYPE_RINGBUF, 0, 0, kRingBufferSize);
+    m_maps.drops = buildxl::linux::CreateEbpfMap(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), sizeof(uint64_t), 1);
+    if (m_maps.tree == -1 || m_maps.syscalls == -1 || m_maps.events == -1 || m_maps.drops == -1)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not create the maps: '%s'", strerror(errno));
+        return false;
+    }
+
+    if (!ConfigureSyscalls() || !LoadPrograms(tracefs))
+    {
+        return false;
+    }
+
+    if (!m_ringBuffer.Initialize(m_maps.events, kRingBufferSize))
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not map the ring buffer: '%s'", strerror(errno));
+        return false;
+    }
+
+    // The ring buffer map is readable when records are submitted
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_maps.events;
+    if (m_epollFd == -1 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_maps.events, &event) == -1)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] epoll setup failed with: '%s'", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+bool EbpfSandbox::ConfigureSyscalls()
+{
+    std::vector<std::pair<uint32_t, uint32_t>> syscalls =
+    {
+        BXL_DECLARATIVE_SYSCALLS(CONFIGURE_DECLARATIVE_SYSCALL)
+        BXL_CUSTOM_SYSCALLS(CONFIGURE_CUSTOM_SYSCALL)
+        // PTraceSandbox reads the current directory of the tracee when it needs it, which can't be done after the fact
+        { SYSCALL_NAME_TO_NUMBER(chdir), buildxl::linux::EncodeEbpfSyscall(1, 0) },
+        { SYSCALL_NAME_TO_NUMBER(fchdir), buildxl::linux::EncodeEbpfSyscall(0, 0) },
+    };
+
+    for (const auto &syscall : syscalls)
+    {
+        // New processes and threads are reported by the scheduler tracepoints instead, which see them before they run
+        if (syscall.first == SYS_fork || syscall.first == SYS_clone || syscall.first == SYS_clone3)
+        {
+            continue;
+        }
+
+        if (buildxl::linux::UpdateEbpfMap(m_maps.syscalls, &syscall.first, &syscall.second) != 0)
+        {
+            BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not configure syscall '%u': '%s'", syscall.first, strerror(errno));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool EbpfSandbox::LoadPrograms(const std::string &tracefs)
+{
+    std::string enter = buildxl::linux::ReadTracepointFormat(tracefs, "raw_syscalls", "sys_enter");
+    std::string exit = buildxl::linux::ReadTracepointFormat(tracefs, "raw_syscalls", "sys_exit");
+    std::string fork = buildxl::linux::ReadTracepointFormat(tracefs, "sched", "sched_process_fork");
+
+    TracepointField enterId, enterArgs, exitId, exitRet, childPid;
+    if (!buildxl::linux::ParseTracepointField(enter, "id", enterId)
+        || !buildxl::linux::ParseTracepointField(enter, "args", enterArgs)
+        || !buildxl::linux::ParseTracepointField(exit, "id", exitId)
+        || !buildxl::linux::ParseTracepointField(exit, "ret", exitRet)
+        || !buildxl::linux::ParseTracepointField(fork, "child_pid", childPid))
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not read the tracepoint formats in '%s'", tracefs.c_str());
+        return false;
+    }
+
+    buildxl::linux::EbpfTracepointLayout layout = {};
+    layout.enter_id = enterId.offset;
+    layout.enter_args = enterArgs.offset;
+    layout.exit_id = exitId.offset;
+    layout.exit_ret = exitRet.offset;
+    layout.fork_child_pid = childPid.offset;
+
+    // The process tracepoints go first: once the syscall ones are attached, the tree must not miss a fork
+    struct
+    {
+        const char *category;
+        const char *name;
+        std::vector<struct bpf_insn> program;
+    } programs[] =
+    {
+        { "sched", "sched_process_fork", buildxl::linux::BuildProcessForkProgram(layout, m_maps) },
+        { "sched", "sched_process_exit", buildxl::linux::BuildProcessExitProgram(layout, m_maps) },
+        { "raw_syscalls", "sys_enter", buildxl::linux::BuildSyscallEnterProgram(layout, m_maps) },
+        { "raw_syscalls", "sys_exit", buildxl::linux::BuildSyscallExitProgram(layout, m_maps) },
+    };
+
+    for (const auto &program : programs)
+    {
+        std::string log;
+        int programFd = buildxl::linux::LoadEbpfProgram(program.program, &log);
+        if (programFd == -1)
+        {
+            BXL_LOG_DEBUG(m_bxl, "[eBPF] The program for '%s' was rejected: '%s' %s", program.name, strerror(errno), log.c_str());
+            return false;
+        }
+
+        m_fds.push_back(programFd);
+        int perfFd = buildxl::linux::AttachEbpfProgram(tracefs, program.category, program.name, programFd);
+        if (perfFd == -1)
+        {
+            BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not attach the program for '%s': '%s'", program.name, strerror(errno));
+            return false;
+        }
+
+        m_fds.push_back(perfFd);
+    }
+
+    return true;
+}
+
+void EbpfSandbox::ObserveProcessTree(pid_t rootPid, std::string exe, std::string semaphoreName)
+{
+    BXL_LOG_DEBUG(m_bxl, "[eBPF] Starting observer PID '%d' to observe PID '%d' ('%s')", getpid(), rootPid, exe.c_str());
+    m_bxl->disable_fd_table();
+
+    uint32_t root = (uint32_t)rootPid, noParent = 0;
+    if (buildxl::linux::UpdateEbpfMap(m_maps.tree, &root, &noParent) != 0)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not add PID '%d' to the tree: '%s'", rootPid, strerror(errno));
+        _exit(-1);
+    }
+
+    char cwd[PATH_MAX] = { 0 };
+    std::string link = "/proc/" + std::to_string(rootPid) + "/cwd";
+    if (readlink(link.c_str(), cwd, sizeof(cwd) - 1) <= 0)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Process '%d' exited before it could be observed", rootPid);
+        _exit(-1);
+    }
+
+    m_processes[rootPid] = exe;
+    m_cwds[rootPid] = cwd;
+
+    // Tells the root process not to install the seccomp filter of the ptrace sandbox: with no tracer, the traced syscalls would fail
+    std::string markerName = semaphoreName + PTraceSandbox::kUntracedSemaphoreSuffix;
+    sem_t *marker = sem_open(markerName.c_str(), O_CREAT, 0644, 0);
+    if (marker == SEM_FAILED)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] sem_open failed with: '%s'", strerror(errno));
+        _exit(-1);
+    }
+    sem_close(marker);
+
+    // The programs are attached, signal the semaphore for the root process to exec
+    sem_t *semaphore = sem_open(semaphoreName.c_str(), O_CREAT, 0644, 0);
+    if (semaphore == NULL)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] sem_open failed with: '%s'", strerror(errno));
+        _exit(-1);
+    }
+    sem_post(semaphore);
+    sem_close(semaphore);
+
+    struct epoll_event event;
+    while (!m_processes.empty())
+    {
+        int count = epoll_wait(m_epollFd, &event, 1, kLivenessCheckMilliseconds);
+        if (count == -1 && errno != EINTR)
+        {
+            std::cerr << "[eBPF] epoll_wait failed with: " << strerror(errno) << std::endl;
+            _exit(-1);
+        }
+
+        DrainRecords();
+        if (count == 0)
+        {
+            CheckLiveness();
+        }
+    }
+
+    if (m_drops > 0)
+    {
+        std::cerr << "[eBPF] " << m_drops << " records were dropped because the ring buffer was full: some accesses were not reported" << std::endl;
+    }
+}
+
+void EbpfSandbox::DrainRecords()
+{
+    m_ringBuffer.Consume([this](const char *data, size_t length) { HandleRecord(data, length); });
+
+    uint32_t key = 0;
+    uint64_t drops = 0;
+    if (buildxl::linux::LookupEbpfMap(m_maps.drops, &key, &drops) == 0 && drops > m_drops)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] %lu records were dropped", (unsigned long)(drops - m_drops));
+        m_drops = drops;
+    }
+}
+
+void EbpfSandbox::HandleRecord(const char *data, size_t length)
+{
+    if (length < sizeof(EbpfRecord))
+    {
+        return;
+    }
+
+    const EbpfRecord *record = (const EbpfRecord *)data;
+    pid_t pid = (pid_t)(record->pid_tgid & 0xffffffff);
+    pid_t tgid = (pid_t)(record->pid_tgid >> 32);
+    switch (record->kind)
+    {
+        case buildxl::linux::kEbpfSyscallEnter:
+        {
+            if (length < buildxl::linux::kEbpfSyscallEntryWithoutPathsSize)
+            {
+                return;
+            }
+
+            // A syscall that never returned (e.g., its exit record was dropped)
+            auto pending = m_pending.find(pid);
+            if (pending != m_pending.end())
+            {
+                HandleSyscall(pending->second, 0);
+            }
+
+            m_pending[pid].assign(data, length);
+            break;
+        }
+        case buildxl::linux::kEbpfSyscallExit:
+        {
+            auto pending = m_pending.find(pid);
+            if (pending != m_pending.end())
+            {
+                std::string entry = std::move(pending->second);
+                m_pending.erase(pending);
+                HandleSyscall(entry, (long)record->value);
+            }
+            break;
+        }
+        case buildxl::linux::kEbpfFork:
+            HandleFork(pid, tgid, (pid_t)record->value);
+            break;
+        case buildxl::linux::kEbpfExit:
+            HandleExit((pid_t)record->value);
+            break;
+        default:
+            break;
+    }
+}
+
+void EbpfSandbox::HandleSyscall(const std::string &entry, long result)
+{
+    m_entry = (const EbpfSyscallEntry *)entry.data();
+    m_entryLength = entry.size();
+    m_pid = (pid_t)(m_entry->record.pid_tgid & 0xffffffff);
+    m_tgid = (pid_t)(m_entry->record.pid_tgid >> 32);
+    m_result = result;
+
+    long syscallNumber = (long)m_entry->record.syscall;
+    switch (syscallNumber)
+    {
+        BXL_DECLARATIVE_SYSCALLS(CHECK_AND_CALL_DECLARATIVE_HANDLER)
+        BXL_CUSTOM_SYSCALLS(CHECK_AND_CALL_HANDLER)
+        case SYSCALL_NAME_TO_NUMBER(chdir):
+        case SYSCALL_NAME_TO_NUMBER(fchdir):
+        {
+            if (m_result == 0)
+            {
+                std::string cwd = syscallNumber == SYSCALL_NAME_TO_NUMBER(chdir) ? ResolvePath(AT_FDCWD, Path()) : ResolveFd((int)Argument(1));
+                if (!cwd.empty())
+                {
+                    m_cwds[m_tgid] = cwd;
+                }
+            }
+            break;
+        }
+        default:
+            BXL_LOG_DEBUG(m_bxl, "[eBPF] Unsupported syscall '%ld'", syscallNumber);
+            break;
+    }
+
+    m_entry = nullptr;
+}
+
+void EbpfSandbox::HandleFork(pid_t parentPid, pid_t parentTgid, pid_t childPid)
+{
+    auto parent = m_processes.find(parentPid);
+    std::string exePath = parent != m_processes.end() ? parent->second : std::string(m_bxl->GetProgramPath());
+
+    // Threads share the directory of their process, and new processes start in the directory of their parent
+    auto cwd = m_cwds.find(parentTgid);
+    if (cwd != m_cwds.end())
+    {
+        m_cwds[childPid] = cwd->second;
+    }
+
+    auto event = buildxl::linux::SandboxEvent::ForkSandboxEvent(parentPid, childPid, exePath);
+    m_bxl->CreateAndReportAccess("fork", event, /* check_cache */ false);
+    m_processes[childPid] = exePath;
+
+    BXL_LOG_DEBUG(m_bxl, "[eBPF] Added new process with PID '%d', parent PID: '%d'", childPid, parentPid);
+}
+
+void EbpfSandbox::HandleExit(pid_t pid)
+{
+    // e.g., execve, whose exit record comes from a thread that no longer exists when a thread other than the leader exec'd
+    auto pending = m_pending.find(pid);
+    if (pending != m_pending.end())
+    {
+        std::string entry = std::move(pending->second);
+        m_pending.erase(pending);
+        HandleSyscall(entry, 0);
+    }
+
+    if (m_processes.erase(pid) == 0)
+    {
+        return;
+    }
+
+    m_cwds.erase(pid);
+    m_bxl->SendExitReport(pid);
+}
+
+void EbpfSandbox::CheckLiveness()
+{
+    std::vector<pid_t> exited;
+    for (const auto &process : m_processes)
+    {
+        if (kill(process.first, 0) == -1 && errno == ESRCH)
+        {
+            exited.push_back(process.first);
+        }
+    }
+
+    for (pid_t pid : exited)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] PID '%d' exited without an exit record", pid);
+        HandleExit(pid);
+    }
+}
+
+const char *EbpfSandbox::Path() const
+{
+    return m_entryLength >= sizeof(EbpfSyscallEntry) ? m_entry->path : "";
+}
+
+const char *EbpfSandbox::SecondPath() const
+{
+    return m_entryLength >= sizeof(EbpfSyscallEntry) ? m_entry->second_path : "";
+}
+
+std::string EbpfSandbox::ResolveFd(int fd)
+{
+    char path[PATH_MAX] = { 0 };
+    std::string link = "/proc/" + std::to_string(m_tgid) + "/fd/" + std::to_string(fd);
+    ssize_t length = readlink(link.c_str(), path, sizeof(path) - 1);
+
+    // Anything but a file (e.g., pipe:[inode]) is not reported
+    return length > 0 && path[0] == '/' ? std::string(path, length) : std::string();
+}
+
+std::string EbpfSandbox::ResolvePath(int dirfd, const char *path)
+{
+    if (path[0] == '/')
+    {
+        return path;
+    }
+
+    std::string directory;
+    if (dirfd == AT_FDCWD)
+    {
+        auto cwd = m_cwds.find(m_tgid);
+        directory = cwd != m_cwds.end() ? cwd->second : std::string();
+    }
+    else
+    {
+        directory = ResolveFd(dirfd);
+    }
+
+    if (directory.empty())
+    {
+        BXL_LOG_DEBUG(m_bxl, "[eBPF] Could not resolve '%s' for PID '%d'", path, m_pid);
+        return directory;
+    }
+
+    // e.g., AT_EMPTY_PATH
+    if (path[0] == '\0')
+    {
+        return directory;
+    }
+
+    // The path is canonicalized when it is reported
+    return directory == "/" ? directory + path : directory + "/" + path;
+}
+
+void EbpfSandbox::Report(es_event_type_t eventType, const std::string &path, const char *syscall, bool noFollow, mode_t mode, bool checkCache)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    eventType,
+        /* pid */           m_pid,
+        /* error */         Error(),
+        /* src_path */      path.c_str());
+    if (noFollow)
+    {
+        event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
+    }
+
+    if (mode != 0)
+    {
+        event.SetMode(mode);
+    }
+
+    m_bxl->CreateAndReportAccess(syscall, event, checkCache);
+}
+
+template <buildxl::linux::SyscallShape shape, es_event_type_t eventType, int fdArg, int pathArg, int flagsArg, buildxl::linux::SyscallResolution resolution>
+void EbpfSandbox::HandleDeclarativeSyscall(const char *syscall)
+{
+    if constexpr (shape == buildxl::linux::kFdSyscall)
+    {
+        Report(eventType, ResolveFd((int)Argument(fdArg)), syscall, /* noFollow */ false);
+    }
+    else
+    {
+        int dirfd = AT_FDCWD;
+        if constexpr (shape == buildxl::linux::kDirfdPathSyscall)
+        {
+            dirfd = (int)Argument(fdArg);
+        }
+
+        bool noFollow = resolution == buildxl::linux::kNoFollowSymlinks;
+        if constexpr (resolution == buildxl::linux::kNoFollowIfRequested)
+        {
+            noFollow = (Argument(flagsArg) & AT_SYMLINK_NOFOLLOW) != 0;
+        }
+
+        Report(eventType, ResolvePath(dirfd, Path()), syscall, noFollow);
+    }
+}
+
+void EbpfSandbox::ReportOpen(const std::string &path, int oflag, const char *syscall)
+{
+    // Unlike PTraceSandbox, the file is looked at after the syscall returned: only O_EXCL guarantees that it was created
+    bool succeeded = m_result >= 0;
+    bool isCreate = succeeded && (oflag & O_CREAT) && (oflag & O_EXCL);
+    bool isWrite = succeeded && (oflag & (O_CREAT | O_TRUNC)) && (oflag & O_ACCMODE) != O_RDONLY;
+    auto eventType = isCreate ? ES_EVENT_TYPE_NOTIFY_CREATE : isWrite ? ES_EVENT_TYPE_NOTIFY_WRITE : ES_EVENT_TYPE_NOTIFY_OPEN;
+    Report(eventType, path, syscall, /* noFollow */ (oflag & O_NOFOLLOW) != 0, m_bxl->get_mode(path.c_str()));
+}
+
+void EbpfSandbox::ReportCreate(const char *syscall, int dirfd, mode_t mode, bool checkCache)
+{
+    Report(ES_EVENT_TYPE_NOTIFY_CREATE, ResolvePath(dirfd, Path()), syscall, /* noFollow */ true, mode, checkCache);
+}
+
+// Syscall Handlers
+HANDLER_FUNCTION(execve)
+{
+    std::string exePath = ResolvePath(AT_FDCWD, Path());
+    if (m_result == 0 && !exePath.empty())
+    {
+        m_processes[m_pid] = exePath;
+    }
+
+    Report(ES_EVENT_TYPE_NOTIFY_EXEC, exePath, SYSCALL_NAME_STRING(execve), /* noFollow */ false);
+}
+
+HANDLER_FUNCTION(execveat)
+{
+    bool noFollow = (Argument(5) & AT_SYMLINK_NOFOLLOW) != 0;
+    std::string exePath = ResolvePath((int)Argument(1), Path());
+    if (m_result == 0 && !exePath.empty())
+    {
+        m_processes[m_pid] = exePath;
+    }
+
+    Report(ES_EVENT_TYPE_NOTIFY_EXEC, exePath, SYSCALL_NAME_STRING(execveat), noFollow);
+}
+
+HANDLER_FUNCTION(creat)
+{
+    ReportOpen(ResolvePath(AT_FDCWD, Path()), O_CREAT | O_WRONLY | O_TRUNC, SYSCALL_NAME_STRING(creat));
+}
+
+HANDLER_FUNCTION(open)
+{
+    ReportOpen(ResolvePath(AT_FDCWD, Path()), (int)Argument(2), SYSCALL_NAME_STRING(open));
+}
+
+HANDLER_FUNCTION(openat)
+{
+    ReportOpen(ResolvePath((int)Argument(1), Path()), (int)Argument(3), SYSCALL_NAME_STRING(openat));
+}
+
+HANDLER_FUNCTION(name_to_handle_at)
+{
+    int oflags = (Argument(5) & AT_SYMLINK_FOLLOW) ? 0 : O_NOFOLLOW;
+    ReportOpen(ResolvePath((int)Argument(1), Path()), oflags, SYSCALL_NAME_STRING(name_to_handle_at));
+}
+
+HANDLER_FUNCTION(rmdir)
+{
+    // We don't want to use the cache since we want to distinguish between creation and deletion of directories
+    Report(ES_EVENT_TYPE_NOTIFY_UNLINK, ResolvePath(AT_FDCWD, Path()), SYSCALL_NAME_STRING(rmdir), /* noFollow */ false, S_IFDIR, /* checkCache */ false);
+}
+
+HANDLER_FUNCTION(rename)
+{
+    HandleRename(SYSCALL_NAME_STRING(rename), AT_FDCWD, AT_FDCWD);
+}
+
+HANDLER_FUNCTION(renameat)
+{
+    HandleRename(SYSCALL_NAME_STRING(renameat), (int)Argument(1), (int)Argument(3));
+}
+
+HANDLER_FUNCTION(renameat2)
+{
+    HandleRename(SYSCALL_NAME_STRING(renameat2), (int)Argument(1), (int)Argument(3));
+}
+
+void EbpfSandbox::HandleRename(const char *syscall, int olddirfd, int newdirfd)
+{
+    std::string oldPath = ResolvePath(olddirfd, Path());
+    std::string newPath = ResolvePath(newdirfd, SecondPath());
+    if (oldPath.empty() || newPath.empty())
+    {
+        return;
+    }
+
+    // The rename already happened: a directory that was moved is enumerated at its destination
+    std::vector<std::string> filesAndDirectories;
+    if (m_result != 0 || !S_ISDIR(m_bxl->get_mode(newPath.c_str())) || !m_bxl->EnumerateDirectory(newPath, /* recursive */ true, filesAndDirectories))
+    {
+        filesAndDirectories = { newPath };
+    }
+
+    for (const auto &destination : filesAndDirectories)
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_UNLINK, oldPath + destination.substr(newPath.length()), syscall, /* noFollow */ true);
+        ReportOpen(destination, O_CREAT | O_WRONLY, syscall);
+    }
+}
+
+HANDLER_FUNCTION(link)
+{
+    HandleLink(SYSCALL_NAME_STRING(link), AT_FDCWD, AT_FDCWD);
+}
+
+HANDLER_FUNCTION(linkat)
+{
+    HandleLink(SYSCALL_NAME_STRING(linkat), (int)Argument(1), (int)Argument(3));
+}
+
+void EbpfSandbox::HandleLink(const char *syscall, int olddirfd, int newdirfd)
+{
+    std::string oldPath = ResolvePath(olddirfd, Path());
+    std::string newPath = ResolvePath(newdirfd, SecondPath());
+    if (oldPath.empty() || newPath.empty())
+    {
+        return;
+    }
+
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    ES_EVENT_TYPE_NOTIFY_LINK,
+        /* pid */           m_pid,
+        /* error */         Error(),
+        /* src_path */      oldPath.c_str(),
+        /* dest_path */     newPath.c_str());
+    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
+
+    m_bxl->CreateAndReportAccess(syscall, event);
+}
+
+HANDLER_FUNCTION(unlink)
+{
+    Report(ES_EVENT_TYPE_NOTIFY_UNLINK, ResolvePath(AT_FDCWD, Path()), SYSCALL_NAME_STRING(unlink), /* noFollow */ true);
+}
+
+HANDLER_FUNCTION(unlinkat)
+{
+    bool removeDirectory = (Argument(3) & AT_REMOVEDIR) != 0;
+    Report(ES_EVENT_TYPE_NOTIFY_UNLINK, ResolvePath((int)Argument(1), Path()), SYSCALL_NAME_STRING(unlinkat),
+        /* noFollow */ !removeDirectory, removeDirectory ? S_IFDIR : 0, /* checkCache */ !removeDirectory);
+}
+
+HANDLER_FUNCTION(symlink)
+{
+    ReportCreate(SYSCALL_NAME_STRING(symlink), AT_FDCWD, S_IFLNK, /* checkCache */ true);
+}
+
+HANDLER_FUNCTION(symlinkat)
+{
+    ReportCreate(SYSCALL_NAME_STRING(symlinkat), (int)Argument(2), S_IFLNK, /* checkCache */ true);
+}
+
+HANDLER_FUNCTION(mkdir)
+{
+    // We don't want to use the cache since we want to distinguish between creation and deletion of directories
+    ReportCreate(SYSCALL_NAME_STRING(mkdir), AT_FDCWD, S_IFDIR, /* checkCache */ false);
+}
+
+HANDLER_FUNCTION(mkdirat)
+{
+    ReportCreate(SYSCALL_NAME_STRING(mkdirat), (int)Argument(1), S_IFDIR, /* checkCache */ false);
+}
+
+HANDLER_FUNCTION(mknod)
+{
+    ReportCreate(SYSCALL_NAME_STRING(mknod), AT_FDCWD, S_IFREG, /* checkCache */ true);
+}
+
+HANDLER_FUNCTION(mknodat)
+{
+    ReportCreate(SYSCALL_NAME_STRING(mknodat), (int)Argument(1), S_IFREG, /* checkCache */ true);
+}
+
+// New processes and threads are reported by HandleFork, from the scheduler tracepoints: these syscalls are never traced
+HANDLER_FUNCTION(fork)
+{
+}
+
+HANDLER_FUNCTION(clone)
+{
+}
+
+HANDLER_FUNCTION(clone3)
+{
+}
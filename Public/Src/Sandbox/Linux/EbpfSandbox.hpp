@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "bxl_observer.hpp"
+#include "ebpf_programs.hpp"
+#include "syscall_table.hpp"
+
+/*
+ * Observes the file accesses of a process tree with eBPF programs attached to the syscall and scheduler tracepoints, instead of ptrace.
+ * Like FanotifySandbox, this is an alternative to PTraceSandbox for statically linked processes: the traced syscalls are the ones of
+ * syscall_table.hpp, but they are never stopped. The programs (see ebpf_programs.hpp) keep the process tree in a map, so only the
+ * syscalls of the pip are copied to a ring buffer, and the runner builds the same reports PTraceSandbox does from there.
+ *
+ * The runner reads the records after the fact, so:
+ *   - descriptors (and the current directory, past the ones the runner tracks) are resolved through /proc when the record is read,
+ *     and can't be resolved once the process exited
+ *   - whether a file existed before it was opened isn't known, so opening with O_CREAT (without O_EXCL) is reported as a write
+ *   - the arguments of exec'd processes are not reported
+ * On the other hand every report carries the actual return value of its syscall.
+ * The programs are built for the tracepoint layouts of the running kernel, which are read from tracefs. Requires Linux 5.8 or later
+ * (for BPF ring buffers), CAP_BPF and CAP_PERFMON (or CAP_SYS_ADMIN). When any of these is missing, Initialize fails and the caller
+ * falls back to ptrace.
+ */
+class EbpfSandbox
+{
+public:
+    EbpfSandbox(BxlObserver *bxl);
+    ~EbpfSandbox();
+
+    /*
+     * @brief Loads the programs and attaches them to their tracepoints
+     * @return False if eBPF is not available (or not usable by this process), in which case nothing is observed
+     */
+    bool Initialize();
+
+    /*
+     * @brief Reports the file accesses of the process tree rooted at the given pid until all of its processes exit
+     * @param semaphoreName The semaphore the tracee waits on before exec'ing, posted once the tree is being observed
+     */
+    void ObserveProcessTree(pid_t rootPid, std::string exe, std::string semaphoreName);
+
+private:
+    BxlObserver *m_bxl;
+    buildxl::linux::EbpfMaps m_maps = { -1, -1, -1, -1 };
+    // Loaded programs, and the perf events that keep them attached
+    std::vector<int> m_fds;
+    buildxl::linux::EbpfRingBuffer m_ringBuffer;
+    int m_epollFd = -1;
+    uint64_t m_drops = 0;
+
+    // Threads of the tree that didn't exit yet -> executable they run
+    std::unordered_map<pid_t, std::string> m_processes;
+    // Process (i.e., thread group) -> its current directory
+    std::unordered_map<pid_t, std::string> m_cwds;
+    // Thread -> entry record of the syscall it is in
+    std::unordered_map<pid_t, std::string> m_pending;
+
+    // The syscall being handled
+    const buildxl::linux::EbpfSyscallEntry *m_entry = nullptr;
+    size_t m_entryLength = 0;
+    pid_t m_pid = 0;
+    pid_t m_tgid = 0;
+    long m_result = 0;
+
+    bool LoadPrograms(const std::string &tracefs);
+    bool ConfigureSyscalls();
+
+    /*
+     * @brief Consumes the ring buffer
+     */
+    void DrainRecords();
+    void HandleRecord(const char *data, size_t length);
+    void HandleSyscall(const std::string &entry, long result);
+    void HandleFork(pid_t parentPid, pid_t parentTgid, pid_t childPid);
+    void HandleExit(pid_t pid);
+
+    /*
+     * @brief Reports the exit of the threads that are gone without an exit record (i.e., the record was dropped)
+     */
+    void CheckLiveness();
+
+    // Handlers for the custom syscalls in syscall_table.hpp (the declarative ones are all handled by HandleDeclarativeSyscall)
+#define DECLARE_EBPF_HANDLER(syscallName, pathArg, secondPathArg) void Handle##syscallName();
+    BXL_CUSTOM_SYSCALLS(DECLARE_EBPF_HANDLER)
+#undef DECLARE_EBPF_HANDLER
+
+    template <buildxl::linux::SyscallShape shape, es_event_type_t eventType, int fdArg, int pathArg, int flagsArg, buildxl::linux::SyscallResolution resolution>
+    void HandleDeclarativeSyscall(const char *syscall);
+
+    void HandleRename(const char *syscall, int olddirfd, int newdirfd);
+    void HandleLink(const char *syscall, int olddirfd, int newdirfd);
+    void ReportOpen(const std::string &path, int oflag, const char *syscall);
+    void ReportCreate(const char *syscall, int dirfd, mode_t mode, bool checkCache);
+    void Report(es_event_type_t eventType, const std::string &path, const char *syscall, bool noFollow, mode_t mode = 0, bool checkCache = true);
+
+    /*
+     * @brief Argument of the syscall being handled (1-based)
+     */
+    long Argument(int index) const { return (long)m_entry->args[index - 1]; }
+    const char *Path() const;
+    const char *SecondPath() const;
+    int Error() const { return m_result < 0 ? (int)-m_result : 0; }
+
+    /*
+     * @brief Absolute path of a path relative to a directory descriptor (or AT_FDCWD) of the current process, or an empty string
+     */
+    std::string ResolvePath(int dirfd, const char *path);
+
+    /*
+     * @brief Path of a descriptor of the current process, or an empty string if it is not a file (or the process is gone)
+     */
+    std::string ResolveFd(int fd);
+};
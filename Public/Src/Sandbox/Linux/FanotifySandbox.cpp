@@ -0,0 +1,459 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "FanotifySandbox.hpp"
+#include "PTraceSandbox.hpp"
+#include <mntent.h>
+#include <sys/epoll.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+
+using buildxl::linux::FanotifyName;
+using buildxl::linux::FanotifyRecord;
+using buildxl::linux::ProcessTreeFilter;
+
+// Older headers don't define the rename event (Linux 5.17), in which case renames are reported as moves
+#ifndef FAN_RENAME
+#define FAN_RENAME 0x10000000
+#endif
+
+// Reads are observed through FAN_OPEN: every process of the tree starts after the file systems are marked, so there is no
+// descriptor it could read without opening it first, and FAN_ACCESS would only add an event per read() on the whole machine.
+static const uint64_t kEventMask = FAN_OPEN | FAN_OPEN_EXEC | FAN_CLOSE_WRITE | FAN_CREATE | FAN_DELETE | FAN_ONDIR;
+static const uint64_t kRenameMask = FAN_RENAME;
+static const uint64_t kMoveMask = FAN_MOVED_FROM | FAN_MOVED_TO;
+
+// Pseudo file systems: nothing a pip reads or writes there is tracked
+static const char *kIgnoredFileSystems[] = { "proc", "sysfs", "cgroup", "cgroup2", "devpts", "mqueue", "debugfs", "tracefs", "securityfs",
+                                             "pstore", "bpf", "autofs", "configfs", "fusectl", "hugetlbfs", "binfmt_misc", "nsfs" };
+
+// Resolved directories are forgotten past this, and whenever a directory is renamed or deleted anywhere
+static const size_t kMaxCachedDirectories = 16 * 1024;
+
+static uint64_t FsidToKey(const fsid_t &fsid)
+{
+    uint64_t key;
+    static_assert(sizeof(key) == sizeof(fsid), "fsid_t is two 32-bit values");
+    memcpy(&key, &fsid, sizeof(key));
+    return key;
+}
+
+FanotifySandbox::FanotifySandbox(BxlObserver *bxl)
+{
+    m_bxl = bxl;
+}
+
+FanotifySandbox::~FanotifySandbox()
+{
+    for (auto &mount : m_mountFds)
+    {
+        close(mount.second);
+    }
+
+    for (auto &pidFd : m_pidFds)
+    {
+        close(pidFd.first);
+    }
+
+    if (m_epollFd != -1)
+    {
+        close(m_epollFd);
+    }
+
+    if (m_fanotifyFd != -1)
+    {
+        close(m_fanotifyFd);
+    }
+}
+
+bool FanotifySandbox::Initialize()
+{
+#ifdef FAN_REPORT_DFID_NAME
+    // FAN_UNLIMITED_QUEUE: an overflow would silently lose accesses. It requires the same capability as marking file systems.
+    m_fanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_UNLIMITED_QUEUE | FAN_REPORT_DFID_NAME, O_RDONLY | O_LARGEFILE | O_CLOEXEC);
+#endif
+    if (m_fanotifyFd == -1)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] fanotify_init failed with: '%s'", strerror(errno));
+        return false;
+    }
+
+    MarkFileSystems();
+    if (m_mountFds.empty())
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] Could not mark any of the file systems in %s", "/proc/self/mounts");
+        return false;
+    }
+
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_fanotifyFd;
+    if (m_epollFd == -1 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fanotifyFd, &event) == -1)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] epoll setup failed with: '%s'", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+void FanotifySandbox::MarkFileSystems()
+{
+    FILE *mounts = setmntent("/proc/self/mounts", "r");
+    if (mounts == NULL)
+    {
+        return;
+    }
+
+    // FAN_RENAME needs Linux 5.17: older kernels reject the whole mask
+    m_mask = kEventMask | kRenameMask;
+
+    struct mntent *mount;
+    while ((mount = getmntent(mounts)) != NULL)
+    {
+        bool ignored = false;
+        for (const char *fileSystem : kIgnoredFileSystems)
+        {
+            ignored |= strcmp(mount->mnt_type, fileSystem) == 0;
+        }
+
+        struct statfs stats;
+        if (ignored || statfs(mount->mnt_dir, &stats) == -1 || m_mountFds.find(FsidToKey(stats.f_fsid)) != m_mountFds.end())
+        {
+            continue;
+        }
+
+        int result = fanotify_mark(m_fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, m_mask, AT_FDCWD, mount->mnt_dir);
+        if (result == -1 && errno == EINVAL && (m_mask & kRenameMask))
+        {
+            m_mask = kEventMask | kMoveMask;
+            result = fanotify_mark(m_fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, m_mask, AT_FDCWD, mount->mnt_dir);
+        }
+
+        // Some file systems can't report file handles (e.g., some network file systems): accesses there are not observed
+        if (result == -1)
+        {
+            BXL_LOG_DEBUG(m_bxl, "[Fanotify] Could not mark '%s' (%s): '%s'", mount->mnt_dir, mount->mnt_type, strerror(errno));
+            continue;
+        }
+
+        int mountFd = open(mount->mnt_dir, O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (mountFd != -1)
+        {
+            m_mountFds[FsidToKey(stats.f_fsid)] = mountFd;
+        }
+    }
+
+    endmntent(mounts);
+}
+
+void FanotifySandbox::ObserveProcessTree(pid_t rootPid, std::string exe, std::string semaphoreName)
+{
+    BXL_LOG_DEBUG(m_bxl, "[Fanotify] Starting observer PID '%d' to observe PID '%d' ('%s')", getpid(), rootPid, exe.c_str());
+
+    m_filter.reset(new ProcessTreeFilter(rootPid));
+    if (!AddProcess(rootPid, /* parentPid */ 0))
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] Process '%d' exited before it could be observed", rootPid);
+        _exit(-1);
+    }
+
+    // Tells the root process not to install the seccomp filter of the ptrace sandbox: with no tracer, the traced syscalls would fail
+    std::string markerName = semaphoreName + PTraceSandbox::kUntracedSemaphoreSuffix;
+    sem_t *marker = sem_open(markerName.c_str(), O_CREAT, 0644, 0);
+    if (marker == SEM_FAILED)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] sem_open failed with: '%s'", strerror(errno));
+        _exit(-1);
+    }
+    sem_close(marker);
+
+    // The file systems are marked, signal the semaphore for the root process to exec
+    sem_t *semaphore = sem_open(semaphoreName.c_str(), O_CREAT, 0644, 0);
+    if (semaphore == NULL)
+    {
+        BXL_LOG_DEBUG(m_bxl, "[Fanotify] sem_open failed with: '%s'", strerror(errno));
+        _exit(-1);
+    }
+    sem_post(semaphore);
+    sem_close(semaphore);
+
+    struct epoll_event events[64];
+    while (!m_pidFds.empty())
+    {
+        int count = epoll_wait(m_epollFd, events, sizeof(events) / sizeof(events[0]), -1);
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            std::cerr << "[Fanotify] epoll_wait failed with: " << strerror(errno) << std::endl;
+            _exit(-1);
+        }
+
+        // Events are always read before exits are handled: the accesses of a process are queued before it exits, and once it
+        // exits its pid is no longer considered part of the tree
+        if (!DrainEvents())
+        {
+            _exit(-1);
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.fd != m_fanotifyFd)
+            {
+                RemoveProcess(events[i].data.fd);
+            }
+        }
+    }
+
+    DrainEvents();
+}
+
+bool FanotifySandbox::AddProcess(pid_t pid, pid_t parentPid)
+{
+    if (parentPid != 0)
+    {
+        char exePath[PATH_MAX] = { 0 };
+        std::string link = "/proc/" + std::to_string(pid) + "/exe";
+        readlink(link.c_str(), exePath, sizeof(exePath) - 1);
+
+        auto event = buildxl::linux::SandboxEvent::ForkSandboxEvent(parentPid, pid, exePath);
+        m_bxl->CreateAndReportAccess("fork", event, /* check_cache */ false);
+    }
+
+    int pidFd = (int)syscall(SYS_pidfd_open, pid, 0);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = pidFd;
+    if (pidFd == -1 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, pidFd, &event) == -1)
+    {
+        if (pidFd != -1)
+        {
+            close(pidFd);
+        }
+
+        return false;
+    }
+
+    m_pidFds[pidFd] = pid;
+    BXL_LOG_DEBUG(m_bxl, "[Fanotify] Observing PID '%d', parent PID: '%d'", pid, parentPid);
+    return true;
+}
+
+void FanotifySandbox::RemoveProcess(int pidFd)
+{
+    auto process = m_pidFds.find(pidFd);
+    if (process == m_pidFds.end())
+    {
+        return;
+    }
+
+    pid_t pid = process->second;
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, pidFd, NULL);
+    close(pidFd);
+    m_pidFds.erase(process);
+
+    m_filter->Remove(pid);
+    m_bxl->SendExitReport(pid);
+}
+
+bool FanotifySandbox::DrainEvents()
+{
+    alignas(struct fanotify_event_metadata) char buffer[64 * 1024];
+    std::vector<FanotifyRecord> records;
+    while (true)
+    {
+        ssize_t length = read(m_fanotifyFd, buffer, sizeof(buffer));
+        if (length == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EAGAIN)
+            {
+                return true;
+            }
+
+            std::cerr << "[Fanotify] read failed with: " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        records.clear();
+        buildxl::linux::ParseFanotifyEvents(buffer, length, records);
+        for (const auto &record : records)
+        {
+            ReportEvent(record);
+        }
+    }
+}
+
+void FanotifySandbox::ReportEvent(const FanotifyRecord &record)
+{
+    uint64_t mask = record.mask;
+
+    // Any process may move a directory: resolved directories can't be trusted past this point
+    if ((mask & FAN_ONDIR) && (mask & (FAN_DELETE | kMoveMask | kRenameMask)))
+    {
+        m_directories.clear();
+    }
+
+    std::vector<pid_t> joined;
+    if (!m_filter->Contains(record.pid, ProcessTreeFilter::ReadParent, &joined))
+    {
+        return;
+    }
+
+    // A process that already exited (or can't be waited on) still gets its accesses reported, followed by its exit
+    std::vector<pid_t> exited;
+    for (pid_t pid : joined)
+    {
+        if (!AddProcess(pid, m_filter->ParentOf(pid)))
+        {
+            exited.push_back(pid);
+        }
+    }
+
+    std::string path = ResolvePath(record.path);
+    if (!path.empty())
+    {
+        ReportAccesses(record, path);
+    }
+
+    for (pid_t pid : exited)
+    {
+        m_filter->Remove(pid);
+        m_bxl->SendExitReport(pid);
+    }
+}
+
+void FanotifySandbox::ReportAccesses(const FanotifyRecord &record, const std::string &path)
+{
+    uint64_t mask = record.mask;
+
+    if (mask & FAN_OPEN_EXEC)
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_EXEC, record.pid, path, "execve");
+    }
+
+    if (mask & (FAN_CREATE | FAN_MOVED_TO))
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_CREATE, record.pid, path, (mask & FAN_CREATE) ? "create" : "rename");
+    }
+
+    if (mask & FAN_OPEN)
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_OPEN, record.pid, path, "open");
+    }
+
+    if (mask & FAN_CLOSE_WRITE)
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_WRITE, record.pid, path, "close");
+    }
+
+    if (mask & (FAN_DELETE | FAN_MOVED_FROM))
+    {
+        Report(ES_EVENT_TYPE_NOTIFY_UNLINK, record.pid, path, (mask & FAN_DELETE) ? "unlink" : "rename");
+    }
+
+    if (mask & kRenameMask)
+    {
+        std::string newPath = ResolvePath(record.new_path);
+        if (newPath.empty())
+        {
+            return;
+        }
+
+        // Like PTraceSandbox::HandleRenameGeneric: a renamed directory moves everything under it
+        std::vector<std::string> filesAndDirectories;
+        if (!(mask & FAN_ONDIR) || !m_bxl->EnumerateDirectory(newPath, /* recursive */ true, filesAndDirectories))
+        {
+            filesAndDirectories = { newPath };
+        }
+
+        for (const auto &destination : filesAndDirectories)
+        {
+            Report(ES_EVENT_TYPE_NOTIFY_UNLINK, record.pid, path + destination.substr(newPath.length()), "rename");
+            Report(ES_EVENT_TYPE_NOTIFY_CREATE, record.pid, destination, "rename");
+        }
+    }
+}
+
+void FanotifySandbox::Report(es_event_type_t eventType, pid_t pid, const std::string &path, const char *operation)
+{
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    eventType,
+        /* pid */           pid,
+        /* error */         0,
+        /* src_path */      path.c_str());
+
+    // The directory is resolved by the kernel, but the entry itself is what the process accessed
+    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
+    if (eventType != ES_EVENT_TYPE_NOTIFY_UNLINK)
+    {
+        event.SetMode(m_bxl->get_mode(path.c_str()));
+    }
+
+    m_bxl->CreateAndReportAccess(operation, event);
+}
+
+std::string FanotifySandbox::ResolvePath(const FanotifyName &name)
+{
+    std::string key = std::to_string(name.fsid) + ":" + name.handle;
+    auto cached = m_directories.find(key);
+    std::string directory;
+    if (cached != m_directories.end())
+    {
+        directory = cached->second;
+    }
+    else
+    {
+        auto mount = m_mountFds.find(name.fsid);
+        if (mount == m_mountFds.end())
+        {
+            return "";
+        }
+
+        // open_by_handle_at takes a non-const struct file_handle
+        std::vector<uint32_t> handle((name.handle.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+        memcpy(handle.data(), name.handle.data(), name.handle.size());
+        int fd = open_by_handle_at(mount->second, (struct file_handle *)handle.data(), O_PATH | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return "";
+        }
+
+        char target[PATH_MAX];
+        std::string link = "/proc/self/fd/" + std::to_string(fd);
+        ssize_t length = readlink(link.c_str(), target, sizeof(target));
+        close(fd);
+
+        // A directory that was deleted since the event was queued
+        static const std::string kDeletedSuffix = " (deleted)";
+        directory.assign(target, length > 0 ? length : 0);
+        if (directory.empty() || (directory.length() > kDeletedSuffix.length()
+            && directory.compare(directory.length() - kDeletedSuffix.length(), kDeletedSuffix.length(), kDeletedSuffix) == 0))
+        {
+            return "";
+        }
+
+        if (m_directories.size() >= kMaxCachedDirectories)
+        {
+            m_directories.clear();
+        }
+
+        m_directories[key] = directory;
+    }
+
+    if (name.name.empty() || name.name == ".")
+    {
+        return directory;
+    }
+
+    return directory == "/" ? directory + name.name : directory + "/" + name.name;
+}
@@ -0,0 +1,78 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "bxl_observer.hpp"
+#include "fanotify_events.hpp"
+
+/*
+ * Observes the file accesses of a process tree with fanotify instead of ptrace. This is an alternative to PTraceSandbox for statically
+ * linked processes (which the interposing sandbox can't observe): the processes run at full speed, and the runner only pays for the
+ * events, which the kernel batches in a single read.
+ *
+ * fanotify marks whole file systems, so the runner sees the accesses of every process on the machine and keeps the ones of the pip's
+ * process tree (see buildxl::linux::ProcessTreeFilter). Events are reported after the fact and without the syscall that caused them,
+ * so some accesses can't be observed this way:
+ *   - probes (stat, access, readlink) and failed accesses don't generate fanotify events
+ *   - the accesses of a process that exits before its first event is read can't be attributed to the pip
+ *   - the file is identified by its parent directory and name, so symlinks on the way to it are not reported
+ * Requires CAP_SYS_ADMIN (for FAN_MARK_FILESYSTEM) and CAP_DAC_READ_SEARCH (for open_by_handle_at), and Linux 5.9 or later.
+ * When any of these is missing, Initialize fails and the caller falls back to ptrace.
+ */
+class FanotifySandbox
+{
+public:
+    FanotifySandbox(BxlObserver *bxl);
+    ~FanotifySandbox();
+
+    /*
+     * @brief Sets up fanotify on the mounted file systems
+     * @return False if fanotify is not available (or not usable by this process), in which case nothing is observed
+     */
+    bool Initialize();
+
+    /*
+     * @brief Reports the file accesses of the process tree rooted at the given pid until all of its known processes exit
+     * @param semaphoreName The semaphore the tracee waits on before exec'ing, posted once the tree is being observed
+     */
+    void ObserveProcessTree(pid_t rootPid, std::string exe, std::string semaphoreName);
+
+private:
+    BxlObserver *m_bxl;
+    int m_fanotifyFd = -1;
+    int m_epollFd = -1;
+    // The events the file systems are marked with (renames are reported as moves on kernels without FAN_RENAME)
+    uint64_t m_mask = 0;
+    std::unique_ptr<buildxl::linux::ProcessTreeFilter> m_filter;
+
+    // fsid -> descriptor of a directory on that file system, for open_by_handle_at
+    std::unordered_map<uint64_t, int> m_mountFds;
+    // pidfd -> process of the tree it waits on
+    std::unordered_map<int, pid_t> m_pidFds;
+    // fsid and directory handle -> path of the directory
+    std::unordered_map<std::string, std::string> m_directories;
+
+    void MarkFileSystems();
+
+    /*
+     * @brief Starts waiting on a process of the tree, and reports it to the engine unless it is the root
+     * @return False if the process already exited, in which case the caller reports its exit
+     */
+    bool AddProcess(pid_t pid, pid_t parentPid);
+    void RemoveProcess(int pidFd);
+
+    /*
+     * @brief Reads and reports the queued events
+     * @return False if the fanotify descriptor failed
+     */
+    bool DrainEvents();
+    void ReportEvent(const buildxl::linux::FanotifyRecord &record);
+    void ReportAccesses(const buildxl::linux::FanotifyRecord &record, const std::string &path);
+    void Report(es_event_type_t eventType, pid_t pid, const std::string &path, const char *operation);
+
+    /*
+     * @brief Path of a directory entry reported by fanotify, or an empty string if the directory is gone
+     */
+    std::string ResolvePath(const buildxl::linux::FanotifyName &name);
+};
@@ -23,20 +23,21 @@
         BPF_JUMP(BPF_JMP+BPF_JEQ+BPF_K, SYSCALL_NAME_TO_NUMBER(name), 0, 1), \
         BPF_STMT(BPF_RET+BPF_K, SECCOMP_RET_TRACE)
 
-// There are "new" versions of certain syscalls (such as fstatat).
-// The name of the function does not include the "new" bit, but the name in the kernel includes this prefix
-// Use this macro to trace those syscalls
-// The other "new" variants of the macros in this file achieve the same thing
-#define TRACE_SYSCALL_NEW(name) TRACE_SYSCALL(new##name)
+#define TRACE_CUSTOM_SYSCALL(name, pathArg, secondPathArg) TRACE_SYSCALL(name),
+#define TRACE_DECLARATIVE_SYSCALL(name, shape, event, fdArg, pathArg, flagsArg, resolution) TRACE_SYSCALL(name),
 
 #define HANDLER_FUNCTION(syscallName) void PTraceSandbox::MAKE_HANDLER_FN_NAME(syscallName) ()
-#define HANDLER_FUNCTION_NEW(syscallName) HANDLER_FUNCTION(new##syscallName)
 
-#define CHECK_AND_CALL_HANDLER(syscallName) \
+#define CHECK_AND_CALL_HANDLER(syscallName, pathArg, secondPathArg) \
         case SYSCALL_NAME_TO_NUMBER(syscallName): \
             PTraceSandbox::MAKE_HANDLER_FN_NAME(syscallName) (); \
-            break
-#define CHECK_AND_CALL_HANDLER_NEW(syscallName) CHECK_AND_CALL_HANDLER(new##syscallName)
+            break;
+
+// Each declarative syscall gets a handler specialized at compile time for its entry in the syscall table
+#define CHECK_AND_CALL_DECLARATIVE_HANDLER(syscallName, shape, event, fdArg, pathArg, flagsArg, resolution) \
+        case SYSCALL_NAME_TO_NUMBER(syscallName): \
+            HandleDeclarativeSyscall<buildxl::linux::shape, event, fdArg, pathArg, flagsArg, buildxl::linux::resolution>(SYSCALL_NAME_STRING(syscallName)); \
+            break;
 
 PTraceSandbox::PTraceSandbox(BxlObserver *bxl)
 {
@@ -49,12 +50,7 @@ PTraceSandbox::~PTraceSandbox()
 
 int PTraceSandbox::ExecuteWithPTraceSandbox(const char *file, char *const argv[], char *const envp[], const char *fam)
 {
-    /**
-     * NOTE: when adding new system calls to interpose here, ensure that a matching unit test for that system call
-     * is added to Public/Src/Sandbox/Linux/UnitTests/TestProcesses/TestProcess/main.cpp and Public/Src/Engine/UnitTests/Processes/LinuxSandboxProcessTests.cs
-     */
-
-    // Filter for the syscalls that BXL is interested in tracing
+    // Filter for the syscalls that BXL is interested in tracing (generated from the tables in syscall_table.hpp)
     // Only the syscalls in here will be signalled to the main process by seccomp
     // List of available syscalls to ptrace: https://github.com/torvalds/linux/blob/master/arch/x86/entry/syscalls/syscall_64.tbl
     // NOTE: The set of syscalls here are not equivalent to the set of functions that are interposed by the regular sandbox
@@ -63,59 +59,9 @@ int PTraceSandbox::ExecuteWithPTraceSandbox(const char *file, char *const argv[]
     struct sock_filter filter[] = {
         // This statement loads the syscall number (seccomp_data.nr) into the accumulator
         BPF_STMT(BPF_LD+BPF_W+BPF_ABS, offsetof(struct seccomp_data, nr)),
-        // The next set of statements indicates that we should stop the tracee if one of these syscalls are detected
-        TRACE_SYSCALL(execveat),
-        TRACE_SYSCALL(execve),
-        TRACE_SYSCALL(stat),
-        TRACE_SYSCALL(lstat),
-        TRACE_SYSCALL(fstat),
-        TRACE_SYSCALL_NEW(fstatat),
-        TRACE_SYSCALL(access),
-        TRACE_SYSCALL(faccessat),
-        TRACE_SYSCALL(creat),
-        TRACE_SYSCALL(open),
-        TRACE_SYSCALL(openat),
-        TRACE_SYSCALL(write),
-        TRACE_SYSCALL(writev),
-        TRACE_SYSCALL(pwritev),
-        TRACE_SYSCALL(pwritev2),
-        TRACE_SYSCALL(pwrite64),
-        TRACE_SYSCALL(truncate),
-        TRACE_SYSCALL(ftruncate),
-        TRACE_SYSCALL(rmdir),
-        TRACE_SYSCALL(rename),
-        TRACE_SYSCALL(renameat),
-        TRACE_SYSCALL(renameat2),
-        TRACE_SYSCALL(link),
-        TRACE_SYSCALL(linkat),
-        TRACE_SYSCALL(unlink),
-        TRACE_SYSCALL(unlinkat),
-        TRACE_SYSCALL(symlink),
-        TRACE_SYSCALL(symlinkat),
-        TRACE_SYSCALL(readlink),
-        TRACE_SYSCALL(readlinkat),
-        TRACE_SYSCALL(utime),
-        TRACE_SYSCALL(utimes),
-        TRACE_SYSCALL(utimensat),
-        TRACE_SYSCALL(futimesat),
-        TRACE_SYSCALL(mkdir),
-        TRACE_SYSCALL(mkdirat),
-        TRACE_SYSCALL(mknod),
-        TRACE_SYSCALL(mknodat),
-        TRACE_SYSCALL(chmod),
-        TRACE_SYSCALL(fchmod),
-        TRACE_SYSCALL(fchmodat),
-        TRACE_SYSCALL(chown),
-        TRACE_SYSCALL(fchown),
-        TRACE_SYSCALL(lchown),
-        TRACE_SYSCALL(fchownat),
-        TRACE_SYSCALL(sendfile),
-        TRACE_SYSCALL(copy_file_range),
-        TRACE_SYSCALL(name_to_handle_at),
-        // NOTE: vfork is explicitly not traced here, see PTraceSandbox::UpdateTraceeTableForExec for more details
-        TRACE_SYSCALL(fork),
-        TRACE_SYSCALL(clone),
-        TRACE_SYSCALL(clone3),
+        // The next set of statements indicates that we should stop the tracee if one of these syscalls are detected (see syscall_table.hpp)
+        BXL_DECLARATIVE_SYSCALLS(TRACE_DECLARATIVE_SYSCALL)
+        BXL_CUSTOM_SYSCALLS(TRACE_CUSTOM_SYSCALL)
         // SECCOMP_RET_ALLOW tells seccomp to allow all of the calls that were being filtered above (as opposed to killing them)
         // This would happen if none of the syscall numbers above get matched, and therefore should not stop the tracee
         BPF_STMT(BPF_RET+BPF_K, SECCOMP_RET_ALLOW),
@@ -151,6 +97,15 @@ int PTraceSandbox::ExecuteWithPTraceSandbox(const char *file, char *const argv[]
     sem_close(semaphoreTracee);
     sem_unlink(semaphoreName.c_str());
 
+    // The runner may observe this process without ptrace (see FanotifySandbox and EbpfSandbox), in which case it leaves a second semaphore
+    std::string untracedMarkerName = semaphoreName + kUntracedSemaphoreSuffix;
+    sem_t *untracedMarker = sem_open(untracedMarkerName.c_str(), 0);
+    if (untracedMarker != SEM_FAILED)
+    {
+        sem_close(untracedMarker);
+        sem_unlink(untracedMarkerName.c_str());
+    }
+
     if (waitResult == -1)
     {
         // Tracer failed to attach within 15 seconds
@@ -158,6 +113,12 @@ int PTraceSandbox::ExecuteWithPTraceSandbox(const char *file, char *const argv[]
         m_bxl->real__exit(-1);
     }
 
+    if (untracedMarker != SEM_FAILED)
+    {
+        // Nothing is traced: the process is observed from the outside, and runs without the seccomp filter
+        return m_bxl->real_execvpe(file, argv, envp);
+    }
+
     // This prctl call prevents the child process from having a higher privilege than its parent
     // It is necessary to make the next PR_SET_SECCOMP call work (or else the parent process would need to run as root)
     if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1) {
@@ -274,7 +235,9 @@ void PTraceSandbox::AttachToProcess(pid_t traceePid, std::string exe, std::strin
         else if (status >> 8 == (SIGTRAP | (PTRACE_EVENT_SECCOMP << 8)))
         {
             long syscallNumber = ptrace(PTRACE_PEEKUSER, m_traceePid, sizeof(long) * ORIG_RAX, NULL);
+            BXL_PROBE2(ptrace_syscall_begin, m_traceePid, syscallNumber);
             HandleSysCallGeneric(syscallNumber);
+            BXL_PROBE2(ptrace_syscall_end, m_traceePid, syscallNumber);
 
             // We can resume the child with PTRACE_CONT here to ignore the ptrace-exit-stop for this syscall
             ptrace(PTRACE_CONT, m_traceePid, NULL, NULL);
@@ -470,56 +433,8 @@ void PTraceSandbox::HandleSysCallGeneric(int syscallNumber)
 {
     switch (syscallNumber)
     {
-        CHECK_AND_CALL_HANDLER(execveat);
-        CHECK_AND_CALL_HANDLER(execve);
-        CHECK_AND_CALL_HANDLER(stat);
-        CHECK_AND_CALL_HANDLER(lstat);
-        CHECK_AND_CALL_HANDLER(fstat);
-        CHECK_AND_CALL_HANDLER_NEW(fstatat);
-        CHECK_AND_CALL_HANDLER(access);
-        CHECK_AND_CALL_HANDLER(faccessat);
-        CHECK_AND_CALL_HANDLER(creat);
-        CHECK_AND_CALL_HANDLER(open);
-        CHECK_AND_CALL_HANDLER(openat);
-        CHECK_AND_CALL_HANDLER(write);
-        CHECK_AND_CALL_HANDLER(writev);
-        CHECK_AND_CALL_HANDLER(pwritev);
-        CHECK_AND_CALL_HANDLER(pwritev2);
-        CHECK_AND_CALL_HANDLER(pwrite64);
-        CHECK_AND_CALL_HANDLER(truncate);
-        CHECK_AND_CALL_HANDLER(ftruncate);
-        CHECK_AND_CALL_HANDLER(rmdir);
-        CHECK_AND_CALL_HANDLER(rename);
-        CHECK_AND_CALL_HANDLER(renameat);
-        CHECK_AND_CALL_HANDLER(link);
-        CHECK_AND_CALL_HANDLER(linkat);
-        CHECK_AND_CALL_HANDLER(unlink);
-        CHECK_AND_CALL_HANDLER(unlinkat);
-        CHECK_AND_CALL_HANDLER(symlink);
-        CHECK_AND_CALL_HANDLER(symlinkat);
-        CHECK_AND_CALL_HANDLER(readlink);
-        CHECK_AND_CALL_HANDLER(readlinkat);
-        CHECK_AND_CALL_HANDLER(utime);
-        CHECK_AND_CALL_HANDLER(utimes);
-        CHECK_AND_CALL_HANDLER(utimensat);
-        CHECK_AND_CALL_HANDLER(futimesat);
-        CHECK_AND_CALL_HANDLER(mkdir);
-        CHECK_AND_CALL_HANDLER(mkdirat);
-        CHECK_AND_CALL_HANDLER(mknod);
-        CHECK_AND_CALL_HANDLER(mknodat);
-        CHECK_AND_CALL_HANDLER(chmod);
-        CHECK_AND_CALL_HANDLER(fchmod);
-        CHECK_AND_CALL_HANDLER(fchmodat);
-        CHECK_AND_CALL_HANDLER(chown);
-        CHECK_AND_CALL_HANDLER(fchown);
-        CHECK_AND_CALL_HANDLER(lchown);
-        CHECK_AND_CALL_HANDLER(fchownat);
-        CHECK_AND_CALL_HANDLER(sendfile);
-        CHECK_AND_CALL_HANDLER(copy_file_range);
-        CHECK_AND_CALL_HANDLER(name_to_handle_at);
-        CHECK_AND_CALL_HANDLER(fork);
-        CHECK_AND_CALL_HANDLER(clone);
-        CHECK_AND_CALL_HANDLER(clone3);
+        BXL_DECLARATIVE_SYSCALLS(CHECK_AND_CALL_DECLARATIVE_HANDLER)
+        BXL_CUSTOM_SYSCALLS(CHECK_AND_CALL_HANDLER)
         default:
             // This should not happen in theory with filtering enabled
             // However if it does occur, we can ignore this syscall and log a message for debugging if necessary
@@ -533,7 +448,8 @@ void PTraceSandbox::ReportOpen(std::string path, int oflag, std::string syscallN
     mode_t pathMode = m_bxl->get_mode(path.c_str());
     bool pathExists = pathMode != 0;
     bool isCreate = !pathExists && (oflag & (O_CREAT|O_TRUNC));
-    bool isWrite = pathExists && (oflag & (O_CREAT|O_TRUNC) && ((oflag & O_ACCMODE == O_WRONLY) || (oflag & O_ACCMODE == O_RDWR)));
+    bool hasWriteAccess = ((oflag & O_ACCMODE) == O_WRONLY) || ((oflag & O_ACCMODE) == O_RDWR);
+    bool isWrite = pathExists && (oflag & (O_CREAT|O_TRUNC) && hasWriteAccess);
     auto eventType = isCreate ? ES_EVENT_TYPE_NOTIFY_CREATE : isWrite ? ES_EVENT_TYPE_NOTIFY_WRITE : ES_EVENT_TYPE_NOTIFY_OPEN;
     auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
         /* event_type */    eventType,
@@ -640,82 +556,6 @@ HANDLER_FUNCTION(execve)
     }
 }
 
-HANDLER_FUNCTION(stat)
-{
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(stat), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(stat), event);
-}
-
-HANDLER_FUNCTION(lstat)
-{
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(lstat), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(lstat), event);
-}
-
-HANDLER_FUNCTION(fstat)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(fstat), fd, ES_EVENT_TYPE_NOTIFY_STAT);
-}
-
-// NOTE: This stat function is not interposed by the Linux sandbox normally
-// However, when calling stat, the final call to the kernel may be this one rather than stat which is why we intercept this
-HANDLER_FUNCTION_NEW(fstatat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(fstatat), 2, /* nullTerminated */ true);
-    auto flags = ReadArgumentLong(4);
-
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(fstatat), event);
-}
-
-HANDLER_FUNCTION(access)
-{
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(access), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_ACCESS,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(access), event);
-}
-
-HANDLER_FUNCTION(faccessat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(faccessat), 2, /* nullTerminated */ true);
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_ACCESS,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(faccessat), event);
-}
-
 HANDLER_FUNCTION(creat)
 {
     auto path = m_bxl->normalize_path(ReadArgumentString(SYSCALL_NAME_STRING(creat), 1, /* nullTerminated */ true).c_str(), /* oflags */ 0, m_traceePid);
@@ -739,6 +579,52 @@ HANDLER_FUNCTION(openat)
     ReportOpen(path, flags, SYSCALL_NAME_STRING(openat));
 }
 
+template <buildxl::linux::SyscallShape shape, es_event_type_t eventType, int fdArg, int pathArg, int flagsArg, buildxl::linux::SyscallResolution resolution>
+void PTraceSandbox::HandleDeclarativeSyscall(const char *syscall)
+{
+    static_assert(shape == buildxl::linux::kPathSyscall || fdArg > 0, "fd-based syscalls need a descriptor argument");
+    static_assert(shape == buildxl::linux::kFdSyscall || pathArg > 0, "path-based syscalls need a path argument");
+    static_assert(resolution != buildxl::linux::kNoFollowIfRequested || flagsArg > 0, "honoring AT_SYMLINK_NOFOLLOW needs a flags argument");
+
+    if constexpr (shape == buildxl::linux::kFdSyscall)
+    {
+        // Never reads a path from the tracee
+        HandleReportAccessFd(syscall, ReadArgumentLong(fdArg), eventType);
+    }
+    else
+    {
+        auto pathname = ReadArgumentString((char *)syscall, pathArg, /* nullTerminated */ true);
+
+        // TODO: Figure out how to report the errno
+        auto event = shape == buildxl::linux::kDirfdPathSyscall
+            ? buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
+                /* event_type */    eventType,
+                /* pid */           m_traceePid,
+                /* error */         0,
+                /* src_path */      pathname.c_str(),
+                /* src_fd */        (int)ReadArgumentLong(fdArg))
+            : buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+                /* event_type */    eventType,
+                /* pid */           m_traceePid,
+                /* error */         0,
+                /* src_path */      pathname.c_str());
+
+        if constexpr (resolution == buildxl::linux::kNoFollowSymlinks)
+        {
+            event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
+        }
+        else if constexpr (resolution == buildxl::linux::kNoFollowIfRequested)
+        {
+            if (ReadArgumentLong(flagsArg) & AT_SYMLINK_NOFOLLOW)
+            {
+                event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
+            }
+        }
+
+        m_bxl->CreateAndReportAccess(syscall, event);
+    }
+}
+
 void PTraceSandbox::HandleReportAccessFd(const char *syscall, int fd, es_event_type_t eventType /*ES_EVENT_TYPE_NOTIFY_WRITE*/)
 {
     auto path = m_bxl->fd_to_path(fd, m_traceePid);
@@ -755,54 +641,6 @@ void PTraceSandbox::HandleReportAccessFd(const char *syscall, int fd, es_event_t
     }
 }
 
-HANDLER_FUNCTION(write)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(write), fd);
-}
-
-HANDLER_FUNCTION(writev)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(writev), fd);
-}
-
-HANDLER_FUNCTION(pwritev)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(pwritev), fd);
-}
-
-HANDLER_FUNCTION(pwritev2)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(pwritev2), fd);
-}
-
-HANDLER_FUNCTION(pwrite64)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(pwrite64), fd);
-}
-
-HANDLER_FUNCTION(truncate)
-{
-    auto path = ReadArgumentString(SYSCALL_NAME_STRING(truncate), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_WRITE,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      path.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(truncate), event);
-}
-
-HANDLER_FUNCTION(ftruncate)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(ftruncate), fd);
-}
-
 HANDLER_FUNCTION(rmdir)
 {
     auto path = ReadArgumentString(SYSCALL_NAME_STRING(rmdir), 1, /* nullTerminated */ true);
@@ -872,8 +710,9 @@ void PTraceSandbox::HandleRenameGeneric(const char *syscall, int olddirfd, const
                 auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
                     /* event_type */    ES_EVENT_TYPE_NOTIFY_UNLINK,
                     /* pid */           m_traceePid,
-                    /* error */         mode,
+                    /* error */         0,
                     /* src_path */      fileOrDirectory.c_str());
+                event.SetMode(mode);
                 event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
                 m_bxl->CreateAndReportAccess(syscall, event);
 
@@ -890,8 +729,9 @@ void PTraceSandbox::HandleRenameGeneric(const char *syscall, int olddirfd, const
         auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
             /* event_type */    ES_EVENT_TYPE_NOTIFY_UNLINK,
             /* pid */           m_traceePid,
-            /* error */         mode,
+            /* error */         0,
             /* src_path */      oldStr.c_str());
+        event.SetMode(mode);
         event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
         m_bxl->CreateAndReportAccess(syscall, event);
 
@@ -1000,88 +840,7 @@ HANDLER_FUNCTION(symlinkat)
         /* src_fd */        dirfd);
     event.SetMode(S_IFLNK);
 
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(fstatat), event);
-}
-
-HANDLER_FUNCTION(readlink)
-{
-    auto path = ReadArgumentString(SYSCALL_NAME_STRING(readlink), 1, /* nullTerminated */ true);
-
-    // TODO [pgunasekara]: A follow up change to handle paths that require normalization.
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_READLINK,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      path.c_str());
-    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(readlink), event);
-}
-
-HANDLER_FUNCTION(readlinkat)
-{
-    auto fd = ReadArgumentLong(1);
-    auto path = ReadArgumentString(SYSCALL_NAME_STRING(readlinkat), 2, /* nullTerminated */ true);
-
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-            /* event_type */    ES_EVENT_TYPE_NOTIFY_READLINK,
-            /* pid */           m_traceePid,
-            /* error */         0,
-            /* src_path */      path.c_str(),
-            /* src_fd */        fd);
-    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(readlinkat), event);
-}
-
-HANDLER_FUNCTION(utime)
-{
-    auto filename = ReadArgumentString(SYSCALL_NAME_STRING(utime), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_SETTIME,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      filename.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(utime), event);
-}
-
-HANDLER_FUNCTION(utimes)
-{
-    Handleutime();
-}
-
-HANDLER_FUNCTION(utimensat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(utimensat), 2, /* nullTerminated */ true);
-
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_SETTIME,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(utimensat), event);
-}
-
-HANDLER_FUNCTION(futimesat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(futimesat), 2, /* nullTerminated */ true);
-
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_SETTIME,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(futimesat), event);
+    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(symlinkat), event);
 }
 
 HANDLER_FUNCTION(mkdir)
@@ -1130,109 +889,6 @@ HANDLER_FUNCTION(mknodat)
 
 }
 
-HANDLER_FUNCTION(chmod)
-{
-    auto path = ReadArgumentString(SYSCALL_NAME_STRING(chmod), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_SETMODE,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      path.c_str());
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(chmod), event);
-}
-
-HANDLER_FUNCTION(fchmod)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(fchmod), fd, ES_EVENT_TYPE_NOTIFY_SETMODE);
-}
-
-HANDLER_FUNCTION(fchmodat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(fchmodat), 2, /* nullTerminated */ true);
-    auto flags = ReadArgumentLong(4);
-
-    // TODO: Figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_SETMODE,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-    
-    if (flags & AT_SYMLINK_NOFOLLOW) {
-        event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-    }
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(fchmodat), event);
-}
-
-HANDLER_FUNCTION(chown)
-{
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(chown), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_AUTH_SETOWNER,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str());
-    
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(chown), event);
-}
-
-HANDLER_FUNCTION(fchown)
-{
-    auto fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(fchown), fd, ES_EVENT_TYPE_AUTH_SETOWNER);
-}
-
-HANDLER_FUNCTION(lchown)
-{
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(lchown), 1, /* nullTerminated */ true);
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_AUTH_SETOWNER,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str());
-    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(lchown), event);
-}
-
-HANDLER_FUNCTION(fchownat)
-{
-    auto dirfd = ReadArgumentLong(1);
-    auto pathname = ReadArgumentString(SYSCALL_NAME_STRING(fchownat), 2, /* nullTerminated */ true);
-    auto flags = ReadArgumentLong(5);
-
-    // TODO: figure out how to report the errno
-    auto event = buildxl::linux::SandboxEvent::RelativePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_AUTH_SETOWNER,
-        /* pid */           m_traceePid,
-        /* error */         0,
-        /* src_path */      pathname.c_str(),
-        /* src_fd */        dirfd);
-
-    if (flags & AT_SYMLINK_NOFOLLOW) {
-        event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-    }
-
-    m_bxl->CreateAndReportAccess(SYSCALL_NAME_STRING(fchownat), event);
-}
-
-HANDLER_FUNCTION(sendfile)
-{
-    auto out_fd = ReadArgumentLong(1);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(sendfile), out_fd);
-}
-
-HANDLER_FUNCTION(copy_file_range)
-{
-    auto fd_out = ReadArgumentLong(3);
-    HandleReportAccessFd(SYSCALL_NAME_STRING(copy_file_range), fd_out);
-}
-
 HANDLER_FUNCTION(name_to_handle_at)
 {
     auto dirfd = ReadArgumentLong(1);
@@ -4,12 +4,12 @@
 #pragma once
 
 #include "bxl_observer.hpp"
+#include "syscall_table.hpp"
 
 typedef void (*HandlerFunction)(void);
 
 #define MAKE_HANDLER_FN_NAME(syscallName) Handle##syscallName
 #define MAKE_HANDLER_FN_DEF(syscallName) void MAKE_HANDLER_FN_NAME(syscallName) ()
-#define MAKE_HANDLER_FN_DEF_NEW(syscallName) MAKE_HANDLER_FN_DEF(new##syscallName)
 
 /*
  * See the documentation section of the repository for an explanation on how this all works along with some helpful resources.
@@ -27,6 +27,10 @@ typedef void (*HandlerFunction)(void);
 class PTraceSandbox
 {
 public:
+    // Appended to the name of the semaphore the tracee waits on: when the runner observes the tracee without ptrace (see
+    // FanotifySandbox and EbpfSandbox), it creates this semaphore before posting, so the tracee doesn't install the seccomp filter
+    static constexpr const char *kUntracedSemaphoreSuffix = ".untraced";
+
     PTraceSandbox(BxlObserver *bxl);
     ~PTraceSandbox();
     
@@ -91,59 +95,14 @@ private:
     int GetErrno();
     void UpdateTraceeTableForExec(std::string exePath);
 
-    // Handlers
-    MAKE_HANDLER_FN_DEF(execveat);
-    MAKE_HANDLER_FN_DEF(execve);
-    MAKE_HANDLER_FN_DEF(stat);
-    MAKE_HANDLER_FN_DEF(lstat);
-    MAKE_HANDLER_FN_DEF(fstat);
-    MAKE_HANDLER_FN_DEF_NEW(fstatat);
-    MAKE_HANDLER_FN_DEF(access);
-    MAKE_HANDLER_FN_DEF(faccessat);
-    MAKE_HANDLER_FN_DEF(creat);
-    MAKE_HANDLER_FN_DEF(open);
-    MAKE_HANDLER_FN_DEF(openat);
-    MAKE_HANDLER_FN_DEF(write);
-    MAKE_HANDLER_FN_DEF(writev);
-    MAKE_HANDLER_FN_DEF(pwritev);
-    MAKE_HANDLER_FN_DEF(pwritev2);
-    MAKE_HANDLER_FN_DEF(pwrite64);
-    MAKE_HANDLER_FN_DEF(truncate);
-    MAKE_HANDLER_FN_DEF(ftruncate);
-    MAKE_HANDLER_FN_DEF(rmdir);
-    MAKE_HANDLER_FN_DEF(rename);
-    MAKE_HANDLER_FN_DEF(renameat);
-    MAKE_HANDLER_FN_DEF(renameat2);
-    MAKE_HANDLER_FN_DEF(link);
-    MAKE_HANDLER_FN_DEF(linkat);
-    MAKE_HANDLER_FN_DEF(unlink);
-    MAKE_HANDLER_FN_DEF(unlinkat);
-    MAKE_HANDLER_FN_DEF(symlink);
-    MAKE_HANDLER_FN_DEF(symlinkat);
-    MAKE_HANDLER_FN_DEF(readlink);
-    MAKE_HANDLER_FN_DEF(readlinkat);
-    MAKE_HANDLER_FN_DEF(utime);
-    MAKE_HANDLER_FN_DEF(utimes);
-    MAKE_HANDLER_FN_DEF(utimensat);
-    MAKE_HANDLER_FN_DEF(futimesat);
-    MAKE_HANDLER_FN_DEF(mkdir);
-    MAKE_HANDLER_FN_DEF(mkdirat);
-    MAKE_HANDLER_FN_DEF(mknod);
-    MAKE_HANDLER_FN_DEF(mknodat);
-    MAKE_HANDLER_FN_DEF(chmod);
-    MAKE_HANDLER_FN_DEF(fchmod);
-    MAKE_HANDLER_FN_DEF(fchmodat);
-    MAKE_HANDLER_FN_DEF(chown);
-    MAKE_HANDLER_FN_DEF(fchown);
-    MAKE_HANDLER_FN_DEF(lchown);
-    MAKE_HANDLER_FN_DEF(fchownat);
-    MAKE_HANDLER_FN_DEF(sendfile);
-    MAKE_HANDLER_FN_DEF(copy_file_range);
-    MAKE_HANDLER_FN_DEF(name_to_handle_at);
+    // Handlers for the custom syscalls in syscall_table.hpp (the declarative ones are all handled by HandleDeclarativeSyscall)
+#define DECLARE_CUSTOM_HANDLER(syscallName, pathArg, secondPathArg) MAKE_HANDLER_FN_DEF(syscallName);
+    BXL_CUSTOM_SYSCALLS(DECLARE_CUSTOM_HANDLER)
+#undef DECLARE_CUSTOM_HANDLER
     MAKE_HANDLER_FN_DEF(exit);
-    MAKE_HANDLER_FN_DEF(fork);
-    MAKE_HANDLER_FN_DEF(clone);
-    MAKE_HANDLER_FN_DEF(clone3);
+
+    template <buildxl::linux::SyscallShape shape, es_event_type_t eventType, int fdArg, int pathArg, int flagsArg, buildxl::linux::SyscallResolution resolution>
+    void HandleDeclarativeSyscall(const char *syscall);
     void HandleChildProcess(const char *syscall);
     void HandleRenameGeneric(const char *syscall, int olddirfd, const char *oldpath, int newdirfd, const char *newpath);
     void HandleReportAccessFd(const char *syscall, int fd, es_event_type_t eventType = ES_EVENT_TYPE_NOTIFY_WRITE);
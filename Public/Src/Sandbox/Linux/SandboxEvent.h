@@ -7,6 +7,7 @@
 #include <unistd.h>
 #include <string>
 #include <sys/stat.h>
+#include "fixed_path.hpp"
 
 namespace buildxl {
 namespace linux {
@@ -37,9 +38,9 @@ private:
     es_event_type_t event_type_;
     // Describes the type of path that this SandboxEvent represents.
     SandboxEventPathType path_type_;
-    // Relative or absolute paths
-    std::string src_path_;
-    std::string dst_path_;
+    // Relative or absolute paths. Stored inline so creating and resolving an event never allocates.
+    FixedPath src_path_;
+    FixedPath dst_path_;
     // File descriptor to src/dst paths or file descriptors for root directories for relative paths
     int src_fd_;
     int dst_fd_;
@@ -56,8 +57,8 @@ private:
 
     SandboxEvent(
         es_event_type_t event_type,
-        const std::string& src_path,
-        const std::string& dst_path,
+        const char *src_path,
+        const char *dst_path,
         int src_fd,
         int dst_fd,
         pid_t pid,
@@ -86,7 +87,7 @@ public:
     static SandboxEvent ForkSandboxEvent(pid_t pid, pid_t child_pid, const std::string& path) {
         return SandboxEvent(
             /* event_type */ ES_EVENT_TYPE_NOTIFY_FORK,
-            /* src_path */ path,
+            /* src_path */ path.c_str(),
             /* dst_path */ "",
             /* src_fd */ -1,
             /* dst_fd */ -1,
@@ -194,8 +195,8 @@ public:
     pid_t GetChildPid() const { assert(is_valid_); return child_pid_; }
     es_event_type_t GetEventType() const { assert(is_valid_); return event_type_; }
     mode_t GetMode() const { assert(is_valid_); return mode_; }
-    const std::string& GetSrcPath() const { assert(is_valid_); return src_path_; }
-    const std::string& GetDstPath() const { assert(is_valid_); return dst_path_; }
+    const FixedPath& GetSrcPath() const { assert(is_valid_); return src_path_; }
+    const FixedPath& GetDstPath() const { assert(is_valid_); return dst_path_; }
     int GetSrcFd() const { assert(is_valid_); return src_fd_; }
     int GetDstFd() const { assert(is_valid_); return dst_fd_; }
     uint GetError() const { assert(is_valid_); return error_; }
@@ -213,11 +214,11 @@ public:
     /**
      * Updates the source and destination paths to be absolute paths.
      */
-    void SetResolvedPaths(const std::string& src_path, const std::string& dst_path) {
+    void SetResolvedPaths(const char *src_path, const char *dst_path) {
         assert(is_valid_);
         assert(!is_sealed_);
-        src_path_ = src_path;
-        dst_path_ = dst_path;
+        src_path_.Assign(src_path);
+        dst_path_.Assign(dst_path);
         src_fd_ = -1;
         dst_fd_ = -1;
         required_path_resolution_ = RequiredPathResolution::kDoNotResolve;  // Prevent the paths from being normalized again 
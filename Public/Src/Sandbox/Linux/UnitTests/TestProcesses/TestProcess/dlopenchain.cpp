@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+// Built as libDlopenChain1.so, libDlopenChain2.so and libDlopenChain3.so (CHAIN_LEVEL 1 to 3): each level loads the next one,
+// from the directory it was loaded from, and calls into it.
+
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#ifndef CHAIN_LEVEL
+#error CHAIN_LEVEL must be defined
+#endif
+
+#define CHAIN_LAST_LEVEL 3
+
+extern "C" int DlopenChain()
+{
+#if CHAIN_LEVEL == CHAIN_LAST_LEVEL
+    return CHAIN_LEVEL;
+#else
+    Dl_info info;
+    if (dladdr((void *)&DlopenChain, &info) == 0 || info.dli_fname == nullptr)
+    {
+        return -1;
+    }
+
+    std::string next(info.dli_fname);
+    next.resize(next.rfind('/') + 1);
+    next.append("libDlopenChain").append(std::to_string(CHAIN_LEVEL + 1)).append(".so");
+
+    void *handle = dlopen(next.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr)
+    {
+        fprintf(stderr, "dlopen failed: %s\n", dlerror());
+        return -1;
+    }
+
+    auto chain = (int (*)())dlsym(handle, "DlopenChain");
+    int level = chain != nullptr ? chain() : -1;
+    dlclose(handle);
+    return level;
+#endif
+}
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <dlfcn.h>
 #include <errno.h>
 #include <iostream>
 #include <sys/mman.h>
@@ -75,14 +76,299 @@ int FileDescriptorAccessesFullyResolvesPath()
     return EXIT_SUCCESS;
 }
 
+// The managed side asks for the loaded libraries to be reported. libDlopenChain1.so (next to this executable) loads
+// libDlopenChain2.so, which loads libDlopenChain3.so: the loader opens all three without going through libc.
+int DlopenChain()
+{
+    char exe[PATH_MAX] = { 0 };
+    ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length <= 0)
+    {
+        std::cerr << "readlink failed with errno " << errno << std::endl;
+        return 2;
+    }
+
+    std::string first(exe, length);
+    first.resize(first.rfind('/') + 1);
+    first.append("libDlopenChain1.so");
+
+    void *handle = dlopen(first.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr)
+    {
+        std::cerr << "dlopen failed: " << dlerror() << std::endl;
+        return 3;
+    }
+
+    auto chain = (int (*)())dlsym(handle, "DlopenChain");
+    if (chain == nullptr || chain() != 3)
+    {
+        std::cerr << "the chain of libraries did not load" << std::endl;
+        return 4;
+    }
+
+    dlclose(handle);
+    return EXIT_SUCCESS;
+}
+
+// The managed side spreads the reports of the pip over several report channels. Every process of this tree writes a file
+// named after its position in the tree (processTree_<child>_<level>), so reports from every channel are needed to see all of them.
+int ProcessTreeOnReportChannels()
+{
+    const int childCount = 16;
+    for (int i = 0; i < childCount; i++)
+    {
+        pid_t child = fork();
+        if (child == -1)
+        {
+            std::cerr << "fork failed with errno " << errno << std::endl;
+            return 2;
+        }
+
+        if (child == 0)
+        {
+            // Each child forks a child of its own, so start reports for a process and exit reports for its parent land on different channels
+            pid_t grandchild = fork();
+            std::string path = "processTree_" + std::to_string(i) + "_" + (grandchild == 0 ? "1" : "0");
+            int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd == -1 || close(fd) == -1)
+            {
+                _exit(3);
+            }
+
+            if (grandchild > 0)
+            {
+                int status = 0;
+                waitpid(grandchild, &status, 0);
+                _exit(WIFEXITED(status) ? WEXITSTATUS(status) : 4);
+            }
+
+            _exit(grandchild == 0 ? 0 : 5);
+        }
+    }
+
+    int result = EXIT_SUCCESS;
+    int status = 0;
+    while (wait(&status) > 0)
+    {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            result = 6;
+        }
+    }
+
+    return result;
+}
+
+static bool WriteOutput(const char *path, int oflag, const char *content)
+{
+    int fd = open(path, oflag, 0644);
+    if (fd == -1)
+    {
+        std::cerr << "open(" << path << ") failed with errno " << errno << std::endl;
+        return false;
+    }
+
+    ssize_t length = strlen(content);
+    bool written = write(fd, content, length) == length;
+    return close(fd) == 0 && written;
+}
+
+// The managed side turns on output hashing, output close notifications and I/O accounting, and declares both files as outputs.
+// outputWrittenOnce is written, closed and read back. outputReopened is written, closed, and reopened to be appended to, so what
+// the sandbox said about its first close is superseded by the second one.
+int WriteOutputs()
+{
+    if (!WriteOutput("outputWrittenOnce", O_WRONLY | O_CREAT | O_TRUNC, "hello")
+        || !WriteOutput("outputReopened", O_WRONLY | O_CREAT | O_TRUNC, "hello")
+        || !WriteOutput("outputReopened", O_WRONLY | O_APPEND, " world"))
+    {
+        return 2;
+    }
+
+    char buf[5];
+    int fd = open("outputWrittenOnce", O_RDONLY);
+    if (fd == -1 || read(fd, buf, sizeof(buf)) != sizeof(buf) || close(fd) == -1)
+    {
+        std::cerr << "reading outputWrittenOnce back failed with errno " << errno << std::endl;
+        return 3;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// The managed side turns on I/O accounting. The child of clone starts from a copy of this process, including what this process
+// accounted for cloneOutput before it cloned: the child must only report what it read itself.
+static int ReadCloneOutput(void *arg)
+{
+    char buf[5];
+    int fd = open("cloneOutput", O_RDONLY);
+    bool readBack = fd != -1 && read(fd, buf, sizeof(buf)) == sizeof(buf) && close(fd) == 0;
+    exit(readBack ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+int IoVolumesAcrossClone()
+{
+    if (!WriteOutput("cloneOutput", O_WRONLY | O_CREAT | O_TRUNC, "hello"))
+    {
+        return 2;
+    }
+
+    const int stackSize = 65536;
+    char *stack = (char *)malloc(stackSize);
+    pid_t child = clone(ReadCloneOutput, stack + stackSize, SIGCHLD, nullptr);
+    if (child == -1)
+    {
+        std::cerr << "clone failed with errno " << errno << std::endl;
+        return 3;
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? EXIT_SUCCESS : 4;
+}
+
+// The managed side turns on access summary mode and lets the test write and read summaryInput. The child reads it, so the read is
+// held in the summary of the child until it exits: a child that is killed never sends it.
+static int ReadSummaryInputInChild(bool killChild)
+{
+    if (!WriteOutput("summaryInput", O_WRONLY | O_CREAT | O_TRUNC, "hello"))
+    {
+        return 2;
+    }
+
+    pid_t child = fork();
+    if (child == -1)
+    {
+        std::cerr << "fork failed with errno " << errno << std::endl;
+        return 3;
+    }
+
+    if (child == 0)
+    {
+        char buf[5];
+        int fd = open("summaryInput", O_RDONLY);
+        if (fd == -1 || read(fd, buf, sizeof(buf)) != sizeof(buf) || close(fd) == -1)
+        {
+            _exit(EXIT_FAILURE);
+        }
+
+        if (killChild)
+        {
+            raise(SIGKILL);
+        }
+
+        exit(EXIT_SUCCESS);
+    }
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    bool expected = killChild
+        ? WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL
+        : WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return expected ? EXIT_SUCCESS : 4;
+}
+
+int SummarizedReadInExitedChild()
+{
+    return ReadSummaryInputInChild(/* killChild */ false);
+}
+
+int SummarizedReadInKilledChild()
+{
+    return ReadSummaryInputInChild(/* killChild */ true);
+}
+
+// The managed side points TEST_INPUT at a file (or a symlink to one) that exists before the pip starts, and keeps it across runs of the test
+int ReadInput()
+{
+    const char *input = getenv("TEST_INPUT");
+    if (input == nullptr)
+    {
+        std::cerr << "TEST_INPUT is not set" << std::endl;
+        return 2;
+    }
+
+    char buf[5];
+    int fd = open(input, O_RDONLY);
+    if (fd == -1 || read(fd, buf, sizeof(buf)) != sizeof(buf) || close(fd) == -1)
+    {
+        std::cerr << "Could not read '" << input << "', errno " << errno << std::endl;
+        return 3;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+// The managed side only allows writing concurrentOutput_<i> if the file did not exist before the pip. Children are released together
+// and all write the same new files, so the first write check for a file races with other children creating it.
+int ConcurrentWritesToNewFiles()
+{
+    const int childCount = 16;
+    const int fileCount = 1000;
+
+    int barrier[2];
+    if (pipe(barrier) == -1)
+    {
+        std::cerr << "pipe failed with errno " << errno << std::endl;
+        return 2;
+    }
+
+    for (int i = 0; i < childCount; i++)
+    {
+        pid_t child = fork();
+        if (child == -1)
+        {
+            std::cerr << "fork failed with errno " << errno << std::endl;
+            return 3;
+        }
+
+        if (child == 0)
+        {
+            // Blocks until the parent closes the write end of the barrier
+            char c;
+            close(barrier[1]);
+            if (read(barrier[0], &c, 1) != 0)
+            {
+                _exit(4);
+            }
+
+            for (int f = 0; f < fileCount; f++)
+            {
+                std::string path = "concurrentOutput_" + std::to_string(f);
+                if (!WriteOutput(path.c_str(), O_WRONLY | O_CREAT, "hello"))
+                {
+                    _exit(5);
+                }
+            }
+
+            _exit(EXIT_SUCCESS);
+        }
+    }
+
+    close(barrier[0]);
+    close(barrier[1]);
+
+    int result = EXIT_SUCCESS;
+    int status = 0;
+    while (wait(&status) > 0)
+    {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            result = 6;
+        }
+    }
+
+    return result;
+}
 
 int main(int argc, char **argv)
 {
     int opt;
     std::string testName;
+    bool listTests = false;
 
     // Parse arguments
-    while((opt = getopt(argc, argv, "t")) != -1)
+    while((opt = getopt(argc, argv, "tl")) != -1)
     {
         switch (opt)
         {
@@ -90,129 +376,41 @@ int main(int argc, char **argv)
                 // -t <name of test to run>
                 testName = std::string(argv[optind]);
                 break;
+            case 'l':
+                // -l: list the syscall tests, one per line
+                listTests = true;
+                break;
         }
     }
 
     #define STR(NAME) #NAME
+
+    if (listTests)
+    {
+        #define PRINT_TEST_NAME(NAME)   { std::cout << STR(Test##NAME) << std::endl; }
+        FOR_EACH_SYSCALL_TEST(PRINT_TEST_NAME)
+        exit(EXIT_SUCCESS);
+    }
+
     #define IF_COMMAND(NAME)   { if (testName == #NAME) { exit(NAME()); } }
     #define IF_COMMAND_STR(NAME)   { if (testName == STR(Test##NAME)) { exit(Test##NAME()); } }
 
     // Function Definitions
     // Basic tests
-    IF_COMMAND_STR(fork);
-    IF_COMMAND_STR(vfork);
-    IF_COMMAND_STR(clone);
-    IF_COMMAND_STR(clone3);
-    IF_COMMAND_STR(fexecve);
-    IF_COMMAND_STR(execv);
-    IF_COMMAND_STR(execve);
-    IF_COMMAND_STR(execvp);
-    IF_COMMAND_STR(execvpe);
-    IF_COMMAND_STR(execl);
-    IF_COMMAND_STR(execlp);
-    IF_COMMAND_STR(execle);
-    IF_COMMAND(Test__lxstat);
-    IF_COMMAND(Test__lxstat64);
-    IF_COMMAND(Test__xstat);
-    IF_COMMAND(Test__xstat64);
-    IF_COMMAND(Test__fxstat);
-    IF_COMMAND(Test__fxstatat);
-    IF_COMMAND(Test__fxstat64);
-    IF_COMMAND(Test__fxstatat64);
-    IF_COMMAND(Teststat);
-    IF_COMMAND(Teststat64);
-    IF_COMMAND(Testlstat);
-    IF_COMMAND(Testlstat64);
-    IF_COMMAND(Testfstat);
-    IF_COMMAND(Testfstat64);
-    IF_COMMAND_STR(fdopen);
-    IF_COMMAND_STR(fopen);
-    IF_COMMAND_STR(fopen64);
-    IF_COMMAND_STR(freopen);
-    IF_COMMAND_STR(freopen64);
-    IF_COMMAND_STR(fread);
-    IF_COMMAND_STR(fwrite);
-    IF_COMMAND_STR(fputc);
-    IF_COMMAND_STR(fputs);
-    IF_COMMAND_STR(putc);
-    IF_COMMAND_STR(putchar);
-    IF_COMMAND_STR(puts);
-    IF_COMMAND_STR(access);
-    IF_COMMAND_STR(faccessat);
-    IF_COMMAND_STR(creat);
-    IF_COMMAND_STR(open64);
-    IF_COMMAND_STR(open);
-    IF_COMMAND_STR(openat);
-    IF_COMMAND_STR(write);
-    IF_COMMAND_STR(writev);
-    IF_COMMAND_STR(pwritev);
-    IF_COMMAND_STR(pwritev2);
-    IF_COMMAND_STR(pwrite);
-    IF_COMMAND_STR(pwrite64);
-    IF_COMMAND_STR(remove);
-    IF_COMMAND_STR(truncate);
-    IF_COMMAND_STR(ftruncate);
-    IF_COMMAND_STR(truncate64);
-    IF_COMMAND_STR(ftruncate64);
-    IF_COMMAND_STR(rmdir);
-    IF_COMMAND_STR(rename);
-    IF_COMMAND_STR(renameat);
-    IF_COMMAND_STR(renameat2);
-    IF_COMMAND_STR(link);
-    IF_COMMAND_STR(linkat);
-    IF_COMMAND_STR(unlink);
-    IF_COMMAND_STR(unlinkat);
-    IF_COMMAND_STR(symlink);
-    IF_COMMAND_STR(symlinkat);
-    IF_COMMAND_STR(readlink);
-    IF_COMMAND_STR(readlinkat);
-    IF_COMMAND_STR(realpath);
-    IF_COMMAND_STR(opendir);
-    IF_COMMAND_STR(fdopendir);
-    IF_COMMAND_STR(utime);
-    IF_COMMAND_STR(utimes);
-    IF_COMMAND_STR(utimensat);
-    IF_COMMAND_STR(futimesat);
-    IF_COMMAND_STR(futimens);
-    IF_COMMAND_STR(mkdir);
-    IF_COMMAND_STR(mkdirat);
-    IF_COMMAND_STR(mknod);
-    IF_COMMAND_STR(mknodat);
-    IF_COMMAND_STR(printf);
-    IF_COMMAND_STR(fprintf);
-    IF_COMMAND_STR(dprintf);
-    IF_COMMAND_STR(vprintf);
-    IF_COMMAND_STR(vfprintf);
-    IF_COMMAND_STR(vdprintf);
-    IF_COMMAND_STR(chmod);
-    IF_COMMAND_STR(fchmod);
-    IF_COMMAND_STR(fchmodat);
-    IF_COMMAND_STR(chown);
-    IF_COMMAND_STR(fchown);
-    IF_COMMAND_STR(lchown);
-    IF_COMMAND_STR(fchownat);
-    IF_COMMAND_STR(sendfile);
-    IF_COMMAND_STR(sendfile64);
-    IF_COMMAND_STR(copy_file_range);
-    IF_COMMAND_STR(name_to_handle_at);
-    IF_COMMAND_STR(dup);
-    IF_COMMAND_STR(dup2);
-    IF_COMMAND_STR(dup3);
-    IF_COMMAND_STR(scandir);
-    IF_COMMAND_STR(scandir64);
-    IF_COMMAND_STR(scandirat);
-    IF_COMMAND_STR(scandirat64);
-    IF_COMMAND_STR(statx);
-    IF_COMMAND_STR(closedir);
-    IF_COMMAND_STR(readdir);
-    IF_COMMAND_STR(readdir64);
-    IF_COMMAND_STR(readdir_r);
-    IF_COMMAND_STR(readdir64_r);
+    FOR_EACH_SYSCALL_TEST(IF_COMMAND_STR)
     // Special tests
     IF_COMMAND(TestAnonymousFile);
     IF_COMMAND(FullPathResolutionOnReports);
     IF_COMMAND(ReadlinkReportDoesNotResolveFinalComponent);
     IF_COMMAND(FileDescriptorAccessesFullyResolvesPath);
+    IF_COMMAND(DlopenChain);
+    IF_COMMAND(ProcessTreeOnReportChannels);
+    IF_COMMAND(WriteOutputs);
+    IF_COMMAND(IoVolumesAcrossClone);
+    IF_COMMAND(SummarizedReadInExitedChild);
+    IF_COMMAND(SummarizedReadInKilledChild);
+    IF_COMMAND(ConcurrentWritesToNewFiles);
+    IF_COMMAND(ReadInput);
 
     // Invalid command
     exit(-1);
@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <access_cache.hpp>
+#include <fixed_path.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+// Every heap allocation in this executable (including operator new, which goes through malloc) is counted while this is set
+static bool g_count_allocations = false;
+static size_t g_allocations = 0;
+
+extern "C" void *malloc(size_t size) {
+    if (g_count_allocations) g_allocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+    if (g_count_allocations) g_allocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+    if (g_count_allocations) g_allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+// Returns the number of heap allocations made by 'action'
+template <typename Action>
+static size_t CountAllocations(Action action) {
+    g_allocations = 0;
+    g_count_allocations = true;
+    action();
+    g_count_allocations = false;
+    return g_allocations;
+}
+
+static vector<string> Paths(int count) {
+    vector<string> paths;
+    for (int i = 0; i < count; i++) {
+        paths.push_back("/home/user/src/project/obj/some/fairly/deep/directory/file_" + to_string(i) + ".o");
+    }
+
+    return paths;
+}
+
+BOOST_AUTO_TEST_SUITE(AccessCacheTests)
+
+BOOST_AUTO_TEST_CASE(TestInsertAndContains)
+{
+    AccessCache cache;
+    BOOST_CHECK(!cache.Contains(1, "/a"));
+    BOOST_CHECK(!cache.Insert(1, "/a"));
+    BOOST_CHECK(cache.Insert(1, "/a"));
+    BOOST_CHECK(cache.Contains(1, "/a"));
+
+    // Keys are independent
+    BOOST_CHECK(!cache.Contains(2, "/a"));
+
+    // The cache keeps its own copy of the path
+    string path = "/b";
+    cache.Insert(1, path);
+    path[1] = 'c';
+    BOOST_CHECK(cache.Contains(1, "/b"));
+    BOOST_CHECK(!cache.Contains(1, "/c"));
+}
+
+BOOST_AUTO_TEST_CASE(TestArenaSpansChunks)
+{
+    AccessCache cache;
+    // Enough paths to fill several arena chunks
+    vector<string> paths = Paths(5000);
+    for (const string& path : paths) {
+        BOOST_CHECK(!cache.Insert(3, path));
+    }
+
+    for (const string& path : paths) {
+        BOOST_CHECK(cache.Contains(3, path));
+    }
+
+    // Paths that can't fit in a chunk are never cached
+    string huge(StringArena::kChunkSize, 'x');
+    cache.Insert(3, huge);
+    BOOST_CHECK(!cache.Contains(3, huge));
+}
+
+BOOST_AUTO_TEST_CASE(TestCachedAccessesDoNotAllocate)
+{
+    AccessCache cache;
+    vector<string> paths = Paths(1000);
+
+    // Warm up: the first access to each path allocates
+    for (const string& path : paths) {
+        cache.Insert(7, path);
+    }
+
+    // Steady state: the same accesses again, the way CheckCache sees them (a path in a fixed buffer)
+    size_t allocations = CountAllocations([&]() {
+        for (int round = 0; round < 10; round++) {
+            for (const string& path : paths) {
+                FixedPath fixed(path.c_str());
+                BOOST_REQUIRE(cache.Contains(7, fixed));
+                BOOST_REQUIRE(cache.Insert(7, fixed));
+            }
+        }
+    });
+
+    BOOST_CHECK_EQUAL(allocations, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestFixedPath)
+{
+    FixedPath empty;
+    BOOST_CHECK(empty.empty());
+    BOOST_CHECK_EQUAL(empty.c_str(), "");
+
+    FixedPath path("/usr/bin/gcc");
+    BOOST_CHECK_EQUAL(path.length(), 12);
+    BOOST_CHECK_EQUAL(path[0], '/');
+    BOOST_CHECK(std::string_view(path) == "/usr/bin/gcc");
+
+    // Assigning from its own buffer is fine
+    path.Assign(path.c_str() + 4);
+    BOOST_CHECK_EQUAL(path.c_str(), "/bin/gcc");
+
+    // Paths are truncated to PATH_MAX - 1 bytes
+    string too_long(PATH_MAX + 10, 'a');
+    FixedPath truncated(too_long.c_str());
+    BOOST_CHECK_EQUAL(truncated.length(), PATH_MAX - 1);
+
+    BOOST_CHECK_EQUAL(CountAllocations([&]() { FixedPath copy = truncated; copy.Assign("/tmp"); }), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <access_summary.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// Stand-ins for the values used by the sandbox
+static const int kProbe = 0x4, kRead = 0x1, kEnumerate = 0x8;
+static const int kOpLookup = 1, kOpOpen = 2, kOpClose = 3, kOpOpenDir = 4;
+static const uint32_t kAllowed = 1;
+
+// Adds an allowed access, ignoring whether it was the first one of its pid
+static AccessSummary::AddResult Add(AccessSummary& summary, pid_t pid, const char *path, int operation, uint32_t requested_access, uint32_t error, uint32_t is_directory) {
+    bool first_for_pid = false;
+    return summary.Add(pid, path, operation, requested_access, kAllowed, error, is_directory, first_for_pid);
+}
+
+static const SummarizedAccess *Find(const vector<SummarizedAccess>& entries, pid_t pid, const string& path) {
+    auto it = find_if(entries.begin(), entries.end(), [&](const SummarizedAccess& e) { return e.pid == pid && e.path == path; });
+    return it == entries.end() ? nullptr : &*it;
+}
+
+BOOST_AUTO_TEST_SUITE(AccessSummaryTests)
+
+BOOST_AUTO_TEST_CASE(TestAccessesToAPathAreCollapsed)
+{
+    AccessSummary summary;
+    pid_t pid = getpid();
+
+    // stat, open, read and close of a header
+    Add(summary, pid, "/src/foo.h", kOpLookup, kProbe, 2, 0);
+    Add(summary, pid, "/src/foo.h", kOpOpen, kRead, 0, 0);
+    Add(summary, pid, "/src/foo.h", kOpClose, kRead, 0, 0);
+    Add(summary, pid, "/src", kOpOpenDir, kEnumerate, 0, 1);
+    BOOST_CHECK_EQUAL(summary.Size(), 2);
+
+    vector<SummarizedAccess> entries;
+    summary.Take(pid, entries);
+    BOOST_CHECK_EQUAL(summary.Size(), 0);
+    BOOST_REQUIRE_EQUAL(entries.size(), 2);
+
+    const SummarizedAccess *header = Find(entries, pid, "/src/foo.h");
+    BOOST_REQUIRE(header != nullptr);
+    BOOST_CHECK_EQUAL(header->requested_access, (uint32_t)(kProbe | kRead));
+    // The representative operation is the first one that read the path, everything else comes from the first access
+    BOOST_CHECK_EQUAL(header->operation, kOpOpen);
+    BOOST_CHECK_EQUAL(header->error, 2);
+    BOOST_CHECK_EQUAL(header->is_directory, 0);
+
+    const SummarizedAccess *directory = Find(entries, pid, "/src");
+    BOOST_REQUIRE(directory != nullptr);
+    BOOST_CHECK_EQUAL(directory->operation, kOpOpenDir);
+    BOOST_CHECK_EQUAL(directory->is_directory, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestTakeIsPerPid)
+{
+    AccessSummary summary;
+    Add(summary, 100, "/src/a.h", kOpOpen, kRead, 0, 0);
+    Add(summary, 200, "/src/a.h", kOpOpen, kRead, 0, 0);
+    Add(summary, 200, "/src/b.h", kOpOpen, kRead, 0, 0);
+    BOOST_CHECK_EQUAL(summary.Size(), 3);
+
+    vector<SummarizedAccess> entries;
+    summary.Take(200, entries);
+    BOOST_CHECK_EQUAL(entries.size(), 2);
+    BOOST_CHECK_EQUAL(summary.Size(), 1);
+
+    entries.clear();
+    summary.Take(0, entries);
+    BOOST_REQUIRE_EQUAL(entries.size(), 1);
+    BOOST_CHECK_EQUAL(entries[0].pid, 100);
+    BOOST_CHECK_EQUAL(summary.Size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestBoundIsReported)
+{
+    AccessSummary summary(/* max_hold_time_ns */ UINT64_MAX);
+    for (size_t i = 0; i + 1 < AccessSummary::kMaxEntries; i++) {
+        BOOST_REQUIRE(Add(summary, 1, ("/src/" + to_string(i)).c_str(), kOpOpen, kRead, 0, 0) == AccessSummary::kHeld);
+    }
+
+    // Accesses to known paths don't grow the table
+    BOOST_CHECK(Add(summary, 1, "/src/0", kOpOpen, kRead, 0, 0) == AccessSummary::kHeld);
+    BOOST_CHECK(Add(summary, 1, "/src/last", kOpOpen, kRead, 0, 0) == AccessSummary::kFlush);
+}
+
+BOOST_AUTO_TEST_CASE(TestHoldTimeIsReported)
+{
+    AccessSummary summary(/* max_hold_time_ns */ 20ull * 1000 * 1000);
+    BOOST_CHECK(Add(summary, 1, "/src/a.h", kOpOpen, kRead, 0, 0) == AccessSummary::kHeld);
+
+    this_thread::sleep_for(chrono::milliseconds(50));
+
+    // Accesses to known paths report it too
+    BOOST_CHECK(Add(summary, 1, "/src/a.h", kOpOpen, kRead, 0, 0) == AccessSummary::kFlush);
+    BOOST_CHECK(Add(summary, 1, "/src/b.h", kOpOpen, kRead, 0, 0) == AccessSummary::kFlush);
+
+    // Once flushed, the hold time starts over
+    vector<SummarizedAccess> entries;
+    summary.Take(0, entries);
+    BOOST_CHECK_EQUAL(entries.size(), 2);
+    BOOST_CHECK(Add(summary, 1, "/src/c.h", kOpOpen, kRead, 0, 0) == AccessSummary::kHeld);
+}
+
+BOOST_AUTO_TEST_CASE(TestFirstAccessOfAPidIsReported)
+{
+    AccessSummary summary;
+    bool first_for_pid = false;
+
+    summary.Add(1, "/src/a.h", kOpOpen, kRead, kAllowed, 0, 0, first_for_pid);
+    BOOST_CHECK(first_for_pid);
+    summary.Add(1, "/src/b.h", kOpOpen, kRead, kAllowed, 0, 0, first_for_pid);
+    BOOST_CHECK(!first_for_pid);
+    summary.Add(2, "/src/a.h", kOpOpen, kRead, kAllowed, 0, 0, first_for_pid);
+    BOOST_CHECK(first_for_pid);
+
+    // Once the entries of a pid are taken, the pid holds nothing again
+    vector<SummarizedAccess> entries;
+    summary.Take(1, entries);
+    summary.Add(1, "/src/a.h", kOpOpen, kRead, kAllowed, 0, 0, first_for_pid);
+    BOOST_CHECK(first_for_pid);
+    summary.Add(2, "/src/b.h", kOpOpen, kRead, kAllowed, 0, 0, first_for_pid);
+    BOOST_CHECK(!first_for_pid);
+}
+
+BOOST_AUTO_TEST_CASE(TestInheritedEntriesAreDropped)
+{
+    AccessSummary summary;
+    Add(summary, getpid(), "/src/a.h", kOpOpen, kRead, 0, 0);
+
+    // Fork while another thread is using the table: the child starts from an empty one it can use
+    atomic<bool> stop(false);
+    thread adder([&]() {
+        for (int i = 0; !stop.load(); i++) {
+            Add(summary, 1, ("/src/" + to_string(i % 64)).c_str(), kOpOpen, kRead, 0, 0);
+        }
+    });
+
+    pid_t child = fork();
+    if (child == 0) {
+        summary.ResetAfterFork();
+        bool empty = summary.Size() == 0;
+        bool added = Add(summary, getpid(), "/src/b.h", kOpOpen, kRead, 0, 0) == AccessSummary::kHeld;
+        vector<SummarizedAccess> entries;
+        summary.Take(0, entries);
+        _exit(empty && added && entries.size() == 1 ? 0 : 1);
+    }
+
+    stop.store(true);
+    adder.join();
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    BOOST_REQUIRE(WIFEXITED(status));
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+
+    // The parent keeps its own entries
+    vector<SummarizedAccess> entries;
+    summary.Take(getpid(), entries);
+    BOOST_CHECK_EQUAL(entries.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestCompilePipRecordCount)
+{
+    // A compiler typically probes a header in a few include directories, stats it, opens it, reads it and closes it
+    const int header_count = 500;
+    const char *include_directories[] = { "/src/include", "/usr/local/include", "/usr/include" };
+    AccessSummary summary;
+    size_t accesses = 0;
+
+    for (int i = 0; i < header_count; i++) {
+        string name = "/header_" + to_string(i) + ".h";
+        for (const char *directory : include_directories) {
+            Add(summary, 1, (directory + name).c_str(), kOpLookup, kProbe, 2, 0);
+            accesses++;
+        }
+
+        string found = string("/usr/include") + name;
+        int operations[] = { kOpLookup, kOpOpen, kOpOpen, kOpClose };
+        int requested[] = { kProbe, kRead, kRead, kRead };
+        for (int j = 0; j < 4; j++) {
+            Add(summary, 1, found.c_str(), operations[j], requested[j], 0, 0);
+            accesses++;
+        }
+    }
+
+    vector<SummarizedAccess> entries;
+    summary.Take(1, entries);
+    BOOST_TEST_MESSAGE("Accesses: " << accesses << ", summarized records: " << entries.size());
+    BOOST_CHECK_EQUAL(entries.size(), header_count * 3);
+    BOOST_CHECK(entries.size() * 2 < accesses);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <string>
+#include <vector>
+#include <content_hasher.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static const size_t kPageSize = 64 * 1024;
+static const size_t kBlockSize = 32 * kPageSize;
+
+// Same content as Enumerable.Range(0, length).Select(i => (byte)(i & 0xFF)) in the managed tests
+static vector<uint8_t> Content(size_t length) {
+    vector<uint8_t> content(length);
+    for (size_t i = 0; i < length; i++) {
+        content[i] = (uint8_t)(i & 0xFF);
+    }
+
+    return content;
+}
+
+static string Hash(const char *hash_type, const vector<uint8_t>& content, size_t chunk_size) {
+    auto hasher = CreateContentHasher(hash_type);
+    for (size_t offset = 0; offset < content.size(); offset += chunk_size) {
+        hasher->Update(content.data() + offset, std::min(chunk_size, content.size() - offset));
+    }
+
+    return hasher->Finish();
+}
+
+BOOST_AUTO_TEST_SUITE(ContentHasherTests)
+
+BOOST_AUTO_TEST_CASE(TestSha256KnownValues)
+{
+    BOOST_CHECK_EQUAL(Hash("SHA256", {}, 1), "E3B0C44298FC1C149AFBF4C8996FB92427AE41E4649B934CA495991B7852B855");
+
+    string abc = "abc";
+    BOOST_CHECK_EQUAL(Hash("SHA256", vector<uint8_t>(abc.begin(), abc.end()), 1), "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD");
+
+    // Spans two blocks of the compression function
+    string two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    BOOST_CHECK_EQUAL(Hash("SHA256", vector<uint8_t>(two_blocks.begin(), two_blocks.end()), 5), "248D6A61D20638B8E5C026930C3E6039A33CE45964FF2167F6ECEDD419DB06C1");
+
+    BOOST_CHECK_EQUAL(Hash("SHA256", vector<uint8_t>(1000000, 'a'), 4096), "CDC76E5C9914FB9281A1C7E284D73E67F1809A48A497200E046D39CCC7112CD0");
+}
+
+BOOST_AUTO_TEST_CASE(TestVsoKnownValues)
+{
+    // CODESYNC: Public/Src/Cache/ContentStore/InterfacesTest/Hashing/VsoHashTests.cs (BlobIdsDoNotChange)
+    const vector<pair<size_t, string>> known_values = {
+        { 0, "1E57CF2792A900D06C1CDFB3C453F35BC86F72788AA9724C96C929D1CC6B456A00" },
+        { 1, "3DA32150B5E69B54E7AD1765D9573BC5E6E05D3B6529556C1B4A436A76A511F400" },
+        { kPageSize - 1, "4AE1AD6462D75D117A5DAFCF98167981371A4B21E1CEE49D0B982DE2CE01032300" },
+        { kPageSize, "85840E1CB7CBFD78B464921C54C96F68C19066F20860EFA8CCE671B40BA5162300" },
+        { kPageSize + 1, "D92A37C547F9D5B6B7B791A24F587DA8189CCA14EBC8511D2482E7448763E2BD00" },
+        { kBlockSize - 1, "1C3C73F7E829E84A5BA05631195105FB49E033FA23BDA6D379B3E46B5D73EF3700" },
+        { kBlockSize, "6DAE3ED3E623AED293297C289C3D20A53083529138B7631E99920EF0D93AF3CD00" },
+        { kBlockSize + 1, "1F9F3C008EA37ECB65BC5FB14A420CEBB3CA72A9601EC056709A6B431F91807100" },
+        { 2 * kBlockSize - 1, "DF0E0DB15E866592DBFA9BCA74E6D547D67789F7EB088839FC1A5CEFA862353700" },
+        { 2 * kBlockSize, "5E3A80B2ACB2284CD21A08979C49CBB80874E1377940699B07A8ABEE9175113200" },
+        { 2 * kBlockSize + 1, "B9A44A420593FA18453B3BE7B63922DF43C93FF52D88F2CAB26FE1FADBA7003100" },
+    };
+
+    for (const auto& known_value : known_values) {
+        vector<uint8_t> content = Content(known_value.first);
+        BOOST_CHECK_EQUAL(Hash("VSO0", content, kBlockSize), known_value.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestChunkingDoesNotMatter)
+{
+    // Writes rarely line up with pages or blocks
+    vector<uint8_t> content = Content(2 * kBlockSize + 12345);
+    string expected = Hash("VSO0", content, content.size());
+
+    for (size_t chunk_size : { (size_t)1, (size_t)7, (size_t)4096, kPageSize - 3, kPageSize + 3, kBlockSize + 1 }) {
+        BOOST_CHECK_EQUAL(Hash("VSO0", content, chunk_size), expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestHashTypes)
+{
+    BOOST_CHECK_EQUAL(CreateContentHasher("VSO0")->Name(), "VSO0");
+    BOOST_CHECK_EQUAL(CreateContentHasher("vso0")->Name(), "VSO0");
+    BOOST_CHECK_EQUAL(CreateContentHasher("SHA256")->Name(), "SHA256");
+    BOOST_CHECK(CreateContentHasher("MD5") == nullptr);
+    BOOST_CHECK(CreateContentHasher("") == nullptr);
+    BOOST_CHECK(CreateContentHasher(nullptr) == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,191 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <copy_engine.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+/**
+ * Throughput of copying a file with copy_file_range, for file sizes from 4KB up, through:
+ *   - pipe_per_call: what the interposed copy_file_range used to do (a new pipe per call, one splice each way)
+ *   - splice: the fallback of the copy engine (looping splice through the pipe of the thread)
+ *   - engine: the copy engine (clone, then the real copy_file_range, then splice)
+ *   - libc: copy_file_range as the process calls it (the interposed one, when running under the sandbox)
+ * Every copy is of a whole file into an empty one, looping until all of it is copied, like cp does.
+ *
+ * Arguments (after --):
+ *   --directory=<path>  where the files are created (default /dev/shm, a tmpfs); pass a directory of an overlayfs
+ *                       (e.g., in a container) to compare with copies between its layers
+ *   --max-size=<n>      largest file size in bytes, with an optional K, M or G suffix; sizes grow by 4x from 4K (default 64M,
+ *                       pass 1G for the full range)
+ *   --min-bytes=<n>     each size is copied until at least this many bytes were copied (default 256M)
+ */
+
+typedef ssize_t (*CopyFunction)(CopyEngine &engine, int fdIn, int fdOut, size_t len);
+
+static ssize_t CopyWithPipePerCall(CopyEngine &, int fdIn, int fdOut, size_t len) {
+    int pipefd[2];
+    if (pipe(pipefd) != 0) {
+        return -1;
+    }
+
+    ssize_t result = splice(fdIn, nullptr, pipefd[1], nullptr, len, 0);
+    if (result > 0) {
+        result = splice(pipefd[0], nullptr, fdOut, nullptr, result, 0);
+    }
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return result;
+}
+
+static ssize_t CopyWithSplice(CopyEngine &, int fdIn, int fdOut, size_t len) {
+    return CopyEngine::SpliceCopy(fdIn, nullptr, fdOut, nullptr, len);
+}
+
+static ssize_t CopyWithEngine(CopyEngine &engine, int fdIn, int fdOut, size_t len) {
+    return engine.CopyFileRange(fdIn, nullptr, fdOut, nullptr, len, 0);
+}
+
+static ssize_t CopyWithLibc(CopyEngine &, int fdIn, int fdOut, size_t len) {
+    return copy_file_range(fdIn, nullptr, fdOut, nullptr, len, 0);
+}
+
+static const char *GetArgument(const char *name) {
+    auto &suite = boost::unit_test::framework::master_test_suite();
+    size_t length = strlen(name);
+    for (int i = 1; i < suite.argc; i++) {
+        if (strncmp(suite.argv[i], name, length) == 0 && suite.argv[i][length] == '=') {
+            return suite.argv[i] + length + 1;
+        }
+    }
+
+    return nullptr;
+}
+
+static uint64_t ParseSize(const char *value) {
+    char *suffix;
+    uint64_t size = strtoull(value, &suffix, 10);
+    switch (*suffix) {
+        case 'G': case 'g': return size << 30;
+        case 'M': case 'm': return size << 20;
+        case 'K': case 'k': return size << 10;
+        default: return size;
+    }
+}
+
+static bool CreateInput(const string &path, uint64_t size) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    vector<char> block(1024 * 1024);
+    for (size_t i = 0; i < block.size(); i++) {
+        block[i] = (char)(i * 31);
+    }
+
+    uint64_t written = 0;
+    while (written < size) {
+        size_t chunk = size - written < block.size() ? size - written : block.size();
+        ssize_t result = write(fd, block.data(), chunk);
+        if (result <= 0) {
+            close(fd);
+            return false;
+        }
+
+        written += result;
+    }
+
+    close(fd);
+    return true;
+}
+
+// Copies the input into a new file until it is all copied. Returns false if a copy failed or came short.
+static bool CopyFile(CopyFunction copy, CopyEngine &engine, const string &input, const string &output, uint64_t size) {
+    int fdIn = open(input.c_str(), O_RDONLY);
+    int fdOut = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    uint64_t copied = 0;
+    while (fdIn >= 0 && fdOut >= 0 && copied < size) {
+        ssize_t result = copy(engine, fdIn, fdOut, size - copied);
+        if (result <= 0) {
+            break;
+        }
+
+        copied += result;
+    }
+
+    close(fdIn);
+    close(fdOut);
+    return copied == size;
+}
+
+BOOST_AUTO_TEST_SUITE(CopyEngineBenchmark)
+
+BOOST_AUTO_TEST_CASE(TestCopyThroughput)
+{
+    const char *directory = GetArgument("--directory");
+    string root = directory != nullptr ? directory : "/dev/shm";
+    const char *maxSizeArgument = GetArgument("--max-size");
+    uint64_t maxSize = maxSizeArgument != nullptr ? ParseSize(maxSizeArgument) : 64ull << 20;
+    const char *minBytesArgument = GetArgument("--min-bytes");
+    uint64_t minBytes = minBytesArgument != nullptr ? ParseSize(minBytesArgument) : 256ull << 20;
+
+    string input = root + "/copy_engine_benchmark_" + to_string(getpid()) + ".in";
+    string output = root + "/copy_engine_benchmark_" + to_string(getpid()) + ".out";
+
+    const struct {
+        const char *name;
+        CopyFunction copy;
+    } methods[] = {
+        { "pipe_per_call", CopyWithPipePerCall },
+        { "splice", CopyWithSplice },
+        { "engine", CopyWithEngine },
+        { "libc", CopyWithLibc },
+    };
+
+    printf("directory,size,method,copies,seconds,mb_per_second\n");
+    for (uint64_t size = 4096; size <= maxSize; size *= 4) {
+        BOOST_REQUIRE_MESSAGE(CreateInput(input, size), "Can't create " << input);
+        int copies = (int)(minBytes / size) < 3 ? 3 : (int)(minBytes / size);
+
+        for (const auto &method : methods) {
+            // What the engine learned about the devices is part of what is measured: one engine per method and size
+            CopyEngine engine;
+            auto start = chrono::steady_clock::now();
+            bool succeeded = true;
+            for (int i = 0; i < copies && succeeded; i++) {
+                succeeded = CopyFile(method.copy, engine, input, output, size);
+            }
+
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            BOOST_CHECK_MESSAGE(succeeded, method.name << " failed to copy " << size << " bytes");
+
+            struct stat st;
+            BOOST_CHECK(stat(output.c_str(), &st) == 0 && (uint64_t)st.st_size == size);
+            printf("%s,%llu,%s,%d,%.4f,%.1f\n", root.c_str(), (unsigned long long)size, method.name, copies, seconds,
+                seconds > 0 ? (double)size * copies / seconds / (1024 * 1024) : 0);
+        }
+    }
+
+    fflush(stdout);
+    unlink(input.c_str());
+    unlink(output.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
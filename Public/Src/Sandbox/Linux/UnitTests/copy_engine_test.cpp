@@ -0,0 +1,307 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <copy_engine.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string MakeTempDirectory() {
+    char pattern[] = "/tmp/copy_engine_testXXXXXX";
+    BOOST_REQUIRE(mkdtemp(pattern) != nullptr);
+    return pattern;
+}
+
+static vector<char> MakeContent(size_t size) {
+    vector<char> content(size);
+    for (size_t i = 0; i < size; i++) {
+        content[i] = (char)(i * 31 + i / 4096);
+    }
+
+    return content;
+}
+
+static int CreateFile(const string &path, const vector<char> &content) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE_EQUAL(pwrite(fd, content.data(), content.size(), 0), (ssize_t)content.size());
+    return fd;
+}
+
+static vector<int> OpenDescriptors() {
+    vector<int> fds;
+    DIR *dir = opendir("/proc/self/fd");
+    BOOST_REQUIRE(dir != nullptr);
+    while (struct dirent *entry = readdir(dir)) {
+        if (entry->d_name[0] != '.' && atoi(entry->d_name) != dirfd(dir)) {
+            fds.push_back(atoi(entry->d_name));
+        }
+    }
+
+    closedir(dir);
+    return fds;
+}
+
+static vector<char> ReadAll(int fd) {
+    struct stat st;
+    BOOST_REQUIRE_EQUAL(fstat(fd, &st), 0);
+    vector<char> content(st.st_size);
+    BOOST_REQUIRE_EQUAL(pread(fd, content.data(), content.size(), 0), (ssize_t)content.size());
+    return content;
+}
+
+BOOST_AUTO_TEST_SUITE(CopyEngineTests)
+
+BOOST_AUTO_TEST_CASE(TestSpliceCopyWithOffsets)
+{
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(10000);
+    int in = CreateFile(dir + "/in", content);
+    int out = CreateFile(dir + "/out", {});
+
+    loff_t offIn = 100, offOut = 0;
+    BOOST_CHECK_EQUAL(CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 5000), 5000);
+    BOOST_CHECK_EQUAL(offIn, 5100);
+    BOOST_CHECK_EQUAL(offOut, 5000);
+
+    // The file offsets are untouched when offsets are given
+    BOOST_CHECK_EQUAL(lseek(in, 0, SEEK_CUR), 0);
+    BOOST_CHECK_EQUAL(lseek(out, 0, SEEK_CUR), 0);
+
+    vector<char> copied = ReadAll(out);
+    BOOST_CHECK(copied == vector<char>(content.begin() + 100, content.begin() + 5100));
+
+    // At the end of the input
+    offIn = content.size();
+    BOOST_CHECK_EQUAL(CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 10), 0);
+
+    close(in);
+    close(out);
+}
+
+BOOST_AUTO_TEST_CASE(TestSpliceCopyMoreThanThePipe)
+{
+    // Takes several round trips through the pipe, and stops where the input ends
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(3 * CopyEngine::kPipeSize + 123);
+    int in = CreateFile(dir + "/in", content);
+    int out = CreateFile(dir + "/out", {});
+
+    BOOST_CHECK_EQUAL(CopyEngine::SpliceCopy(in, nullptr, out, nullptr, content.size() + 1000), (ssize_t)content.size());
+    BOOST_CHECK_EQUAL(lseek(in, 0, SEEK_CUR), (off_t)content.size());
+    BOOST_CHECK_EQUAL(lseek(out, 0, SEEK_CUR), (off_t)content.size());
+    BOOST_CHECK(ReadAll(out) == content);
+
+    close(in);
+    close(out);
+}
+
+BOOST_AUTO_TEST_CASE(TestSplicePipeSurvivesClosedDescriptors)
+{
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(4096);
+    int in = CreateFile(dir + "/in", content);
+    int out = CreateFile(dir + "/out", {});
+
+    // On a new thread, so that the first copy creates the pipe: the descriptors it opens are that pipe
+    ssize_t first = 0, second = 0;
+    vector<int> reused;
+    thread copier([&]() {
+        vector<int> before = OpenDescriptors();
+        loff_t offIn = 0, offOut = 0;
+        first = CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 1024);
+
+        // Close them behind the engine's back, and reuse the numbers for files
+        for (int fd : OpenDescriptors()) {
+            if (find(before.begin(), before.end(), fd) == before.end() && close(fd) == 0) {
+                reused.push_back(open((dir + "/in").c_str(), O_RDONLY));
+            }
+        }
+
+        second = CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 3072);
+    });
+    copier.join();
+
+    BOOST_CHECK_EQUAL(first, 1024);
+    BOOST_CHECK_EQUAL(second, 3072);
+    BOOST_CHECK(ReadAll(out) == content);
+
+    // The reused descriptors were left alone
+    BOOST_CHECK_EQUAL(reused.size(), 2);
+    for (int fd : reused) {
+        BOOST_CHECK_EQUAL(close(fd), 0);
+    }
+
+    close(in);
+    close(out);
+}
+
+BOOST_AUTO_TEST_CASE(TestCopyFileRange)
+{
+    CopyEngine engine;
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(100000);
+    int in = CreateFile(dir + "/in", content);
+
+    // A whole file into an empty one (a clone, where the file system supports it)
+    int whole = CreateFile(dir + "/whole", {});
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(in, nullptr, whole, nullptr, content.size(), 0), (ssize_t)content.size());
+    BOOST_CHECK_EQUAL(lseek(in, 0, SEEK_CUR), (off_t)content.size());
+    BOOST_CHECK_EQUAL(lseek(whole, 0, SEEK_CUR), (off_t)content.size());
+    BOOST_CHECK(ReadAll(whole) == content);
+
+    // A range in the middle of a file
+    int range = CreateFile(dir + "/range", MakeContent(10));
+    loff_t offIn = 500, offOut = 10;
+    errno = 1234;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(in, &offIn, range, &offOut, 2000, 0), 2000);
+    BOOST_CHECK_EQUAL(errno, 1234);
+    BOOST_CHECK_EQUAL(offIn, 2500);
+    BOOST_CHECK_EQUAL(offOut, 2010);
+    vector<char> copied = ReadAll(range);
+    BOOST_REQUIRE_EQUAL(copied.size(), 2010);
+    BOOST_CHECK(vector<char>(copied.begin() + 10, copied.end()) == vector<char>(content.begin() + 500, content.begin() + 2500));
+
+    close(in);
+    close(whole);
+    close(range);
+}
+
+BOOST_AUTO_TEST_CASE(TestCopyFileRangeFromPipe)
+{
+    // Not a regular file: the kernel would refuse it, so it goes straight to splicing
+    CopyEngine engine;
+    string dir = MakeTempDirectory();
+    int out = CreateFile(dir + "/out", {});
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+    BOOST_REQUIRE_EQUAL(write(fds[1], "hello", 5), 5);
+    close(fds[1]);
+
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fds[0], nullptr, out, nullptr, 100, 0), 5);
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fds[0], nullptr, out, nullptr, 100, 0), 0);
+    vector<char> copied = ReadAll(out);
+    BOOST_CHECK_EQUAL(string(copied.begin(), copied.end()), "hello");
+
+    close(fds[0]);
+    close(out);
+}
+
+BOOST_AUTO_TEST_CASE(TestInvalidArguments)
+{
+    CopyEngine engine;
+    string dir = MakeTempDirectory();
+    int fd = CreateFile(dir + "/file", MakeContent(1000));
+    int other = CreateFile(dir + "/other", {});
+
+    errno = 0;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fd, nullptr, other, nullptr, 10, 1), -1);
+    BOOST_CHECK_EQUAL(errno, EINVAL);
+
+    // Overlapping ranges of the same file, through the same or another descriptor
+    int same = open((dir + "/file").c_str(), O_RDWR);
+    BOOST_REQUIRE(same >= 0);
+    loff_t offIn = 0, offOut = 100;
+    errno = 0;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fd, &offIn, same, &offOut, 200, 0), -1);
+    BOOST_CHECK_EQUAL(errno, EINVAL);
+    errno = 0;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fd, &offIn, fd, &offOut, 200, 0), -1);
+    BOOST_CHECK_EQUAL(errno, EINVAL);
+
+    // Disjoint ones are fine
+    offIn = 0;
+    offOut = 500;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(fd, &offIn, same, &offOut, 100, 0), 100);
+
+    errno = 0;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(-1, nullptr, other, nullptr, 10, 0), -1);
+    BOOST_CHECK_EQUAL(errno, EBADF);
+
+    close(fd);
+    close(same);
+    close(other);
+}
+
+BOOST_AUTO_TEST_CASE(TestUnsupportedCopiesAreRemembered)
+{
+    CopyEngine engine;
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(1000);
+    int in = CreateFile(dir + "/in", content);
+    int out = CreateFile(dir + "/out", {});
+
+    // The input can't be written to, so copying into it fails with EBADF: not something the devices are to blame for
+    int readOnly = open((dir + "/in").c_str(), O_RDONLY);
+    BOOST_REQUIRE(readOnly >= 0);
+    errno = 0;
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(out, nullptr, readOnly, nullptr, 10, 0), -1);
+    BOOST_CHECK_EQUAL(errno, EBADF);
+    close(readOnly);
+
+    struct stat st;
+    BOOST_REQUIRE_EQUAL(fstat(in, &st), 0);
+    BOOST_CHECK(!engine.IsNativeCopyUnsupported(st.st_dev, st.st_dev));
+
+    // Whatever the file system supports, a copy succeeds, and a clone attempt is remembered only if it failed
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(in, nullptr, out, nullptr, content.size(), 0), (ssize_t)content.size());
+    BOOST_CHECK(ReadAll(out) == content);
+    bool cloneUnsupported = engine.IsCloneUnsupported(st.st_dev, st.st_dev);
+    int again = CreateFile(dir + "/again", {});
+    lseek(in, 0, SEEK_SET);
+    BOOST_CHECK_EQUAL(engine.CopyFileRange(in, nullptr, again, nullptr, content.size(), 0), (ssize_t)content.size());
+    BOOST_CHECK_EQUAL(engine.IsCloneUnsupported(st.st_dev, st.st_dev), cloneUnsupported);
+    BOOST_CHECK(ReadAll(again) == content);
+
+    close(in);
+    close(out);
+    close(again);
+}
+
+BOOST_AUTO_TEST_CASE(TestResetAfterFork)
+{
+    CopyEngine engine;
+    string dir = MakeTempDirectory();
+    vector<char> content = MakeContent(4096);
+    int in = CreateFile(dir + "/in", content);
+    int out = CreateFile(dir + "/out", {});
+
+    loff_t offIn = 0, offOut = 0;
+    BOOST_REQUIRE_EQUAL(CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 2048), 2048);
+
+    pid_t child = fork();
+    if (child == 0) {
+        engine.ResetAfterFork();
+        _exit(CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 2048) == 2048 ? 0 : 1);
+    }
+
+    int status;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    BOOST_CHECK(ReadAll(out) == content);
+
+    // The parent's pipe still works
+    offIn = 0;
+    offOut = 0;
+    BOOST_CHECK_EQUAL(CopyEngine::SpliceCopy(in, &offIn, out, &offOut, 4096), 4096);
+
+    close(in);
+    close(out);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
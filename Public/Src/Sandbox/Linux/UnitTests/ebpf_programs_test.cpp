@@ -0,0 +1,249 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fcntl.h>
+#include <string.h>
+#include <string>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <ebpf_programs.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+static const char *kSysEnterFormat =
+    "name: sys_enter\n"
+    "ID: 443\n"
+    "format:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\tfield:int common_pid;\toffset:4;\tsize:4;\tsigned:1;\n"
+    "\n"
+    "\tfield:long id;\toffset:8;\tsize:8;\tsigned:1;\n"
+    "\tfield:unsigned long args[6];\toffset:16;\tsize:48;\tsigned:0;\n";
+
+// Older kernels have the command names inline
+static const char *kSchedProcessForkFormat =
+    "name: sched_process_fork\n"
+    "ID: 311\n"
+    "format:\n"
+    "\tfield:unsigned short common_type;\toffset:0;\tsize:2;\tsigned:0;\n"
+    "\n"
+    "\tfield:char parent_comm[16];\toffset:8;\tsize:16;\tsigned:1;\n"
+    "\tfield:pid_t parent_pid;\toffset:24;\tsize:4;\tsigned:1;\n"
+    "\tfield:char child_comm[16];\toffset:28;\tsize:16;\tsigned:1;\n"
+    "\tfield:pid_t child_pid;\toffset:44;\tsize:4;\tsigned:1;\n";
+
+BOOST_AUTO_TEST_SUITE(EbpfProgramsTests)
+
+BOOST_AUTO_TEST_CASE(TestParseTracepointFormat)
+{
+    TracepointField field = {};
+    BOOST_CHECK_EQUAL(ParseTracepointId(kSysEnterFormat), 443);
+    BOOST_CHECK(ParseTracepointField(kSysEnterFormat, "id", field));
+    BOOST_CHECK_EQUAL(field.offset, 8);
+    BOOST_CHECK_EQUAL(field.size, 8);
+    BOOST_CHECK(ParseTracepointField(kSysEnterFormat, "args", field));
+    BOOST_CHECK_EQUAL(field.offset, 16);
+    BOOST_CHECK_EQUAL(field.size, 48);
+
+    // Names match whole identifiers only
+    BOOST_CHECK(!ParseTracepointField(kSysEnterFormat, "arg", field));
+    BOOST_CHECK(!ParseTracepointField(kSysEnterFormat, "pid", field));
+    BOOST_CHECK(ParseTracepointField(kSysEnterFormat, "common_pid", field));
+    BOOST_CHECK_EQUAL(field.offset, 4);
+
+    BOOST_CHECK_EQUAL(ParseTracepointId(kSchedProcessForkFormat), 311);
+    BOOST_CHECK(ParseTracepointField(kSchedProcessForkFormat, "child_pid", field));
+    BOOST_CHECK_EQUAL(field.offset, 44);
+    BOOST_CHECK_EQUAL(field.size, 4);
+
+    BOOST_CHECK_EQUAL(ParseTracepointId(""), -1);
+}
+
+BOOST_AUTO_TEST_CASE(TestAssemblerLabels)
+{
+    EbpfAssembler assembler;
+    assembler.Jump("end");
+    assembler.Bind("loop");
+    assembler.AddImm(1, 1);
+    assembler.JumpIfImm(BPF_JLT, 1, 10, "loop");
+    assembler.Bind("end");
+    assembler.Exit();
+
+    vector<struct bpf_insn> program;
+    BOOST_REQUIRE(assembler.Finish(program));
+    BOOST_REQUIRE_EQUAL(program.size(), 4);
+    BOOST_CHECK_EQUAL(program[0].off, 2);
+    BOOST_CHECK_EQUAL(program[2].off, -2);
+    BOOST_CHECK_EQUAL(program[2].imm, 10);
+
+    // Loading a map takes two instructions
+    EbpfAssembler maps;
+    maps.LoadMapFd(1, 42);
+    maps.Jump("missing");
+    BOOST_CHECK(!maps.Finish(program));
+    BOOST_CHECK_EQUAL(program.size(), 3);
+    BOOST_CHECK_EQUAL(program[0].src_reg, BPF_PSEUDO_MAP_FD);
+    BOOST_CHECK_EQUAL(program[0].imm, 42);
+}
+
+// Loads the programs and checks what they report for a child process, when eBPF is available to the test (it requires CAP_BPF and
+// CAP_PERFMON, or CAP_SYS_ADMIN)
+BOOST_AUTO_TEST_CASE(TestProgramsReportProcessTree)
+{
+    const uint32_t ringBufferSize = 1024 * 1024;
+    EbpfMaps maps = {};
+    maps.tree = CreateEbpfMap(BPF_MAP_TYPE_HASH, sizeof(uint32_t), sizeof(uint32_t), 1024);
+    maps.syscalls = CreateEbpfMap(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), sizeof(uint32_t), kEbpfMaxSyscalls);
+    maps.events = CreateEbpfMap(BPF_MAP_TYPE_RINGBUF, 0, 0, ringBufferSize);
+    maps.drops = CreateEbpfMap(BPF_MAP_TYPE_ARRAY, sizeof(uint32_t), sizeof(uint64_t), 1);
+    string tracefs = FindTracefs();
+    string enterFormat = tracefs.empty() ? "" : ReadTracepointFormat(tracefs, "raw_syscalls", "sys_enter");
+    if (maps.tree < 0 || maps.events < 0 || enterFormat.empty()) {
+        BOOST_TEST_MESSAGE("eBPF is not available, skipping: " << strerror(errno));
+        return;
+    }
+
+    TracepointField id, args, ret, childPid;
+    BOOST_REQUIRE(ParseTracepointField(enterFormat, "id", id));
+    BOOST_REQUIRE(ParseTracepointField(enterFormat, "args", args));
+    string exitFormat = ReadTracepointFormat(tracefs, "raw_syscalls", "sys_exit");
+    BOOST_REQUIRE(ParseTracepointField(exitFormat, "ret", ret));
+    BOOST_REQUIRE(ParseTracepointField(ReadTracepointFormat(tracefs, "sched", "sched_process_fork"), "child_pid", childPid));
+
+    EbpfTracepointLayout layout = {};
+    layout.enter_id = id.offset;
+    layout.enter_args = args.offset;
+    BOOST_REQUIRE(ParseTracepointField(exitFormat, "id", id));
+    layout.exit_id = id.offset;
+    layout.exit_ret = ret.offset;
+    layout.fork_child_pid = childPid.offset;
+
+    uint32_t syscallNumber = SYS_openat;
+    uint32_t config = EncodeEbpfSyscall(2, 0);
+    BOOST_REQUIRE_EQUAL(UpdateEbpfMap(maps.syscalls, &syscallNumber, &config), 0);
+
+    struct {
+        const char *category;
+        const char *name;
+        vector<struct bpf_insn> program;
+    } programs[] = {
+        { "raw_syscalls", "sys_enter", BuildSyscallEnterProgram(layout, maps) },
+        { "raw_syscalls", "sys_exit", BuildSyscallExitProgram(layout, maps) },
+        { "sched", "sched_process_fork", BuildProcessForkProgram(layout, maps) },
+        { "sched", "sched_process_exit", BuildProcessExitProgram(layout, maps) },
+    };
+
+    vector<int> fds;
+    for (const auto &program : programs) {
+        string log;
+        int programFd = LoadEbpfProgram(program.program, &log);
+        BOOST_REQUIRE_MESSAGE(programFd >= 0, program.name << " was rejected: " << strerror(errno) << "\n" << log);
+        int perfFd = AttachEbpfProgram(tracefs, program.category, program.name, programFd);
+        BOOST_REQUIRE_MESSAGE(perfFd >= 0, program.name << " can't be attached: " << strerror(errno));
+        fds.push_back(programFd);
+        fds.push_back(perfFd);
+    }
+
+    EbpfRingBuffer ringBuffer;
+    BOOST_REQUIRE(ringBuffer.Initialize(maps.events, ringBufferSize));
+
+    // The child waits for the parent to add it to the tree, then forks a grandchild that opens a file
+    string path = TempPath("ebpf");
+    int pipeFds[2];
+    BOOST_REQUIRE_EQUAL(pipe(pipeFds), 0);
+    pid_t child = fork();
+    if (child == 0) {
+        char ready;
+        close(pipeFds[1]);
+        if (read(pipeFds[0], &ready, 1) != 1) {
+            _exit(1);
+        }
+
+        pid_t grandchild = fork();
+        if (grandchild == 0) {
+            close(open(path.c_str(), O_WRONLY | O_CREAT, 0644));
+            _exit(0);
+        }
+
+        int status;
+        waitpid(grandchild, &status, 0);
+        _exit(0);
+    }
+
+    uint32_t key = (uint32_t)child, parent = 0;
+    BOOST_REQUIRE_EQUAL(UpdateEbpfMap(maps.tree, &key, &parent), 0);
+    close(pipeFds[0]);
+    BOOST_REQUIRE_EQUAL(write(pipeFds[1], "x", 1), 1);
+    close(pipeFds[1]);
+
+    int status;
+    waitpid(child, &status, 0);
+    unlink(path.c_str());
+    for (int fd : fds) {
+        close(fd);
+    }
+
+    pid_t grandchild = -1;
+    bool entered = false, exited = false, grandchildExited = false, childExited = false;
+    ringBuffer.Consume([&](const char *data, size_t length) {
+        BOOST_REQUIRE_GE(length, sizeof(EbpfRecord));
+        const EbpfRecord *record = (const EbpfRecord *)data;
+        pid_t tid = (pid_t)(record->pid_tgid & 0xffffffff);
+        switch (record->kind) {
+            case kEbpfFork:
+                BOOST_CHECK_EQUAL(tid, child);
+                grandchild = (pid_t)record->value;
+                break;
+            case kEbpfSyscallEnter: {
+                BOOST_CHECK_EQUAL(record->syscall, SYS_openat);
+                BOOST_REQUIRE_EQUAL(length, sizeof(EbpfSyscallEntry));
+                const EbpfSyscallEntry *entry = (const EbpfSyscallEntry *)data;
+                if (tid == grandchild && path == entry->path) {
+                    BOOST_CHECK((entry->args[2] & O_CREAT) != 0);
+                    BOOST_CHECK_EQUAL(entry->second_path[0], '\0');
+                    entered = true;
+                }
+                break;
+            }
+            case kEbpfSyscallExit:
+                exited |= tid == grandchild && entered && record->value >= 0;
+                break;
+            case kEbpfExit:
+                grandchildExited |= record->value == grandchild;
+                childExited |= record->value == child;
+                break;
+        }
+    });
+
+    BOOST_CHECK_NE(grandchild, -1);
+    BOOST_CHECK(entered);
+    BOOST_CHECK(exited);
+    BOOST_CHECK(grandchildExited);
+    BOOST_CHECK(childExited);
+
+    // Exited processes leave the tree, and nothing was dropped
+    uint32_t value;
+    BOOST_CHECK_NE(LookupEbpfMap(maps.tree, &key, &value), 0);
+    uint32_t zero = 0;
+    uint64_t drops = 1;
+    BOOST_CHECK_EQUAL(LookupEbpfMap(maps.drops, &zero, &drops), 0);
+    BOOST_CHECK_EQUAL(drops, 0);
+
+    close(maps.tree);
+    close(maps.syscalls);
+    close(maps.events);
+    close(maps.drops);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fcntl.h>
+#include <map>
+#include <string.h>
+#include <string>
+#include <sys/fanotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <fanotify_events.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+// Appends an info record with a directory handle and a name, laid out like the kernel does
+static void AppendName(string &event, uint8_t infoType, uint32_t fsid, const string &handle, const char *name) {
+    string record(sizeof(struct fanotify_event_info_fid), '\0');
+    uint32_t handleBytes = (uint32_t)handle.size();
+    int32_t handleType = 1;
+    record.append((const char *)&handleBytes, sizeof(handleBytes));
+    record.append((const char *)&handleType, sizeof(handleType));
+    record.append(handle);
+    record.append(name);
+    record.push_back('\0');
+    while (record.size() % 4 != 0) {
+        record.push_back('\0');
+    }
+
+    struct fanotify_event_info_fid *fid = (struct fanotify_event_info_fid *)&record[0];
+    fid->hdr.info_type = infoType;
+    fid->hdr.len = (uint16_t)record.size();
+    memcpy(&fid->fsid, &fsid, sizeof(fsid));
+    event.append(record);
+}
+
+static void AppendEvent(string &buffer, pid_t pid, uint64_t mask, const string &records) {
+    struct fanotify_event_metadata metadata = {};
+    metadata.event_len = (uint32_t)(sizeof(metadata) + records.size());
+    metadata.vers = FANOTIFY_METADATA_VERSION;
+    metadata.metadata_len = sizeof(metadata);
+    metadata.mask = mask;
+    metadata.fd = FAN_NOFD;
+    metadata.pid = pid;
+    buffer.append((const char *)&metadata, sizeof(metadata));
+    buffer.append(records);
+}
+
+BOOST_AUTO_TEST_SUITE(FanotifyEventsTests)
+
+BOOST_AUTO_TEST_CASE(TestParseEvents)
+{
+    string buffer, open, rename, overflow;
+    AppendName(open, FAN_EVENT_INFO_TYPE_DFID_NAME, 7, "handle", "input.txt");
+    AppendEvent(buffer, 100, FAN_OPEN | FAN_ACCESS, open);
+
+    // Overflow events carry no directory entry and are skipped
+    AppendEvent(buffer, 0, FAN_Q_OVERFLOW, overflow);
+
+    AppendName(rename, 10 /* FAN_EVENT_INFO_TYPE_OLD_DFID_NAME */, 7, "old", "a.tmp");
+    AppendName(rename, 12 /* FAN_EVENT_INFO_TYPE_NEW_DFID_NAME */, 7, "newdir", "a.o");
+    AppendEvent(buffer, 101, 0x10000000 /* FAN_RENAME */, rename);
+
+    vector<FanotifyRecord> records;
+    BOOST_CHECK_EQUAL(ParseFanotifyEvents(buffer.data(), buffer.size(), records), 2);
+    BOOST_REQUIRE_EQUAL(records.size(), 2);
+
+    BOOST_CHECK_EQUAL(records[0].pid, 100);
+    BOOST_CHECK_EQUAL(records[0].mask, FAN_OPEN | FAN_ACCESS);
+    BOOST_CHECK_EQUAL(records[0].path.fsid, 7);
+    BOOST_CHECK_EQUAL(records[0].path.name, "input.txt");
+    // The handle keeps its struct file_handle header, so it can be passed to open_by_handle_at as is
+    BOOST_CHECK_EQUAL(records[0].path.handle.size(), 8 + 6);
+    BOOST_CHECK_EQUAL(records[0].path.handle.substr(8), "handle");
+    BOOST_CHECK(records[0].new_path.handle.empty());
+
+    BOOST_CHECK_EQUAL(records[1].pid, 101);
+    BOOST_CHECK_EQUAL(records[1].path.name, "a.tmp");
+    BOOST_CHECK_EQUAL(records[1].path.handle.substr(8), "old");
+    BOOST_CHECK_EQUAL(records[1].new_path.name, "a.o");
+    BOOST_CHECK_EQUAL(records[1].new_path.handle.substr(8), "newdir");
+}
+
+BOOST_AUTO_TEST_CASE(TestParseStopsAtMalformedEvents)
+{
+    string buffer, good, bad;
+    AppendName(good, FAN_EVENT_INFO_TYPE_DFID_NAME, 1, "h", "first");
+    AppendEvent(buffer, 100, FAN_CLOSE_WRITE, good);
+
+    // A handle that claims to be longer than its record
+    AppendName(bad, FAN_EVENT_INFO_TYPE_DFID_NAME, 1, "h", "second");
+    uint32_t handleBytes = 1024;
+    memcpy(&bad[sizeof(struct fanotify_event_info_fid)], &handleBytes, sizeof(handleBytes));
+    AppendEvent(buffer, 100, FAN_CLOSE_WRITE, bad);
+    AppendEvent(buffer, 100, FAN_CLOSE_WRITE, good);
+
+    vector<FanotifyRecord> records;
+    BOOST_CHECK_EQUAL(ParseFanotifyEvents(buffer.data(), buffer.size(), records), 1);
+    BOOST_CHECK_EQUAL(records[0].path.name, "first");
+
+    // A truncated buffer (e.g., a short read) yields the complete events only
+    records.clear();
+    string first = buffer.substr(0, sizeof(struct fanotify_event_metadata) + good.size());
+    BOOST_CHECK_EQUAL(ParseFanotifyEvents(first.data(), first.size() - 1, records), 0);
+    BOOST_CHECK_EQUAL(ParseFanotifyEvents(first.data(), first.size(), records), 1);
+}
+
+// Parses what the kernel reports, when fanotify is available to the test (it requires CAP_SYS_ADMIN)
+BOOST_AUTO_TEST_CASE(TestParseKernelEvents)
+{
+    int fanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME, O_RDONLY);
+    if (fanotifyFd == -1 || fanotify_mark(fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, FAN_CREATE | FAN_CLOSE_WRITE | FAN_DELETE, AT_FDCWD, "/tmp") == -1) {
+        BOOST_TEST_MESSAGE("fanotify is not available, skipping: " << strerror(errno));
+        if (fanotifyFd != -1) {
+            close(fanotifyFd);
+        }
+
+        return;
+    }
+
+    string path = TempPath("fanotify");
+    string name = path.substr(strlen("/tmp/"));
+    pid_t child = fork();
+    if (child == 0) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        close(fd);
+        unlink(path.c_str());
+        _exit(0);
+    }
+
+    int status;
+    waitpid(child, &status, 0);
+
+    alignas(struct fanotify_event_metadata) char buffer[16 * 1024];
+    vector<FanotifyRecord> records;
+    ssize_t length;
+    while ((length = read(fanotifyFd, buffer, sizeof(buffer))) > 0) {
+        ParseFanotifyEvents(buffer, length, records);
+    }
+
+    close(fanotifyFd);
+
+    // Other processes may be writing to /tmp as well
+    uint64_t mask = 0;
+    for (const auto &record : records) {
+        if (record.pid == child && record.path.name == name) {
+            BOOST_CHECK_GT(record.path.handle.size(), 8);
+            mask |= record.mask;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(mask, FAN_CREATE | FAN_CLOSE_WRITE | FAN_DELETE);
+}
+
+BOOST_AUTO_TEST_CASE(TestProcessTreeFilter)
+{
+    // 10 is the root of the pip, 11 and 12 are its descendants, 20 is an unrelated process and 30 exited before it was looked up
+    map<pid_t, pid_t> parents = { { 10, 5 }, { 11, 10 }, { 12, 11 }, { 20, 5 }, { 5, 1 } };
+    int lookups = 0;
+    auto parentOf = [&](pid_t pid) {
+        lookups++;
+        auto parent = parents.find(pid);
+        return parent == parents.end() ? -1 : parent->second;
+    };
+
+    ProcessTreeFilter filter(10);
+    vector<pid_t> joined;
+    BOOST_CHECK(filter.Contains(10, parentOf, &joined));
+    BOOST_CHECK(joined.empty());
+    BOOST_CHECK_EQUAL(lookups, 0);
+
+    BOOST_CHECK(filter.Contains(12, parentOf, &joined));
+    BOOST_REQUIRE_EQUAL(joined.size(), 2);
+    BOOST_CHECK_EQUAL(joined[0], 11);
+    BOOST_CHECK_EQUAL(joined[1], 12);
+    BOOST_CHECK_EQUAL(filter.ParentOf(12), 11);
+    BOOST_CHECK_EQUAL(filter.ParentOf(11), 10);
+    BOOST_CHECK_EQUAL(lookups, 2);
+
+    BOOST_CHECK(!filter.Contains(20, parentOf));
+    BOOST_CHECK(!filter.Contains(30, parentOf));
+
+    // Decisions are cached
+    int before = lookups;
+    joined.clear();
+    BOOST_CHECK(filter.Contains(12, parentOf, &joined));
+    BOOST_CHECK(!filter.Contains(20, parentOf));
+    BOOST_CHECK(!filter.Contains(5, parentOf));
+    BOOST_CHECK_EQUAL(lookups, before);
+    BOOST_CHECK(joined.empty());
+
+    // Once a process exits, its pid no longer belongs to the pip
+    filter.Remove(12);
+    parents[12] = 20;
+    BOOST_CHECK(!filter.Contains(12, parentOf));
+}
+
+BOOST_AUTO_TEST_CASE(TestReadParent)
+{
+    BOOST_CHECK_EQUAL(ProcessTreeFilter::ReadParent(getpid()), getppid());
+    BOOST_CHECK_EQUAL(ProcessTreeFilter::ReadParent(-5), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <first_write_registry.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string CreateFam(const char *name) {
+    string fam_path = string("/tmp/bxl_") + name + "_" + to_string(getpid()) + ".fam";
+    ofstream fam(fam_path);
+    fam << "fam";
+    fam.close();
+    unlink((fam_path + FirstWriteRegistry::kFileSuffix).c_str());
+    return fam_path;
+}
+
+static void DeleteFam(const string& fam_path) {
+    unlink(fam_path.c_str());
+    unlink((fam_path + FirstWriteRegistry::kFileSuffix).c_str());
+}
+
+static string PathFor(int i) {
+    return "/home/user/src/out/file_" + to_string(i) + ".o";
+}
+
+BOOST_AUTO_TEST_SUITE(FirstWriteRegistryTests)
+
+BOOST_AUTO_TEST_CASE(TestRegisterOncePerPath)
+{
+    string fam_path = CreateFam("fwr_once");
+
+    FirstWriteRegistry registry;
+    BOOST_REQUIRE(registry.Initialize(fam_path.c_str()));
+
+    string path = PathFor(0);
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kFirstWrite);
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kAlreadyRegistered);
+
+    // A second mapping (i.e., another process of the same pip) sees the same registry
+    FirstWriteRegistry other;
+    BOOST_REQUIRE(other.Initialize(fam_path.c_str()));
+    BOOST_CHECK_EQUAL(other.TryRegister(path.c_str(), path.length()), kAlreadyRegistered);
+
+    string another_path = PathFor(1);
+    BOOST_CHECK_EQUAL(other.TryRegister(another_path.c_str(), another_path.length()), kFirstWrite);
+    BOOST_CHECK_EQUAL(registry.TryRegister(another_path.c_str(), another_path.length()), kAlreadyRegistered);
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestIsRegisteredDoesNotRegister)
+{
+    string fam_path = CreateFam("fwr_is_registered");
+
+    FirstWriteRegistry registry;
+    BOOST_REQUIRE(registry.Initialize(fam_path.c_str()));
+
+    string path = PathFor(0);
+    BOOST_CHECK(!registry.IsRegistered(path.c_str(), path.length()));
+    BOOST_CHECK(!registry.IsRegistered(path.c_str(), path.length()));
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kFirstWrite);
+    BOOST_CHECK(registry.IsRegistered(path.c_str(), path.length()));
+
+    // Registrations made by other processes of the pip are visible too
+    FirstWriteRegistry other;
+    BOOST_REQUIRE(other.Initialize(fam_path.c_str()));
+    BOOST_CHECK(other.IsRegistered(path.c_str(), path.length()));
+
+    string another_path = PathFor(1);
+    BOOST_CHECK(!other.IsRegistered(another_path.c_str(), another_path.length()));
+    BOOST_CHECK_EQUAL(other.TryRegister(another_path.c_str(), another_path.length()), kFirstWrite);
+    BOOST_CHECK(registry.IsRegistered(another_path.c_str(), another_path.length()));
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestUninitializedRegistryIsUnavailable)
+{
+    FirstWriteRegistry registry;
+    string path = PathFor(0);
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kRegistryUnavailable);
+    BOOST_CHECK(!registry.IsRegistered(path.c_str(), path.length()));
+    BOOST_CHECK(!registry.Initialize("/tmp/this/fam/does/not/exist.fam"));
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kRegistryUnavailable);
+}
+
+BOOST_AUTO_TEST_CASE(TestStaleRegistryIsReplaced)
+{
+    string fam_path = CreateFam("fwr_stale");
+    string path = PathFor(0);
+
+    {
+        FirstWriteRegistry registry;
+        BOOST_REQUIRE(registry.Initialize(fam_path.c_str()));
+        BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kFirstWrite);
+    }
+
+    // Rewriting the FAM (as the engine does for every pip run) invalidates the registry
+    unlink(fam_path.c_str());
+    usleep(10000);
+    ofstream fam(fam_path);
+    fam << "new fam";
+    fam.close();
+
+    FirstWriteRegistry registry;
+    BOOST_REQUIRE(registry.Initialize(fam_path.c_str()));
+    BOOST_CHECK_EQUAL(registry.TryRegister(path.c_str(), path.length()), kFirstWrite);
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestConcurrentProcessesRegisterEachPathOnce)
+{
+    const int process_count = 8;
+    const int path_count = 5000;
+    string fam_path = CreateFam("fwr_concurrent");
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+
+    vector<pid_t> children;
+    for (int p = 0; p < process_count; p++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Every process maps the registry independently, as processes started with exec do
+            FirstWriteRegistry registry;
+            if (!registry.Initialize(fam_path.c_str())) {
+                _exit(1);
+            }
+
+            int first_writes = 0;
+            for (int i = 0; i < path_count; i++) {
+                // Start at different offsets so processes actually race on the same paths
+                string path = PathFor((i + p * 997) % path_count);
+                auto result = registry.TryRegister(path.c_str(), path.length());
+                if (result == kRegistryUnavailable) {
+                    _exit(2);
+                }
+                first_writes += result == kFirstWrite ? 1 : 0;
+            }
+
+            if (write(fds[1], &first_writes, sizeof(first_writes)) != sizeof(first_writes)) {
+                _exit(3);
+            }
+            _exit(0);
+        }
+        BOOST_REQUIRE(pid > 0);
+        children.push_back(pid);
+    }
+
+    int total_first_writes = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        BOOST_REQUIRE(WIFEXITED(status));
+        BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+
+        int first_writes = 0;
+        BOOST_REQUIRE_EQUAL(read(fds[0], &first_writes, sizeof(first_writes)), (ssize_t)sizeof(first_writes));
+        total_first_writes += first_writes;
+    }
+
+    // Exactly one process got to register each path
+    BOOST_CHECK_EQUAL(total_first_writes, path_count);
+
+    close(fds[0]);
+    close(fds[1]);
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <input_prefetcher.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+static void WriteFile(const string& path, const string& content) {
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_REQUIRE_EQUAL(write(fd, content.data(), content.length()), (ssize_t)content.length());
+    close(fd);
+}
+
+BOOST_AUTO_TEST_SUITE(InputPrefetcherTests)
+
+BOOST_AUTO_TEST_CASE(TestParseList)
+{
+    vector<string> paths = InputPrefetcher::ParseList("/a/b.h\n\n/c/d.h\r\nrelative/e.h\n/f g/h.h");
+    BOOST_REQUIRE_EQUAL(paths.size(), 3);
+    BOOST_CHECK_EQUAL(paths[0], "/a/b.h");
+    BOOST_CHECK_EQUAL(paths[1], "/c/d.h");
+    BOOST_CHECK_EQUAL(paths[2], "/f g/h.h");
+
+    BOOST_CHECK(InputPrefetcher::ParseList("").empty());
+    BOOST_CHECK(InputPrefetcher::ParseList("\n\n").empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestPrefetchStatistics)
+{
+    string file = TempPath("prefetch_file");
+    string directory = TempPath("prefetch_dir");
+    WriteFile(file, "0123456789");
+    mkdir(directory.c_str(), 0755);
+
+    InputPrefetcher prefetcher;
+    prefetcher.Prefetch({ file, directory, TempPath("prefetch_missing"), file });
+
+    PrefetchStatistics statistics = prefetcher.Stop();
+    BOOST_CHECK_EQUAL(statistics.listed, 4);
+    BOOST_CHECK_EQUAL(statistics.prefetched, 2);
+    BOOST_CHECK_EQUAL(statistics.missing, 2);
+    BOOST_CHECK_EQUAL(statistics.bytes, 20);
+    BOOST_CHECK(statistics.completed);
+
+    rmdir(directory.c_str());
+    unlink(file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestPrefetchInBackground)
+{
+    string file = TempPath("prefetch_background");
+    string list = TempPath("prefetch_list");
+    WriteFile(file, "content");
+    WriteFile(list, file + "\n" + file + "\n");
+
+    InputPrefetcher prefetcher;
+    BOOST_REQUIRE(prefetcher.Start(list.c_str()));
+    BOOST_CHECK(prefetcher.IsStarted());
+
+    // The thread is never joined: wait for it to go through the list
+    PrefetchStatistics statistics;
+    for (int i = 0; i < 500; i++) {
+        statistics = prefetcher.GetStatistics();
+        if (statistics.completed) {
+            break;
+        }
+
+        usleep(10000);
+    }
+
+    BOOST_CHECK(statistics.completed);
+    BOOST_CHECK_EQUAL(statistics.listed, 2);
+    BOOST_CHECK_EQUAL(statistics.prefetched, 2);
+
+    unlink(list.c_str());
+    unlink(file.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestMissingList)
+{
+    InputPrefetcher prefetcher;
+    BOOST_CHECK(!prefetcher.Start(TempPath("prefetch_no_list").c_str()));
+    BOOST_CHECK(!prefetcher.IsStarted());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
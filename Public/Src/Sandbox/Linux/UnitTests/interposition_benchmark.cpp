@@ -0,0 +1,313 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Throughput of a mixed open/write/stat/readdir workload as the number of threads grows, with every operation going through
+ * the interposed libc functions (sandboxed) and through raw syscalls (not sandboxed: never interposed), in the same process.
+ *
+ * Meant to be run under the sandbox: it prints one line per thread count and mode, plus the access cache statistics of the
+ * sandbox, which show how often a lookup fell through to a full access check because the cache lock was busy. Each thread
+ * works on its own small set of files, so after the first pass every access of a thread is a cache hit.
+ *
+ * Arguments (after --):
+ *   --iterations=<n>   iterations per thread (each iteration is a few operations; default 200)
+ *   --max-threads=<n>  largest thread count; counts double from 1 (default 128)
+ *   --detours=<path>   re-executes the benchmark with the given libDetours.so in LD_PRELOAD in place of the one the sandbox
+ *                      injected (e.g., a ThreadSanitizer build of it, for the interposition_benchmark_tsan configuration)
+ */
+
+static const int kFilesPerThread = 8;
+
+typedef void (*GetCacheStatisticsFunction)(uint64_t *, uint64_t *, uint64_t *);
+
+struct CacheStatistics {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t busy = 0;
+};
+
+static int sIterations = 200;
+static int sMaxThreads = 128;
+
+static const char *GetArgument(const char *name) {
+    auto &suite = boost::unit_test::framework::master_test_suite();
+    size_t length = strlen(name);
+    for (int i = 1; i < suite.argc; i++) {
+        if (strncmp(suite.argv[i], name, length) == 0 && suite.argv[i][length] == '=') {
+            return suite.argv[i] + length + 1;
+        }
+    }
+
+    return nullptr;
+}
+
+// Swaps the injected libDetours.so for the requested one and re-executes. The exec is a raw syscall: the interposed
+// execve would put the injected library back.
+static void ReexecWithDetours(const char *detours) {
+    const char *preload = getenv("LD_PRELOAD");
+    if (preload == nullptr || strstr(preload, detours) != nullptr) {
+        return;
+    }
+
+    string newPreload = string("LD_PRELOAD=") + detours;
+    vector<string> environment;
+    for (char **env = environ; *env != nullptr; env++) {
+        if (strncmp(*env, "LD_PRELOAD=", 11) != 0) {
+            environment.emplace_back(*env);
+        }
+    }
+
+    environment.push_back(newPreload);
+    vector<char *> envp;
+    for (auto &value : environment) {
+        envp.push_back(&value[0]);
+    }
+
+    envp.push_back(nullptr);
+
+    auto &suite = boost::unit_test::framework::master_test_suite();
+    vector<char *> argv;
+    argv.push_back((char *)"/proc/self/exe");
+    argv.push_back((char *)"--");
+    for (int i = 1; i < suite.argc; i++) {
+        argv.push_back(suite.argv[i]);
+    }
+
+    argv.push_back(nullptr);
+    syscall(SYS_execve, "/proc/self/exe", argv.data(), envp.data());
+    BOOST_FAIL("Could not re-execute with " << detours << "; errno: " << errno);
+}
+
+static bool GetCacheStatistics(CacheStatistics &statistics) {
+    static auto getStatistics = (GetCacheStatisticsFunction)dlsym(RTLD_DEFAULT, "bxl_get_access_cache_statistics");
+    if (getStatistics == nullptr) {
+        return false;
+    }
+
+    getStatistics(&statistics.lookups, &statistics.hits, &statistics.busy);
+    return true;
+}
+
+static string ThreadDirectory(int thread) {
+    return "bench_" + to_string(thread);
+}
+
+static string ThreadFile(int thread, int file) {
+    return ThreadDirectory(thread) + "/file_" + to_string(file);
+}
+
+// Returns the number of operations performed
+static uint64_t RunSandboxed(int thread) {
+    uint64_t operations = 0;
+    char buffer[64] = { 0 };
+    string directory = ThreadDirectory(thread);
+    for (int i = 0; i < sIterations; i++) {
+        string path = ThreadFile(thread, i % kFilesPerThread);
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        write(fd, buffer, sizeof(buffer));
+        close(fd);
+
+        struct stat st;
+        stat(path.c_str(), &st);
+        operations += 4;
+
+        if (i % kFilesPerThread == 0) {
+            DIR *dir = opendir(directory.c_str());
+            while (readdir(dir) != nullptr) {
+            }
+
+            closedir(dir);
+            operations += 3;
+        }
+    }
+
+    return operations;
+}
+
+static uint64_t RunNotSandboxed(int thread) {
+    uint64_t operations = 0;
+    char buffer[64] = { 0 };
+    char entries[4096];
+    string directory = ThreadDirectory(thread);
+    for (int i = 0; i < sIterations; i++) {
+        string path = ThreadFile(thread, i % kFilesPerThread);
+        int fd = (int)syscall(SYS_openat, AT_FDCWD, path.c_str(), O_RDWR | O_CREAT, 0644);
+        syscall(SYS_write, fd, buffer, sizeof(buffer));
+        syscall(SYS_close, fd);
+
+        struct stat st;
+        syscall(SYS_newfstatat, AT_FDCWD, path.c_str(), &st, 0);
+        operations += 4;
+
+        if (i % kFilesPerThread == 0) {
+            int dirFd = (int)syscall(SYS_openat, AT_FDCWD, directory.c_str(), O_RDONLY | O_DIRECTORY, 0);
+            while (syscall(SYS_getdents64, dirFd, entries, sizeof(entries)) > 0) {
+            }
+
+            syscall(SYS_close, dirFd);
+            operations += 3;
+        }
+    }
+
+    return operations;
+}
+
+// Runs the workload on the given number of threads and returns the throughput in operations per second
+template <typename Workload>
+static double Measure(int threadCount, Workload workload, uint64_t &operations) {
+    atomic<uint64_t> total { 0 };
+    atomic<bool> go { false };
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&, t]() {
+            while (!go.load()) {
+                this_thread::yield();
+            }
+
+            total += workload(t);
+        });
+    }
+
+    auto start = chrono::steady_clock::now();
+    go = true;
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    operations = total.load();
+    return seconds > 0 ? operations / seconds : 0;
+}
+
+BOOST_AUTO_TEST_SUITE(InterpositionBenchmark)
+
+BOOST_AUTO_TEST_CASE(TestThroughputScaling)
+{
+    const char *detours = GetArgument("--detours");
+    if (detours != nullptr) {
+        ReexecWithDetours(detours);
+    }
+
+    if (const char *iterations = GetArgument("--iterations")) {
+        sIterations = max(1, atoi(iterations));
+    }
+
+    if (const char *maxThreads = GetArgument("--max-threads")) {
+        sMaxThreads = max(1, atoi(maxThreads));
+    }
+
+    for (int t = 0; t < sMaxThreads; t++) {
+        mkdir(ThreadDirectory(t).c_str(), 0755);
+    }
+
+    CacheStatistics before, after;
+    bool hasCache = GetCacheStatistics(before);
+    if (!hasCache) {
+        BOOST_TEST_MESSAGE("Not running under the sandbox: sandboxed and not sandboxed numbers are the same workload");
+    }
+
+    printf("threads,mode,operations,ops_per_second,scaling,cache_lookups,cache_hit_rate,cache_fall_through_rate\n");
+
+    double sandboxedBaseline = 0, notSandboxedBaseline = 0;
+    for (int threadCount = 1; threadCount <= sMaxThreads; threadCount *= 2) {
+        uint64_t operations;
+        double notSandboxed = Measure(threadCount, RunNotSandboxed, operations);
+        BOOST_CHECK_GT(operations, 0);
+        notSandboxedBaseline = threadCount == 1 ? notSandboxed : notSandboxedBaseline;
+        printf("%d,raw,%llu,%.0f,%.2f,,,\n", threadCount, (unsigned long long)operations, notSandboxed,
+            notSandboxedBaseline > 0 ? notSandboxed / (notSandboxedBaseline * threadCount) : 0);
+
+        GetCacheStatistics(before);
+        double sandboxed = Measure(threadCount, RunSandboxed, operations);
+        GetCacheStatistics(after);
+        BOOST_CHECK_GT(operations, 0);
+        sandboxedBaseline = threadCount == 1 ? sandboxed : sandboxedBaseline;
+
+        // A lookup falls through to a full access check when it misses, or when the cache lock was busy
+        uint64_t lookups = after.lookups - before.lookups;
+        uint64_t hits = after.hits - before.hits;
+        uint64_t busy = after.busy - before.busy;
+        uint64_t attempts = lookups + busy;
+        printf("%d,sandboxed,%llu,%.0f,%.2f,%llu,%.4f,%.4f\n", threadCount, (unsigned long long)operations, sandboxed,
+            sandboxedBaseline > 0 ? sandboxed / (sandboxedBaseline * threadCount) : 0,
+            (unsigned long long)attempts,
+            attempts > 0 ? (double)hits / attempts : 0,
+            attempts > 0 ? (double)(attempts - hits) / attempts : 0);
+    }
+
+    fflush(stdout);
+
+    for (int t = 0; t < sMaxThreads; t++) {
+        for (int f = 0; f < kFilesPerThread; f++) {
+            unlink(ThreadFile(t, f).c_str());
+        }
+
+        rmdir(ThreadDirectory(t).c_str());
+    }
+}
+
+/**
+ * Cost of the interposed read, which reports nothing and is only there for I/O accounting: ns per 1-byte read from /dev/zero,
+ * through libc (interposed) and through the raw syscall. Run it with and without __BUILDXL_IO_ACCOUNTING in the environment of
+ * the sandboxed process to see both sides of the short circuit in the read interposers.
+ *
+ * Arguments (after --):
+ *   --reads=<n>        reads per mode (default 1000000)
+ */
+BOOST_AUTO_TEST_CASE(TestReadOverhead)
+{
+    int reads = 1000000;
+    if (const char *value = GetArgument("--reads")) {
+        reads = max(1, atoi(value));
+    }
+
+    int fd = (int)syscall(SYS_openat, AT_FDCWD, "/dev/zero", O_RDONLY, 0);
+    BOOST_REQUIRE_GE(fd, 0);
+
+    char byte;
+    auto time = [&](auto read) {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < reads; i++) {
+            read();
+        }
+
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / reads;
+    };
+
+    // Warm up: the first interposed call initializes the sandbox
+    time([&]() { return read(fd, &byte, 1); });
+
+    double raw = time([&]() { return syscall(SYS_read, fd, &byte, 1); });
+    double interposed = time([&]() { return read(fd, &byte, 1); });
+    double interposedPread = time([&]() { return pread(fd, &byte, 1, 0); });
+    syscall(SYS_close, fd);
+
+    printf("io_accounting,raw_ns,read_ns,pread_ns,read_overhead_ns\n");
+    printf("%s,%.1f,%.1f,%.1f,%.1f\n", getenv("__BUILDXL_IO_ACCOUNTING") != nullptr ? "on" : "off", raw, interposed, interposedPread,
+        interposed - raw);
+    fflush(stdout);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
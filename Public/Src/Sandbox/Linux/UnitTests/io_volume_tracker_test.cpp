@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <io_volume_tracker.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static IoVolume Find(const vector<pair<string, IoVolume>> &summary, const string &path) {
+    auto entry = find_if(summary.begin(), summary.end(), [&](const pair<string, IoVolume> &e) { return e.first == path; });
+    BOOST_REQUIRE(entry != summary.end());
+    return entry->second;
+}
+
+BOOST_AUTO_TEST_SUITE(IoVolumeTrackerTests)
+
+BOOST_AUTO_TEST_CASE(TestDisabledTrackerAccountsNothing)
+{
+    IoVolumeTracker tracker;
+    BOOST_CHECK(!tracker.IsEnabled());
+    BOOST_CHECK_EQUAL(tracker.Start(), 0);
+
+    tracker.Add(3, IoVolumeTracker::kWrite, 100, tracker.Start());
+    IoVolume volume;
+    BOOST_CHECK(!tracker.Take(3, volume));
+
+    vector<pair<int, IoVolume>> volumes;
+    tracker.TakeAll(volumes);
+    BOOST_CHECK(volumes.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestVolumesPerDescriptor)
+{
+    IoVolumeTracker tracker;
+    tracker.Enable();
+
+    uint64_t start = tracker.Start();
+    BOOST_CHECK_GT(start, 0);
+    tracker.Add(3, IoVolumeTracker::kRead, 10, start);
+    tracker.Add(3, IoVolumeTracker::kRead, 0, start);
+    tracker.Add(3, IoVolumeTracker::kWrite, 5, start);
+    // Failed calls count, but transfer nothing
+    tracker.Add(3, IoVolumeTracker::kWrite, -1, start);
+    tracker.Add(4, IoVolumeTracker::kWrite, 7, start);
+
+    // Out of range descriptors are ignored
+    tracker.Add(-1, IoVolumeTracker::kRead, 1, start);
+    tracker.Add(IoVolumeTracker::kMaxFd, IoVolumeTracker::kRead, 1, start);
+
+    IoVolume volume;
+    BOOST_REQUIRE(tracker.Take(3, volume));
+    BOOST_CHECK_EQUAL(volume.reads, 2);
+    BOOST_CHECK_EQUAL(volume.bytes_read, 10);
+    BOOST_CHECK_EQUAL(volume.writes, 2);
+    BOOST_CHECK_EQUAL(volume.bytes_written, 5);
+    BOOST_CHECK_LE(volume.read_ns + volume.write_ns, 4 * (IoVolumeTracker::Now() - start));
+
+    // Taking resets the counters
+    BOOST_CHECK(!tracker.Take(3, volume));
+    BOOST_CHECK(!tracker.Take(-1, volume));
+
+    vector<pair<int, IoVolume>> volumes;
+    tracker.TakeAll(volumes);
+    BOOST_REQUIRE_EQUAL(volumes.size(), 1);
+    BOOST_CHECK_EQUAL(volumes[0].first, 4);
+    BOOST_CHECK_EQUAL(volumes[0].second.writes, 1);
+    BOOST_CHECK_EQUAL(volumes[0].second.bytes_written, 7);
+}
+
+BOOST_AUTO_TEST_CASE(TestSummaryPerPath)
+{
+    IoVolumeTracker tracker;
+    tracker.Enable();
+
+    // The same file read through two descriptors, one after the other
+    IoVolume first = { 100, 0, 2, 0, 1000, 0 };
+    IoVolume second = { 50, 20, 1, 1, 500, 300 };
+    IoVolume other = { 0, 4096, 0, 1, 0, 42 };
+    tracker.Fold("/a", first);
+    tracker.Fold("/b", other);
+    tracker.Fold("/a", second);
+
+    vector<pair<string, IoVolume>> summary;
+    tracker.Drain(summary);
+    BOOST_REQUIRE_EQUAL(summary.size(), 2);
+
+    IoVolume a = Find(summary, "/a");
+    BOOST_CHECK_EQUAL(a.bytes_read, 150);
+    BOOST_CHECK_EQUAL(a.bytes_written, 20);
+    BOOST_CHECK_EQUAL(a.reads, 3);
+    BOOST_CHECK_EQUAL(a.writes, 1);
+    BOOST_CHECK_EQUAL(a.read_ns, 1500);
+    BOOST_CHECK_EQUAL(a.write_ns, 300);
+    BOOST_CHECK_EQUAL(Find(summary, "/b").bytes_written, 4096);
+
+    // Draining empties the summary
+    summary.clear();
+    tracker.Drain(summary);
+    BOOST_CHECK(summary.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestConcurrentAdds)
+{
+    IoVolumeTracker tracker;
+    tracker.Enable();
+
+    const int threadCount = 8;
+    const int callsPerThread = 10000;
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back([&tracker, i]() {
+            for (int call = 0; call < callsPerThread; call++) {
+                // Half of the threads share a descriptor
+                tracker.Add(i % 2 == 0 ? 5 : 6 + i, IoVolumeTracker::kWrite, 3, tracker.Start());
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    IoVolume volume;
+    BOOST_REQUIRE(tracker.Take(5, volume));
+    BOOST_CHECK_EQUAL(volume.writes, (threadCount / 2) * callsPerThread);
+    BOOST_CHECK_EQUAL(volume.bytes_written, 3ull * (threadCount / 2) * callsPerThread);
+}
+
+BOOST_AUTO_TEST_CASE(TestResetAfterFork)
+{
+    IoVolumeTracker tracker;
+    tracker.Enable();
+    tracker.Add(3, IoVolumeTracker::kRead, 10, tracker.Start());
+    tracker.Fold("/a", { 1, 0, 1, 0, 0, 0 });
+
+    pid_t child = fork();
+    if (child == 0) {
+        tracker.ResetAfterFork();
+
+        IoVolume volume;
+        vector<pair<string, IoVolume>> summary;
+        tracker.Drain(summary);
+        bool clean = !tracker.Take(3, volume) && summary.empty() && tracker.IsEnabled();
+        _exit(clean ? 0 : 1);
+    }
+
+    int status;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // The parent keeps its own state
+    IoVolume volume;
+    BOOST_CHECK(tracker.Take(3, volume));
+    vector<pair<string, IoVolume>> summary;
+    tracker.Drain(summary);
+    BOOST_CHECK_EQUAL(summary.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <chrono>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Startup cost of the audit module (libBxlAudit.so): how long it takes to start a program and wait for it to exit, without
+ * and with the module in LD_AUDIT. The two are interleaved, so that both see the same machine.
+ *
+ * Meant to be run under the sandbox (the programs it starts then have libDetours.so preloaded, and the module hands the
+ * libraries over to it), but it measures the module alone as well.
+ *
+ * Arguments (after --):
+ *   --audit=<path>       the audit module (required: the benchmark does nothing without it)
+ *   --program=<path>     the program to start (default /bin/true); pass one that links many libraries to see the cost grow with them
+ *   --iterations=<n>     starts per mode (default 200)
+ */
+
+extern char **environ;
+
+static const char *GetArgument(const char *name) {
+    auto &suite = boost::unit_test::framework::master_test_suite();
+    size_t length = strlen(name);
+    for (int i = 1; i < suite.argc; i++) {
+        if (strncmp(suite.argv[i], name, length) == 0 && suite.argv[i][length] == '=') {
+            return suite.argv[i] + length + 1;
+        }
+    }
+
+    return nullptr;
+}
+
+// The environment of this process, with LD_AUDIT and the variable that activates the module set (or removed)
+static vector<string> MakeEnvironment(const char *audit) {
+    vector<string> environment;
+    for (char **env = environ; *env != nullptr; env++) {
+        if (strncmp(*env, "LD_AUDIT=", 9) != 0 && strncmp(*env, "__BUILDXL_AUDIT_PATH=", 21) != 0) {
+            environment.emplace_back(*env);
+        }
+    }
+
+    if (audit != nullptr) {
+        environment.emplace_back(string("LD_AUDIT=") + audit);
+        environment.emplace_back(string("__BUILDXL_AUDIT_PATH=") + audit);
+    }
+
+    return environment;
+}
+
+// Microseconds from spawning the program to reaping it, or -1 if it failed
+static double StartAndWait(const char *program, vector<string> &environment) {
+    vector<char *> envp;
+    for (auto &variable : environment) {
+        envp.push_back(&variable[0]);
+    }
+
+    envp.push_back(nullptr);
+    char *argv[] = { const_cast<char *>(program), nullptr };
+
+    auto start = chrono::steady_clock::now();
+    pid_t pid;
+    if (posix_spawn(&pid, program, nullptr, nullptr, argv, envp.data()) != 0) {
+        return -1;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+}
+
+static double Percentile(vector<double> &samples, double percentile) {
+    sort(samples.begin(), samples.end());
+    return samples[min(samples.size() - 1, (size_t)(percentile * samples.size()))];
+}
+
+BOOST_AUTO_TEST_SUITE(LibraryAuditBenchmark)
+
+BOOST_AUTO_TEST_CASE(TestStartupCost)
+{
+    const char *audit = GetArgument("--audit");
+    if (audit == nullptr) {
+        BOOST_TEST_MESSAGE("No audit module given (--audit=<path>): nothing to measure");
+        return;
+    }
+
+    const char *program = GetArgument("--program");
+    program = program != nullptr ? program : "/bin/true";
+    const char *iterationsArgument = GetArgument("--iterations");
+    int iterations = iterationsArgument != nullptr ? max(1, atoi(iterationsArgument)) : 200;
+
+    vector<string> withoutAudit = MakeEnvironment(nullptr);
+    vector<string> withAudit = MakeEnvironment(audit);
+
+    // Warm up the page cache with both
+    BOOST_REQUIRE_GE(StartAndWait(program, withoutAudit), 0);
+    BOOST_REQUIRE_GE(StartAndWait(program, withAudit), 0);
+
+    vector<double> baseline, audited;
+    for (int i = 0; i < iterations; i++) {
+        double without = StartAndWait(program, withoutAudit);
+        double with = StartAndWait(program, withAudit);
+        BOOST_REQUIRE_GE(without, 0);
+        BOOST_REQUIRE_GE(with, 0);
+        baseline.push_back(without);
+        audited.push_back(with);
+    }
+
+    double baselineMedian = Percentile(baseline, 0.5);
+    double auditedMedian = Percentile(audited, 0.5);
+    printf("mode,starts,p50_us,p95_us,overhead_us,overhead_ratio\n");
+    printf("no_audit,%d,%.1f,%.1f,,\n", iterations, baselineMedian, Percentile(baseline, 0.95));
+    printf("audit,%d,%.1f,%.1f,%.1f,%.3f\n", iterations, auditedMedian, Percentile(audited, 0.95),
+        auditedMedian - baselineMedian, baselineMedian > 0 ? auditedMedian / baselineMedian : 0);
+    fflush(stdout);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <library_audit.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static vector<pair<string, int>> sReported;
+
+static void Collect(const char *path, int loaded) {
+    sReported.emplace_back(path, loaded);
+}
+
+BOOST_AUTO_TEST_SUITE(LibraryAuditTests)
+
+BOOST_AUTO_TEST_CASE(TestStartupIsKeptUntilAttached)
+{
+    // The object is big: keep it off the stack
+    auto audit = make_unique<LibraryAudit>();
+    sReported.clear();
+
+    // The main program and the vDSO are not files
+    audit->Opened("");
+    audit->Opened("linux-vdso.so.1");
+
+    // DT_NEEDED: the name is searched, then the loader tries a path from the cache
+    audit->Searched("libc.so.6");
+    audit->Searched("/lib/x86_64-linux-gnu/libc.so.6");
+    audit->Opened("/lib/x86_64-linux-gnu/libc.so.6");
+    audit->Consistent();
+    BOOST_CHECK(sReported.empty());
+    BOOST_CHECK(!audit->IsAttached());
+
+    audit->Attach(Collect);
+    BOOST_CHECK(audit->IsAttached());
+    BOOST_REQUIRE_EQUAL(sReported.size(), 1);
+    BOOST_CHECK_EQUAL(sReported[0].first, "/lib/x86_64-linux-gnu/libc.so.6");
+    BOOST_CHECK_EQUAL(sReported[0].second, 1);
+
+    // Once attached, accesses are handed over as they happen
+    audit->Searched("/opt/lib/libm.so.6");
+    audit->Opened("/opt/lib/libm.so.6");
+    BOOST_REQUIRE_EQUAL(sReported.size(), 2);
+    BOOST_CHECK_EQUAL(sReported[1].first, "/opt/lib/libm.so.6");
+}
+
+BOOST_AUTO_TEST_CASE(TestDlopenChain)
+{
+    // A library that loads a library that loads a library, each next to the previous one
+    auto audit = make_unique<LibraryAudit>();
+    audit->Attach(Collect);
+    sReported.clear();
+
+    for (int level = 1; level <= 3; level++) {
+        string path = "/chain/libDlopenChain" + to_string(level) + ".so";
+        audit->Searched(path.c_str());
+        audit->Opened(path.c_str());
+        audit->Consistent();
+    }
+
+    // Loading any of them again maps nothing
+    audit->Searched("/chain/libDlopenChain2.so");
+    audit->Opened("/chain/libDlopenChain2.so");
+    audit->Consistent();
+
+    BOOST_REQUIRE_EQUAL(sReported.size(), 3);
+    for (int level = 1; level <= 3; level++) {
+        BOOST_CHECK_EQUAL(sReported[level - 1].first, "/chain/libDlopenChain" + to_string(level) + ".so");
+        BOOST_CHECK_EQUAL(sReported[level - 1].second, 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestPathsTriedButNotMapped)
+{
+    auto audit = make_unique<LibraryAudit>();
+    audit->Attach(Collect);
+    sReported.clear();
+
+    // The loader goes through the library path until it finds the library
+    audit->Searched("libfoo.so");
+    audit->Searched("/a/libfoo.so");
+    audit->Searched("/b/libfoo.so");
+    audit->Opened("/b/libfoo.so");
+
+    // A dlopen that fails: only the end of the load tells
+    audit->Searched("/c/libbar.so");
+    audit->Consistent();
+
+    // Something else got mapped while a path was being tried
+    audit->Searched("/d/libbaz.so");
+    audit->Opened("/e/libbaz.so");
+
+    vector<pair<string, int>> expected = {
+        { "/a/libfoo.so", 0 },
+        { "/b/libfoo.so", 1 },
+        { "/c/libbar.so", 0 },
+        { "/d/libbaz.so", 0 },
+        { "/e/libbaz.so", 1 },
+    };
+    BOOST_REQUIRE_EQUAL(sReported.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        BOOST_CHECK_EQUAL(sReported[i].first, expected[i].first);
+        BOOST_CHECK_EQUAL(sReported[i].second, expected[i].second);
+    }
+
+    // Trying an absent path again is not a new access
+    audit->Searched("/a/libfoo.so");
+    audit->Consistent();
+    BOOST_CHECK_EQUAL(sReported.size(), expected.size());
+}
+
+BOOST_AUTO_TEST_CASE(TestBufferOverflowDropsAccesses)
+{
+    auto audit = make_unique<LibraryAudit>();
+    sReported.clear();
+
+    // Long paths, so that the buffer fills up before the table of seen paths does
+    string directory = "/" + string(1000, 'd');
+    int count = (int)(LibraryAudit::kBufferSize / 1000) + 10;
+    for (int i = 0; i < count; i++) {
+        audit->Opened((directory + "/lib" + to_string(i) + ".so").c_str());
+    }
+
+    BOOST_CHECK_GT(audit->Dropped(), 0);
+    audit->Attach(Collect);
+    BOOST_CHECK_EQUAL((int)sReported.size() + audit->Dropped(), count);
+
+    // Nothing is dropped once attached
+    audit->Opened("/late/lib.so");
+    BOOST_CHECK_EQUAL(sReported.back().first, "/late/lib.so");
+}
+
+BOOST_AUTO_TEST_CASE(TestManyPaths)
+{
+    // Past the capacity of the table of seen paths, paths are handed over every time rather than lost
+    auto audit = make_unique<LibraryAudit>();
+    audit->Attach(Collect);
+    sReported.clear();
+
+    for (int i = 0; i < LibraryAudit::kMaxPaths; i++) {
+        audit->Opened(("/lib/" + to_string(i) + ".so").c_str());
+    }
+
+    BOOST_CHECK_EQUAL(sReported.size(), (size_t)LibraryAudit::kMaxPaths);
+    audit->Opened("/lib/0.so");
+    audit->Opened("/lib/0.so");
+    BOOST_CHECK_EQUAL(sReported.size(), (size_t)LibraryAudit::kMaxPaths + 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestSeenPathsOverflow)
+{
+    // Paths that don't fit with the ones seen are handed over every time, while the ones that fit are still handed over once
+    auto audit = make_unique<LibraryAudit>();
+    audit->Attach(Collect);
+    sReported.clear();
+
+    string directory = "/" + string(1000, 'd');
+    int count = (int)(LibraryAudit::kSeenPathsSize / 1000) + 10;
+    for (int i = 0; i < count; i++) {
+        audit->Opened((directory + "/lib" + to_string(i) + ".so").c_str());
+    }
+
+    BOOST_CHECK_EQUAL(sReported.size(), (size_t)count);
+
+    audit->Opened((directory + "/lib0.so").c_str());
+    BOOST_CHECK_EQUAL(sReported.size(), (size_t)count);
+
+    audit->Opened((directory + "/lib" + to_string(count - 1) + ".so").c_str());
+    BOOST_CHECK_EQUAL(sReported.size(), (size_t)count + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
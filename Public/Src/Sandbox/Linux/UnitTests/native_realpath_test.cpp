@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <errno.h>
+#include <limits.h>
+#include <random>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <native_realpath.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// {root}
+//   `-- dir
+//         `-- file
+//         `-- up [-> ..]
+//   `-- file
+//   `-- dirlink [-> dir]
+//   `-- filelink [-> dir/file]
+//   `-- dangling [-> missing]
+//   `-- loop1 [-> loop2]
+//   `-- loop2 [-> loop1]
+class RealpathTree {
+public:
+    RealpathTree() {
+        char temp[] = "/tmp/bxl_realpath_XXXXXX";
+        BOOST_REQUIRE(mkdtemp(temp) != nullptr);
+        char resolved[PATH_MAX];
+        BOOST_REQUIRE(realpath(temp, resolved) != nullptr);
+        root = resolved;
+
+        BOOST_REQUIRE_EQUAL(mkdir((root + "/dir").c_str(), 0700), 0);
+        File("dir/file");
+        File("file");
+        Symlink("..", "dir/up");
+        Symlink("dir", "dirlink");
+        Symlink("dir/file", "filelink");
+        Symlink("missing", "dangling");
+        Symlink("loop2", "loop1");
+        Symlink("loop1", "loop2");
+    }
+
+    ~RealpathTree() {
+        string command = "rm -rf " + root;
+        BOOST_CHECK_EQUAL(system(command.c_str()), 0);
+    }
+
+    string root;
+
+private:
+    void File(const char *path) { FILE *f = fopen((root + "/" + path).c_str(), "w"); BOOST_REQUIRE(f != nullptr); fclose(f); }
+    void Symlink(const char *target, const char *path) { BOOST_REQUIRE_EQUAL(symlink(target, (root + "/" + path).c_str()), 0); }
+};
+
+static int Resolve(const string& path, string& result, string& failed_path, vector<string> *symlinks = nullptr) {
+    char buffer[PATH_MAX];
+    char failed[PATH_MAX];
+    strcpy(buffer, path.c_str());
+
+    auto read_link = [symlinks](const char *prefix, char *target, size_t target_size) {
+        ssize_t length = readlink(prefix, target, target_size);
+        if (length != -1 && symlinks != nullptr) {
+            symlinks->push_back(prefix);
+        }
+        return length;
+    };
+    auto is_directory = [](const char *prefix) {
+        struct stat st;
+        return stat(prefix, &st) == 0 && S_ISDIR(st.st_mode);
+    };
+
+    int error = ResolveRealPath(buffer, failed, read_link, is_directory);
+    result = buffer;
+    failed_path = failed;
+    return error;
+}
+
+BOOST_AUTO_TEST_SUITE(NativeRealpathTests)
+
+BOOST_AUTO_TEST_CASE(TestErrors)
+{
+    RealpathTree tree;
+    string result, failed;
+
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/dir/missing", result, failed), ENOENT);
+    BOOST_CHECK_EQUAL(failed, tree.root + "/dir/missing");
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/missing/file", result, failed), ENOENT);
+    BOOST_CHECK_EQUAL(failed, tree.root + "/missing");
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/dangling", result, failed), ENOENT);
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/file/", result, failed), ENOTDIR);
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/filelink/..", result, failed), ENOTDIR);
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/loop1", result, failed), ELOOP);
+}
+
+BOOST_AUTO_TEST_CASE(TestSymlinksAreReported)
+{
+    RealpathTree tree;
+    string result, failed;
+    vector<string> symlinks;
+
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/dirlink/up/filelink", result, failed, &symlinks), 0);
+    BOOST_CHECK_EQUAL(result, tree.root + "/dir/file");
+    BOOST_REQUIRE_EQUAL(symlinks.size(), 3);
+    BOOST_CHECK_EQUAL(symlinks[0], tree.root + "/dirlink");
+    BOOST_CHECK_EQUAL(symlinks[1], tree.root + "/dir/up");
+    BOOST_CHECK_EQUAL(symlinks[2], tree.root + "/filelink");
+
+    // Nothing to report without symlinks
+    symlinks.clear();
+    BOOST_CHECK_EQUAL(Resolve(tree.root + "/dir/./file", result, failed, &symlinks), 0);
+    BOOST_CHECK_EQUAL(result, tree.root + "/dir/file");
+    BOOST_CHECK(symlinks.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestFuzzAgainstGlibc)
+{
+    RealpathTree tree;
+    const vector<string> components = { "dir", "file", "up", "dirlink", "filelink", "dangling", "loop1", "missing", ".", "..", "" };
+    mt19937 random(58);
+    uniform_int_distribution<size_t> pick(0, components.size() - 1);
+    uniform_int_distribution<int> length(1, 7);
+
+    int succeeded = 0, failed_count = 0;
+    for (int i = 0; i < 20000; i++) {
+        string path = tree.root;
+        int count = length(random);
+        for (int c = 0; c < count; c++) {
+            path += "/" + components[pick(random)];
+        }
+
+        char expected[PATH_MAX];
+        errno = 0;
+        bool expected_success = realpath(path.c_str(), expected) != nullptr;
+        int expected_errno = expected_success ? 0 : errno;
+
+        string result, failed;
+        int error = Resolve(path, result, failed);
+        BOOST_CHECK_MESSAGE(error == expected_errno, path << ": got errno " << error << ", expected " << expected_errno);
+
+        if (expected_success) {
+            BOOST_CHECK_MESSAGE(result == expected, path << ": got " << result << ", expected " << expected);
+            succeeded++;
+        }
+        else if (error == ENOENT) {
+            // glibc leaves the prefix that failed to resolve in the buffer
+            BOOST_CHECK_MESSAGE(failed == expected, path << ": failed at " << failed << ", glibc failed at " << expected);
+            failed_count++;
+        }
+    }
+
+    BOOST_TEST_MESSAGE("Compared " << succeeded << " resolved paths and " << failed_count << " failures against glibc");
+    BOOST_CHECK(succeeded > 1000);
+    BOOST_CHECK(failed_count > 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,215 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <output_close_tracker.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+// Opens the file for writing like the interposed open would, returning whether it was reported as reopened
+static int OpenTracked(OutputCloseTracker& tracker, const string& path, bool& reopened) {
+    int fd = open(path.c_str(), O_CREAT | O_WRONLY | O_APPEND, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    reopened = tracker.Track(fd, path.c_str());
+    return fd;
+}
+
+static int OpenTracked(OutputCloseTracker& tracker, const string& path) {
+    bool reopened;
+    return OpenTracked(tracker, path, reopened);
+}
+
+// Closes like the interposed close would, returning whether the output was reported as closed
+static bool Close(OutputCloseTracker& tracker, int fd, ClosedOutput& closed) {
+    OutputCloseTracker::ReleasedOutput released;
+    bool last_writer = tracker.Release(fd, released);
+    BOOST_REQUIRE_EQUAL(close(fd), 0);
+    return last_writer && tracker.Finalize(released, closed);
+}
+
+BOOST_AUTO_TEST_SUITE(OutputCloseTrackerTests)
+
+BOOST_AUTO_TEST_CASE(TestCloseIsReported)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_close");
+    unlink(path.c_str());
+    ClosedOutput closed;
+
+    int fd = OpenTracked(tracker, path);
+    BOOST_REQUIRE_EQUAL(write(fd, "0123", 4), 4);
+    BOOST_REQUIRE(Close(tracker, fd, closed));
+
+    struct stat st;
+    BOOST_REQUIRE_EQUAL(stat(path.c_str(), &st), 0);
+    BOOST_CHECK_EQUAL(closed.path, path);
+    BOOST_CHECK_EQUAL(closed.size, 4);
+    BOOST_CHECK_EQUAL(closed.mtime_ns, (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec);
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestLastDescriptorCloses)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_last");
+    ClosedOutput closed;
+
+    // Duplicated descriptors
+    int fd = OpenTracked(tracker, path);
+    int dup_fd = dup(fd);
+    tracker.Duplicate(fd, dup_fd);
+    BOOST_CHECK(!Close(tracker, fd, closed));
+    BOOST_CHECK(Close(tracker, dup_fd, closed));
+
+    // Independent opens of the same file, through different paths
+    string link_path = path + ".lnk";
+    BOOST_REQUIRE_EQUAL(symlink(path.c_str(), link_path.c_str()), 0);
+    fd = OpenTracked(tracker, path);
+    int other_fd = OpenTracked(tracker, link_path);
+    BOOST_CHECK(!Close(tracker, other_fd, closed));
+    BOOST_CHECK(Close(tracker, fd, closed));
+    BOOST_CHECK_EQUAL(closed.path, path);
+
+    // A descriptor duplicated over another one closes the file the latter was open on
+    string other_path = path + ".other";
+    fd = OpenTracked(tracker, path);
+    other_fd = OpenTracked(tracker, other_path);
+    OutputCloseTracker::ReleasedOutput released;
+    BOOST_REQUIRE(tracker.Release(other_fd, released));
+    BOOST_REQUIRE_EQUAL(dup2(fd, other_fd), other_fd);
+    tracker.Duplicate(fd, other_fd);
+    BOOST_CHECK(tracker.Finalize(released, closed));
+    BOOST_CHECK_EQUAL(closed.path, other_path);
+    BOOST_CHECK(!Close(tracker, fd, closed));
+    BOOST_CHECK(Close(tracker, other_fd, closed));
+    BOOST_CHECK_EQUAL(closed.path, path);
+
+    unlink(other_path.c_str());
+    unlink(link_path.c_str());
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestReopenIsReported)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_reopen");
+    ClosedOutput closed;
+    bool reopened;
+
+    int fd = OpenTracked(tracker, path, reopened);
+    BOOST_CHECK(!reopened);
+    BOOST_REQUIRE(Close(tracker, fd, closed));
+
+    fd = OpenTracked(tracker, path, reopened);
+    BOOST_CHECK(reopened);
+
+    // Only once per close
+    int other_fd = OpenTracked(tracker, path, reopened);
+    BOOST_CHECK(!reopened);
+
+    BOOST_CHECK(!Close(tracker, other_fd, closed));
+    BOOST_CHECK(Close(tracker, fd, closed));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestReplacedFilesAreNotReported)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_replaced");
+    string renamed_path = path + ".renamed";
+    ClosedOutput closed;
+
+    // Written under a temporary name and then moved away
+    int fd = OpenTracked(tracker, path);
+    BOOST_REQUIRE_EQUAL(rename(path.c_str(), renamed_path.c_str()), 0);
+    BOOST_CHECK(!Close(tracker, fd, closed));
+
+    // Replaced by a different file
+    fd = OpenTracked(tracker, path);
+    BOOST_REQUIRE_EQUAL(rename(renamed_path.c_str(), path.c_str()), 0);
+    BOOST_CHECK(!Close(tracker, fd, closed));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestSharedDescriptorsAreNotReported)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_shared");
+    ClosedOutput closed;
+
+    // The descriptors a forked child inherits may be written after the parent closes them
+    int fd = OpenTracked(tracker, path);
+    tracker.StopTrackingShared();
+    BOOST_CHECK(!Close(tracker, fd, closed));
+
+    fd = OpenTracked(tracker, path);
+    tracker.ResetAfterFork();
+    BOOST_CHECK(!Close(tracker, fd, closed));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestExitReleasesEverything)
+{
+    OutputCloseTracker tracker;
+    tracker.Enable();
+    string path = TempPath("oct_exit");
+    string other_path = path + ".other";
+    ClosedOutput closed;
+
+    int fd = OpenTracked(tracker, path);
+    int dup_fd = dup(fd);
+    tracker.Duplicate(fd, dup_fd);
+    int other_fd = OpenTracked(tracker, other_path);
+
+    vector<OutputCloseTracker::ReleasedOutput> released;
+    tracker.ReleaseAll(released);
+    BOOST_REQUIRE_EQUAL(released.size(), 2);
+    BOOST_CHECK_EQUAL(released[0].path, path);
+    BOOST_CHECK_EQUAL(released[1].path, other_path);
+
+    // Nothing is left to report
+    BOOST_CHECK(!Close(tracker, fd, closed));
+    BOOST_CHECK(!Close(tracker, dup_fd, closed));
+    BOOST_CHECK(!Close(tracker, other_fd, closed));
+
+    unlink(other_path.c_str());
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestDisabled)
+{
+    OutputCloseTracker tracker;
+    string path = TempPath("oct_disabled");
+    ClosedOutput closed;
+    bool reopened;
+
+    int fd = OpenTracked(tracker, path, reopened);
+    BOOST_CHECK(!reopened);
+    BOOST_CHECK(!Close(tracker, fd, closed));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,265 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <output_hash_tracker.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+static string HashOf(const string& content) {
+    auto hasher = CreateContentHasher("VSO0");
+    hasher->Update(content.data(), content.length());
+    return string("VSO0:") + hasher->Finish();
+}
+
+// Opens the file like the interposed open would, and starts tracking it
+static int OpenTracked(OutputHashTracker& tracker, const string& path, int flags = O_CREAT | O_TRUNC | O_WRONLY) {
+    int fd = open(path.c_str(), flags, 0644);
+    BOOST_REQUIRE(fd >= 0);
+    tracker.Track(fd, path.c_str(), flags);
+    return fd;
+}
+
+// Writes like the interposed write would
+static void Write(OutputHashTracker& tracker, int fd, const string& content) {
+    ssize_t written = write(fd, content.data(), content.length());
+    BOOST_REQUIRE_EQUAL(written, (ssize_t)content.length());
+    tracker.Write(fd, content.data(), written);
+}
+
+static void PositionalWrite(OutputHashTracker& tracker, int fd, const string& content, off_t offset) {
+    ssize_t written = pwrite(fd, content.data(), content.length(), offset);
+    BOOST_REQUIRE_EQUAL(written, (ssize_t)content.length());
+    tracker.PositionalWrite(fd, offset, content.data(), written);
+}
+
+// Closes like the interposed close would, returning whether a hash was produced
+static bool Close(OutputHashTracker& tracker, int fd, OutputHash& output) {
+    bool completed = tracker.Complete(fd, output);
+    close(fd);
+    return completed;
+}
+
+BOOST_AUTO_TEST_SUITE(OutputHashTrackerTests)
+
+BOOST_AUTO_TEST_CASE(TestSequentialWrites)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+
+    string path = TempPath("oht_sequential");
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "hello ");
+
+    struct iovec iov[2] = { { (void *)"wor", 3 }, { (void *)"ld", 2 } };
+    ssize_t written = writev(fd, iov, 2);
+    BOOST_REQUIRE_EQUAL(written, 5);
+    tracker.Writev(fd, iov, 2, written);
+
+    // A positional write right where the previous one ended keeps the hash valid
+    PositionalWrite(tracker, fd, "!", 11);
+
+    // Failed writes don't count
+    tracker.Write(fd, "ignored", -1);
+
+    OutputHash output;
+    BOOST_REQUIRE(Close(tracker, fd, output));
+    BOOST_CHECK_EQUAL(output.path, path);
+    BOOST_CHECK_EQUAL(output.size, 12);
+    BOOST_CHECK_EQUAL(output.hash, HashOf("hello world!"));
+
+    struct stat st;
+    BOOST_REQUIRE_EQUAL(stat(path.c_str(), &st), 0);
+    BOOST_CHECK_EQUAL(output.mtime_ns, (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec);
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestEmptyFile)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+
+    string path = TempPath("oht_empty");
+    int fd = OpenTracked(tracker, path);
+
+    OutputHash output;
+    BOOST_REQUIRE(Close(tracker, fd, output));
+    BOOST_CHECK_EQUAL(output.size, 0);
+    BOOST_CHECK_EQUAL(output.hash, HashOf(""));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestOnlyEmptyFilesOpenedForWritingAreTracked)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+    string path = TempPath("oht_untracked");
+    OutputHash output;
+
+    // Existing content was never seen
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "existing");
+    close(fd);
+    fd = OpenTracked(tracker, path, O_WRONLY | O_APPEND);
+    Write(tracker, fd, " and more");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Not opened for writing
+    fd = OpenTracked(tracker, path, O_RDONLY);
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Not a regular file
+    fd = OpenTracked(tracker, "/dev/null", O_WRONLY);
+    Write(tracker, fd, "discarded");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestNonSequentialWritesInvalidate)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+    string path = TempPath("oht_seek");
+    OutputHash output;
+
+    // Seeking back and overwriting
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123456789");
+    lseek(fd, 2, SEEK_SET);
+    Write(tracker, fd, "ab");
+    lseek(fd, 0, SEEK_END);
+    Write(tracker, fd, "cd");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Seeking forward, leaving a gap
+    fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    lseek(fd, 10, SEEK_CUR);
+    Write(tracker, fd, "4567");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Positional write past the end
+    fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    PositionalWrite(tracker, fd, "89", 8);
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Positional write that overwrites, even if the file keeps growing sequentially afterwards
+    fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    PositionalWrite(tracker, fd, "ab", 0);
+    Write(tracker, fd, "4567");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestChangesFromElsewhereInvalidate)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+    string path = TempPath("oht_elsewhere");
+    OutputHash output;
+
+    // Appended through another descriptor after the last tracked write
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    int other = open(path.c_str(), O_WRONLY | O_APPEND);
+    BOOST_REQUIRE_EQUAL(write(other, "x", 1), 1);
+    close(other);
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Appended through another descriptor between tracked writes
+    fd = OpenTracked(tracker, path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND);
+    Write(tracker, fd, "0123");
+    other = open(path.c_str(), O_WRONLY | O_APPEND);
+    BOOST_REQUIRE_EQUAL(write(other, "x", 1), 1);
+    close(other);
+    Write(tracker, fd, "4567");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestInvalidate)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("SHA256"));
+    string path = TempPath("oht_invalidate");
+    OutputHash output;
+
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    tracker.Invalidate(fd);
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Truncated by path: the tracked file is found through any path to it
+    string link_path = path + ".lnk";
+    fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    BOOST_REQUIRE_EQUAL(symlink(path.c_str(), link_path.c_str()), 0);
+    tracker.InvalidatePath(link_path.c_str());
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    // Nothing survives a fork
+    fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    tracker.ResetAfterFork();
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    unlink(link_path.c_str());
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestErrnoIsPreserved)
+{
+    OutputHashTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize("VSO0"));
+    string path = TempPath("oht_errno");
+    OutputHash output;
+
+    int fd = OpenTracked(tracker, path);
+    errno = EAGAIN;
+    tracker.Write(fd, "0123", 4);
+    BOOST_CHECK_EQUAL(errno, EAGAIN);
+    tracker.InvalidatePath("/does/not/exist");
+    BOOST_CHECK_EQUAL(errno, EAGAIN);
+    tracker.Complete(fd, output);
+    BOOST_CHECK_EQUAL(errno, EAGAIN);
+
+    close(fd);
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestDisabled)
+{
+    OutputHashTracker tracker;
+    BOOST_CHECK(!tracker.Initialize("MD5"));
+    BOOST_CHECK(!tracker.IsEnabled());
+
+    string path = TempPath("oht_disabled");
+    OutputHash output;
+    int fd = OpenTracked(tracker, path);
+    Write(tracker, fd, "0123");
+    BOOST_CHECK(!Close(tracker, fd, output));
+
+    unlink(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
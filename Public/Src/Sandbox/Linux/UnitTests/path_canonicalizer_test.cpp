@@ -0,0 +1,220 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <errno.h>
+#include <limits.h>
+#include <random>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <path_canonicalizer.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// {root}
+//   `-- real1
+//         `-- dir
+//               `-- file.txt
+//         `-- up [-> ..]
+//         `-- file.txt
+//   `-- real2
+//         `-- abs [-> {root}/real1/dir]
+//   `-- symlink1 [-> real1]
+//   `-- symlink2 [-> symlink1/dir]
+//   `-- filelink [-> real1/file.txt]
+//   `-- loop1 [-> loop2]
+//   `-- loop2 [-> loop1]
+class SymlinkTree {
+public:
+    SymlinkTree() {
+        char temp[] = "/tmp/bxl_canonicalizer_XXXXXX";
+        BOOST_REQUIRE(mkdtemp(temp) != nullptr);
+        // The root itself must not go through symlinks for the comparison with realpath to be meaningful
+        char resolved[PATH_MAX];
+        BOOST_REQUIRE(realpath(temp, resolved) != nullptr);
+        root = resolved;
+
+        Directory("real1");
+        Directory("real1/dir");
+        Directory("real2");
+        File("real1/file.txt");
+        File("real1/dir/file.txt");
+        Symlink("..", "real1/up");
+        Symlink((root + "/real1/dir").c_str(), "real2/abs");
+        Symlink("real1", "symlink1");
+        Symlink("symlink1/dir", "symlink2");
+        Symlink("real1/file.txt", "filelink");
+        Symlink("loop2", "loop1");
+        Symlink("loop1", "loop2");
+    }
+
+    ~SymlinkTree() {
+        string command = "rm -rf " + root;
+        BOOST_CHECK_EQUAL(system(command.c_str()), 0);
+    }
+
+    string root;
+
+private:
+    void Directory(const char *path) { BOOST_REQUIRE_EQUAL(mkdir((root + "/" + path).c_str(), 0700), 0); }
+    void File(const char *path) { FILE *f = fopen((root + "/" + path).c_str(), "w"); BOOST_REQUIRE(f != nullptr); fclose(f); }
+    void Symlink(const char *target, const char *path) { BOOST_REQUIRE_EQUAL(symlink(target, (root + "/" + path).c_str()), 0); }
+};
+
+static CanonicalizationResult Canonicalize(const string& path, bool follow_final_symlink, string& result, vector<string> *symlinks = nullptr) {
+    char buffer[PATH_MAX];
+    strcpy(buffer, path.c_str());
+    auto status = CanonicalizePath(buffer, follow_final_symlink, [symlinks](const char *prefix, bool is_final, char *target, size_t target_size) {
+        ssize_t length = readlink(prefix, target, target_size);
+        if (length != -1 && symlinks != nullptr) {
+            symlinks->push_back(prefix);
+        }
+        return length;
+    });
+
+    result = buffer;
+    return status;
+}
+
+BOOST_AUTO_TEST_SUITE(PathCanonicalizerTests)
+
+BOOST_AUTO_TEST_CASE(TestLexicalCanonicalization)
+{
+    auto no_symlinks = [](const char *, bool, char *, size_t) { return (ssize_t)-1; };
+    const vector<pair<string, string>> cases = {
+        { "/", "/" },
+        { "//", "/" },
+        { "/a/b/c", "/a/b/c" },
+        { "/a//b///c/", "/a/b/c" },
+        { "/a/./b/.", "/a/b" },
+        { "/a/b/../c", "/a/c" },
+        { "/a/b/../../..", "/" },
+        { "/../a", "/a" },
+        { "/a/..b/.c/...", "/a/..b/.c/..." },
+    };
+
+    for (const auto& test : cases) {
+        char buffer[PATH_MAX];
+        strcpy(buffer, test.first.c_str());
+        BOOST_CHECK_EQUAL(CanonicalizePath(buffer, true, no_symlinks), kCanonicalized);
+        BOOST_CHECK_EQUAL(string(buffer), test.second);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestSymlinksAreReportedAndFollowed)
+{
+    SymlinkTree tree;
+    string result;
+    vector<string> symlinks;
+
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/symlink2/file.txt", true, result, &symlinks), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1/dir/file.txt");
+    BOOST_REQUIRE_EQUAL(symlinks.size(), 2);
+    BOOST_CHECK_EQUAL(symlinks[0], tree.root + "/symlink2");
+    BOOST_CHECK_EQUAL(symlinks[1], tree.root + "/symlink1");
+
+    // '..' applies to the target of the symlink, not to the symlink itself
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/real2/abs/../file.txt", true, result), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1/file.txt");
+
+    // The final symlink is only followed when asked to
+    symlinks.clear();
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/symlink1/../filelink", false, result, &symlinks), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/filelink");
+    BOOST_CHECK_EQUAL(symlinks.size(), 1);
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/filelink", true, result), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1/file.txt");
+
+    // ...unless the path ends with a slash
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/symlink1/", false, result), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1");
+
+    // Components don't need to exist
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/symlink1/missing/../dir", true, result), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1/dir");
+}
+
+BOOST_AUTO_TEST_CASE(TestSymlinkLoops)
+{
+    SymlinkTree tree;
+    string result;
+
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/loop1/file", true, result), kSymlinkLoop);
+    BOOST_CHECK(result.find(tree.root + "/loop") == 0);
+
+    // Going through the same symlink several times is not a loop
+    BOOST_CHECK_EQUAL(Canonicalize(tree.root + "/real1/up/real1/up/real1/up/symlink1/dir", true, result), kCanonicalized);
+    BOOST_CHECK_EQUAL(result, tree.root + "/real1/dir");
+}
+
+BOOST_AUTO_TEST_CASE(TestLongPaths)
+{
+    auto no_symlinks = [](const char *, bool, char *, size_t) { return (ssize_t)-1; };
+
+    // Pathological input for a canonicalizer that shifts the rest of the path for every '.' component
+    string path = "/a";
+    while (path.length() + 2 < PATH_MAX - 1) {
+        path += "/.";
+    }
+
+    char buffer[PATH_MAX];
+    strcpy(buffer, path.c_str());
+    BOOST_CHECK_EQUAL(CanonicalizePath(buffer, true, no_symlinks), kCanonicalized);
+    BOOST_CHECK_EQUAL(string(buffer), "/a");
+
+    // A path that can't fit is left untouched
+    string component(200, 'x');
+    path = "";
+    while (path.length() < PATH_MAX - 300) {
+        path += "/" + component;
+    }
+    strcpy(buffer, path.c_str());
+    auto too_long = [&component](const char *prefix, bool is_final, char *target, size_t target_size) {
+        // Every component is a symlink to a long relative path
+        string link = component + "/" + component;
+        memcpy(target, link.c_str(), link.length());
+        return (ssize_t)link.length();
+    };
+    BOOST_CHECK_EQUAL(CanonicalizePath(buffer, true, too_long), kNameTooLong);
+    BOOST_CHECK_EQUAL(string(buffer), path);
+}
+
+BOOST_AUTO_TEST_CASE(TestFuzzAgainstRealpath)
+{
+    SymlinkTree tree;
+    const vector<string> components = { "real1", "real2", "dir", "up", "abs", "symlink1", "symlink2", "filelink", "file.txt", ".", "..", "", "missing" };
+    mt19937 random(42);
+    uniform_int_distribution<size_t> pick(0, components.size() - 1);
+    uniform_int_distribution<int> length(1, 8);
+
+    int compared = 0;
+    for (int i = 0; i < 20000; i++) {
+        string path = tree.root;
+        int count = length(random);
+        for (int c = 0; c < count; c++) {
+            path += "/" + components[pick(random)];
+        }
+
+        string result;
+        auto status = Canonicalize(path, true, result);
+        BOOST_REQUIRE(status != kNameTooLong);
+
+        char expected[PATH_MAX];
+        if (realpath(path.c_str(), expected) != nullptr) {
+            BOOST_CHECK_MESSAGE(result == expected, path << ": got " << result << ", expected " << expected);
+            compared++;
+        }
+    }
+
+    BOOST_TEST_MESSAGE("Compared " << compared << " paths against realpath");
+    BOOST_CHECK(compared > 1000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
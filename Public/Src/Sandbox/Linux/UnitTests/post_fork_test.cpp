@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <atomic>
+#include <mutex>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <post_fork.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// A component whose lock is held by another thread while the process forks
+class LockedComponent : public PostForkResettable {
+public:
+    void ResetAfterFork() override {
+        ResetLock(mtx_);
+        resets_++;
+    }
+
+    std::mutex mtx_;
+    int resets_ = 0;
+};
+
+BOOST_AUTO_TEST_SUITE(PostForkTests)
+
+BOOST_AUTO_TEST_CASE(TestChildGetsFreshLocks)
+{
+    static LockedComponent first, second;
+    BOOST_REQUIRE(RegisterPostForkReset(&first));
+    BOOST_REQUIRE(RegisterPostForkReset(&second));
+
+    atomic<bool> locked { false }, forked { false };
+    thread holder([&]() {
+        lock_guard<std::mutex> lock(first.mtx_);
+        locked = true;
+        while (!forked) {
+            this_thread::yield();
+        }
+    });
+
+    while (!locked) {
+        this_thread::yield();
+    }
+
+    pid_t child = fork();
+    if (child == 0) {
+        // The thread holding the lock doesn't exist here: without the reset, this would never return
+        RunPostForkResets();
+        bool reset = first.mtx_.try_lock() && second.mtx_.try_lock() && first.resets_ == 1 && second.resets_ == 1;
+        _exit(reset ? 0 : 1);
+    }
+
+    forked = true;
+    holder.join();
+
+    int status;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // Resets only happen in children
+    BOOST_CHECK_EQUAL(first.resets_, 0);
+    BOOST_CHECK_EQUAL(second.resets_, 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestRegistrationIsBounded)
+{
+    static LockedComponent components[kMaxPostForkResets];
+    int registered = 0;
+    for (auto &component : components) {
+        registered += RegisterPostForkReset(&component) ? 1 : 0;
+    }
+
+    // The previous test registered two already
+    BOOST_CHECK_EQUAL(registered, kMaxPostForkResets - 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
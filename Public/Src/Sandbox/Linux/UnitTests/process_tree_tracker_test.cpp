@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fstream>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include <process_tree_tracker.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string CreateFam(const char *name) {
+    string fam_path = string("/tmp/bxl_") + name + "_" + to_string(getpid()) + ".fam";
+    ofstream fam(fam_path);
+    fam << "fam";
+    fam.close();
+    unlink((fam_path + ProcessTreeTracker::kFileSuffix).c_str());
+    return fam_path;
+}
+
+static void DeleteFam(const string& fam_path) {
+    unlink(fam_path.c_str());
+    unlink((fam_path + ProcessTreeTracker::kFileSuffix).c_str());
+}
+
+// Forks a child the way the fork interposer does. The child runs 'child' and exits with its result.
+template <typename Child>
+static pid_t ForkTracked(ProcessTreeTracker& tracker, Child child) {
+    int slot = tracker.ReserveChild();
+    pid_t pid = fork();
+    tracker.CompleteChild(slot, pid);
+    if (pid == 0) {
+        _exit(child());
+    }
+
+    return pid;
+}
+
+BOOST_AUTO_TEST_SUITE(ProcessTreeTrackerTests)
+
+BOOST_AUTO_TEST_CASE(TestLastProcessCompletesTheTree)
+{
+    string fam_path = CreateFam("ptt_last");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+
+    tracker.Register(getpid());
+    // Registering again (e.g., after an exec) doesn't add the process twice
+    tracker.Register(getpid());
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 1);
+
+    // The child outlives the parent's release: only the child's release completes the tree
+    int to_child[2];
+    BOOST_REQUIRE_EQUAL(pipe(to_child), 0);
+    pid_t child = ForkTracked(tracker, [&]() {
+        char c;
+        close(to_child[1]);
+        BOOST_REQUIRE_EQUAL(read(to_child[0], &c, 1), 1);
+        return tracker.Release(getpid()) ? 0 : 1;
+    });
+    close(to_child[0]);
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 2);
+
+    BOOST_CHECK(!tracker.Release(getpid()));
+    BOOST_CHECK_EQUAL(write(to_child[1], "x", 1), 1);
+
+    int status;
+    BOOST_REQUIRE_EQUAL(waitpid(child, &status, 0), child);
+    BOOST_CHECK_EQUAL(WEXITSTATUS(status), 0);
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 0);
+
+    // Releasing twice is harmless
+    BOOST_CHECK(!tracker.Release(getpid()));
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestKilledProcessesAreSwept)
+{
+    string fam_path = CreateFam("ptt_killed");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+    tracker.Register(getpid());
+
+    // Killed without a chance to release its slot. It is left as a zombie: not reaped yet, but gone.
+    pid_t zombie = ForkTracked(tracker, []() { pause(); return 0; });
+    // Same, but reaped
+    pid_t reaped = ForkTracked(tracker, []() { pause(); return 0; });
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 3);
+
+    BOOST_REQUIRE_EQUAL(kill(zombie, SIGKILL), 0);
+    BOOST_REQUIRE_EQUAL(kill(reaped, SIGKILL), 0);
+    BOOST_REQUIRE_EQUAL(waitpid(reaped, nullptr, 0), reaped);
+    siginfo_t info;
+    BOOST_REQUIRE_EQUAL(waitid(P_PID, zombie, &info, WEXITED | WNOWAIT), 0);
+
+    BOOST_CHECK(tracker.Release(getpid()));
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 0);
+
+    waitpid(zombie, nullptr, 0);
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestSweepAllChecksEveryProcess)
+{
+    string fam_path = CreateFam("ptt_sweep_all");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+    tracker.Register(getpid());
+
+    // More killed processes than a regular sweep looks at
+    const int killed_count = ProcessTreeTracker::kMaxSweptProcesses * 2 + 1;
+    vector<pid_t> killed;
+    for (int i = 0; i < killed_count; i++) {
+        killed.push_back(ForkTracked(tracker, []() { pause(); return 0; }));
+    }
+
+    for (pid_t pid : killed) {
+        BOOST_REQUIRE_EQUAL(kill(pid, SIGKILL), 0);
+        BOOST_REQUIRE_EQUAL(waitpid(pid, nullptr, 0), pid);
+    }
+
+    // Too many processes are left for a regular release to look for dead ones
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), killed_count + 1);
+    BOOST_CHECK(!tracker.Release(getpid()));
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), killed_count);
+
+    // The root process releases with a full sweep
+    tracker.Register(getpid());
+    BOOST_CHECK(tracker.Release(getpid(), /* sweep_all */ true));
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 0);
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestLiveProcessesKeepTheTreeOpen)
+{
+    string fam_path = CreateFam("ptt_live");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+    tracker.Register(getpid());
+
+    // A daemon that is still running when everyone else is done
+    pid_t daemon = ForkTracked(tracker, []() { pause(); return 0; });
+    BOOST_CHECK(!tracker.Release(getpid()));
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 1);
+
+    kill(daemon, SIGKILL);
+    waitpid(daemon, nullptr, 0);
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestDisabledTrackerNeverCompletes)
+{
+    string fam_path = CreateFam("ptt_disabled");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+    tracker.Register(getpid());
+
+    // Disabling is pip-wide
+    ProcessTreeTracker other;
+    BOOST_REQUIRE(other.Initialize(fam_path.c_str()));
+    other.Disable();
+
+    BOOST_CHECK(tracker.IsDisabled());
+    BOOST_CHECK(!tracker.Release(getpid()));
+    BOOST_CHECK_EQUAL(tracker.ReserveChild(), -1);
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_CASE(TestFailedForkGivesTheSlotBack)
+{
+    string fam_path = CreateFam("ptt_failed_fork");
+    ProcessTreeTracker tracker;
+    BOOST_REQUIRE(tracker.Initialize(fam_path.c_str()));
+    tracker.Register(getpid());
+
+    int slot = tracker.ReserveChild();
+    BOOST_CHECK(slot >= 0);
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 2);
+    tracker.CompleteChild(slot, -1);
+    BOOST_CHECK_EQUAL(tracker.LiveCount(), 1);
+    BOOST_CHECK(tracker.Release(getpid()));
+
+    DeleteFam(fam_path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
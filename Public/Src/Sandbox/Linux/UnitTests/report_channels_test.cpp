@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <fcntl.h>
+#include <limits.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include <report_channels.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// Stand-in for the managed report reader: one reader per channel, fed by a set of writer processes that
+// report the same way the sandbox does (open, write a length prefixed message, close).
+class StandInReader {
+public:
+    StandInReader(const string& reports_path, int channel_count) : channel_count_(channel_count) {
+        for (int i = 0; i < channel_count; i++) {
+            char path[PATH_MAX];
+            BOOST_REQUIRE(GetReportChannelPath(reports_path.c_str(), i, path, PATH_MAX));
+            unlink(path);
+            BOOST_REQUIRE_EQUAL(mkfifo(path, 0600), 0);
+            paths_.push_back(path);
+            // Open read-write so the reader never sees EOF while writers come and go
+            fds_.push_back(open(path, O_RDWR));
+            BOOST_REQUIRE(fds_.back() != -1);
+        }
+    }
+
+    ~StandInReader() {
+        for (int i = 0; i < channel_count_; i++) {
+            close(fds_[i]);
+            unlink(paths_[i].c_str());
+        }
+    }
+
+    const string& GetPath(int channel) const { return paths_[channel]; }
+
+    // Reads 'expected' messages from the channel, checking that messages from the same pid arrive in order.
+    // Returns the number of out-of-order messages.
+    int Drain(int channel, int expected) {
+        unordered_map<int, int> last_sequence;
+        int out_of_order = 0;
+        int received = 0;
+        string pending;
+        char buffer[64 * 1024];
+
+        while (received < expected) {
+            ssize_t n = read(fds_[channel], buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+
+            pending.append(buffer, n);
+            size_t offset = 0;
+            while (pending.size() - offset >= sizeof(uint)) {
+                uint length = *(const uint*)(pending.data() + offset);
+                if (pending.size() - offset - sizeof(uint) < length) {
+                    break;
+                }
+
+                int pid = 0, sequence = 0;
+                sscanf(pending.data() + offset + sizeof(uint), "%d|%d", &pid, &sequence);
+                auto it = last_sequence.find(pid);
+                if (it != last_sequence.end() && it->second >= sequence) {
+                    out_of_order++;
+                }
+                last_sequence[pid] = sequence;
+
+                offset += sizeof(uint) + length;
+                received++;
+            }
+            pending.erase(0, offset);
+        }
+
+        return out_of_order;
+    }
+
+private:
+    int channel_count_;
+    vector<string> paths_;
+    vector<int> fds_;
+};
+
+static void WriteReports(const StandInReader& reader, int channel_count, int message_count) {
+    const char *path = reader.GetPath(SelectReportChannel(getpid(), channel_count)).c_str();
+    char message[PIPE_BUF];
+    for (int i = 0; i < message_count; i++) {
+        int length = snprintf(message + sizeof(uint), PIPE_BUF - sizeof(uint), "%d|%d|/some/path/to/a/file/accessed/by/the/process\n", getpid(), i);
+        *(uint*)message = length;
+        int fd = open(path, O_WRONLY | O_APPEND);
+        if (fd == -1 || write(fd, message, sizeof(uint) + length) != (ssize_t)(sizeof(uint) + length)) {
+            _exit(1);
+        }
+        close(fd);
+    }
+}
+
+// Runs 'writer_count' writer processes against 'channel_count' channels and returns the elapsed time
+static chrono::milliseconds RunReadScenario(int channel_count, int writer_count, int message_count) {
+    char reports_path[PATH_MAX];
+    snprintf(reports_path, PATH_MAX, "/tmp/bxl_report_channels_%d.fifo", getpid());
+    StandInReader reader(reports_path, channel_count);
+
+    auto start = chrono::steady_clock::now();
+
+    vector<int> expected(channel_count, 0);
+    vector<pid_t> writers;
+    for (int i = 0; i < writer_count; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            WriteReports(reader, channel_count, message_count);
+            _exit(0);
+        }
+        BOOST_REQUIRE(pid > 0);
+        writers.push_back(pid);
+        expected[SelectReportChannel(pid, channel_count)] += message_count;
+    }
+
+    vector<int> out_of_order(channel_count, 0);
+    vector<thread> readers;
+    for (int i = 0; i < channel_count; i++) {
+        readers.emplace_back([&, i]() { out_of_order[i] = reader.Drain(i, expected[i]); });
+    }
+
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+    for (pid_t pid : writers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    for (int i = 0; i < channel_count; i++) {
+        BOOST_CHECK_EQUAL(out_of_order[i], 0);
+    }
+
+    return elapsed;
+}
+
+BOOST_AUTO_TEST_SUITE(ReportChannelsTests)
+
+BOOST_AUTO_TEST_CASE(TestClampReportChannelCount)
+{
+    BOOST_CHECK_EQUAL(ClampReportChannelCount(0), 1);
+    BOOST_CHECK_EQUAL(ClampReportChannelCount(1), 1);
+    BOOST_CHECK_EQUAL(ClampReportChannelCount(4), 4);
+    BOOST_CHECK_EQUAL(ClampReportChannelCount(1000), (int)kMaxReportChannels);
+    BOOST_CHECK_EQUAL(ClampReportChannelCount(UINT32_MAX), (int)kMaxReportChannels);
+}
+
+BOOST_AUTO_TEST_CASE(TestReportChannelPath)
+{
+    char path[PATH_MAX];
+    BOOST_CHECK(GetReportChannelPath("/tmp/bxl_pip.fifo", 0, path, PATH_MAX));
+    BOOST_CHECK_EQUAL(path, "/tmp/bxl_pip.fifo");
+    BOOST_CHECK(GetReportChannelPath("/tmp/bxl_pip.fifo", 3, path, PATH_MAX));
+    BOOST_CHECK_EQUAL(path, "/tmp/bxl_pip.fifo.3");
+
+    char small[8];
+    BOOST_CHECK(!GetReportChannelPath("/tmp/bxl_pip.fifo", 3, small, sizeof(small)));
+}
+
+BOOST_AUTO_TEST_CASE(TestSelectReportChannelSpreadsSequentialPids)
+{
+    const int channel_count = 8;
+    vector<int> hits(channel_count, 0);
+    for (pid_t pid = 1000; pid < 1000 + 64 * channel_count; pid++) {
+        int channel = SelectReportChannel(pid, channel_count);
+        BOOST_REQUIRE(channel >= 0 && channel < channel_count);
+        BOOST_CHECK_EQUAL(channel, SelectReportChannel(pid, channel_count));
+        hits[channel]++;
+    }
+
+    for (int i = 0; i < channel_count; i++) {
+        // Every channel should get a fair share (64 on average)
+        BOOST_CHECK_GT(hits[i], 32);
+    }
+
+    BOOST_CHECK_EQUAL(SelectReportChannel(1234, 1), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestShardedReadScaling)
+{
+    const int writer_count = 16;
+    const int message_count = 2000;
+
+    for (int channel_count : { 1, 2, 4, 8 }) {
+        auto elapsed = RunReadScenario(channel_count, writer_count, message_count);
+        BOOST_TEST_MESSAGE("channels: " << channel_count << ", writers: " << writer_count
+            << ", messages: " << writer_count * message_count << ", elapsed: " << elapsed.count() << "ms");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <stdio.h>
+#include <string>
+#include <report_lag_analysis.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// Builds a timestamped report line the same way BxlObserver::BuildReport does
+static string BuildTimedReport(int pid, int operation, uint64_t observed, uint64_t sequence_number, const char *path) {
+    char line[4096];
+    snprintf(line, sizeof(line), "%s|%d|%d|%d|%d|%d|%d|%d|%d|%lu|%lu|%s\n", "cc1", pid, 1, 0, 0, 0, operation, 0, 0, (unsigned long)observed, (unsigned long)sequence_number, path);
+    return line;
+}
+
+static ReportTiming Timing(int pid, int operation, uint64_t observed, uint64_t arrival, uint64_t sequence_number) {
+    ReportTiming timing;
+    BOOST_REQUIRE(ParseTimedReport(BuildTimedReport(pid, operation, observed, sequence_number, "/tmp/a|b"), arrival, timing));
+    return timing;
+}
+
+BOOST_AUTO_TEST_SUITE(ReportLagTests)
+
+BOOST_AUTO_TEST_CASE(TestParseTimedReport)
+{
+    ReportTiming timing;
+    BOOST_REQUIRE(ParseTimedReport(BuildTimedReport(1234, 5, 1000, 7, "/usr/include/stdio.h"), 2500, timing));
+
+    BOOST_CHECK_EQUAL(timing.pid, 1234);
+    BOOST_CHECK_EQUAL(timing.operation, 5);
+    BOOST_CHECK_EQUAL(timing.observed, 1000);
+    BOOST_CHECK_EQUAL(timing.arrival, 2500);
+    BOOST_CHECK_EQUAL(timing.sequence_number, 7);
+}
+
+BOOST_AUTO_TEST_CASE(TestReportsWithoutTimestampsAreMalformed)
+{
+    ReportTiming timing;
+    BOOST_CHECK(!ParseTimedReport("cc1|1234|1|0|0|0|5|0|0|/usr/include/stdio.h\n", 2500, timing));
+    BOOST_CHECK(!ParseTimedReport("", 2500, timing));
+}
+
+BOOST_AUTO_TEST_CASE(TestLagPercentiles)
+{
+    ReportLagAnalysis analysis;
+    for (uint64_t i = 1; i <= 100; i++) {
+        // The lag of the i-th report is i microseconds
+        analysis.Add(Timing(1, i % 2 == 0 ? 5 : 3, 1000000, 1000000 + i * 1000, i));
+    }
+
+    BOOST_CHECK_EQUAL(analysis.Count(), 100);
+    BOOST_CHECK_EQUAL(analysis.Processes(), 1);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(0), 1000);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(50), 50000);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(99), 99000);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(100), 100000);
+
+    // Per operation distributions only include the reports for that operation
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(5, 0), 2000);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(3, 100), 99000);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(42, 50), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestReportsArrivingBeforeObservationHaveNoLag)
+{
+    // Clocks are the same for all processes, but the reader could in principle sample it before the writer does
+    ReportLagAnalysis analysis;
+    analysis.Add(Timing(1, 5, 2000, 1000, 0));
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(100), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestReorderingIsTrackedPerPid)
+{
+    ReportLagAnalysis analysis;
+
+    // Interleaved pids don't count as reordering
+    analysis.Add(Timing(1, 5, 0, 0, 0));
+    analysis.Add(Timing(2, 5, 0, 0, 0));
+    analysis.Add(Timing(1, 5, 0, 0, 1));
+    analysis.Add(Timing(2, 5, 0, 0, 1));
+    BOOST_CHECK_EQUAL(analysis.Reordered(), 0);
+
+    // A report about pid 1 overtaken by a later one
+    analysis.Add(Timing(1, 5, 0, 0, 3));
+    analysis.Add(Timing(1, 5, 0, 0, 2));
+    BOOST_CHECK_EQUAL(analysis.Reordered(), 1);
+
+    // Duplicates are reordering too
+    analysis.Add(Timing(2, 5, 0, 0, 1));
+    BOOST_CHECK_EQUAL(analysis.Reordered(), 2);
+
+    BOOST_CHECK_EQUAL(analysis.Processes(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestSequenceStartsOverOnExec)
+{
+    // After an exec, the pid is reported on by a new sandbox instance, whose sequence starts at 0
+    ReportLagAnalysis analysis;
+    analysis.Add(Timing(1, 5, 0, 0, 0));
+    analysis.Add(Timing(1, 5, 0, 0, 1));
+    analysis.Add(Timing(1, 5, 0, 0, 2));
+    analysis.Add(Timing(1, 5, 0, 0, 0));
+    analysis.Add(Timing(1, 5, 0, 0, 1));
+    BOOST_CHECK_EQUAL(analysis.Reordered(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestMalformedReportsAreCounted)
+{
+    ReportLagAnalysis analysis;
+    analysis.AddMalformed();
+    analysis.AddMalformed();
+    BOOST_CHECK_EQUAL(analysis.Malformed(), 2);
+    BOOST_CHECK_EQUAL(analysis.Count(), 0);
+    BOOST_CHECK_EQUAL(analysis.LagPercentile(50), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <stdio.h>
+#include <string>
+#include <report_line.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+// Builds a report line the same way BxlObserver::BuildReport does
+static string BuildReport(const char *progname, int pid, int access, int status, int error, int operation, int is_directory, const char *path, bool timestamps = false) {
+    char line[4096];
+    if (timestamps) {
+        snprintf(line, sizeof(line), "%s|%d|%d|%d|%d|%d|%d|%d|%d|%lu|%lu|%s\n", progname, pid, access, status, 0, error, operation, is_directory, 0, 123456789ul, 42ul, path);
+    } else {
+        snprintf(line, sizeof(line), "%s|%d|%d|%d|%d|%d|%d|%d|%d|%s\n", progname, pid, access, status, 0, error, operation, is_directory, 0, path);
+    }
+
+    return line;
+}
+
+BOOST_AUTO_TEST_SUITE(ReportLineTests)
+
+BOOST_AUTO_TEST_CASE(TestRoundTrip)
+{
+    ParsedReport report;
+    BOOST_REQUIRE(ParseReportLine(BuildReport("cc1", 1234, 17, 0100644, 2, 5, 0, "/usr/include/stdio.h"), /* has_timestamps */ false, report));
+
+    BOOST_CHECK_EQUAL(report.progname, "cc1");
+    BOOST_CHECK_EQUAL(report.pid, 1234);
+    BOOST_CHECK_EQUAL(report.requested_access, 17);
+    BOOST_CHECK_EQUAL(report.status, 0100644);
+    BOOST_CHECK_EQUAL(report.error, 2);
+    BOOST_CHECK_EQUAL(report.operation, 5);
+    BOOST_CHECK_EQUAL(report.is_directory, 0);
+    BOOST_CHECK_EQUAL(report.timestamp, 0);
+    BOOST_CHECK_EQUAL(report.path, "/usr/include/stdio.h");
+}
+
+BOOST_AUTO_TEST_CASE(TestTimestamps)
+{
+    ParsedReport report;
+    BOOST_REQUIRE(ParseReportLine(BuildReport("ld", 7, 1, 040755, 0, 3, 1, "/tmp", /* timestamps */ true), /* has_timestamps */ true, report));
+
+    BOOST_CHECK_EQUAL(report.timestamp, 123456789);
+    BOOST_CHECK_EQUAL(report.sequence_number, 42);
+    BOOST_CHECK_EQUAL(report.is_directory, 1);
+    BOOST_CHECK_EQUAL(report.path, "/tmp");
+}
+
+BOOST_AUTO_TEST_CASE(TestPathIsTakenVerbatim)
+{
+    // The path is the last field, so separators and trailing characters in it are preserved
+    ParsedReport report;
+    BOOST_REQUIRE(ParseReportLine(BuildReport("sh", 1, 0, 0, 0, 0, 0, "/tmp/a|b|"), /* has_timestamps */ false, report));
+    BOOST_CHECK_EQUAL(report.path, "/tmp/a|b|");
+
+    // Empty paths (e.g., process exit reports) and lines without the trailing newline are fine too
+    BOOST_REQUIRE(ParseReportLine("sh|1|0|1|0|0|1|0|0|", /* has_timestamps */ false, report));
+    BOOST_CHECK_EQUAL(report.path, "");
+}
+
+BOOST_AUTO_TEST_CASE(TestNegativeFields)
+{
+    // Errors and pids are printed with %d, so they can show up as negative numbers
+    ParsedReport report;
+    BOOST_REQUIRE(ParseReportLine(BuildReport("sh", -1, 0, 0, -1, 0, 0, "/x"), /* has_timestamps */ false, report));
+    BOOST_CHECK_EQUAL(report.pid, -1);
+    BOOST_CHECK_EQUAL(report.error, (uint32_t)-1);
+}
+
+BOOST_AUTO_TEST_CASE(TestMalformedLines)
+{
+    ParsedReport report;
+    BOOST_CHECK(!ParseReportLine("", /* has_timestamps */ false, report));
+    BOOST_CHECK(!ParseReportLine("sh|1|0|1|0|0|1|0|/path", /* has_timestamps */ false, report));
+    BOOST_CHECK(!ParseReportLine("sh|1|0|x|0|0|1|0|0|/path", /* has_timestamps */ false, report));
+
+    // A line without timestamps can't be parsed as one with timestamps
+    BOOST_CHECK(!ParseReportLine(BuildReport("sh", 1, 0, 0, 0, 0, 0, "/path"), /* has_timestamps */ true, report));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,349 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <OpNames.hpp>
+#include <report_log.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string CreateLogDirectory(const char *name) {
+    string directory = string("/tmp/bxl_") + name + "_" + to_string(getpid()) + "_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(&directory[0]) != nullptr);
+    return directory;
+}
+
+static void DeleteLogDirectory(const string& directory) {
+    DIR *dir = opendir(directory.c_str());
+    struct dirent *entry;
+    while (dir != nullptr && (entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            unlink((directory + "/" + entry->d_name).c_str());
+        }
+    }
+
+    if (dir != nullptr) {
+        closedir(dir);
+    }
+    rmdir(directory.c_str());
+}
+
+static vector<string> LogFiles(const string& directory) {
+    vector<string> files;
+    DIR *dir = opendir(directory.c_str());
+    struct dirent *entry;
+    while (dir != nullptr && (entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] != '.') {
+            files.push_back(directory + "/" + entry->d_name);
+        }
+    }
+
+    if (dir != nullptr) {
+        closedir(dir);
+    }
+    return files;
+}
+
+// Same shape as the reports produced by BxlObserver::BuildReport
+static string Report(pid_t pid, int operation, const string& path) {
+    return "test|" + to_string(pid) + "|1|1|0|0|" + to_string(operation) + "|0|0|" + path + "\n";
+}
+
+static bool Append(ReportLogWriter& log, pid_t pid, int operation, const string& path) {
+    string report = Report(pid, operation, path);
+    return log.Append(report.c_str(), report.length(), pid, operation);
+}
+
+BOOST_AUTO_TEST_SUITE(ReportLogTests)
+
+BOOST_AUTO_TEST_CASE(TestAppendSealAndRead)
+{
+    string directory = CreateLogDirectory("log_seal");
+
+    ReportLogWriter log;
+    BOOST_CHECK(!log.IsOpenForCurrentProcess());
+    BOOST_REQUIRE(log.Open(directory.c_str()));
+    BOOST_CHECK(log.IsOpenForCurrentProcess());
+
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK(Append(log, getpid(), kOpKAuthReadFile, "/src/file_" + to_string(i)));
+    }
+    BOOST_CHECK(Append(log, getpid(), kOpProcessExit, ""));
+    BOOST_CHECK(log.Seal());
+
+    // Nothing can be appended to a sealed log
+    BOOST_CHECK(!Append(log, getpid(), kOpKAuthReadFile, "/src/late"));
+    BOOST_CHECK(!log.Seal());
+
+    vector<string> files = LogFiles(directory);
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+
+    ReportLogContents contents;
+    BOOST_REQUIRE(ReadReportLog(files[0].c_str(), contents));
+    BOOST_CHECK_EQUAL(contents.pid, getpid());
+    BOOST_CHECK_EQUAL(contents.parent_pid, getppid());
+    BOOST_CHECK(contents.sealed);
+    BOOST_CHECK(!contents.truncated);
+    BOOST_REQUIRE_EQUAL(contents.records.size(), 101);
+
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK_EQUAL(contents.records[i].message, Report(getpid(), kOpKAuthReadFile, "/src/file_" + to_string(i)));
+        BOOST_CHECK_EQUAL(contents.records[i].operation, kOpKAuthReadFile);
+        if (i > 0) {
+            BOOST_CHECK(contents.records[i - 1].timestamp <= contents.records[i].timestamp);
+        }
+    }
+    BOOST_CHECK_EQUAL(contents.records[100].operation, kOpProcessExit);
+
+    DeleteLogDirectory(directory);
+}
+
+BOOST_AUTO_TEST_CASE(TestRecoveryOfTornLog)
+{
+    string directory = CreateLogDirectory("log_torn");
+
+    ReportLogWriter log;
+    BOOST_REQUIRE(log.Open(directory.c_str()));
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK(Append(log, getpid(), kOpKAuthReadFile, "/src/file_" + to_string(i)));
+    }
+
+    vector<string> files = LogFiles(directory);
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+
+    // A process that dies without sealing its log: all committed records are recovered
+    ReportLogContents contents;
+    BOOST_REQUIRE(ReadReportLog(files[0].c_str(), contents));
+    BOOST_CHECK(!contents.sealed);
+    BOOST_CHECK(!contents.truncated);
+    BOOST_CHECK_EQUAL(contents.records.size(), 10);
+
+    // Corrupt the payload of the last record, as if the process died in the middle of copying it
+    string last = Report(getpid(), kOpKAuthReadFile, "/src/file_9");
+    int fd = open(files[0].c_str(), O_RDWR);
+    BOOST_REQUIRE(fd != -1);
+    vector<char> content(1024 * 1024);
+    ssize_t size = pread(fd, content.data(), content.size(), 0);
+    BOOST_REQUIRE(size > 0);
+    auto position = search(content.begin(), content.begin() + size, last.begin(), last.end());
+    BOOST_REQUIRE(position != content.begin() + size);
+    BOOST_REQUIRE_EQUAL(pwrite(fd, "X", 1, (position - content.begin()) + 5), 1);
+    close(fd);
+
+    BOOST_REQUIRE(ReadReportLog(files[0].c_str(), contents));
+    BOOST_CHECK(!contents.sealed);
+    BOOST_CHECK(contents.truncated);
+    BOOST_CHECK_EQUAL(contents.records.size(), 9);
+
+    DeleteLogDirectory(directory);
+}
+
+BOOST_AUTO_TEST_CASE(TestMergePreservesProcessCausality)
+{
+    string directory = CreateLogDirectory("log_merge");
+
+    ReportLogWriter parent_log;
+    BOOST_REQUIRE(parent_log.Open(directory.c_str()));
+    BOOST_CHECK(Append(parent_log, getpid(), kOpKAuthReadFile, "/src/parent_before"));
+
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(pipe(fds), 0);
+
+    pid_t child = fork();
+    if (child == 0) {
+        // The inherited log belongs to the parent
+        if (parent_log.IsOpenForCurrentProcess()) {
+            _exit(1);
+        }
+
+        // Wait until the parent reported the start of this process, as the sandbox does before the child runs
+        char go;
+        if (read(fds[0], &go, 1) != 1) {
+            _exit(3);
+        }
+
+        ReportLogWriter child_log;
+        if (!child_log.Open(directory.c_str())) {
+            _exit(2);
+        }
+
+        for (int i = 0; i < 10; i++) {
+            Append(child_log, getpid(), kOpKAuthReadFile, "/src/child_" + to_string(i));
+        }
+
+        // The child crashes: no exit report and no trailer
+        _exit(0);
+    }
+
+    BOOST_REQUIRE(child > 0);
+    BOOST_CHECK(Append(parent_log, child, kOpProcessStart, "/bin/child"));
+    BOOST_REQUIRE_EQUAL(write(fds[1], "1", 1), 1);
+
+    int status = 0;
+    waitpid(child, &status, 0);
+    BOOST_REQUIRE(WIFEXITED(status));
+    BOOST_REQUIRE_EQUAL(WEXITSTATUS(status), 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    BOOST_CHECK(Append(parent_log, getpid(), kOpKAuthReadFile, "/src/parent_after"));
+    BOOST_CHECK(Append(parent_log, getpid(), kOpProcessExit, ""));
+    BOOST_CHECK(parent_log.Seal());
+
+    vector<ReportLogRecord> merged;
+    BOOST_REQUIRE(MergeReportLogs(directory.c_str(), merged));
+    // 4 from the parent, 10 from the child, plus the synthesized exit of the child
+    BOOST_REQUIRE_EQUAL(merged.size(), 15);
+
+    int child_start = -1, child_exit = -1, first_child_access = -1, last_child_access = -1, parent_after = -1;
+    for (int i = 0; i < (int)merged.size(); i++) {
+        const ReportLogRecord& record = merged[i];
+        if (record.operation == kOpProcessStart && record.pid == child) child_start = i;
+        if (record.operation == kOpProcessExit && record.pid == child) child_exit = i;
+        if (record.operation == kOpKAuthReadFile && record.pid == child) {
+            if (first_child_access == -1) first_child_access = i;
+            last_child_access = i;
+        }
+        if (record.message.find("parent_after") != string::npos) parent_after = i;
+        if (i > 0) {
+            BOOST_CHECK(merged[i - 1].timestamp <= record.timestamp);
+        }
+    }
+
+    BOOST_CHECK(child_start >= 0 && child_start < first_child_access);
+    BOOST_CHECK(last_child_access < child_exit);
+    BOOST_CHECK(child_exit < parent_after);
+    BOOST_CHECK_EQUAL(merged.back().operation, kOpProcessExit);
+    BOOST_CHECK_EQUAL(merged.back().pid, getpid());
+
+    // The synthesized exit report looks like a regular one
+    BOOST_CHECK_EQUAL(merged[child_exit].message, "test|" + to_string(child) + "|0|1|0|0|" + to_string(kOpProcessExit) + "|0|0|\n");
+
+    DeleteLogDirectory(directory);
+}
+
+BOOST_AUTO_TEST_CASE(TestMergeWithoutProcessLifetimeReports)
+{
+    string directory = CreateLogDirectory("log_lifetime");
+
+    // A process that exec'ed (its first log is sealed without an exit report) and whose new image crashed
+    ReportLogWriter before_exec;
+    BOOST_REQUIRE(before_exec.Open(directory.c_str()));
+    BOOST_CHECK(Append(before_exec, getpid(), kOpProcessStart, "/bin/tool"));
+    BOOST_CHECK(Append(before_exec, getpid(), kOpKAuthReadFile, "/src/before_exec"));
+    BOOST_CHECK(before_exec.Seal());
+
+    ReportLogWriter after_exec;
+    BOOST_REQUIRE(after_exec.Open(directory.c_str()));
+    BOOST_CHECK(Append(after_exec, getpid(), kOpKAuthReadFile, "/src/after_exec"));
+
+    vector<ReportLogRecord> merged;
+    BOOST_REQUIRE(MergeReportLogs(directory.c_str(), merged));
+    BOOST_REQUIRE_EQUAL(merged.size(), 4);
+    BOOST_CHECK_EQUAL(merged.front().operation, kOpProcessStart);
+    BOOST_CHECK_EQUAL(merged.back().operation, kOpProcessExit);
+
+    // Start and exit reports (including the synthesized one) already went over the FIFO
+    BOOST_REQUIRE(MergeReportLogs(directory.c_str(), merged, /* include_process_lifetime */ false));
+    BOOST_REQUIRE_EQUAL(merged.size(), 2);
+    BOOST_CHECK(merged[0].message.find("before_exec") != string::npos);
+    BOOST_CHECK(merged[1].message.find("after_exec") != string::npos);
+
+    DeleteLogDirectory(directory);
+}
+
+static double MicrosecondsPerReport(chrono::steady_clock::time_point start, int reports) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / reports;
+}
+
+BOOST_AUTO_TEST_CASE(TestThroughputAgainstFifo)
+{
+    const int thread_count = 4;
+    const int reports_per_thread = 20000;
+    string report = Report(getpid(), kOpKAuthReadFile, "/home/user/src/some/relatively/long/path/to/a/source/file.cpp");
+
+    // FIFO transport: every report opens the FIFO, writes and closes it (as BxlObserver::Send does), while a reader drains it
+    string directory = CreateLogDirectory("log_perf");
+    string fifo = directory + "/reports.fifo";
+    BOOST_REQUIRE_EQUAL(mkfifo(fifo.c_str(), 0600), 0);
+
+    thread reader([&fifo]() {
+        int fd = open(fifo.c_str(), O_RDONLY);
+        char buffer[PIPE_BUF];
+        while (read(fd, buffer, sizeof(buffer)) > 0) { }
+        close(fd);
+    });
+
+    // Keep the FIFO open for writing so the reader doesn't see EOF between reports
+    int keep_alive = open(fifo.c_str(), O_WRONLY);
+    BOOST_REQUIRE(keep_alive != -1);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> writers;
+    for (int t = 0; t < thread_count; t++) {
+        writers.emplace_back([&fifo, &report]() {
+            for (int i = 0; i < reports_per_thread; i++) {
+                int fd = open(fifo.c_str(), O_WRONLY | O_APPEND);
+                if (write(fd, report.c_str(), report.length()) != (ssize_t)report.length()) {
+                    break;
+                }
+                close(fd);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    double fifo_cost = MicrosecondsPerReport(start, thread_count * reports_per_thread);
+
+    close(keep_alive);
+    reader.join();
+    unlink(fifo.c_str());
+
+    // Log transport
+    ReportLogWriter log;
+    BOOST_REQUIRE(log.Open(directory.c_str()));
+
+    start = chrono::steady_clock::now();
+    writers.clear();
+    for (int t = 0; t < thread_count; t++) {
+        writers.emplace_back([&log, &report]() {
+            for (int i = 0; i < reports_per_thread; i++) {
+                log.Append(report.c_str(), report.length(), getpid(), kOpKAuthReadFile);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    double log_cost = MicrosecondsPerReport(start, thread_count * reports_per_thread);
+    BOOST_CHECK(log.Seal());
+
+    BOOST_TEST_MESSAGE("FIFO: " << fifo_cost << "us/report, log: " << log_cost << "us/report");
+
+    vector<string> files = LogFiles(directory);
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+    ReportLogContents contents;
+    BOOST_REQUIRE(ReadReportLog(files[0].c_str(), contents));
+    BOOST_CHECK(contents.sealed);
+    BOOST_CHECK_EQUAL(contents.records.size(), thread_count * reports_per_thread);
+
+    DeleteLogDirectory(directory);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <fcntl.h>
+#include <limits.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <resolution_snapshot.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+// Resolves a prefix the way the observer does without a snapshot, recording it in the log
+static void ResolveAndRecord(ResolutionSnapshot &snapshot, const string &log, const string &path) {
+    struct stat before;
+    BOOST_REQUIRE(ResolutionSnapshot::Describe(path.c_str(), before));
+    char target[PATH_MAX];
+    ssize_t length = readlink(path.c_str(), target, PATH_MAX);
+    snapshot.Record(log.c_str(), path.c_str(), before, target, length);
+}
+
+BOOST_AUTO_TEST_SUITE(ResolutionSnapshotTests)
+
+BOOST_AUTO_TEST_CASE(TestSerialization)
+{
+    unordered_map<string, ResolutionEntry> entries;
+    entries["/a/dir"] = { false, 1, 2, 0, "" };
+    entries["/a/link with spaces"] = { true, 3, 4, 5, "../target\twith tab" };
+
+    string content = ResolutionSnapshot::Serialize("tag", entries);
+
+    unordered_map<string, ResolutionEntry> parsed;
+    BOOST_REQUIRE(ResolutionSnapshot::Deserialize(content, "tag", parsed));
+    BOOST_REQUIRE_EQUAL(parsed.size(), 2);
+    BOOST_CHECK(!parsed["/a/dir"].is_symlink);
+    BOOST_CHECK_EQUAL(parsed["/a/dir"].inode, 2);
+    BOOST_CHECK(parsed["/a/link with spaces"].is_symlink);
+    BOOST_CHECK_EQUAL(parsed["/a/link with spaces"].ctime_ns, 5);
+    BOOST_CHECK_EQUAL(parsed["/a/link with spaces"].target, "../target\twith tab");
+
+    // Snapshots for something else, and garbage, are ignored
+    parsed.clear();
+    BOOST_CHECK(!ResolutionSnapshot::Deserialize(content, "other", parsed));
+    BOOST_CHECK(!ResolutionSnapshot::Deserialize("garbage", "tag", parsed));
+    BOOST_CHECK(ResolutionSnapshot::Deserialize(content.substr(0, content.length() - 5), "tag", parsed));
+    BOOST_CHECK_LE(parsed.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestRecordSaveAndValidate)
+{
+    string directory = TempPath("rs_dir");
+    string link = TempPath("rs_link");
+    string log = TempPath("rs_log");
+    string saved = TempPath("rs_saved");
+    mkdir(directory.c_str(), 0755);
+    BOOST_REQUIRE_EQUAL(symlink(directory.c_str(), link.c_str()), 0);
+    unlink(log.c_str());
+
+    {
+        ResolutionSnapshot snapshot;
+        ResolveAndRecord(snapshot, log, directory);
+        ResolveAndRecord(snapshot, log, link);
+        // Recorded once per process
+        ResolveAndRecord(snapshot, log, link);
+        BOOST_REQUIRE(snapshot.Save(saved.c_str(), log.c_str()));
+    }
+
+    ResolutionSnapshot snapshot;
+    BOOST_CHECK_EQUAL(snapshot.LoadAndValidate(saved.c_str()), 2);
+    const ResolutionEntry *entry = snapshot.Find(link.c_str());
+    BOOST_REQUIRE(entry != nullptr);
+    BOOST_CHECK(entry->is_symlink);
+    BOOST_CHECK_EQUAL(entry->target, directory);
+    entry = snapshot.Find(directory.c_str());
+    BOOST_REQUIRE(entry != nullptr);
+    BOOST_CHECK(!entry->is_symlink);
+    BOOST_CHECK(snapshot.Find("/not/there") == nullptr);
+
+    // Prefixes the pip may write are not kept
+    ResolutionSnapshot filtered;
+    BOOST_CHECK_EQUAL(filtered.LoadAndValidate(saved.c_str()), 2);
+    BOOST_CHECK_EQUAL(filtered.DropIf([&](const string &path) { return path == link; }), 1);
+    BOOST_CHECK(filtered.Find(link.c_str()) == nullptr);
+
+    unlink(saved.c_str());
+    unlink(log.c_str());
+    unlink(link.c_str());
+    rmdir(directory.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestStaleEntriesAreDropped)
+{
+    string directory = TempPath("rs_stale_dir");
+    string link = TempPath("rs_stale_link");
+    string log = TempPath("rs_stale_log");
+    string saved = TempPath("rs_stale_saved");
+    mkdir(directory.c_str(), 0755);
+    BOOST_REQUIRE_EQUAL(symlink("/tmp", link.c_str()), 0);
+    unlink(log.c_str());
+
+    {
+        ResolutionSnapshot snapshot;
+        ResolveAndRecord(snapshot, log, directory);
+        ResolveAndRecord(snapshot, log, link);
+        BOOST_REQUIRE(snapshot.Save(saved.c_str(), log.c_str()));
+    }
+
+    // The symlink is retargeted and the directory becomes a symlink
+    unlink(link.c_str());
+    BOOST_REQUIRE_EQUAL(symlink("/var", link.c_str()), 0);
+    rmdir(directory.c_str());
+    BOOST_REQUIRE_EQUAL(symlink("/tmp", directory.c_str()), 0);
+
+    ResolutionSnapshot snapshot;
+    BOOST_CHECK_EQUAL(snapshot.LoadAndValidate(saved.c_str()), 0);
+    BOOST_CHECK(snapshot.Find(link.c_str()) == nullptr);
+    BOOST_CHECK(snapshot.Find(directory.c_str()) == nullptr);
+
+    unlink(saved.c_str());
+    unlink(log.c_str());
+    unlink(link.c_str());
+    unlink(directory.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestReplacedWhileResolvingIsNotRecorded)
+{
+    string link = TempPath("rs_race_link");
+    string log = TempPath("rs_race_log");
+    BOOST_REQUIRE_EQUAL(symlink("/tmp", link.c_str()), 0);
+    unlink(log.c_str());
+
+    ResolutionSnapshot snapshot;
+    struct stat before;
+    BOOST_REQUIRE(ResolutionSnapshot::Describe(link.c_str(), before));
+    char target[PATH_MAX];
+    ssize_t length = readlink(link.c_str(), target, PATH_MAX);
+
+    unlink(link.c_str());
+    BOOST_REQUIRE_EQUAL(symlink("/var", link.c_str()), 0);
+    snapshot.Record(log.c_str(), link.c_str(), before, target, length);
+
+    struct stat st;
+    BOOST_CHECK(stat(log.c_str(), &st) != 0);
+
+    unlink(link.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestPublishAndLoad)
+{
+    string directory = TempPath("rs_pub_dir");
+    string log = TempPath("rs_pub_log");
+    string saved = TempPath("rs_pub_saved");
+    string published = TempPath("rs_pub_published");
+    mkdir(directory.c_str(), 0755);
+    unlink(log.c_str());
+
+    {
+        ResolutionSnapshot snapshot;
+        ResolveAndRecord(snapshot, log, directory);
+        BOOST_REQUIRE(snapshot.Save(saved.c_str(), log.c_str()));
+    }
+
+    ResolutionSnapshot root;
+    BOOST_REQUIRE_EQUAL(root.LoadAndValidate(saved.c_str()), 1);
+    BOOST_REQUIRE(root.Publish(published.c_str(), "pip"));
+
+    ResolutionSnapshot child;
+    BOOST_CHECK(!child.Load(published.c_str(), "another pip"));
+    BOOST_CHECK(child.Load(published.c_str(), "pip"));
+    BOOST_CHECK(child.Find(directory.c_str()) != nullptr);
+
+    unlink(published.c_str());
+    unlink(saved.c_str());
+    unlink(log.c_str());
+    rmdir(directory.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
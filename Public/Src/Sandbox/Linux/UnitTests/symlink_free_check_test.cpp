@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <chrono>
+#include <limits.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <path_canonicalizer.hpp>
+#include <symlink_free_check.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string CreateRoot() {
+    char temp[] = "/tmp/bxl_symlink_free_XXXXXX";
+    BOOST_REQUIRE(mkdtemp(temp) != nullptr);
+    char resolved[PATH_MAX];
+    BOOST_REQUIRE(realpath(temp, resolved) != nullptr);
+    return resolved;
+}
+
+static void DeleteRoot(const string& root) {
+    string command = "rm -rf " + root;
+    BOOST_CHECK_EQUAL(system(command.c_str()), 0);
+}
+
+static void CreateFile(const string& path) {
+    FILE *f = fopen(path.c_str(), "w");
+    BOOST_REQUIRE(f != nullptr);
+    fclose(f);
+}
+
+// Canonicalizes the path the way BxlObserver::resolve_path does, counting the syscalls that takes
+static string Resolve(const string& path, bool use_fast_path, size_t& syscalls) {
+    char buffer[PATH_MAX];
+    strcpy(buffer, path.c_str());
+
+    if (use_fast_path) {
+        syscalls++;
+        if (ResolvesWithoutSymlinks(buffer, true)) {
+            CanonicalizePath(buffer, true, [](const char *, bool, char *, size_t) { return (ssize_t)-1; });
+            return buffer;
+        }
+    }
+
+    CanonicalizePath(buffer, true, [&syscalls](const char *prefix, bool is_final, char *target, size_t target_size) {
+        syscalls++;
+        return readlink(prefix, target, target_size);
+    });
+    return buffer;
+}
+
+BOOST_AUTO_TEST_SUITE(SymlinkFreeCheckTests)
+
+BOOST_AUTO_TEST_CASE(TestSymlinkFreeCheck)
+{
+    if (!IsSymlinkFreeCheckAvailable()) {
+        BOOST_TEST_MESSAGE("openat2 is not available on this kernel, every path must fall back to the component walk");
+        BOOST_CHECK(!ResolvesWithoutSymlinks("/", true));
+        return;
+    }
+
+    string root = CreateRoot();
+    BOOST_REQUIRE_EQUAL(mkdir((root + "/dir").c_str(), 0700), 0);
+    CreateFile(root + "/dir/file");
+    BOOST_REQUIRE_EQUAL(symlink("dir", (root + "/link").c_str()), 0);
+    BOOST_REQUIRE_EQUAL(symlink("dir/file", (root + "/filelink").c_str()), 0);
+
+    BOOST_CHECK(ResolvesWithoutSymlinks((root + "/dir/file").c_str(), true));
+    BOOST_CHECK(ResolvesWithoutSymlinks((root + "/dir/../dir/./file").c_str(), true));
+
+    // Intermediate symlinks
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/link/file").c_str(), true));
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/link/file").c_str(), false));
+
+    // The final symlink only matters when it would be followed
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/filelink").c_str(), true));
+    BOOST_CHECK(ResolvesWithoutSymlinks((root + "/filelink").c_str(), false));
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/link/").c_str(), false));
+
+    // A missing final component can't be a symlink, but a missing intermediate one can't be checked
+    BOOST_CHECK(ResolvesWithoutSymlinks((root + "/dir/missing").c_str(), true));
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/missing/file").c_str(), true));
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/link/missing").c_str(), true));
+    BOOST_CHECK(!ResolvesWithoutSymlinks((root + "/dir/missing/..").c_str(), true));
+
+    // Relative paths are not supported
+    BOOST_CHECK(!ResolvesWithoutSymlinks("dir/file", true));
+
+    DeleteRoot(root);
+}
+
+BOOST_AUTO_TEST_CASE(TestSyscallCounts)
+{
+    const int directory_count = 20;
+    const int files_per_directory = 20;
+    string root = CreateRoot();
+
+    // A symlink-free source tree, 6 levels deep
+    string source = root + "/src/project/module/component";
+    BOOST_REQUIRE_EQUAL(system(("mkdir -p " + source).c_str()), 0);
+    vector<string> source_paths;
+    for (int d = 0; d < directory_count; d++) {
+        string directory = source + "/dir" + to_string(d);
+        BOOST_REQUIRE_EQUAL(mkdir(directory.c_str(), 0700), 0);
+        for (int f = 0; f < files_per_directory; f++) {
+            string file = directory + "/file" + to_string(f) + ".h";
+            CreateFile(file);
+            source_paths.push_back(file);
+        }
+        // Probes for headers that don't exist are common too
+        source_paths.push_back(directory + "/missing.h");
+    }
+
+    // A Bazel-style execroot: the same tree where every input is a symlink into the source tree
+    string execroot = root + "/execroot/main";
+    BOOST_REQUIRE_EQUAL(system(("mkdir -p " + execroot).c_str()), 0);
+    vector<string> execroot_paths;
+    for (int d = 0; d < directory_count; d++) {
+        string directory = execroot + "/dir" + to_string(d);
+        BOOST_REQUIRE_EQUAL(mkdir(directory.c_str(), 0700), 0);
+        for (int f = 0; f < files_per_directory; f++) {
+            string name = "/file" + to_string(f) + ".h";
+            BOOST_REQUIRE_EQUAL(symlink((source + "/dir" + to_string(d) + name).c_str(), (directory + name).c_str()), 0);
+            execroot_paths.push_back(directory + name);
+        }
+    }
+
+    for (auto paths : { &source_paths, &execroot_paths }) {
+        size_t walk_syscalls = 0, fast_path_syscalls = 0;
+
+        auto start = chrono::steady_clock::now();
+        for (const string& path : *paths) {
+            Resolve(path, /* use_fast_path */ false, walk_syscalls);
+        }
+        auto walk_time = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / paths->size();
+
+        start = chrono::steady_clock::now();
+        for (const string& path : *paths) {
+            size_t ignored = 0;
+            // Same result either way
+            BOOST_CHECK_EQUAL(Resolve(path, /* use_fast_path */ true, fast_path_syscalls), Resolve(path, /* use_fast_path */ false, ignored));
+        }
+
+        BOOST_TEST_MESSAGE((paths == &source_paths ? "Source tree" : "Execroot") << ": "
+            << (double)walk_syscalls / paths->size() << " syscalls/path (" << walk_time << "us) with the component walk, "
+            << (double)fast_path_syscalls / paths->size() << " syscalls/path with the fast path");
+
+        if (IsSymlinkFreeCheckAvailable() && paths == &source_paths) {
+            BOOST_CHECK(fast_path_syscalls * 4 < walk_syscalls);
+        }
+    }
+
+    DeleteRoot(root);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
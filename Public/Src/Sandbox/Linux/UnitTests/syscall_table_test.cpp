@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <set>
+#include <string>
+#include <tuple>
+#include <sys/syscall.h>
+#include <vector>
+#include <syscall_table.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+typedef struct DeclarativeSyscall {
+    string name;
+    long number;
+    SyscallShape shape;
+    int fd_arg;
+    int path_arg;
+    int flags_arg;
+    SyscallResolution resolution;
+} DeclarativeSyscall;
+
+#define DECLARATIVE_ENTRY(name, shape, event, fdArg, pathArg, flagsArg, resolution) { #name, __NR_##name, shape, fdArg, pathArg, flagsArg, resolution },
+#define CUSTOM_ENTRY(name, pathArg, secondPathArg) __NR_##name,
+#define CUSTOM_PATHS_ENTRY(name, pathArg, secondPathArg) { #name, pathArg, secondPathArg },
+
+static const vector<DeclarativeSyscall> kDeclarativeSyscalls = { BXL_DECLARATIVE_SYSCALLS(DECLARATIVE_ENTRY) };
+static const vector<long> kCustomSyscalls = { BXL_CUSTOM_SYSCALLS(CUSTOM_ENTRY) };
+static const vector<tuple<string, int, int>> kCustomSyscallPaths = { BXL_CUSTOM_SYSCALLS(CUSTOM_PATHS_ENTRY) };
+
+BOOST_AUTO_TEST_SUITE(SyscallTableTests)
+
+BOOST_AUTO_TEST_CASE(TestEverySyscallIsListedOnce)
+{
+    set<long> numbers;
+    for (const auto &syscall : kDeclarativeSyscalls) {
+        BOOST_CHECK_MESSAGE(numbers.insert(syscall.number).second, syscall.name);
+    }
+
+    for (long number : kCustomSyscalls) {
+        BOOST_CHECK_MESSAGE(numbers.insert(number).second, number);
+    }
+
+    // vfork is not traced on purpose, see PTraceSandbox::UpdateTraceeTableForExec
+    BOOST_CHECK(numbers.find(__NR_vfork) == numbers.end());
+}
+
+BOOST_AUTO_TEST_CASE(TestArgumentsMatchTheShape)
+{
+    for (const auto &syscall : kDeclarativeSyscalls) {
+        BOOST_TEST_CONTEXT(syscall.name) {
+            // Syscalls take at most 6 arguments
+            BOOST_CHECK(syscall.fd_arg >= 0 && syscall.fd_arg <= 6);
+            BOOST_CHECK(syscall.path_arg >= 0 && syscall.path_arg <= 6);
+            BOOST_CHECK(syscall.flags_arg >= 0 && syscall.flags_arg <= 6);
+
+            switch (syscall.shape) {
+                case kFdSyscall:
+                    BOOST_CHECK(syscall.fd_arg > 0);
+                    BOOST_CHECK_EQUAL(syscall.path_arg, 0);
+                    break;
+                case kPathSyscall:
+                    BOOST_CHECK_EQUAL(syscall.fd_arg, 0);
+                    BOOST_CHECK(syscall.path_arg > 0);
+                    break;
+                case kDirfdPathSyscall:
+                    BOOST_CHECK(syscall.fd_arg > 0);
+                    BOOST_CHECK(syscall.path_arg > syscall.fd_arg);
+                    break;
+            }
+
+            BOOST_CHECK_EQUAL(syscall.flags_arg > 0, syscall.resolution == kNoFollowIfRequested);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestCustomPathArguments)
+{
+    for (const auto &syscall : kCustomSyscallPaths) {
+        BOOST_TEST_CONTEXT(get<0>(syscall)) {
+            BOOST_CHECK(get<1>(syscall) >= 0 && get<1>(syscall) <= 6);
+            BOOST_CHECK(get<2>(syscall) >= 0 && get<2>(syscall) <= 6);
+
+            // A second path only comes with a first one
+            BOOST_CHECK(get<2>(syscall) == 0 || get<1>(syscall) > 0);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define BOOST_TEST_MODULE LinuxSandboxTest
+#define _DO_NOT_EXPORT
+
+#include <boost/test/included/unit_test.hpp>
+#include <stdio.h>
+#include <string>
+#include <unistd.h>
+#include <unmonitored_executables.hpp>
+
+using namespace std;
+using namespace buildxl::linux;
+
+static string TempPath(const char *name) {
+    return string("/tmp/bxl_") + name + "_" + to_string(getpid());
+}
+
+static void WriteFile(const string &path, const char *content) {
+    FILE *file = fopen(path.c_str(), "w");
+    BOOST_REQUIRE(file != nullptr);
+    fputs(content, file);
+    fclose(file);
+}
+
+BOOST_AUTO_TEST_SUITE(UnmonitoredExecutablesTests)
+
+BOOST_AUTO_TEST_CASE(TestMatchByPathAndName)
+{
+    UnmonitoredExecutables executables;
+    BOOST_CHECK(executables.IsEmpty());
+    BOOST_CHECK(!executables.Matches("/usr/bin/collect2"));
+
+    BOOST_CHECK_EQUAL(executables.Initialize("/usr/libexec/gcc/collect2;ccache;;clang-format"), 3);
+    BOOST_CHECK(!executables.IsEmpty());
+
+    // Absolute entries only match that path
+    BOOST_CHECK(executables.Matches("/usr/libexec/gcc/collect2"));
+    BOOST_CHECK(!executables.Matches("/opt/gcc/collect2"));
+
+    // Anything else matches the program name
+    BOOST_CHECK(executables.Matches("/usr/bin/ccache"));
+    BOOST_CHECK(executables.Matches("/opt/llvm/bin/clang-format"));
+    BOOST_CHECK(!executables.Matches("/usr/bin/ccache-wrapper"));
+    BOOST_CHECK(!executables.Matches("/usr/bin/gcc"));
+
+    // Callers pass absolute paths
+    BOOST_CHECK(!executables.Matches("ccache"));
+}
+
+BOOST_AUTO_TEST_CASE(TestMalformedEntriesAreIgnored)
+{
+    UnmonitoredExecutables executables;
+    BOOST_CHECK_EQUAL(executables.Initialize("/usr/bin/;tool|1234;other|not-a-hash;good"), 1);
+    BOOST_CHECK(executables.Matches("/usr/bin/good"));
+    BOOST_CHECK(!executables.Matches("/usr/bin/tool"));
+    BOOST_CHECK(!executables.Matches("/usr/bin/other"));
+}
+
+BOOST_AUTO_TEST_CASE(TestMatchByContent)
+{
+    string tool = TempPath("um_tool");
+    WriteFile(tool, "hello");
+
+    // SHA-256 of "hello"
+    const char *hash = "2CF24DBA5FB0A30E26E83B2AC5B9E29E1B161E5C1FA7425E73043362938B9824";
+    BOOST_CHECK_EQUAL(UnmonitoredExecutables::HashFile(tool.c_str()), hash);
+
+    UnmonitoredExecutables executables;
+    string list = tool + "|" + "2cf24dba5fb0a30e26e83b2ac5b9e29e1b161e5c1fa7425e73043362938b9824";
+    BOOST_REQUIRE_EQUAL(executables.Initialize(list.c_str()), 1);
+    BOOST_CHECK(executables.Matches(tool.c_str()));
+
+    // A different executable at the same path runs monitored
+    WriteFile(tool, "hello, world");
+    BOOST_CHECK(!executables.Matches(tool.c_str()));
+
+    unlink(tool.c_str());
+    BOOST_CHECK(!executables.Matches(tool.c_str()));
+    BOOST_CHECK_EQUAL(UnmonitoredExecutables::HashFile(tool.c_str()), "");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
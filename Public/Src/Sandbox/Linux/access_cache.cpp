@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "access_cache.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace buildxl {
+namespace linux {
+
+// Each chunk starts with a pointer to the previous one
+static const size_t kChunkHeaderSize = sizeof(char *);
+
+StringArena::~StringArena() {
+    while (chunk_ != nullptr) {
+        char *previous;
+        memcpy(&previous, chunk_, sizeof(previous));
+        free(chunk_);
+        chunk_ = previous;
+    }
+}
+
+std::string_view StringArena::Copy(std::string_view value) {
+    size_t size = value.length() + 1;
+    if (kChunkHeaderSize + size > kChunkSize) {
+        return std::string_view();
+    }
+
+    if (used_ + size > kChunkSize) {
+        char *chunk = (char *)malloc(kChunkSize);
+        if (chunk == nullptr) {
+            return std::string_view();
+        }
+
+        memcpy(chunk, &chunk_, sizeof(chunk_));
+        chunk_ = chunk;
+        used_ = kChunkHeaderSize;
+    }
+
+    char *copy = chunk_ + used_;
+    memcpy(copy, value.data(), value.length());
+    copy[value.length()] = '\0';
+    used_ += size;
+
+    return std::string_view(copy, value.length());
+}
+
+bool AccessCache::Contains(int key, std::string_view path) const {
+    auto it = sets_.find(key);
+    return it != sets_.end() && it->second.find(path) != it->second.end();
+}
+
+bool AccessCache::Insert(int key, std::string_view path) {
+    auto& set = sets_[key];
+    if (set.find(path) != set.end()) {
+        return true;
+    }
+
+    std::string_view copy = arena_.Copy(path);
+    if (copy.data() != nullptr) {
+        set.insert(copy);
+    }
+
+    return false;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_ACCESS_CACHE_H
+#define BUILDXL_SANDBOX_LINUX_ACCESS_CACHE_H
+
+#include <stddef.h>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Bump allocator for strings that live as long as the arena does.
+ *
+ * Strings are copied back to back into large chunks, so interning a string costs one heap allocation per chunk
+ * instead of one per string, and nothing is freed until the arena is destroyed.
+ */
+class StringArena {
+public:
+    static const size_t kChunkSize = 64 * 1024;
+
+    StringArena() : chunk_(nullptr), used_(kChunkSize) { }
+    ~StringArena();
+    StringArena(const StringArena&) = delete;
+    StringArena& operator = (const StringArena&) = delete;
+
+    /**
+     * Returns a null-terminated copy of the given string, owned by the arena. Returns an empty view if out of memory.
+     */
+    std::string_view Copy(std::string_view value);
+
+private:
+    // Chunks are linked through their first bytes
+    char *chunk_;
+    size_t used_;
+};
+
+/**
+ * Per-process cache of accesses that were already checked, keyed by event type and path.
+ *
+ * Lookups and insertions of known paths never allocate: the sets are keyed by views over paths interned in a StringArena,
+ * so a lookup only hashes the path of the access. Only inserting a new path allocates (a set node, and occasionally a new
+ * arena chunk or a rehash). Not thread-safe: callers synchronize access.
+ */
+class AccessCache {
+public:
+    AccessCache() = default;
+    AccessCache(const AccessCache&) = delete;
+    AccessCache& operator = (const AccessCache&) = delete;
+
+    bool Contains(int key, std::string_view path) const;
+
+    /**
+     * Adds the given path under the given key. Returns true if it was already there.
+     */
+    bool Insert(int key, std::string_view path);
+
+private:
+    std::unordered_map<int, std::unordered_set<std::string_view>> sets_;
+    StringArena arena_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_ACCESS_CACHE_H
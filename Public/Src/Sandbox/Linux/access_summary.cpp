@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "access_summary.hpp"
+
+#include <time.h>
+
+namespace buildxl {
+namespace linux {
+
+uint64_t AccessSummary::CoarseMonotonicTimeNs() {
+    // The hold time is in the order of milliseconds: the coarse clock is precise enough and cheaper to read on every access
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+AccessSummary::AddResult AccessSummary::Add(pid_t pid, const char *path, int operation, uint32_t requested_access, uint32_t status, uint32_t error, uint32_t is_directory, bool& first_for_pid) {
+    std::unique_lock<std::mutex> lock(mtx_, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return kBusy;
+    }
+
+    uint64_t now = CoarseMonotonicTimeNs();
+    // Entries of other pids left behind by a per pid Take keep the original time, so they may be flushed a bit early
+    if (entry_count_ == 0) {
+        oldest_entry_time_ = now;
+    }
+
+    bool held_too_long = now - oldest_entry_time_ >= max_hold_time_ns_;
+
+    auto& entries_for_pid = entries_[pid];
+    first_for_pid = entries_for_pid.empty();
+    auto it = entries_for_pid.find(path);
+
+    if (it == entries_for_pid.end()) {
+        entries_for_pid.emplace(path, SummarizedAccess { pid, path, operation, requested_access, status, error, is_directory });
+        entry_count_++;
+        return entry_count_ >= kMaxEntries || held_too_long ? kFlush : kHeld;
+    }
+
+    SummarizedAccess& entry = it->second;
+    // A read is what the managed side cares the most about (e.g., for observed inputs), so the entry is represented by
+    // the operation that read the path if there was one
+    if ((requested_access & kReadAccess) != 0 && (entry.requested_access & kReadAccess) == 0) {
+        entry.operation = operation;
+    }
+
+    entry.requested_access |= requested_access;
+    return held_too_long ? kFlush : kHeld;
+}
+
+void AccessSummary::Take(pid_t pid, std::vector<SummarizedAccess>& entries) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto it = entries_.begin(); it != entries_.end(); ) {
+        if (pid != 0 && it->first != pid) {
+            ++it;
+            continue;
+        }
+
+        for (auto& entry : it->second) {
+            entries.push_back(std::move(entry.second));
+        }
+
+        entry_count_ -= it->second.size();
+        it = entries_.erase(it);
+    }
+}
+
+void AccessSummary::ResetAfterFork() {
+    // Another thread of the parent may have been halfway through an update of the table: start over with a fresh one.
+    // The old table is leaked on purpose.
+    ResetLock(mtx_);
+    new (&entries_) std::unordered_map<pid_t, std::unordered_map<std::string, SummarizedAccess>>();
+    entry_count_ = 0;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_ACCESS_SUMMARY_H
+#define BUILDXL_SANDBOX_LINUX_ACCESS_SUMMARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * All accesses a process made to a path, collapsed into a single report.
+ */
+typedef struct SummarizedAccess {
+    pid_t pid;
+    std::string path;
+    // The operation of the first access, or of the first access that read the path if there was one
+    int operation;
+    // Union of the requested accesses
+    uint32_t requested_access;
+    // Status, error and directory flag of the first access
+    uint32_t status;
+    uint32_t error;
+    uint32_t is_directory;
+} SummarizedAccess;
+
+/**
+ * Per-process table of accesses, keyed by (pid, path).
+ *
+ * In access summary mode, accesses that don't need to reach the managed side right away are accumulated here instead of being
+ * reported one by one. The table is flushed per pid when that process execs or exits, and entirely when it reaches its bound or
+ * when its oldest entry was held for longer than the maximum hold time.
+ *
+ * Held entries only live in the memory of the process: if it is killed (e.g., SIGKILL) they are lost. Add tells the caller when
+ * the table starts holding entries for a pid, and Take returns the entries of a pid together, so the caller can let the managed side
+ * know which pids had accesses that were never sent. The hold time bounds how long an access can stay unreported while the process
+ * keeps running and accessing files, but the check only happens when an access is added.
+ */
+class AccessSummary : public PostForkResettable {
+public:
+    // Entries across all pids before the table has to be flushed
+    static const size_t kMaxEntries = 4096;
+    // Time an entry can be held before the table has to be flushed
+    static const uint64_t kMaxHoldTimeNs = 100ull * 1000 * 1000;
+
+    typedef enum AddResult {
+        // Another thread is using the table: the access was not added
+        kBusy,
+        kHeld,
+        // The access was added, and the table should be flushed: it reached its bound, or its oldest entry was held for longer
+        // than the maximum hold time
+        kFlush
+    } AddResult;
+
+    explicit AccessSummary(uint64_t max_hold_time_ns = kMaxHoldTimeNs)
+        : entry_count_(0), max_hold_time_ns_(max_hold_time_ns), oldest_entry_time_(0) { }
+    AccessSummary(const AccessSummary&) = delete;
+    AccessSummary& operator = (const AccessSummary&) = delete;
+
+    /**
+     * Adds an access to the table. Never blocks: accesses can be observed from signal handlers, which may interrupt a thread that
+     * is using the table. 'first_for_pid' is set when the table held nothing for 'pid' before this access.
+     */
+    AddResult Add(pid_t pid, const char *path, int operation, uint32_t requested_access, uint32_t status, uint32_t error, uint32_t is_directory, bool& first_for_pid);
+
+    /**
+     * Moves the entries of the given pid (or of all pids if pid is 0) to 'entries', leaving them out of the table.
+     * The entries of a pid are next to each other.
+     */
+    void Take(pid_t pid, std::vector<SummarizedAccess>& entries);
+
+    size_t Size() const { return entry_count_; }
+
+    /**
+     * A forked child inherits a copy of the table of its parent, but those entries are the parent's to report.
+     * Must be called in a forked child before it does anything else.
+     */
+    void ResetAfterFork() override;
+
+private:
+    // Bit used to pick the representative operation of an entry. CODESYNC: RequestedAccess::Read
+    static const uint32_t kReadAccess = 0x1;
+
+    static uint64_t CoarseMonotonicTimeNs();
+
+    std::mutex mtx_;
+    size_t entry_count_;
+    uint64_t max_hold_time_ns_;
+    // When the table went from empty to non-empty
+    uint64_t oldest_entry_time_;
+    std::unordered_map<pid_t, std::unordered_map<std::string, SummarizedAccess>> entries_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_ACCESS_SUMMARY_H
@@ -0,0 +1,103 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+// libBxlAudit.so: an rtld-audit module (see rtld-audit(7)) that reports the shared libraries the dynamic loader searches for
+// and maps, at startup and on dlopen, which the interposed functions of libDetours.so can't see. Loaded through LD_AUDIT
+// when __BUILDXL_AUDIT_PATH is set (see BxlObserver::ensureEnvs).
+//
+// The module runs in a link namespace of its own. It can't call into libDetours.so before the loader relocated and initialized
+// it, so la_preinit (right before main, after every initializer) is the earliest point where it hands over what it saw:
+// from then on, libraries are reported as they are loaded. What didn't fit in the meantime can't be recovered, and fails the
+// process (see LibraryAudit::Dropped).
+
+#include <dlfcn.h>
+#include <link.h>
+#include <stdlib.h>
+
+#include "common.h"
+#include "library_audit.hpp"
+
+// CODESYNC: bxl_report_library_access and bxl_report_library_accesses_dropped in detours.cpp
+static const char kSinkName[] = "bxl_report_library_access";
+static const char kDroppedName[] = "bxl_report_library_accesses_dropped";
+
+typedef void (*DroppedFunction)(int count);
+
+static buildxl::linux::LibraryAudit sAudit;
+
+// The main program, whose global scope has libDetours.so in it
+static struct link_map *sMainMap = nullptr;
+
+static void AttachToSandbox()
+{
+    if (sAudit.IsAttached() || sMainMap == nullptr)
+    {
+        return;
+    }
+
+    auto sink = (buildxl::linux::LibraryAudit::Sink)dlsym(sMainMap, kSinkName);
+    if (sink == nullptr)
+    {
+        return;
+    }
+
+    sAudit.Attach(sink);
+    if (sAudit.Dropped() > 0)
+    {
+        auto dropped = (DroppedFunction)dlsym(sMainMap, kDroppedName);
+        if (dropped != nullptr)
+        {
+            dropped(sAudit.Dropped());
+        }
+    }
+}
+
+extern "C" {
+
+unsigned int la_version(unsigned int version)
+{
+    // Returning 0 makes the loader drop the module: it stays out of processes the sandbox stopped monitoring
+    const char *auditPath = getenv(BxlEnvAuditPath);
+    if (version < 1 || auditPath == nullptr || auditPath[0] == '\0')
+    {
+        return 0;
+    }
+
+    return LAV_CURRENT;
+}
+
+char *la_objsearch(const char *name, uintptr_t *cookie, unsigned int flag)
+{
+    sAudit.Searched(name);
+    return (char *)name;
+}
+
+unsigned int la_objopen(struct link_map *map, Lmid_t lmid, uintptr_t *cookie)
+{
+    // Only the base namespace has the sandbox in its global scope (libraries loaded into other namespaces with dlmopen are
+    // reported all the same)
+    if (lmid == LM_ID_BASE && sMainMap == nullptr)
+    {
+        sMainMap = map;
+    }
+
+    sAudit.Opened(map->l_name);
+
+    // No symbol binding callbacks: they would slow down every call through the PLT
+    return 0;
+}
+
+void la_activity(uintptr_t *cookie, unsigned int flag)
+{
+    if (flag == LA_ACT_CONSISTENT)
+    {
+        sAudit.Consistent();
+    }
+}
+
+void la_preinit(uintptr_t *cookie)
+{
+    AttachToSandbox();
+}
+
+} // extern "C"
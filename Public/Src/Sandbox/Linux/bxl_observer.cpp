@@ -81,10 +81,76 @@ BxlObserver::BxlObserver()
         secondaryReportPath_[reportLength] = '2';
         secondaryReportPath_[reportLength + 1] = '\0';
     }
+
+    InitReportChannels();
+
+    reportTimestampsEnabled_ = CheckEnableLinuxSandboxReportTimestamps(pip_->GetFamExtraFlags());
+    reportSequencePid_ = getpid();
+
+    // The managed side creates the directory next to the FAM, and merges and deletes it once the process tree is done
+    if (CheckEnableLinuxSandboxReportLogs(pip_->GetFamExtraFlags()))
+    {
+        snprintf(reportLogDirectory_, PATH_MAX, "%s%s", famPath_, buildxl::linux::ReportLogWriter::kDirectorySuffix);
+    }
+
+    accessSummaryEnabled_ = CheckEnableLinuxSandboxAccessSummary(pip_->GetFamExtraFlags());
+
+    // Deferring the policy evaluation is only sound if the result of an access check can't change the outcome of the access
+    // The engine decides this per pip through the FAM: it also has to be prepared to run the observation evaluator
+    observeOnly_ = CheckEnableLinuxSandboxObserveOnly(pip_->GetFamExtraFlags()) && !IsFailingUnexpectedAccesses();
+
+    // An unsupported hash type just leaves output hashing off: the engine hashes the outputs itself, as usual
+    const char *outputHashType = getenv(BxlEnvOutputHashing);
+    if (!is_null_or_empty(outputHashType))
+    {
+        outputHashes_.Initialize(outputHashType);
+    }
+
+    if (!is_null_or_empty(getenv(BxlEnvOutputCloseNotifications)))
+    {
+        outputCloses_.Enable();
+    }
+
+    if (!is_null_or_empty(getenv(BxlEnvIoAccounting)))
+    {
+        ioVolumes_.Enable();
+    }
+
+    const char *resolutionSnapshot = pip_->GetResolutionSnapshot();
+    if (!is_null_or_empty(resolutionSnapshot))
+    {
+        strlcpy(resolutionSnapshotPath_, resolutionSnapshot, PATH_MAX);
+    }
+
+    // The engine decides which executables run unmonitored, so the list comes from the FAM: a pip can't take itself out of the sandbox
+    const char *unmonitoredExecutables = pip_->GetUnmonitoredExecutables();
+    if (!is_null_or_empty(unmonitoredExecutables))
+    {
+        unmonitoredExecutables_.Initialize(unmonitoredExecutables);
+    }
+
+    // The children of this process start from a copy of these, whatever other threads were doing with them (see post_fork.hpp)
+    buildxl::linux::RegisterPostForkReset(&outputHashes_);
+    buildxl::linux::RegisterPostForkReset(&outputCloses_);
+    buildxl::linux::RegisterPostForkReset(&ioVolumes_);
+    buildxl::linux::RegisterPostForkReset(&copyEngine_);
+    buildxl::linux::RegisterPostForkReset(&resolutionSnapshot_);
+    buildxl::linux::RegisterPostForkReset(&accessSummary_);
 }
 
 BxlObserver::~BxlObserver()
 {
+    // The I/O volumes are held by members that go away with the observer: report them now. Whatever is read or written
+    // after this point (e.g., by exit handlers) is not accounted for.
+    report_io_volumes();
+
+    // Summarized accesses must be reported before the summary goes away. Accesses observed after this point
+    // (e.g., from exit handlers) are reported right away.
+    if (accessSummaryEnabled_)
+    {
+        FlushAccessSummary(0);
+    }
+
     if (messageCountingSemaphore_ != nullptr)
     {
         // best effort, no need to observe the return value here
@@ -107,6 +173,31 @@ void BxlObserver::InitDetoursLibPath()
     {
         detoursLibFullPath_[0] = '\0';
     }
+
+    const char *auditPath = getenv(BxlEnvAuditPath);
+    if (!is_null_or_empty(auditPath))
+    {
+        strlcpy(auditLibFullPath_, auditPath, PATH_MAX);
+    }
+    else
+    {
+        auditLibFullPath_[0] = '\0';
+    }
+}
+
+void BxlObserver::InitReportChannels()
+{
+    // The FAM carries how many report FIFOs the managed side is reading from, so every process of the pip (no matter what environment
+    // it was started with) agrees on the channel each pid reports on.
+    reportChannelCount_ = buildxl::linux::ClampReportChannelCount(pip_->GetReportChannelCount());
+
+    for (int i = 1; i < reportChannelCount_; i++)
+    {
+        if (!buildxl::linux::GetReportChannelPath(GetReportsPath(), i, reportChannelPaths_[i], PATH_MAX))
+        {
+            _fatal("Report channel %d for '%s' does not fit in PATH_MAX", i, GetReportsPath());
+        }
+    }
 }
 
 void BxlObserver::InitFam(pid_t pid)
@@ -180,8 +271,13 @@ void BxlObserver::Init()
 
 // Access Reporting
 AccessCheckResult BxlObserver::CreateAccess(const char *syscall_name, buildxl::linux::SandboxEvent& event, AccessReportGroup& report_group, bool check_cache) {
+    // Take the timestamp before path resolution, so the report lag also accounts for the time spent in the sandbox
+    uint64_t observedTime = reportTimestampsEnabled_ ? MonotonicTimeNs() : 0;
+    BXL_PROBE1(create_access_begin, syscall_name);
+
     if (!event.IsValid()) {
         LOG_DEBUG("Won't report an access for syscall %s because the event is invalid.", syscall_name); 
+        BXL_PROBE3(create_access_end, syscall_name, "", "invalid");
         return sNotChecked;
     }
 
@@ -196,11 +292,13 @@ AccessCheckResult BxlObserver::CreateAccess(const char *syscall_name, buildxl::l
     // Check if non-file, we don't want to report these.
     if (!isFileEvent) {
         LOG_DEBUG("Won't report an access for syscall %s because the paths for the event couldn't be resolved.", syscall_name); 
+        BXL_PROBE3(create_access_end, syscall_name, event.GetSrcPath().c_str(), "not_a_file");
         return sNotChecked;
     }
     
     // Check cache and return early if this access has already been checked.
-    if (check_cache && IsCacheHit(event.GetEventType(), event.GetSrcPath(), event.GetDstPath())) {
+    if (check_cache && IsCacheHit(event.GetEventType(), event.GetSrcPath().c_str(), event.GetDstPath().c_str())) {
+        BXL_PROBE3(create_access_end, syscall_name, event.GetSrcPath().c_str(), "cache_hit");
         return sNotChecked;
     }
 
@@ -208,33 +306,34 @@ AccessCheckResult BxlObserver::CreateAccess(const char *syscall_name, buildxl::l
     auto result = sNotChecked;
     auto access_should_be_blocked = false;
 
-    if (IsEnabled(event.GetPid())) {
-        IOHandler handler(sandbox_);
-        handler.SetProcess(process_);
-
-        // We convert this to an IOEvent here because the macos handler expects an IOEvent. This can be removed once that dependency is removed
-        // TODO [pgunasekara]: Remove this once we remove IOEvent
-        IOEvent io_event(
-            /* pid */       event.GetPid(),
-            /* cpid */      event.GetEventType() == ES_EVENT_TYPE_NOTIFY_FORK ? event.GetChildPid() : 0,
-            /* ppid */      0,
-            /* type */      event.GetEventType(),
-            /* action */    ES_ACTION_TYPE_NOTIFY,
-            /* src */       event.GetSrcPath(),
-            /* dst */       event.GetDstPath(),
-            /* exec */      event.GetEventType() == ES_EVENT_TYPE_NOTIFY_FORK ? event.GetSrcPath() : progFullPath_,
-            /* mode */      event.GetMode(),
-            /* modified */  false,
-            /* error */     event.GetError());
-
-        result = handler.CheckAccessAndBuildReport(io_event, report_group);
+    if (IsEnabled(event.GetPid()) && observeOnly_ && IsObservableEvent(event.GetEventType())) {
+        // The policy is evaluated out of process: just send what was observed. The access is never blocked in this mode.
+        CreateObservation(event, report_group.firstReport);
+        report_group.secondReport.shouldReport = false;
+        report_group.SetErrno(event.GetError());
+        report_group.firstReport.stats.creationTime = observedTime;
+        CheckCache(event.GetEventType(), event.GetSrcPath().c_str(), /* addEntryIfMissing */ true);
+    }
+    else if (IsEnabled(event.GetPid())) {
+        result = CheckAccess(
+            event.GetPid(),
+            event.GetEventType() == ES_EVENT_TYPE_NOTIFY_FORK ? event.GetChildPid() : 0,
+            event.GetEventType(),
+            event.GetSrcPath().c_str(),
+            event.GetDstPath().c_str(),
+            event.GetEventType() == ES_EVENT_TYPE_NOTIFY_FORK ? event.GetSrcPath().c_str() : progFullPath_,
+            event.GetMode(),
+            event.GetError(),
+            report_group);
         access_should_be_blocked = result.ShouldDenyAccess() && IsFailingUnexpectedAccesses();
         report_group.SetErrno(event.GetError());
+        report_group.firstReport.stats.creationTime = observedTime;
+        report_group.secondReport.stats.creationTime = observedTime;
 
         if (!access_should_be_blocked) {
             // This access won't be blocked, so let's cache it.
             // We cache event types that are always a miss in IsCacheHit, but this also should be fine.
-            CheckCache(event.GetEventType(), event.GetSrcPath(), /* addEntryIfMissing */ true);
+            CheckCache(event.GetEventType(), event.GetSrcPath().c_str(), /* addEntryIfMissing */ true);
         }
     }
 
@@ -242,10 +341,134 @@ AccessCheckResult BxlObserver::CreateAccess(const char *syscall_name, buildxl::l
     LOG_DEBUG("(( %10s:%2d )) %s %s%s", syscall_name, event.GetEventType(), event.GetSrcPath().c_str(),
         !result.ShouldReport() ? "[Ignored]" : result.ShouldDenyAccess() ? "[Denied]" : "[Allowed]",
         access_should_be_blocked ? "[Blocked]" : "");
+    BXL_PROBE3(create_access_end, syscall_name, event.GetSrcPath().c_str(),
+        access_should_be_blocked ? "blocked" : !result.ShouldReport() ? "ignored" : result.ShouldDenyAccess() ? "denied" : "allowed");
+
+    return result;
+}
+
+AccessCheckResult BxlObserver::CheckAccess(pid_t pid, pid_t childPid, es_event_type_t eventType, const char *srcPath, const char *dstPath, const char *executablePath, mode_t mode, uint error, AccessReportGroup& report_group) {
+    IOHandler handler(sandbox_);
+    handler.SetProcess(process_);
+
+    // We convert this to an IOEvent here because the macos handler expects an IOEvent. This can be removed once that dependency is removed
+    // TODO [pgunasekara]: Remove this once we remove IOEvent
+    IOEvent io_event(
+        /* pid */       pid,
+        /* cpid */      childPid,
+        /* ppid */      0,
+        /* type */      eventType,
+        /* action */    ES_ACTION_TYPE_NOTIFY,
+        /* src */       srcPath,
+        /* dst */       dstPath,
+        /* exec */      executablePath,
+        /* mode */      mode,
+        /* modified */  false,
+        /* error */     error);
+
+    return handler.CheckAccessAndBuildReport(io_event, report_group);
+}
+
+bool BxlObserver::IsObservableEvent(es_event_type_t eventType) {
+    // CODESYNC: IOHandler::CheckAccessAndBuildReport
+    switch (eventType) {
+        case ES_EVENT_TYPE_NOTIFY_LOOKUP:
+        case ES_EVENT_TYPE_AUTH_OPEN:
+        case ES_EVENT_TYPE_NOTIFY_OPEN:
+        case ES_EVENT_TYPE_NOTIFY_CLOSE:
+        case ES_EVENT_TYPE_NOTIFY_CHDIR:
+        case ES_EVENT_TYPE_NOTIFY_READDIR:
+        case ES_EVENT_TYPE_NOTIFY_FSGETPATH:
+        case ES_EVENT_TYPE_AUTH_GETATTRLIST:
+        case ES_EVENT_TYPE_NOTIFY_GETATTRLIST:
+        case ES_EVENT_TYPE_AUTH_GETEXTATTR:
+        case ES_EVENT_TYPE_NOTIFY_GETEXTATTR:
+        case ES_EVENT_TYPE_AUTH_LISTEXTATTR:
+        case ES_EVENT_TYPE_NOTIFY_LISTEXTATTR:
+        case ES_EVENT_TYPE_NOTIFY_ACCESS:
+        case ES_EVENT_TYPE_NOTIFY_STAT:
+        case ES_EVENT_TYPE_AUTH_READLINK:
+        case ES_EVENT_TYPE_NOTIFY_READLINK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void BxlObserver::CreateObservation(const buildxl::linux::SandboxEvent& event, AccessReport& observation) {
+    es_event_type_t eventType = event.GetEventType();
+    mode_t mode = event.GetMode();
+
+    // The open handler looks at the file system when the mode is unknown. Do it now, so the evaluation doesn't depend
+    // on the state of the file system by the time the observation is evaluated. A path that doesn't exist is handled
+    // by the open handler exactly as a lookup.
+    if ((eventType == ES_EVENT_TYPE_AUTH_OPEN || eventType == ES_EVENT_TYPE_NOTIFY_OPEN) && mode == 0) {
+        mode = get_mode(event.GetSrcPath().c_str());
+        if (mode == 0) {
+            eventType = ES_EVENT_TYPE_NOTIFY_LOOKUP;
+        }
+    }
+
+    observation.operation = FileOperation::kOpObservation;
+    observation.pid = event.GetPid();
+    observation.rootPid = pip_->GetProcessId();
+    observation.requestedAccess = eventType;
+    observation.status = mode;
+    observation.reportExplicitly = 0;
+    observation.error = event.GetError();
+    observation.pipId = pip_->GetPipId();
+    observation.isDirectory = S_ISDIR(mode);
+    observation.shouldReport = true;
+    strlcpy(observation.path, event.GetSrcPath().c_str(), sizeof(observation.path));
+}
+
+AccessCheckResult BxlObserver::EvaluateObservation(const AccessReport &observation, AccessReportGroup &report_group) {
+    // Observations are never about process events, which are the only ones that look at the executable path
+    AccessCheckResult result = CheckAccess(
+        observation.pid,
+        /* childPid */ 0,
+        (es_event_type_t)observation.requestedAccess,
+        observation.path,
+        /* dstPath */ "",
+        /* executablePath */ "",
+        (mode_t)observation.status,
+        observation.error,
+        report_group);
+
+    report_group.SetErrno(observation.error);
+    report_group.firstReport.stats.creationTime = observation.stats.creationTime;
+    report_group.secondReport.stats.creationTime = observation.stats.creationTime;
 
     return result;
 }
 
+void BxlObserver::ReplayAccess(es_event_type_t eventType, uint error, const char *path, AccessReportGroup &inProcess, AccessReportGroup &observeOnly) {
+    bool observeOnlyEnabled = observeOnly_;
+
+    // Each evaluation gets its own event: events are sealed once their paths are resolved
+    auto inProcessEvent = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(eventType, getpid(), error, path);
+    observeOnly_ = false;
+    CreateAccess("replay", inProcessEvent, inProcess, /* check_cache */ false);
+
+    auto observeOnlyEvent = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(eventType, getpid(), error, path);
+    observeOnly_ = true;
+    CreateAccess("replay", observeOnlyEvent, observeOnly, /* check_cache */ false);
+
+    observeOnly_ = observeOnlyEnabled;
+}
+
+std::string BxlObserver::RenderReports(const AccessReportGroup &report_group) {
+    std::string rendered;
+    char buffer[PIPE_BUF];
+    for (const AccessReport *report : { &report_group.firstReport, &report_group.secondReport }) {
+        if (report->shouldReport && BuildReport(buffer, sizeof(buffer), *report, report->path) > 0) {
+            rendered.append(buffer);
+        }
+    }
+
+    return rendered;
+}
+
 void BxlObserver::ReportAccess(const AccessReportGroup& report_group) {
     SendReport(report_group);
 }
@@ -452,7 +675,7 @@ void BxlObserver::LogDebug(pid_t pid, const char *fmt, ...)
 
 // Checks whether cache contains (event, path) pair and returns the result of this check.
 // If the pair is not in cache and addEntryIfMissing is true, attempts to add the pair to cache.
-bool BxlObserver::CheckCache(es_event_type_t event, const string &path, bool addEntryIfMissing)
+bool BxlObserver::CheckCache(es_event_type_t event, const char *path, bool addEntryIfMissing)
 {
     // coalesce some similar events
     es_event_type_t key;
@@ -484,42 +707,45 @@ bool BxlObserver::CheckCache(es_event_type_t event, const string &path, bool add
             break;
     }
 
+    BXL_PROBE2(cache_check_begin, (int)event, path);
+
     // This code could possibly be executing from an interrupt routine or from who knows where,
     // so to avoid deadlocks it's essential to never block here indefinitely.
     if (!cacheMtx_.try_lock_for(chrono::milliseconds(1)))
     {
+        BXL_PROBE3(cache_check_end, (int)event, path, "busy");
+        cacheBusy_.fetch_add(1, std::memory_order_relaxed);
         return false; // failed to acquire mutex -> forget about it
     }
 
     // ============================== in the critical section ================================
 
     // make sure the mutex is released by the end
-    shared_ptr<timed_mutex> sp(&cacheMtx_, [](timed_mutex *mtx) { mtx->unlock(); });
+    unique_lock<timed_mutex> lock(cacheMtx_, adopt_lock);
 
-    unordered_map<es_event_type_t, unordered_set<string>>::iterator it = cache_.find(key);
-    if (it == cache_.end())
-    {
-        if (addEntryIfMissing) 
-        {
-            unordered_set<string> set;
-            set.insert(path);
-            cache_.insert(make_pair(key, set));
-        }
+    bool hit = addEntryIfMissing
+        ? cache_.Insert(key, path)
+        : cache_.Contains(key, path);
 
-        return false;
-    }
+    cacheLookups_++;
+    cacheHits_ += hit ? 1 : 0;
 
-    if (addEntryIfMissing) 
-    {
-        return !it->second.insert(path).second;
-    }
-    else 
+    BXL_PROBE3(cache_check_end, (int)event, path, hit ? "hit" : "miss");
+    return hit;
+}
+
+void BxlObserver::GetCacheStatistics(uint64_t& lookups, uint64_t& hits, uint64_t& busy)
+{
     {
-        return (it->second.find(path) != it->second.end());
+        lock_guard<timed_mutex> lock(cacheMtx_);
+        lookups = cacheLookups_;
+        hits = cacheHits_;
     }
+
+    busy = cacheBusy_.load(std::memory_order_relaxed);
 }
 
-bool BxlObserver::IsCacheHit(es_event_type_t event, const string &path, const string &secondPath)
+bool BxlObserver::IsCacheHit(es_event_type_t event, const char *path, const char *secondPath)
 {
     // (1) IMPORTANT           : never do any of this stuff after this object has been disposed!
     //     WHY                 : because the cache date structure is invalid at that point.
@@ -527,7 +753,7 @@ bool BxlObserver::IsCacheHit(es_event_type_t event, const string &path, const st
     //                           global BxlObserver singleton instance can already be disposed.
     // (2) never cache FORK, EXEC, EXIT and events that take 2 paths
     if (disposed_ ||
-        secondPath.length() > 0 ||
+        secondPath[0] != '\0' ||
         event == ES_EVENT_TYPE_NOTIFY_FORK ||
         event == ES_EVENT_TYPE_NOTIFY_EXEC ||
         event == ES_EVENT_TYPE_NOTIFY_EXIT)
@@ -538,7 +764,7 @@ bool BxlObserver::IsCacheHit(es_event_type_t event, const string &path, const st
     return CheckCache(event, path, /* addEntryIfMissing */ false);
 }
 
-bool BxlObserver::Send(const char *buf, size_t bufsiz, bool useSecondaryPipe, bool countReport)
+bool BxlObserver::Send(const char *buf, size_t bufsiz, int channel, bool useSecondaryPipe, bool countReport)
 {
     if (!real_open)
     {
@@ -551,7 +777,9 @@ bool BxlObserver::Send(const char *buf, size_t bufsiz, bool useSecondaryPipe, bo
         _fatal("Cannot atomically send a buffer whose size (%ld) is greater than PIPE_BUF (%d)", bufsiz, PIPE_BUF);
     }
 
-    const char *reportsPath = useSecondaryPipe ? GetSecondaryReportsPath() : GetReportsPath();
+    BXL_PROBE2(send_begin, useSecondaryPipe ? -1 : channel, bufsiz);
+
+    const char *reportsPath = useSecondaryPipe ? GetSecondaryReportsPath() : GetReportChannelPath(channel);
     int logFd = real_open(reportsPath, O_WRONLY | O_APPEND, 0);
     if (logFd == -1)
     {
@@ -563,16 +791,11 @@ bool BxlObserver::Send(const char *buf, size_t bufsiz, bool useSecondaryPipe, bo
     // the message is received by the managed side but we haven't yet incremented the counter if we do it after sending the message.
     // If the message fails to send, the code below will write to stderr and exit with a bad exit code causing the pip to fail anyways.
     // So it doesn't matter if we increment the counter but fail to send a message.
-    if (messageCountingSemaphore_ != nullptr && countReport)
+    // All report channels (and the secondary pipe) are counted on the same semaphore: the managed side only checks the count once
+    // it processed the reports from every channel.
+    if (countReport)
     {
-        auto result = real_sem_post(messageCountingSemaphore_);
-        if (result != 0)
-        {
-            // something went wrong with the semaphore, we shouldn't call LOG_DEBUG here because it will just come back to this function
-            // we also don't want to call _fatal because that will fail the pip.
-            // instead log the error to stdout (this could be promoted to stderr in the future when this feature is stable)
-            real_fprintf(stdout, "posting to buildxl message counting semaphore failed with errno: %d\n", errno);
-        }
+        CountReport();
     }
 
     ssize_t numWritten = real_write(logFd, buf, bufsiz);
@@ -588,9 +811,27 @@ bool BxlObserver::Send(const char *buf, size_t bufsiz, bool useSecondaryPipe, bo
 
     real_close(logFd);
 
+    BXL_PROBE2(send_end, useSecondaryPipe ? -1 : channel, bufsiz);
     return true;
 }
 
+void BxlObserver::CountReport()
+{
+    if (messageCountingSemaphore_ == nullptr)
+    {
+        return;
+    }
+
+    auto result = real_sem_post(messageCountingSemaphore_);
+    if (result != 0)
+    {
+        // something went wrong with the semaphore, we shouldn't call LOG_DEBUG here because it will just come back to this function
+        // we also don't want to call _fatal because that will fail the pip.
+        // instead log the error to stdout (this could be promoted to stderr in the future when this feature is stable)
+        real_fprintf(stdout, "posting to buildxl message counting semaphore failed with errno: %d\n", errno);
+    }
+}
+
 bool BxlObserver::SendExitReport(pid_t pid)
 {
     IOHandler handler(sandbox_);
@@ -615,19 +856,181 @@ bool BxlObserver::SendReport(const AccessReportGroup &report)
 
 bool BxlObserver::SendReport(const AccessReport &report, bool isDebugMessage, bool useSecondaryPipe)
 {
-    // there is no central sendbox process here (i.e., there is an instance of this
-    // guy in every child process), so counting process tree size is not feasible
-    if (report.operation == FileOperation::kOpProcessTreeCompleted)
+    if (accessSummaryEnabled_ && !isDebugMessage && !useSecondaryPipe && !disposed_)
     {
-        return true;
+        if (SummarizeAccess(report))
+        {
+            return true;
+        }
+
+        // The summary of a process is lost when it execs or exits, so flush it first. This also keeps all accesses
+        // of a process ahead of its exit report.
+        if (report.operation == FileOperation::kOpProcessStart || report.operation == FileOperation::kOpProcessExit)
+        {
+            FlushAccessSummary(report.pid <= 0 ? getpid() : report.pid);
+        }
+    }
+
+    return SendReportNow(report, isDebugMessage, useSecondaryPipe);
+}
+
+bool BxlObserver::SummarizeAccess(const AccessReport &report)
+{
+    // Denied accesses, accesses that must be reported explicitly, writes and anything that is not a plain file access are never summarized
+    if (!bxlObserverInitialized_
+        || report.reportExplicitly != 0
+        || report.status != FileAccessStatus::FileAccessStatus_Allowed
+        || HasAnyFlags(report.requestedAccess, (int)RequestedAccess::Write))
+    {
+        return false;
+    }
+
+    switch (report.operation)
+    {
+        case FileOperation::kOpProcessStart:
+        case FileOperation::kOpProcessExit:
+        case FileOperation::kOpProcessCommandLine:
+        case FileOperation::kOpProcessTreeCompleted:
+        case FileOperation::kOpFirstAllowWriteCheckInProcess:
+        case FileOperation::kOpProcessRequiresPtrace:
+        case FileOperation::kOpObservation:
+        case FileOperation::kOpOutputContentHash:
+        case FileOperation::kOpOutputClosed:
+        case FileOperation::kOpOutputReopened:
+        case FileOperation::kOpInputPrefetchStatistics:
+        case FileOperation::kOpIoVolume:
+        case FileOperation::kOpAccessSummaryHeld:
+        case FileOperation::kOpAccessSummaryFlushed:
+        case FileOperation::kOpKAuthVNodeExecute:
+        case FileOperation::kOpDebugMessage:
+            return false;
+        default:
+            break;
+    }
+
+    pid_t pid = report.pid <= 0 ? getpid() : report.pid;
+    bool firstForPid = false;
+    auto result = accessSummary_.Add(
+        pid,
+        report.path,
+        report.operation,
+        report.requestedAccess,
+        report.status,
+        report.error,
+        report.isDirectory,
+        firstForPid);
+
+    // If the summary is busy, just report the access right away
+    if (result == buildxl::linux::AccessSummary::kBusy)
+    {
+        return false;
+    }
+
+    // The accesses of this pid are incomplete until the matching kOpAccessSummaryFlushed
+    if (firstForPid)
+    {
+        ReportAccessSummaryMarker(kOpAccessSummaryHeld, pid);
+    }
+
+    if (result == buildxl::linux::AccessSummary::kFlush)
+    {
+        FlushAccessSummary(0);
+    }
+
+    return true;
+}
+
+void BxlObserver::FlushAccessSummary(pid_t pid)
+{
+    std::vector<buildxl::linux::SummarizedAccess> entries;
+    accessSummary_.Take(pid, entries);
+
+    for (const auto& entry : entries)
+    {
+        AccessReport report =
+        {
+            .operation          = (FileOperation)entry.operation,
+            .pid                = entry.pid,
+            .rootPid            = pip_->GetProcessId(),
+            .requestedAccess    = entry.requested_access,
+            .status             = entry.status,
+            .reportExplicitly   = 0,
+            .error              = entry.error,
+            .pipId              = pip_->GetPipId(),
+            .path               = {0},
+            .stats              = {0},
+            .isDirectory        = entry.is_directory,
+            .shouldReport       = true,
+        };
+
+        strlcpy(report.path, entry.path.c_str(), sizeof(report.path));
+        SendReportNow(report, /* isDebugMessage */ false, /* useSecondaryPipe */ false);
+
+        // The entries of a pid are taken together: the last one is followed by the marker that balances its kOpAccessSummaryHeld
+        if (&entry == &entries.back() || (&entry + 1)->pid != entry.pid)
+        {
+            ReportAccessSummaryMarker(kOpAccessSummaryFlushed, entry.pid);
+        }
+    }
+}
+
+void BxlObserver::ReportAccessSummaryMarker(FileOperation operation, pid_t pid)
+{
+    AccessReport report =
+    {
+        .operation        = operation,
+        .pid              = pid,
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = (int) RequestedAccess::None,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = (int) ReportLevel::Report,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    SendReportNow(report, /* isDebugMessage */ false, /* useSecondaryPipe */ false);
+}
+
+uint64_t BxlObserver::NextReportSequenceNumber(pid_t pid)
+{
+    if (pid == getpid())
+    {
+        // A forked child inherits the counter of its parent. Only the forking thread survives a fork, so the first report
+        // in the child can't race with another thread of the same process here.
+        if (reportSequencePid_.load(std::memory_order_relaxed) != pid)
+        {
+            reportSequenceNumber_.store(0, std::memory_order_relaxed);
+            reportSequencePid_.store(pid, std::memory_order_relaxed);
+        }
+
+        return reportSequenceNumber_.fetch_add(1, std::memory_order_relaxed);
     }
 
+    std::lock_guard<std::mutex> lock(reportSequenceMtx_);
+    return reportSequenceNumbers_[pid]++;
+}
+
+bool BxlObserver::SendReportNow(const AccessReport &report, bool isDebugMessage, bool useSecondaryPipe)
+{
     // The BxlObserver isn't ready to send reports yet (usually because the message counting semaphore isn't yet initialized)
     bool unexpectedReport = !bxlObserverInitialized_ && report.operation != FileOperation::kOpDebugMessage;
     const int PrefixLength = sizeof(uint);
     char buffer[PIPE_BUF] = {0};
     int maxMessageLength = PIPE_BUF - PrefixLength;
-    int reportSize = BuildReport(&buffer[PrefixLength], maxMessageLength, report, report.path, unexpectedReport);
+    // Reports that were not created from an observed access (e.g., process lifetime events) are timestamped when sent
+    uint64_t timestamp = 0;
+    uint64_t sequenceNumber = 0;
+    if (reportTimestampsEnabled_)
+    {
+        timestamp = report.stats.creationTime != 0 ? report.stats.creationTime : MonotonicTimeNs();
+        sequenceNumber = NextReportSequenceNumber(report.pid <= 0 ? getpid() : report.pid);
+    }
+
+    int reportSize = BuildReport(&buffer[PrefixLength], maxMessageLength, report, report.path, unexpectedReport, timestamp, sequenceNumber);
     // CODESYNC: Public/Src/Engine/Processes/SandboxedProcessUnix.cs
     bool shouldCountReportType = 
         report.operation != FileOperation::kOpProcessStart
@@ -655,12 +1058,160 @@ bool BxlObserver::SendReport(const AccessReport &report, bool isDebugMessage, bo
             // Let's leave an ending \0
             strncpy(truncatedMessage, report.path, truncatedSize - 1);
 
-            reportSize = BuildReport(&buffer[PrefixLength], maxMessageLength, report, truncatedMessage, unexpectedReport);
+            reportSize = BuildReport(&buffer[PrefixLength], maxMessageLength, report, truncatedMessage, unexpectedReport, timestamp, sequenceNumber);
         }
     }
 
     *(uint*)(buffer) = reportSize;
-    return Send(buffer, std::min(reportSize + PrefixLength, PIPE_BUF), useSecondaryPipe, shouldCountReportType);
+
+    if (!useSecondaryPipe && AppendToReportLog(&buffer[PrefixLength], reportSize, report))
+    {
+        // Process lifetime reports also go over the FIFO: the managed side relies on them to know when the process tree is done.
+        // The merged logs are fed back without them (see report_log_merge.cpp).
+        if (report.operation != FileOperation::kOpProcessStart && report.operation != FileOperation::kOpProcessExit)
+        {
+            // The managed side gets the logged report once the logs are merged, and it checks the message count only after that
+            if (shouldCountReportType)
+            {
+                CountReport();
+            }
+
+            return true;
+        }
+    }
+
+    // Reports are sharded by the pid they are about (not the pid sending them: under ptrace the tracer reports on behalf of the tracee,
+    // and process start reports are sent from the parent too) so all reports for a given process land on the same channel in order.
+    int channel = buildxl::linux::SelectReportChannel(report.pid <= 0 ? getpid() : report.pid, reportChannelCount_);
+    bool sent = Send(buffer, std::min(reportSize + PrefixLength, PIPE_BUF), channel, useSecondaryPipe, shouldCountReportType);
+
+    // Leave the process tree only after the exit report is sent, so the tree completion always arrives after it
+    if (report.operation == FileOperation::kOpProcessExit && (report.pid <= 0 || report.pid == getpid()))
+    {
+        LeaveProcessTree();
+    }
+
+    return sent;
+}
+
+buildxl::linux::ProcessTreeTracker *BxlObserver::GetProcessTree()
+{
+    if (!IsValid())
+    {
+        return nullptr;
+    }
+
+    std::call_once(processTreeInitialized_, [this]()
+    {
+        if (!processTree_.Initialize(famPath_))
+        {
+            LOG_DEBUG("Could not map the process tree tracker for '%s', tree completion won't be reported", famPath_);
+        }
+    });
+
+    return processTree_.IsInitialized() ? &processTree_ : nullptr;
+}
+
+void BxlObserver::RegisterInProcessTree()
+{
+    auto processTree = GetProcessTree();
+    if (processTree != nullptr)
+    {
+        processTree->Register(getpid());
+    }
+}
+
+int BxlObserver::ReserveChildInProcessTree()
+{
+    auto processTree = GetProcessTree();
+    return processTree != nullptr ? processTree->ReserveChild() : -1;
+}
+
+void BxlObserver::CompleteChildInProcessTree(int slot, pid_t forkResult)
+{
+    auto processTree = GetProcessTree();
+    if (processTree != nullptr)
+    {
+        processTree->CompleteChild(slot, forkResult);
+    }
+}
+
+void BxlObserver::DisableProcessTreeTracking()
+{
+    // Processes traced by the ptrace sandbox (and their children) are not in the tree, so it could look complete while they are still running
+    auto processTree = GetProcessTree();
+    if (processTree != nullptr)
+    {
+        processTree->Disable();
+    }
+}
+
+void BxlObserver::LeaveProcessTree()
+{
+    // The root process checks every process left for dead ones, however many there are: once it is gone, the tree is more likely to be done
+    auto processTree = GetProcessTree();
+    if (processTree == nullptr || !processTree->Release(getpid(), /* sweep_all */ rootPid_ == getpid()))
+    {
+        return;
+    }
+
+    // This was the last live process of the pip. The report is about the current process, so it lands on the same channel as its exit report.
+    AccessReport report =
+    {
+        .operation        = kOpProcessTreeCompleted,
+        .pid              = getpid(),
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = 0,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = 0,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    SendReportNow(report, /* isDebugMessage */ false, /* useSecondaryPipe */ false);
+}
+
+bool BxlObserver::AppendToReportLog(const char *report, int reportSize, const AccessReport &access)
+{
+    // The managed side needs the tree completion right away: it tells it to start merging the logs
+    if (reportLogDirectory_[0] == '\0' || disposed_ || access.operation == FileOperation::kOpProcessTreeCompleted)
+    {
+        return false;
+    }
+
+    if (!reportLog_.IsOpenForCurrentProcess())
+    {
+        // The log is created lazily on the first report of each process, which also covers forked children (they inherit the parent's
+        // log object, but not its ownership). Never wait on the lock: after a fork it could be held by a thread that doesn't exist anymore.
+        std::unique_lock<std::mutex> lock(reportLogMtx_, std::try_to_lock);
+        if (!lock.owns_lock())
+        {
+            return false;
+        }
+
+        if (!reportLog_.IsOpenForCurrentProcess() && !reportLog_.Open(reportLogDirectory_))
+        {
+            return false;
+        }
+    }
+
+    pid_t pid = access.pid <= 0 ? getpid() : access.pid;
+    if (!reportLog_.Append(report, reportSize, pid, access.operation))
+    {
+        return false;
+    }
+
+    // The exit report is the last report of a process, so the log can be sealed now
+    if (access.operation == FileOperation::kOpProcessExit && pid == getpid())
+    {
+        reportLog_.Seal();
+    }
+
+    return true;
 }
 
 void BxlObserver::report_exec(const char *syscallName, const char *procName, const char *file, int error, mode_t mode, pid_t associatedPid)
@@ -752,9 +1303,8 @@ bool BxlObserver::is_non_file(const mode_t mode)
     return mode != 0 && !S_ISDIR(mode) && !S_ISREG(mode) && !S_ISLNK(mode);
 }
 
-void BxlObserver::report_firstAllowWriteCheck(const char *fullPath)
+void BxlObserver::report_firstAllowWriteCheck(const char *fullPath, mode_t mode)
 {
-    mode_t mode = get_mode(fullPath);
     bool fileExists = mode != 0 && !S_ISDIR(mode);
      
     AccessReport report =
@@ -780,19 +1330,54 @@ void BxlObserver::report_firstAllowWriteCheck(const char *fullPath)
     AccessCheckResult result(RequestedAccess::Write, fileExists ? ResultAction::Deny : ResultAction::Allow, ReportLevel::Report);
 }
 
-bool BxlObserver::check_and_report_process_requires_ptrace(int fd)
+bool BxlObserver::TryRegisterFirstAllowWriteCheck(const std::string& path, mode_t& mode)
 {
-    return check_and_report_process_requires_ptrace(fd_to_path(fd).c_str());
-}
+    std::call_once(firstWriteRegistryInitialized_, [this]()
+    {
+        if (!firstWriteRegistry_.Initialize(famPath_))
+        {
+            LOG_DEBUG("Could not map the first write registry for '%s', falling back to per-process write checks", famPath_);
+        }
+    });
 
-bool BxlObserver::IsPTraceForced(const char *path)
-{
-    // 1. Get the last component of the path (i.e., the program name)
-    if (forcedPTraceProcessNames_.size() == 0) 
+    bool alreadyRegistered = firstWriteRegistry_.IsInitialized()
+        ? firstWriteRegistry_.IsRegistered(path.c_str(), path.length())
+        : FilesCheckedForAccess::GetInstance()->IsRegistered(path);
+    if (alreadyRegistered)
     {
         return false;
     }
-    
+
+    // The path has to be probed before it is registered: as soon as it is, other processes of the pip write to it without
+    // checking it, so probing it afterwards could find a file one of them just created and report a write to an existing file.
+    // A probe made by a process that then loses the registration is just discarded.
+    mode = get_mode(path.c_str());
+
+    switch (firstWriteRegistry_.TryRegister(path.c_str(), path.length()))
+    {
+        case buildxl::linux::FirstWriteRegistration::kFirstWrite:
+            return true;
+        case buildxl::linux::FirstWriteRegistration::kAlreadyRegistered:
+            return false;
+        default:
+            // The managed side keeps the first report it gets for a path, so falling back to one report per process is always safe
+            return FilesCheckedForAccess::GetInstance()->TryRegisterPath(path);
+    }
+}
+
+bool BxlObserver::check_and_report_process_requires_ptrace(int fd)
+{
+    return check_and_report_process_requires_ptrace(fd_to_path(fd).c_str());
+}
+
+bool BxlObserver::IsPTraceForced(const char *path)
+{
+    // 1. Get the last component of the path (i.e., the program name)
+    if (forcedPTraceProcessNames_.size() == 0) 
+    {
+        return false;
+    }
+    
     char *progname = basename((char*)path);
     return std::find(forcedPTraceProcessNames_.begin(), forcedPTraceProcessNames_.end(), std::string(progname)) != forcedPTraceProcessNames_.end();
 }
@@ -828,6 +1413,7 @@ bool BxlObserver::check_and_report_process_requires_ptrace(const char *path)
         };
 
         strlcpy(report.path, path, sizeof(report.path));
+        DisableProcessTreeTracking();
         SendReport(report, /* isDebugMessage */ false, /* useSecondaryPipe */ true);
         return true;
     }
@@ -886,6 +1472,7 @@ bool BxlObserver::check_and_report_process_requires_ptrace(const char *path)
         };
 
         strlcpy(report.path, path, sizeof(report.path));
+        DisableProcessTreeTracking();
 
         SendReport(report, /* isDebugMessage */ false, /* useSecondaryPipe */ true);
     }
@@ -896,7 +1483,8 @@ bool BxlObserver::check_and_report_process_requires_ptrace(const char *path)
 void BxlObserver::set_ptrace_permissions()
 {
     // This should happen before sending a kOpProcessRequiresPtrace report to bxl because it will signal bxl to launch the tracer.
-    if (prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY) == -1)
+    // EINVAL means the kernel is built without Yama: there is no restriction on who can attach to lift then.
+    if (prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY) == -1 && errno != EINVAL)
     {
         std::cerr << "[BuildXL] Failed to allow ptrace for process " << getpid() << ": " << strerror(errno) << "\n";
         // This process is going to fail anyways when the tracer fails to attach, so we should exit here with a bad exit code.
@@ -1025,6 +1613,393 @@ void BxlObserver::reset_fd_table()
     }
 }
 
+void BxlObserver::report_output_hash(int fd)
+{
+    buildxl::linux::OutputHash output;
+    if (!outputHashes_.Complete(fd, output) || !IsEnabled(getpid()))
+    {
+        return;
+    }
+
+    AccessReport report =
+    {
+        .operation        = kOpOutputContentHash,
+        .pid              = getpid(),
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = (int) RequestedAccess::Write,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = (int) ReportLevel::Report,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    // The path goes last, so the managed side can take it verbatim
+    // CODESYNC: Public/Src/Engine/Processes/SandboxedProcessUnix.cs
+    int length = snprintf(report.path, sizeof(report.path), "%lld|%lld|%s|%s",
+        (long long)output.size, (long long)output.mtime_ns, output.hash.c_str(), output.path.c_str());
+    if (length < 0 || length >= (int)sizeof(report.path))
+    {
+        // Too long to be reported: the engine will hash the file itself
+        return;
+    }
+
+    SendReport(report);
+}
+
+void BxlObserver::track_output_open(int fd, const char *path, int oflag)
+{
+    int accessMode = oflag & O_ACCMODE;
+    if (!outputCloses_.IsEnabled() || fd < 0 || (accessMode != O_WRONLY && accessMode != O_RDWR) || !IsEnabled(getpid()))
+    {
+        return;
+    }
+
+    // Only files the pip may write are outputs (the engine still ignores the ones that are not declared, e.g., temporary files)
+    IOHandler handler(sandbox_);
+    handler.SetProcess(process_);
+    PolicyResult policy = handler.PolicyForPath(path);
+    if (!policy.AllowWrite(/* basedOnlyOnPolicy */ true) || policy.IndicateUntracked())
+    {
+        return;
+    }
+
+    if (!outputCloses_.Track(fd, path))
+    {
+        return;
+    }
+
+    // The engine may have started processing this output already
+    AccessReport report =
+    {
+        .operation        = kOpOutputReopened,
+        .pid              = getpid(),
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = (int) RequestedAccess::Write,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = (int) ReportLevel::Report,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    strlcpy(report.path, path, sizeof(report.path));
+    SendReport(report);
+}
+
+void BxlObserver::report_output_closed(const buildxl::linux::OutputCloseTracker::ReleasedOutput& released)
+{
+    buildxl::linux::ClosedOutput closed;
+    if (!IsEnabled(getpid()) || !outputCloses_.Finalize(released, closed))
+    {
+        return;
+    }
+
+    AccessReport report =
+    {
+        .operation        = kOpOutputClosed,
+        .pid              = getpid(),
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = (int) RequestedAccess::Write,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = (int) ReportLevel::Report,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    // The path goes last, so the managed side can take it verbatim
+    // CODESYNC: Public/Src/Engine/Processes/SandboxedProcessUnix.cs
+    int length = snprintf(report.path, sizeof(report.path), "%lld|%lld|%s",
+        (long long)closed.size, (long long)closed.mtime_ns, closed.path.c_str());
+    if (length < 0 || length >= (int)sizeof(report.path))
+    {
+        // Too long to be reported: the engine will process the output when the pip exits
+        return;
+    }
+
+    SendReport(report);
+}
+
+void BxlObserver::start_input_prefetch()
+{
+    // Only the root process starts prefetching, once per pip: children get an empty root pid
+    const char *prefetchList = pip_->GetInputPrefetchList();
+    if (is_null_or_empty(prefetchList) || rootPid_ != getpid() || !IsEnabled(getpid()))
+    {
+        return;
+    }
+
+    if (!inputPrefetcher_.Start(prefetchList))
+    {
+        LOG_DEBUG("Could not start prefetching the inputs listed in '%s'", prefetchList);
+    }
+}
+
+// The published snapshot is only valid for the pip that published it
+static std::string GetResolutionSnapshotTag(const char *famPath)
+{
+    struct stat st;
+    if (!buildxl::linux::ResolutionSnapshot::Describe(famPath, st))
+    {
+        return std::string();
+    }
+
+    return std::to_string(st.st_ino) + ":" + std::to_string((int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec);
+}
+
+void BxlObserver::load_resolution_snapshot()
+{
+    if (resolutionSnapshotPath_[0] == '\0')
+    {
+        return;
+    }
+
+    std::call_once(resolutionSnapshotLoaded_, [this]()
+    {
+        std::string tag = GetResolutionSnapshotTag(famPath_);
+        if (tag.empty())
+        {
+            return;
+        }
+
+        std::string published = std::string(famPath_) + buildxl::linux::ResolutionSnapshot::kFileSuffix;
+        if (rootPid_ != getpid())
+        {
+            resolutionSnapshot_.Load(published.c_str(), tag);
+            return;
+        }
+
+        // Prefixes the pip may write could change under its children while it runs
+        resolutionSnapshot_.LoadAndValidate(resolutionSnapshotPath_);
+        size_t kept = resolutionSnapshot_.DropIf([this](const std::string &path) { return may_be_written_by_pip(path.c_str()); });
+        if (kept > 0 && !resolutionSnapshot_.Publish(published.c_str(), tag))
+        {
+            LOG_DEBUG("Could not publish the resolution snapshot to '%s'", published.c_str());
+        }
+    });
+}
+
+void BxlObserver::save_resolution_snapshot()
+{
+    if (resolutionSnapshotPath_[0] == '\0' || rootPid_ != getpid() || resolutionSnapshotSaved_.exchange(true))
+    {
+        return;
+    }
+
+    // Processes that outlive the root process may still record entries: those are picked up by the next run
+    std::string log = std::string(famPath_) + buildxl::linux::ResolutionSnapshot::kLogFileSuffix;
+    if (!resolutionSnapshot_.Save(resolutionSnapshotPath_, log.c_str()))
+    {
+        LOG_DEBUG("Could not save the resolution snapshot to '%s'", resolutionSnapshotPath_);
+    }
+}
+
+void BxlObserver::report_input_prefetch_statistics()
+{
+    if (!inputPrefetcher_.IsStarted() || !IsEnabled(getpid()))
+    {
+        return;
+    }
+
+    buildxl::linux::PrefetchStatistics statistics = inputPrefetcher_.Stop();
+
+    AccessReport report =
+    {
+        .operation        = kOpInputPrefetchStatistics,
+        .pid              = getpid(),
+        .rootPid          = pip_->GetProcessId(),
+        .requestedAccess  = (int) RequestedAccess::None,
+        .status           = FileAccessStatus::FileAccessStatus_Allowed,
+        .reportExplicitly = (int) ReportLevel::Report,
+        .error            = 0,
+        .pipId            = pip_->GetPipId(),
+        .path             = {0},
+        .stats            = {0},
+        .isDirectory      = 0,
+        .shouldReport     = true,
+    };
+
+    // The list goes last, so the managed side can take it verbatim (and compare it with what the pip actually read)
+    // CODESYNC: Public/Src/Engine/Processes/SandboxedProcessUnix.cs
+    snprintf(report.path, sizeof(report.path), "%llu|%llu|%llu|%llu|%llu|%d|%s",
+        (unsigned long long)statistics.listed,
+        (unsigned long long)statistics.prefetched,
+        (unsigned long long)statistics.missing,
+        (unsigned long long)statistics.bytes,
+        (unsigned long long)(statistics.elapsed_ns / 1000000),
+        statistics.completed ? 1 : 0,
+        inputPrefetcher_.GetListPath().c_str());
+
+    SendReport(report);
+}
+
+void BxlObserver::fold_io_volume(int fd)
+{
+    buildxl::linux::IoVolume volume;
+    if (disposed_ || !ioVolumes_.Take(fd, volume))
+    {
+        return;
+    }
+
+    // Skip the fd table: it may be stale for pipes and sockets, which don't have a path anyway
+    char path[PATH_MAX] = { 0 };
+    ssize_t length = read_path_for_fd(fd, path, PATH_MAX - 1);
+    if (length <= 0 || path[0] != '/')
+    {
+        return;
+    }
+
+    path[length] = '\0';
+    ioVolumes_.Fold(path, volume);
+}
+
+void BxlObserver::report_library_accesses_dropped(int count)
+{
+    // The dropped paths are inputs the pip would not be known to depend on: like a report that doesn't fit in a message, this
+    // is a sandbox failure rather than something to carry on with
+    _fatal("The audit module dropped %d library access(es) the dynamic loader made before the sandbox was attached", count);
+}
+
+void BxlObserver::report_library_access(const char *path, bool loaded)
+{
+    // The libraries of the sandbox itself are not inputs of the pip
+    if (is_null_or_empty(path) || strcmp(path, detoursLibFullPath_) == 0 || strcmp(path, auditLibFullPath_) == 0)
+    {
+        return;
+    }
+
+    // The loader opens every path it tries, and most of the ones it doesn't map are absent: the error is the one the open would have got
+    int error = loaded || real_access(path, F_OK) == 0 ? 0 : errno;
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    ES_EVENT_TYPE_NOTIFY_OPEN,
+        /* pid */           getpid(),
+        /* error */         error,
+        /* src_path */      path);
+    CreateAndReportAccess(loaded ? "la_objopen" : "la_objsearch", event);
+}
+
+void BxlObserver::prepare_for_exec()
+{
+    report_io_volumes();
+
+    // The summary lives in the memory of the current image
+    if (accessSummaryEnabled_)
+    {
+        FlushAccessSummary(0);
+    }
+
+    // The new image starts its own log. If the exec fails, this process keeps reporting over the FIFO.
+    if (reportLogDirectory_[0] != '\0')
+    {
+        reportLog_.Seal();
+    }
+}
+
+void BxlObserver::report_io_volumes()
+{
+    // Already reported when the observer was destroyed (exit handlers run after static destructors)
+    if (disposed_ || !ioVolumes_.IsEnabled())
+    {
+        return;
+    }
+
+    // Descriptors that are still open count as well
+    std::vector<std::pair<int, buildxl::linux::IoVolume>> open;
+    ioVolumes_.TakeAll(open);
+    for (const auto& entry : open)
+    {
+        char path[PATH_MAX] = { 0 };
+        ssize_t length = read_path_for_fd(entry.first, path, PATH_MAX - 1);
+        if (length > 0 && path[0] == '/')
+        {
+            path[length] = '\0';
+            ioVolumes_.Fold(path, entry.second);
+        }
+    }
+
+    std::vector<std::pair<std::string, buildxl::linux::IoVolume>> summary;
+    ioVolumes_.Drain(summary);
+    if (summary.empty() || !IsEnabled(getpid()))
+    {
+        return;
+    }
+
+    for (const auto& entry : summary)
+    {
+        const buildxl::linux::IoVolume& volume = entry.second;
+        AccessReport report =
+        {
+            .operation        = kOpIoVolume,
+            .pid              = getpid(),
+            .rootPid          = pip_->GetProcessId(),
+            .requestedAccess  = (int) RequestedAccess::None,
+            .status           = FileAccessStatus::FileAccessStatus_Allowed,
+            .reportExplicitly = (int) ReportLevel::Report,
+            .error            = 0,
+            .pipId            = pip_->GetPipId(),
+            .path             = {0},
+            .stats            = {0},
+            .isDirectory      = 0,
+            .shouldReport     = true,
+        };
+
+        // The path goes last, so the managed side can take it verbatim
+        // CODESYNC: Public/Src/Engine/Processes/SandboxedProcessUnix.cs
+        int length = snprintf(report.path, sizeof(report.path), "%llu|%llu|%llu|%llu|%llu|%llu|%s",
+            (unsigned long long)volume.bytes_read,
+            (unsigned long long)volume.bytes_written,
+            (unsigned long long)volume.reads,
+            (unsigned long long)volume.writes,
+            (unsigned long long)volume.read_ns,
+            (unsigned long long)volume.write_ns,
+            entry.first.c_str());
+        if (length < 0 || length >= (int)sizeof(report.path))
+        {
+            continue;
+        }
+
+        SendReport(report);
+    }
+}
+
+void BxlObserver::report_outputs_closed_at_exit(bool flushStreams)
+{
+    if (!outputCloses_.IsEnabled())
+    {
+        return;
+    }
+
+    // The descriptors are closed by the kernel when the process is gone, but nothing can write them anymore
+    std::vector<buildxl::linux::OutputCloseTracker::ReleasedOutput> released;
+    outputCloses_.ReleaseAll(released);
+    if (released.empty())
+    {
+        return;
+    }
+
+    // On a regular exit, buffered streams are only flushed after the exit handlers ran: flush them now, so the reported
+    // sizes are the final ones (on _exit, buffered content is never written)
+    if (flushStreams)
+    {
+        fflush(NULL);
+    }
+
+    for (const auto& output : released)
+    {
+        report_output_closed(output);
+    }
+}
+
 std::string BxlObserver::fd_to_path(int fd, pid_t associatedPid)
 {
     char path[PATH_MAX] = {0};
@@ -1063,24 +2038,14 @@ std::string BxlObserver::fd_to_path(int fd, pid_t associatedPid)
     return path;
 }
 
-void BxlObserver::report_intermediate_symlinks(const char *pathname, pid_t associatedPid)
+std::string BxlObserver::normalize_path_at(int dirfd, const char *pathname, int oflags, pid_t associatedPid, const char *systemcall)
 {
-    if (pathname == nullptr)
-    {
-        // Nothing to do
-        return;
-    }
-
-    // Make it into an absolute path
     char fullPath[PATH_MAX] = {0};
-    // associatedPid is irrelevant as we're using AT_FDCWD
-    relative_to_absolute(pathname, AT_FDCWD, /* associatedPid */ 0, fullPath); 
-
-    // This will report all intermediate symlinks in the path
-    resolve_path(fullPath, /* followFinalSymlink */ true, associatedPid);
+    normalize_path_at(dirfd, pathname, fullPath, oflags, associatedPid, systemcall);
+    return fullPath;
 }
 
-std::string BxlObserver::normalize_path_at(int dirfd, const char *pathname, int oflags, pid_t associatedPid, const char *systemcall)
+void BxlObserver::normalize_path_at(int dirfd, const char *pathname, char *fullPath, int oflags, pid_t associatedPid, const char *systemcall)
 {
     // Observe that dirfd is assumed to point to a directory file descriptor. Under that assumption, it is safe to call fd_to_path for it.
     // TODO: If we wanted to be very defensive, we could also consider the case of some tool invoking any of the *at(... dirfd ...) family with a 
@@ -1090,16 +2055,17 @@ std::string BxlObserver::normalize_path_at(int dirfd, const char *pathname, int
     // no pathname given --> read path for dirfd
     if (pathname == nullptr)
     {
-        return fd_to_path(dirfd, associatedPid);
+        std::string path = fd_to_path(dirfd, associatedPid);
+        strncpy(fullPath, path.c_str(), PATH_MAX - 1);
+        fullPath[PATH_MAX - 1] = '\0';
+        return;
     }
 
-    char fullPath[PATH_MAX] = {0};
+    fullPath[0] = '\0';
     relative_to_absolute(pathname, dirfd, associatedPid, fullPath, systemcall);    
 
     bool followFinalSymlink = (oflags & O_NOFOLLOW) == 0;
     resolve_path(fullPath, followFinalSymlink, associatedPid);
-
-    return fullPath;
 }
 
 void BxlObserver::relative_to_absolute(const char *pathname, int dirfd, int associatedPid, char *fullpath, const char *systemcall)
@@ -1141,20 +2107,6 @@ void BxlObserver::relative_to_absolute(const char *pathname, int dirfd, int asso
     }
 }
 
-static void shift_left(char *str, int n)
-{
-    do
-    {
-        *(str - n) = *str;
-    } while (*str++);
-}
-
-static char* find_prev_slash(char *pStr)
-{
-    while (*--pStr != '/');
-    return pStr;
-}
-
 // resolve any intermediate directory symlinks
 void BxlObserver::resolve_path(char *fullpath, bool followFinalSymlink, pid_t associatedPid)
 {
@@ -1164,103 +2116,184 @@ void BxlObserver::resolve_path(char *fullpath, bool followFinalSymlink, pid_t as
         return;
     }
 
-    unordered_set<string> visited;
+    BXL_PROBE1(resolve_path_begin, fullpath);
 
-    char readlinkBuf[PATH_MAX];
-    char *pFullpath = fullpath + 1;
-    while (true)
+    // Fast path: most paths don't go through any symlink. If the kernel confirms that, a lexical pass is all we need.
+    if (buildxl::linux::ResolvesWithoutSymlinks(fullpath, followFinalSymlink))
     {
-        // first handle "/../", "/./", and "//"
-        if (*pFullpath == '/')
-        {
-            char *pPrevSlash = find_prev_slash(pFullpath);
-            int parentDirLen = pFullpath - pPrevSlash - 1;
-            if (parentDirLen == 0)
-            {
-                shift_left(pFullpath + 1, 1);
-                continue;
-            }
-            else if (parentDirLen == 1 && *(pFullpath - 1) == '.')
-            {
-                shift_left(pFullpath + 1, 2);
-                --pFullpath;
-                continue;
-            }
-            else if (parentDirLen == 2 && *(pFullpath - 1) == '.' && *(pFullpath - 2) == '.')
-            {
-                // find previous slash unless already at the beginning
-                if (pPrevSlash > fullpath)
-                {
-                    pPrevSlash = find_prev_slash(pPrevSlash);
-                }
-                int shiftLen = pFullpath - pPrevSlash;
-                shift_left(pFullpath + 1, shiftLen);
-                pFullpath = pPrevSlash + 1;
-                continue;
-            }
-        }
+        buildxl::linux::CanonicalizePath(fullpath, followFinalSymlink, [](const char *, bool, char *, size_t) { return (ssize_t)-1; });
+        BXL_PROBE2(resolve_path_end, fullpath, "no_symlinks");
+        return;
+    }
 
-        // call readlink for intermediate dirs and the final path if followSymlink is true
-        ssize_t nReadlinkBuf = -1;
-        char ch = *pFullpath;
-        if (*pFullpath == '/' || (*pFullpath == '\0' && followFinalSymlink))
-        {
-            *pFullpath = '\0';
-            nReadlinkBuf = internal_readlink(fullpath, readlinkBuf, PATH_MAX);
-            *pFullpath = ch;
-        }
+    // Every symlink we go through is reported as a readlink access
+    auto readLink = [this, associatedPid](const char *prefix, bool isFinal, char *target, size_t targetSize)
+    {
+        return readlink_and_report(prefix, target, targetSize, associatedPid);
+    };
 
-        // if not a symlink --> either continue or exit if at the end of the path
-        if (nReadlinkBuf == -1)
-        {
-            if (*pFullpath == '\0')
-            {
-                break;
-            }
-            else
-            {
-                ++pFullpath;
-                continue;
-            }
-        }
+    auto result = buildxl::linux::CanonicalizePath(fullpath, followFinalSymlink, readLink);
+    if (result != buildxl::linux::kCanonicalized)
+    {
+        LOG_DEBUG("Could not fully canonicalize path '%s' (%s)", fullpath, result == buildxl::linux::kSymlinkLoop ? "symlink loop" : "name too long");
+    }
 
-        // current path is a symlink
-        readlinkBuf[nReadlinkBuf] = '\0';
+    BXL_PROBE2(resolve_path_end, fullpath,
+        result == buildxl::linux::kCanonicalized ? "walked" : result == buildxl::linux::kSymlinkLoop ? "symlink_loop" : "name_too_long");
+}
 
-        // report readlink for the current path
-        *pFullpath = '\0';
-        // break if the same symlink has already been visited (breaks symlink loops)
-        if (!visited.insert(fullpath).second) break;
-        
+ssize_t BxlObserver::readlink_and_report(const char *path, char *buf, size_t bufsiz, pid_t associatedPid)
+{
+    ssize_t length = resolutionSnapshotPath_[0] != '\0'
+        ? readlink_with_snapshot(path, buf, bufsiz)
+        : internal_readlink(path, buf, bufsiz);
+    if (length != -1)
+    {
         auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
             /* event_type */    ES_EVENT_TYPE_NOTIFY_READLINK,
             /* pid */           associatedPid,
             /* error */         0,
-            /* src_path */      fullpath);
+            /* src_path */      path);
 
         // Don't normalize the paths here! We are exactly doing that right now...
-        event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kDoNotResolve);    
+        event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kDoNotResolve);
         CreateAndReportAccess("_readlink", event);
-        
-        *pFullpath = ch;
+    }
 
-        // append the rest of the original path to the readlink target
-        strcpy(
-            readlinkBuf + nReadlinkBuf,
-            (readlinkBuf[nReadlinkBuf-1] == '/' && *pFullpath == '/') ? pFullpath + 1 : pFullpath);
+    return length;
+}
+
+ssize_t BxlObserver::readlink_with_snapshot(const char *path, char *buf, size_t bufsiz)
+{
+    load_resolution_snapshot();
 
-        // if readlink target is an absolute path -> overwrite fullpath with it and start from the beginning
-        if (readlinkBuf[0] == '/')
+    // The snapshot gives the same answer readlink would (the caller still reports the symlink)
+    const buildxl::linux::ResolutionEntry *entry = resolutionSnapshot_.Find(path);
+    if (entry != nullptr)
+    {
+        if (!entry->is_symlink)
         {
-            strcpy(fullpath, readlinkBuf);
-            pFullpath = fullpath + 1;
-            continue;
+            errno = EINVAL;
+            return -1;
         }
 
-        // readlink target is a relative path -> replace the current dir in fullpath with the target
-        pFullpath = find_prev_slash(pFullpath);
-        strcpy(++pFullpath, readlinkBuf);
+        size_t length = std::min(bufsiz, entry->target.length());
+        memcpy(buf, entry->target.data(), length);
+        return length;
     }
+
+    struct stat before;
+    bool described = buildxl::linux::ResolutionSnapshot::Describe(path, before);
+    ssize_t length = internal_readlink(path, buf, bufsiz);
+    int error = errno;
+
+    // Directories and (untruncated) symlinks the pip can't change are worth remembering for the next run
+    if (described && (length == -1 ? error == EINVAL : (size_t)length < bufsiz) && !may_be_written_by_pip(path))
+    {
+        std::string log = std::string(famPath_) + buildxl::linux::ResolutionSnapshot::kLogFileSuffix;
+        resolutionSnapshot_.Record(log.c_str(), path, before, buf, length);
+    }
+
+    errno = error;
+    return length;
+}
+
+bool BxlObserver::may_be_written_by_pip(const char *path)
+{
+    IOHandler handler(sandbox_);
+    handler.SetProcess(process_);
+    return handler.PolicyForPath(path).AllowWrite(/* basedOnlyOnPolicy */ true);
+}
+
+char *BxlObserver::realpath_and_report(const char *path, char *resolved_path, pid_t associatedPid)
+{
+    if (!IsEnabled(associatedPid == 0 ? getpid() : associatedPid))
+    {
+        return fwd_realpath(path, resolved_path).restore();
+    }
+
+    if (path == nullptr)
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    if (path[0] == '\0')
+    {
+        errno = ENOENT;
+        return nullptr;
+    }
+
+    // Make it into an absolute path
+    char fullPath[PATH_MAX];
+    size_t pathLength = strnlen(path, PATH_MAX);
+    size_t prefixLength = 0;
+    if (path[0] != '/')
+    {
+        if (!getcurrentworkingdirectory(fullPath, PATH_MAX, associatedPid))
+        {
+            return nullptr;
+        }
+
+        prefixLength = strlen(fullPath);
+        fullPath[prefixLength++] = '/';
+    }
+
+    if (prefixLength + pathLength >= PATH_MAX)
+    {
+        errno = ENAMETOOLONG;
+        return nullptr;
+    }
+    memcpy(fullPath + prefixLength, path, pathLength + 1);
+
+    char failedPath[PATH_MAX];
+    auto readLink = [this, associatedPid](const char *prefix, char *target, size_t targetSize)
+    {
+        return readlink_and_report(prefix, target, targetSize, associatedPid);
+    };
+    auto isDirectory = [this](const char *prefix) { return S_ISDIR(get_mode(prefix)); };
+
+    int error = buildxl::linux::ResolveRealPath(fullPath, failedPath, readLink, isDirectory);
+    if (error == ELOOP || error == ENAMETOOLONG)
+    {
+        // Nothing sensible to report
+        errno = error;
+        return nullptr;
+    }
+
+    // Report a probe on the resolved path (or on the path that failed to resolve): this is what tells the caller whether the path exists
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
+        /* pid */           associatedPid == 0 ? getpid() : associatedPid,
+        /* error */         error,
+        /* src_path */      error == 0 ? fullPath : failedPath);
+    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kDoNotResolve);
+    CreateAndReportAccess("realpath", event);
+
+    if (error != 0)
+    {
+        // Like glibc, leave the prefix that failed to resolve in the caller's buffer (but for a component that is not a directory)
+        if (resolved_path != nullptr && error != ENOTDIR)
+        {
+            strcpy(resolved_path, failedPath);
+        }
+
+        errno = error;
+        return nullptr;
+    }
+
+    if (resolved_path == nullptr)
+    {
+        resolved_path = strdup(fullPath);
+        if (resolved_path == nullptr)
+        {
+            errno = ENOMEM;
+        }
+
+        return resolved_path;
+    }
+
+    return strcpy(resolved_path, fullPath);
 }
 
 char** BxlObserver::ensure_env_value_with_log(char *const envp[], char const *envName, char const *envValue)
@@ -1274,17 +2307,24 @@ char** BxlObserver::ensure_env_value_with_log(char *const envp[], char const *en
     return newEnvp;
 }
 
+char** BxlObserver::removeEnvs(char *const envp[])
+{
+    char **newEnvp = remove_path_from_LDPRELOAD(envp, detoursLibFullPath_);
+    newEnvp = ensure_env_value(newEnvp, BxlEnvFamPath, "");
+    newEnvp = ensure_env_value(newEnvp, BxlEnvDetoursPath, "");
+    newEnvp = ensure_env_value(newEnvp, BxlEnvRootPid, "");
+    newEnvp = ensure_env_value(newEnvp, BxlPTraceForcedProcessNames, "");
+    // LD_AUDIT is left alone: the audit module stays dormant without its variable
+    newEnvp = ensure_env_value(newEnvp, BxlEnvAuditPath, "");
+    return newEnvp;
+}
+
 // Propagate the environment needed for sandbox initialization
 char** BxlObserver::ensureEnvs(char *const envp[])
 {
     if (!IsMonitoringChildProcesses())
     {
-        char **newEnvp = remove_path_from_LDPRELOAD(envp, detoursLibFullPath_);
-        newEnvp = ensure_env_value(newEnvp, BxlEnvFamPath, "");
-        newEnvp = ensure_env_value(newEnvp, BxlEnvDetoursPath, "");
-        newEnvp = ensure_env_value(newEnvp, BxlEnvRootPid, "");
-        newEnvp = ensure_env_value(newEnvp, BxlPTraceForcedProcessNames, "");
-        return newEnvp;
+        return removeEnvs(envp);
     }
     else
     {
@@ -1299,10 +2339,75 @@ char** BxlObserver::ensureEnvs(char *const envp[])
         newEnvp = ensure_env_value(newEnvp, BxlEnvRootPid, "");
         newEnvp = ensure_env_value_with_log(newEnvp, BxlPTraceForcedProcessNames, forcedPTraceProcessNamesList_);
 
+        if (auditLibFullPath_[0] != '\0')
+        {
+            newEnvp = ensure_paths_included_in_env(newEnvp, LD_AUDIT_ENV_VAR_PREFIX, auditLibFullPath_, NULL);
+            newEnvp = ensure_env_value_with_log(newEnvp, BxlEnvAuditPath, auditLibFullPath_);
+        }
+
         return newEnvp;
     }
 }
 
+bool BxlObserver::IsUnmonitoredExecutable(const char *path)
+{
+    if (unmonitoredExecutables_.IsEmpty() || !IsMonitoringChildProcesses() || is_null_or_empty(path))
+    {
+        return false;
+    }
+
+    if (path[0] == '/')
+    {
+        return unmonitoredExecutables_.Matches(path);
+    }
+
+    char fullPath[PATH_MAX];
+    relative_to_absolute(path, AT_FDCWD, /* associatedPid */ 0, fullPath, "exec");
+    return unmonitoredExecutables_.Matches(fullPath);
+}
+
+char** BxlObserver::prepare_unmonitored_exec(const char *syscallName, const char *file, char *const argv[], char *const envp[])
+{
+    // The exec report is what the new image would have sent on __init__, with the arguments it is about to get
+    // (the command line of this process is still the one of the old image)
+    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
+        /* event_type */    ES_EVENT_TYPE_NOTIFY_EXEC,
+        /* pid */           getpid(),
+        /* error */         0,
+        /* src_path */      file);
+    CreateAndReportAccess(syscallName, event, /* check_cache */ false);
+
+    if (IsReportingProcessArgs())
+    {
+        std::string cmdLine;
+        for (int i = 0; argv != nullptr && argv[i] != nullptr; i++)
+        {
+            if (i > 0)
+            {
+                cmdLine.append(" ");
+            }
+
+            cmdLine.append(argv[i]);
+        }
+
+        report_exec_args(getpid(), cmdLine.c_str());
+    }
+
+    LOG_DEBUG("Executing '%s' unmonitored", file);
+
+    // No exit is reported here: the exec may still fail, and this process would go on sandboxed. Once the exec succeeds nothing
+    // reports the exit of the process, so it stays in the process tree (natively and on the managed side) until it is found dead,
+    // the same way a killed process is. Outputs this process has open are not reported closed: the descriptors survive the exec,
+    // and the executable may keep writing them.
+    return removeEnvs(envp);
+}
+
+void BxlObserver::unmonitored_exec_failed(const char *syscallName, const char *procName, const char *file, int error)
+{
+    // Nothing was torn down before the exec, so this process carries on as any other whose exec failed
+    report_exec(syscallName, procName, file, error);
+}
+
 bool BxlObserver::EnumerateDirectory(std::string rootDirectory, bool recursive, std::vector<std::string>& filesAndDirectories)
 {
     std::stack<std::string> directoriesToEnumerate;
@@ -25,6 +25,7 @@
 #include <sys/vfs.h>
 #include <utime.h>
 
+#include <atomic>
 #include <ostream>
 #include <sstream>
 #include <chrono>
@@ -37,13 +38,32 @@
 #include "SandboxedPip.hpp"
 #include "utils.h"
 #include "common.h"
+#include "bxl_probes.h"
 #include "SandboxEvent.h"
+#include "report_channels.hpp"
+#include "first_write_registry.hpp"
+#include "process_tree_tracker.hpp"
+#include "report_log.hpp"
+#include "access_summary.hpp"
+#include "native_realpath.hpp"
+#include "post_fork.hpp"
+#include "access_cache.hpp"
+#include "path_canonicalizer.hpp"
+#include "symlink_free_check.hpp"
+#include "input_prefetcher.hpp"
+#include "resolution_snapshot.hpp"
+#include "unmonitored_executables.hpp"
+#include "output_close_tracker.hpp"
+#include "output_hash_tracker.hpp"
+#include "io_volume_tracker.hpp"
+#include "copy_engine.hpp"
 
 using namespace std;
 
 extern const char *__progname;
 
 static const char LD_PRELOAD_ENV_VAR_PREFIX[] = "LD_PRELOAD=";
+static const char LD_AUDIT_ENV_VAR_PREFIX[] = "LD_AUDIT=";
 
 static const char GLIBC_23[] = "GLIBC_2.3";
 
@@ -227,12 +247,89 @@ private:
     int rootPid_;
     char progFullPath_[PATH_MAX];
     char detoursLibFullPath_[PATH_MAX];
+    // Set when the audit module (libBxlAudit.so) reports the libraries the dynamic loader maps
+    char auditLibFullPath_[PATH_MAX];
     char famPath_[PATH_MAX];
     char forcedPTraceProcessNamesList_[PATH_MAX];
     char secondaryReportPath_[PATH_MAX];
 
+    // Reports are sharded over reportChannelCount_ FIFOs. Channel 0 is always the reports path from the FAM.
+    int reportChannelCount_ = 1;
+    char reportChannelPaths_[buildxl::linux::kMaxReportChannels][PATH_MAX];
+
+    // Diagnostic mode (EnableLinuxSandboxReportTimestamps in the FAM): every report carries the (CLOCK_MONOTONIC) time at which
+    // the access was observed and a sequence number that increases monotonically for all the reports about a given pid.
+    // Reports about this process use reportSequenceNumber_, which starts over when reportSequencePid_ doesn't match (i.e., in a forked child).
+    // Reports about other processes (only sent by the ptrace runner) use a counter per pid.
+    bool reportTimestampsEnabled_ = false;
+    std::atomic<uint64_t> reportSequenceNumber_ { 0 };
+    std::atomic<pid_t> reportSequencePid_ { 0 };
+    std::mutex reportSequenceMtx_;
+    std::unordered_map<pid_t, uint64_t> reportSequenceNumbers_;
+
+    // When EnableLinuxSandboxReportLogs is set in the FAM, reports are appended to a per-process log under the report log directory instead of
+    // being written to the reports FIFO. Process start and exit reports are still sent over the FIFO too, so the managed side can keep track of the process tree.
+    char reportLogDirectory_[PATH_MAX] = { 0 };
+    buildxl::linux::ReportLogWriter reportLog_;
+    std::mutex reportLogMtx_;
+
+    // Access summary mode (EnableLinuxSandboxAccessSummary in the FAM): allowed non-write accesses that don't have to be reported explicitly are
+    // collapsed per (pid, path) and reported when the process execs or exits (or when the table is full or held for too long, see AccessSummary),
+    // instead of one report per access. A process that is killed without running its exit handlers (e.g., SIGKILL) loses the accesses still held
+    // in its summary: the managed side is told when a pid starts holding some (kOpAccessSummaryHeld) and when they are sent (kOpAccessSummaryFlushed),
+    // so it can tell when they were lost.
+    bool accessSummaryEnabled_ = false;
+    buildxl::linux::AccessSummary accessSummary_;
+
+    // Observe-only mode: only honored when the pip doesn't fail on unexpected accesses, so the outcome of an access check never
+    // changes what the process sees. Read-only accesses are not checked here: a raw observation is sent instead, and the policy is
+    // evaluated out of process by the observation evaluator (see EvaluateObservation).
+    bool observeOnly_ = false;
+
+    // Output hashing mode: the content of files written sequentially from scratch is hashed as it is written, and the hash is
+    // reported when the file is closed (see kOpOutputContentHash). The value of __BUILDXL_OUTPUT_HASHING is the hash type.
+    buildxl::linux::OutputHashTracker outputHashes_;
+
+    // Output close notifications: reported when a process closes the last descriptor it had open for writing on a file under
+    // an output cone (see kOpOutputClosed), and when it opens it for writing again (see kOpOutputReopened).
+    buildxl::linux::OutputCloseTracker outputCloses_;
+
+    // Input prefetch: the root process warms up the page cache with the inputs listed in the file the FAM points to (observed on
+    // a previous run) while the tool starts up, and reports how far it got when it exits (see kOpInputPrefetchStatistics).
+    buildxl::linux::InputPrefetcher inputPrefetcher_;
+
+    // I/O accounting: when __BUILDXL_IO_ACCOUNTING is set, the bytes read and written through each descriptor (and the time spent
+    // doing so) are accounted for, and reported once per path when the process exits or execs (see kOpIoVolume).
+    buildxl::linux::IoVolumeTracker ioVolumes_;
+
+    // Implements copy_file_range, which can't be forwarded as is (see CopyEngine)
+    buildxl::linux::CopyEngine copyEngine_;
+
+    // Warm-start path resolution: the root process validates the snapshot the FAM points to (saved by a previous run
+    // of the pip) and publishes it next to the FAM for the rest of the process tree, and saves an updated one when it exits.
+    // Lazily loaded on first use.
+    buildxl::linux::ResolutionSnapshot resolutionSnapshot_;
+    std::once_flag resolutionSnapshotLoaded_;
+    std::atomic<bool> resolutionSnapshotSaved_ { false };
+    char resolutionSnapshotPath_[PATH_MAX] = { 0 };
+
+    // Executables that run without the sandbox when exec'd, as listed in the FAM by the engine
+    buildxl::linux::UnmonitoredExecutables unmonitoredExecutables_;
+
+    // Pip-wide registry of paths checked for allowed writes, shared by all processes of the pip. Lazily mapped on first use.
+    buildxl::linux::FirstWriteRegistry firstWriteRegistry_;
+    std::once_flag firstWriteRegistryInitialized_;
+
+    // Pip-wide set of live processes, used to report when the whole process tree is done. Lazily mapped on first use.
+    buildxl::linux::ProcessTreeTracker processTree_;
+    std::once_flag processTreeInitialized_;
+
     std::timed_mutex cacheMtx_;
-    std::unordered_map<es_event_type_t, std::unordered_set<std::string>> cache_;
+    buildxl::linux::AccessCache cache_;
+    // Cache statistics. Lookups and hits are only updated under cacheMtx_; busy counts lookups that gave up on the lock.
+    uint64_t cacheLookups_ = 0;
+    uint64_t cacheHits_ = 0;
+    std::atomic<uint64_t> cacheBusy_ { 0 };
 
     // In a typical case, a process will not have more than 1024 open file descriptors at a time.
     // File descriptors start at 3 (1 and 2 are reserved for stdout and stderr).
@@ -262,10 +359,42 @@ private:
 
     void InitFam(pid_t pid);
     void InitDetoursLibPath();
-    bool Send(const char *buf, size_t bufsiz, bool useSecondaryPipe, bool countReport);
-    bool IsCacheHit(es_event_type_t event, const string &path, const string &secondPath);
-    bool CheckCache(es_event_type_t event, const string &path, bool addEntryIfMissing);
+    void InitReportChannels();
+    bool Send(const char *buf, size_t bufsiz, int channel, bool useSecondaryPipe, bool countReport);
+    // Posts the message counting semaphore for a report the managed side is going to receive
+    void CountReport();
+    // Appends a serialized report (without its length prefix) to the report log of this process. Returns false if the report must go over the FIFO instead.
+    bool AppendToReportLog(const char *report, int reportSize, const AccessReport &access);
+    // Sends a report right away, regardless of access summary mode
+    bool SendReportNow(const AccessReport &report, bool isDebugMessage, bool useSecondaryPipe);
+    // Adds the report to the access summary. Returns false if the report has to be sent right away.
+    bool SummarizeAccess(const AccessReport &report);
+    // Sends the summarized accesses of the given pid (or of all pids if pid is 0)
+    void FlushAccessSummary(pid_t pid);
+    // Tells the managed side that the summary started holding accesses of the given pid, or that they were sent
+    void ReportAccessSummaryMarker(FileOperation operation, pid_t pid);
+    // Returns the process tree tracker, or nullptr if it is not available
+    buildxl::linux::ProcessTreeTracker *GetProcessTree();
+    // Removes the current process from the process tree, reporting the tree as completed if it was the last one
+    void LeaveProcessTree();
+    void DisableProcessTreeTracking();
+    bool IsCacheHit(es_event_type_t event, const char *path, const char *secondPath);
+    bool CheckCache(es_event_type_t event, const char *path, bool addEntryIfMissing);
+
+    // Checks an access against the policy and builds its reports. Shared by in-process evaluation and EvaluateObservation,
+    // so that both produce the same reports for the same inputs.
+    AccessCheckResult CheckAccess(pid_t pid, pid_t childPid, es_event_type_t eventType, const char *srcPath, const char *dstPath, const char *executablePath, mode_t mode, uint error, AccessReportGroup& report_group);
+
+    // Whether the policy for the given event can be evaluated out of process. Only accesses whose evaluation depends on nothing
+    // but the path, mode and error of the access qualify. Writes don't: the policy for a write can depend on whether the file
+    // existed at the time of the write (see report_firstAllowWriteCheck).
+    static bool IsObservableEvent(es_event_type_t eventType);
+
+    // Fills in the observation for an event whose policy is evaluated out of process (see EvaluateObservation)
+    void CreateObservation(const buildxl::linux::SandboxEvent& event, AccessReport& observation);
     char** ensure_env_value_with_log(char *const envp[], char const *envName, const char *envValue);
+    // Removes the environment needed for sandbox initialization, so a process runs unmonitored
+    char** removeEnvs(char *const envp[]);
     ssize_t read_path_for_fd(int fd, char *buf, size_t bufsiz, pid_t associatedPid = 0);
 
     bool IsMonitoringChildProcesses() const { return !pip_ || CheckMonitorChildProcesses(pip_->GetFamFlags()); }
@@ -306,6 +435,12 @@ private:
 
     void relative_to_absolute(const char *pathname, int dirfd, int associatedPid, char *fullPath, const char *systemcall = "");
     void resolve_path(char *fullpath, bool followFinalSymlink, pid_t associatedPid);
+    // readlink(2) on an absolute path, reporting a readlink access if the path is a symlink
+    ssize_t readlink_and_report(const char *path, char *buf, size_t bufsiz, pid_t associatedPid);
+    // readlink(2) on an absolute path, answered from the resolution snapshot when possible
+    ssize_t readlink_with_snapshot(const char *path, char *buf, size_t bufsiz);
+    // Whether the policy of the pip allows writing the given path, in which case it can't be part of the resolution snapshot
+    bool may_be_written_by_pip(const char *path);
     
     /**
      * If possible, resolves relative or file descriptor paths to absolute paths in a SandboxEvent, and returns true. 
@@ -327,15 +462,34 @@ private:
     void FileDescriptorToPath(int fd, pid_t pid, char *out_path_buffer, size_t buffer_size);
 
     // Builds the report to be sent over the FIFO in the given buffer
-    inline int BuildReport(char* buffer, int maxMessageLength, const AccessReport &report, const char *path, bool unexpectedReport = false)
+    inline int BuildReport(char* buffer, int maxMessageLength, const AccessReport &report, const char *path, bool unexpectedReport = false, uint64_t timestamp = 0, uint64_t sequenceNumber = 0)
     {
         // Note: when adding new fields, always leave 'path' as the last component of this message
         // This is for the sake of the arithmetic when truncating debug messages, where this assumption is made (see SendReport). 
+        if (reportTimestampsEnabled_)
+        {
+            return snprintf(
+                buffer, maxMessageLength, "%s|%d|%d|%d|%d|%d|%d|%d|%d|%lu|%lu|%s\n",
+                __progname, report.pid <= 0 ? getpid() : report.pid, report.requestedAccess, report.status, report.reportExplicitly, report.error, report.operation, report.isDirectory, unexpectedReport, timestamp, sequenceNumber, path);
+        }
+
         return snprintf(
             buffer, maxMessageLength, "%s|%d|%d|%d|%d|%d|%d|%d|%d|%s\n",
             __progname, report.pid <= 0 ? getpid() : report.pid, report.requestedAccess, report.status, report.reportExplicitly, report.error, report.operation, report.isDirectory, unexpectedReport, path);
     }
 
+    // Returns the sequence number for the next report about the given pid
+    uint64_t NextReportSequenceNumber(pid_t pid);
+
+    // Current CLOCK_MONOTONIC time in nanoseconds. The monotonic clock is shared by all processes on the machine,
+    // so timestamps taken by different processes of the pip (and by the reader) can be compared.
+    static inline uint64_t MonotonicTimeNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
     static BxlObserver *sInstance;
     static AccessCheckResult sNotChecked;
 
@@ -355,23 +509,78 @@ public:
 
     bool SendReport(const AccessReport &report, bool isDebugMessage = false, bool useSecondaryPipe = false);
     bool SendReport(const AccessReportGroup &report);
+
+    /**
+     * Evaluates the policy for an access observed by a process running in observe-only mode, producing the same reports
+     * in-process evaluation would have. The observation is a report with operation kOpObservation where
+     *   - requestedAccess is the es_event_type_t of the access
+     *   - status is the mode of the path when the access was observed
+     *   - error is the error of the access
+     *   - path is the resolved path
+     * Used by the observation evaluator (see observation_evaluator.cpp).
+     */
+    AccessCheckResult EvaluateObservation(const AccessReport &observation, AccessReportGroup &report_group);
+    bool IsReportingTimestamps() const { return reportTimestampsEnabled_; }
+
+    // Sends every report over the FIFO, even if the FAM asks for report logs (see ReportLogWriter)
+    void DisableReportLogs() { reportLogDirectory_[0] = '\0'; }
+
+    /**
+     * Replays a recorded access on an absolute path through in-process evaluation and through observe-only mode, regardless of
+     * the mode this process runs in. For an observable access, observeOnly holds the observation instead of the reports.
+     * Used by the observation evaluator to check both evaluations agree (see observation_evaluator.cpp).
+     */
+    void ReplayAccess(es_event_type_t eventType, uint error, const char *path, AccessReportGroup &inProcess, AccessReportGroup &observeOnly);
+
+    // Renders the reports of the group that would be sent, as they travel over the FIFO but without timestamps
+    std::string RenderReports(const AccessReportGroup &report_group);
     // Specialization for the exit report event. 
     // We may need to send an exit report on exit handlers after destructors
     // have been called. This method avoids accessing shared structures.
     bool SendExitReport(pid_t pid = 0);
+
+    // Access cache statistics for this process: lookups that got the cache lock, hits among those, and lookups that fell through
+    // to a full access check because the lock was busy
+    void GetCacheStatistics(uint64_t& lookups, uint64_t& hits, uint64_t& busy);
+
+    // Process tree tracking. A process is added to the tree when the sandbox is loaded into it, and children are added by the
+    // fork/clone interposers (the slot is reserved before the fork, so the tree never looks complete while a child is being created).
+    // A process leaves the tree after sending its exit report, and the one that leaves it last reports the tree as completed.
+    void RegisterInProcessTree();
+    int ReserveChildInProcessTree();
+    void CompleteChildInProcessTree(int slot, pid_t forkResult);
     char** ensureEnvs(char *const envp[]);
 
+    // Whether the given executable, about to be exec'd, runs unmonitored (see UnmonitoredExecutables)
+    bool IsUnmonitoredExecutable(const char *path);
+
+    // Prepares this process to exec an unmonitored executable: the exec is reported (the new image won't report itself) and the
+    // returned environment doesn't load the sandbox. Nothing the executable (or any of its children) does is reported afterwards.
+    // No exit is reported either: the process keeps its slot in the process tree until it's found dead, like a killed process would.
+    char** prepare_unmonitored_exec(const char *syscallName, const char *file, char *const argv[], char *const envp[]);
+
+    // Reports the failed exec of an unmonitored executable. This process is still sandboxed and in the process tree.
+    void unmonitored_exec_failed(const char *syscallName, const char *procName, const char *file, int error);
+
     const char* GetProgramPath() { return progFullPath_; }
     const char* GetReportsPath() { int len; return IsValid() ? pip_->GetReportsPath(&len) : NULL; }
     const char* GetSecondaryReportsPath() { return secondaryReportPath_; }
+    const char* GetReportChannelPath(int channel) { return channel == 0 ? GetReportsPath() : reportChannelPaths_[channel]; }
+    int GetReportChannelCount() const { return reportChannelCount_; }
     const char* GetDetoursLibPath() { return detoursLibFullPath_; }
+    const char* GetAuditLibPath() { return auditLibFullPath_; }
 
     bool IsReportingProcessArgs() const { return !pip_ || CheckReportProcessArgs(pip_->GetFamFlags()); }
 
     void report_exec(const char *syscallName, const char *procName, const char *file, int error, mode_t mode = 0, pid_t associatedPid = 0);
     void report_exec_args(pid_t pid);
     void report_exec_args(pid_t pid, const char *args);
-    void report_intermediate_symlinks(const char *pathname, pid_t associatedPid);
+
+    // realpath(3) computed by the sandbox itself, reporting the symlinks it goes through and a probe on the resolved path (or on the
+    // path where resolution failed) as part of the same walk. Follows glibc semantics for a null resolved_path (the result is allocated
+    // with malloc), for errno, and for resolved_path on failure (it gets the prefix that failed to resolve) Forwards to glibc when
+    // the sandbox is not enabled.
+    char *realpath_and_report(const char *path, char *resolved_path, pid_t associatedPid = 0);
 
     // Removes detours path from LD_PRELOAD from the given environment and returns the modified environment
     inline char** RemoveLDPreloadFromEnv(char *const envp[])
@@ -401,8 +610,13 @@ public:
     void CreateAndReportAccess(const char *syscall_name, buildxl::linux::SandboxEvent& event, bool check_cache = true);
 
     // Send a special message to managed code if the policy to override allowed writes based on file existence is set
-    // and the write is allowed by policy
-    void report_firstAllowWriteCheck(const char *fullPath);
+    // and the write is allowed by policy. The mode is the one TryRegisterFirstAllowWriteCheck probed for the path.
+    void report_firstAllowWriteCheck(const char *fullPath, mode_t mode);
+
+    // Returns whether this is the first time the given path is checked for allowed writes, in which case mode is set to the mode
+    // the path had (0 if it did not exist) before it was registered.
+    // The check is pip-wide (across the whole process tree) when the shared first write registry is available, and per-process otherwise.
+    bool TryRegisterFirstAllowWriteCheck(const std::string& path, mode_t& mode);
 
     // Checks and reports when a process that requires ptrace is about to be executed
     // Observe that as soon as this method determines ptrace is required and sends the corresponding report
@@ -416,6 +630,61 @@ public:
 
     // Clears the specified entry on the file descriptor table
     void reset_fd_table_entry(int fd);
+
+    // Streaming hashes of the files written by this process. Disabled unless output hashing was requested.
+    buildxl::linux::OutputHashTracker& output_hashes() { return outputHashes_; }
+
+    // Stops hashing the given file descriptor, which is about to be closed, and reports its hash if its content is known
+    void report_output_hash(int fd);
+
+    // Descriptors open for writing on outputs. Disabled unless output close notifications were requested.
+    buildxl::linux::OutputCloseTracker& output_closes() { return outputCloses_; }
+    buildxl::linux::ResolutionSnapshot& resolution_snapshot() { return resolutionSnapshot_; }
+
+    // Starts tracking a file descriptor that was just opened with the given flags, if it was opened for writing on an output.
+    // Reports the output as reopened if it was reported closed before.
+    void track_output_open(int fd, const char *path, int oflag);
+
+    // Reports an output whose last descriptor open for writing was just closed
+    void report_output_closed(const buildxl::linux::OutputCloseTracker::ReleasedOutput& released);
+
+    // Bytes read and written per descriptor. Disabled unless I/O accounting was requested.
+    buildxl::linux::IoVolumeTracker& io_volumes() { return ioVolumes_; }
+
+    // Folds what was read and written through the given file descriptor, which is about to be closed, into the summary of its path
+    void fold_io_volume(int fd);
+
+    // Reports what this process read and wrote, once per path, and starts over. Called when the process exits or execs.
+    void report_io_volumes();
+
+    // Called right before an exec: the current image is about to go away without running its exit handlers
+    void prepare_for_exec();
+
+    // Copies for the copy_file_range interposer
+    buildxl::linux::CopyEngine& copy_engine() { return copyEngine_; }
+
+    // Reports a library the dynamic loader tried (but did not map) or mapped, as told by the audit module (see audit_module.cpp)
+    void report_library_access(const char *path, bool loaded);
+
+    // Fails the process: the audit module dropped library accesses, which can't be recovered (see audit_module.cpp)
+    void report_library_accesses_dropped(int count);
+
+    // Starts prefetching the inputs of the pip, if requested and this is the root process
+    void start_input_prefetch();
+
+    // Stops prefetching inputs, and reports how far it got. Does nothing if prefetching was never started.
+    void report_input_prefetch_statistics();
+
+    // Loads the resolution snapshot, if requested. The root process validates it and publishes it for its children, so it
+    // must do so before it starts any.
+    void load_resolution_snapshot();
+
+    // Saves an updated resolution snapshot for the next run of the pip. Only the root process does, when it exits.
+    void save_resolution_snapshot();
+
+    // Reports every output still open for writing, for a process that is exiting. Buffered streams must be flushed first unless
+    // the process is exiting without flushing them (_exit).
+    void report_outputs_closed_at_exit(bool flushStreams);
     
     // Clears the entire file descriptor table
     void reset_fd_table();
@@ -431,6 +700,9 @@ public:
     
     std::string normalize_path_at(int dirfd, const char *pathname, int oflags = 0, pid_t associatedPid = 0, const char *systemcall = "");
 
+    // Same as above, but writes the normalized path into fullPath (a buffer of at least PATH_MAX bytes) instead of allocating a string
+    void normalize_path_at(int dirfd, const char *pathname, char *fullPath, int oflags = 0, pid_t associatedPid = 0, const char *systemcall = "");
+
     // Whether the given descriptor is a non-file (e.g., a pipe, or socket, etc.)
     static bool is_non_file(const mode_t mode);
 
@@ -508,6 +780,17 @@ public:
         return normalize_path_at(AT_FDCWD, pathname, oflags, associatedPid);
     }
 
+    void normalize_path(const char *pathname, char *fullPath, int oflags = 0, pid_t associatedPid = 0)
+    {
+        if (pathname == nullptr)
+        {
+            fullPath[0] = '\0';
+            return;
+        }
+
+        normalize_path_at(AT_FDCWD, pathname, fullPath, oflags, associatedPid);
+    }
+
     bool IsFailingUnexpectedAccesses()
     {
         return CheckFailUnexpectedFileAccesses(pip_->GetFamFlags());
@@ -583,6 +866,11 @@ public:
     GEN_FN_DEF(int, open64, const char *, int, mode_t);
     GEN_FN_DEF(int, open, const char *, int, mode_t);
     GEN_FN_DEF(int, openat, int, const char *, int, mode_t);
+    GEN_FN_DEF(ssize_t, read, int, void*, size_t);
+    GEN_FN_DEF(ssize_t, readv, int fd, const struct iovec *iov, int iovcnt);
+    GEN_FN_DEF(ssize_t, preadv, int fd, const struct iovec *iov, int iovcnt, off_t offset);
+    GEN_FN_DEF(ssize_t, pread, int fd, void *buf, size_t count, off_t offset);
+    GEN_FN_DEF(ssize_t, pread64, int fd, void *buf, size_t count, off_t offset);
     GEN_FN_DEF(ssize_t, write, int, const void*, size_t);
     GEN_FN_DEF(ssize_t, writev, int fd, const struct iovec *iov, int iovcnt);
     GEN_FN_DEF(ssize_t, pwritev, int fd, const struct iovec *iov, int iovcnt, off_t offset);
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BXL_PROBES_H
+#define BXL_PROBES_H
+
+// Statically defined tracepoints (USDT) in the sandbox hot paths, under the 'buildxl' provider.
+//
+// Each probe is a single nop plus an ELF note describing where its arguments live, so it costs nothing until a tracer
+// (perf, bpftrace, systemtap) attaches to it. See Public/Src/Sandbox/Linux/bpftrace for scripts that use them, e.g.:
+//
+//     bpftrace -l 'usdt:/path/to/libDetours.so:buildxl:*'
+//
+// Probes are emitted when <sys/sdt.h> is available (systemtap-sdt-dev / systemtap-sdt-devel), unless BXL_DISABLE_PROBES is defined.
+// Otherwise they compile to nothing (and their arguments are not evaluated).
+//
+// CODESYNC: Public/Src/Sandbox/Linux/bpftrace/*.bt
+// Probes come in _begin/_end pairs, so tracers can measure the time in between:
+//     create_access_begin(syscall)                     create_access_end(syscall, path, outcome)
+//     resolve_path_begin(path)                         resolve_path_end(path, outcome)
+//     policy_search_begin(path)                        policy_search_end(path, found)
+//     cache_check_begin(event type, path)              cache_check_end(event type, path, outcome)
+//     send_begin(channel, size)                        send_end(channel, size)
+//     ptrace_syscall_begin(tracee pid, syscall number) ptrace_syscall_end(tracee pid, syscall number)
+// Outcomes are short strings (e.g., "allowed", "cache_hit") so they can be used as map keys directly.
+
+#if !defined(BXL_DISABLE_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define BXL_PROBES_ENABLED 1
+#endif
+#endif
+
+#ifdef BXL_PROBES_ENABLED
+#define BXL_PROBE1(name, a1)                DTRACE_PROBE1(buildxl, name, a1)
+#define BXL_PROBE2(name, a1, a2)            DTRACE_PROBE2(buildxl, name, a1, a2)
+#define BXL_PROBE3(name, a1, a2, a3)        DTRACE_PROBE3(buildxl, name, a1, a2, a3)
+#else
+#define BXL_PROBE1(name, a1)                do { } while (0)
+#define BXL_PROBE2(name, a1, a2)            do { } while (0)
+#define BXL_PROBE3(name, a1, a2, a3)        do { } while (0)
+#endif
+
+#endif // BXL_PROBES_H
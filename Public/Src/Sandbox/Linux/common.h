@@ -12,5 +12,11 @@
 #define BxlPTraceForcedProcessNames "__BUILDXL_PTRACE_FORCED_PROCESSES"
 #define BxlPTraceTracedPid "__BUILDXL_TRACED_PID"
 #define BxlPTraceTracedPath "__BUILDXL_TRACED_PATH"
+#define BxlEnvOutputHashing "__BUILDXL_OUTPUT_HASHING"
+#define BxlEnvOutputCloseNotifications "__BUILDXL_OUTPUT_CLOSE_NOTIFICATIONS"
+#define BxlEnvFanotifyBackend "__BUILDXL_FANOTIFY_BACKEND"
+#define BxlEnvEbpfBackend "__BUILDXL_EBPF_BACKEND"
+#define BxlEnvIoAccounting "__BUILDXL_IO_ACCOUNTING"
+#define BxlEnvAuditPath "__BUILDXL_AUDIT_PATH"
 
 #endif //COMMON_H
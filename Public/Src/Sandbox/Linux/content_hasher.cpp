@@ -0,0 +1,268 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "content_hasher.hpp"
+
+#include <algorithm>
+#include <string.h>
+#include <strings.h>
+
+namespace buildxl {
+namespace linux {
+
+static const uint32_t kSha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t RotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+void Sha256::Reset() {
+    static const uint32_t kInitialState[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    memcpy(state_, kInitialState, sizeof(state_));
+    length_ = 0;
+    buffered_ = 0;
+}
+
+void Sha256::Transform(const uint8_t block[64]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) | ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+        uint32_t ch = (e & f) ^ (~e & g);
+        uint32_t t1 = h + s1 + ch + kSha256RoundConstants[i] + w[i];
+        uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+        uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        uint32_t t2 = s0 + maj;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+    state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
+
+void Sha256::Update(const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    length_ += length;
+
+    if (buffered_ > 0) {
+        size_t n = std::min(length, sizeof(buffer_) - buffered_);
+        memcpy(buffer_ + buffered_, bytes, n);
+        buffered_ += n;
+        bytes += n;
+        length -= n;
+
+        if (buffered_ < sizeof(buffer_)) {
+            return;
+        }
+
+        Transform(buffer_);
+        buffered_ = 0;
+    }
+
+    // Whole blocks are hashed straight from the caller's buffer
+    for (; length >= sizeof(buffer_); bytes += sizeof(buffer_), length -= sizeof(buffer_)) {
+        Transform(bytes);
+    }
+
+    memcpy(buffer_, bytes, length);
+    buffered_ = length;
+}
+
+void Sha256::Finish(uint8_t digest[kDigestSize]) {
+    uint64_t bit_length = length_ * 8;
+
+    // Padding: a one bit, zeroes up to 56 bytes (mod 64), then the big endian length in bits
+    uint8_t padding[72] = { 0x80 };
+    size_t padding_length = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; i++) {
+        padding[padding_length + i] = (uint8_t)(bit_length >> (56 - i * 8));
+    }
+
+    Update(padding, padding_length + 8);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (uint8_t)(state_[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(state_[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(state_[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)state_[i];
+    }
+
+    Reset();
+}
+
+static std::string ToHex(const uint8_t *bytes, size_t length) {
+    static const char kDigits[] = "0123456789ABCDEF";
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        hex[i * 2] = kDigits[bytes[i] >> 4];
+        hex[i * 2 + 1] = kDigits[bytes[i] & 0xF];
+    }
+
+    return hex;
+}
+
+class Sha256ContentHasher : public ContentHasher {
+public:
+    const char *Name() const override { return "SHA256"; }
+
+    void Update(const void *data, size_t length) override { sha_.Update(data, length); }
+
+    std::string Finish() override {
+        uint8_t digest[Sha256::kDigestSize];
+        sha_.Finish(digest);
+        return ToHex(digest, sizeof(digest));
+    }
+
+private:
+    Sha256 sha_;
+};
+
+/**
+ * VSO0, the engine's default hash type (CODESYNC: Public/Src/Cache/ContentStore/Hashing/VsoHash.cs).
+ *
+ * Content is split in 2MB blocks of 64KB pages. The hash of a block is the SHA-256 of the SHA-256 of its pages, and the blob identifier
+ * is a rolling SHA-256 over the block hashes, seeded with a well known string and flagging the final block. An empty blob consists of
+ * a single empty block. The identifier is followed by the algorithm id byte (0).
+ *
+ * Whether a full block is the final one is only known when more content shows up (or the hasher is finished), so a full block
+ * is kept pending until then.
+ */
+class VsoContentHasher : public ContentHasher {
+public:
+    static const size_t kPageSize = 64 * 1024;
+    static const size_t kPagesPerBlock = 32;
+
+    const char *Name() const override { return "VSO0"; }
+
+    void Update(const void *data, size_t length) override {
+        const uint8_t *bytes = (const uint8_t *)data;
+        while (length > 0) {
+            if (has_pending_block_) {
+                AddBlock(pending_block_, /* is_final */ false);
+                has_pending_block_ = false;
+            }
+
+            size_t n = std::min(length, kPageSize - page_length_);
+            page_.Update(bytes, n);
+            page_length_ += n;
+            bytes += n;
+            length -= n;
+
+            if (page_length_ == kPageSize) {
+                CompletePage();
+            }
+        }
+    }
+
+    std::string Finish() override {
+        if (page_length_ > 0) {
+            CompletePage();
+        }
+
+        if (has_pending_block_) {
+            AddBlock(pending_block_, /* is_final */ true);
+        }
+        else {
+            // The last (possibly empty) block is not full
+            uint8_t block_hash[Sha256::kDigestSize];
+            block_.Finish(block_hash);
+            AddBlock(block_hash, /* is_final */ true);
+        }
+
+        uint8_t identifier[Sha256::kDigestSize + 1];
+        memcpy(identifier, rolling_id_, Sha256::kDigestSize);
+        identifier[Sha256::kDigestSize] = 0; // AlgorithmId.File
+        return ToHex(identifier, sizeof(identifier));
+    }
+
+private:
+    void CompletePage() {
+        uint8_t page_hash[Sha256::kDigestSize];
+        page_.Finish(page_hash);
+        page_length_ = 0;
+
+        block_.Update(page_hash, sizeof(page_hash));
+        if (++block_pages_ == kPagesPerBlock) {
+            block_.Finish(pending_block_);
+            block_pages_ = 0;
+            has_pending_block_ = true;
+        }
+    }
+
+    void AddBlock(const uint8_t block_hash[Sha256::kDigestSize], bool is_final) {
+        static const char kSeed[] = "VSO Content Identifier Seed";
+
+        Sha256 sha;
+        if (is_first_block_) {
+            sha.Update(kSeed, sizeof(kSeed) - 1);
+            is_first_block_ = false;
+        }
+        else {
+            sha.Update(rolling_id_, sizeof(rolling_id_));
+        }
+
+        uint8_t final_flag = is_final ? 1 : 0;
+        sha.Update(block_hash, Sha256::kDigestSize);
+        sha.Update(&final_flag, 1);
+        sha.Finish(rolling_id_);
+    }
+
+    Sha256 page_;
+    size_t page_length_ = 0;
+    Sha256 block_;
+    size_t block_pages_ = 0;
+    uint8_t pending_block_[Sha256::kDigestSize];
+    bool has_pending_block_ = false;
+    uint8_t rolling_id_[Sha256::kDigestSize];
+    bool is_first_block_ = true;
+};
+
+std::unique_ptr<ContentHasher> CreateContentHasher(const char *name) {
+    if (name == nullptr) {
+        return nullptr;
+    }
+
+    if (strcasecmp(name, "SHA256") == 0) {
+        return std::unique_ptr<ContentHasher>(new Sha256ContentHasher());
+    }
+
+    if (strcasecmp(name, "VSO0") == 0) {
+        return std::unique_ptr<ContentHasher>(new VsoContentHasher());
+    }
+
+    return nullptr;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_CONTENT_HASHER_H
+#define BUILDXL_SANDBOX_LINUX_CONTENT_HASHER_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Plain SHA-256 (FIPS 180-4). Building block for the content hashers below.
+ */
+class Sha256 {
+public:
+    static const size_t kDigestSize = 32;
+
+    Sha256() { Reset(); }
+
+    void Reset();
+    void Update(const void *data, size_t length);
+    void Finish(uint8_t digest[kDigestSize]);
+
+private:
+    void Transform(const uint8_t block[64]);
+
+    uint32_t state_[8];
+    uint64_t length_;
+    uint8_t buffer_[64];
+    size_t buffered_;
+};
+
+/**
+ * Incrementally hashes the content of a file as it is written.
+ *
+ * Hashers must produce the same hash the engine's content hasher computes for the same content, so hashes reported by the sandbox
+ * can be used in place of re-reading the file. New hash types are plugged in by adding them to CreateContentHasher.
+ */
+class ContentHasher {
+public:
+    virtual ~ContentHasher() = default;
+
+    // Name of the hash type, as the engine renders it (e.g., "VSO0")
+    virtual const char *Name() const = 0;
+
+    virtual void Update(const void *data, size_t length) = 0;
+
+    // Returns the hash as an uppercase hex string. The hasher can't be updated afterwards.
+    virtual std::string Finish() = 0;
+};
+
+/**
+ * Creates a hasher for the given hash type name (case insensitive). Returns nullptr if the hash type is not supported.
+ * Supported hash types: SHA256 and VSO0.
+ */
+std::unique_ptr<ContentHasher> CreateContentHasher(const char *name);
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_CONTENT_HASHER_H
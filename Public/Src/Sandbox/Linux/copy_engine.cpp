@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "copy_engine.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * The pipe a thread splices through. The descriptors belong to the process, which may close them behind our back
+ * (e.g., a tool closing every descriptor it doesn't know about) and get the same numbers for something else: the pipe
+ * is checked to still be the one we created before every use.
+ */
+class ThreadPipe {
+public:
+    ~ThreadPipe() { Close(); }
+
+    // Returns false (and sets errno) if there is no usable pipe
+    bool Ensure() {
+        if (fds_[0] != -1 && IsOurs()) {
+            return true;
+        }
+
+        // Not ours anymore: the descriptors must not be closed
+        Forget();
+        if (syscall(SYS_pipe2, fds_, O_CLOEXEC) != 0) {
+            Forget();
+            return false;
+        }
+
+        // Best effort: a bigger pipe means fewer round trips
+        syscall(SYS_fcntl, fds_[1], F_SETPIPE_SZ, (int)CopyEngine::kPipeSize);
+
+        struct stat st;
+        if (RawFstat(fds_[0], &st) != 0) {
+            Close();
+            return false;
+        }
+
+        inode_ = st.st_ino;
+        return true;
+    }
+
+    int Read() const { return fds_[0]; }
+    int Write() const { return fds_[1]; }
+
+    void Close() {
+        if (fds_[0] != -1) {
+            RawClose(fds_[0]);
+            RawClose(fds_[1]);
+        }
+
+        Forget();
+    }
+
+    void Forget() {
+        fds_[0] = fds_[1] = -1;
+        inode_ = 0;
+    }
+
+private:
+    bool IsOurs() const {
+        // Both ends of a pipe share its inode
+        struct stat readEnd, writeEnd;
+        return RawFstat(fds_[0], &readEnd) == 0 && RawFstat(fds_[1], &writeEnd) == 0
+            && S_ISFIFO(readEnd.st_mode) && readEnd.st_ino == inode_ && writeEnd.st_ino == inode_;
+    }
+
+    int fds_[2] = { -1, -1 };
+    ino_t inode_ = 0;
+};
+
+static thread_local ThreadPipe tPipe;
+
+// Errors that copy_file_range (or FICLONE) returns for every copy between the same devices
+static bool IsUnsupportedError(int error) {
+    return error == EXDEV || error == EINVAL || error == ENOSYS || error == EOPNOTSUPP || error == ENOTTY;
+}
+
+ssize_t CopyEngine::CopyFileRange(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, size_t len, unsigned int flags) {
+    int savedErrno = errno;
+    if (flags != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stat in, out;
+    if (RawFstat(fdIn, &in) != 0 || RawFstat(fdOut, &out) != 0) {
+        return -1;
+    }
+
+    bool regular = S_ISREG(in.st_mode) && S_ISREG(out.st_mode);
+    bool sameFile = in.st_dev == out.st_dev && in.st_ino == out.st_ino;
+    if (sameFile) {
+        // Overlapping ranges of the same file are invalid
+        off_t startIn = offIn == nullptr ? RawSeek(fdIn, 0, SEEK_CUR) : *offIn;
+        off_t startOut = offOut == nullptr ? RawSeek(fdOut, 0, SEEK_CUR) : *offOut;
+        if (startIn < startOut + (off_t)len && startOut < startIn + (off_t)len) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+
+    ssize_t result;
+    if (regular && !sameFile && in.st_size > 0 && out.st_size == 0 && len >= (size_t)in.st_size
+        && !IsUnsupported(in.st_dev, out.st_dev, kClone)) {
+        // A whole file into an empty one, from the start of both
+        off_t startIn = offIn == nullptr ? RawSeek(fdIn, 0, SEEK_CUR) : *offIn;
+        off_t startOut = offOut == nullptr ? RawSeek(fdOut, 0, SEEK_CUR) : *offOut;
+        if (startIn == 0 && startOut == 0) {
+            result = Clone(fdIn, offIn, fdOut, offOut, in.st_size);
+            if (result >= 0) {
+                errno = savedErrno;
+                return result;
+            }
+
+            if (IsUnsupportedError(errno)) {
+                SetUnsupported(in.st_dev, out.st_dev, kClone);
+            }
+        }
+    }
+
+    if (regular && !IsUnsupported(in.st_dev, out.st_dev, kNativeCopy)) {
+        result = (ssize_t)syscall(SYS_copy_file_range, fdIn, offIn, fdOut, offOut, len, 0);
+        if (result >= 0) {
+            errno = savedErrno;
+            return result;
+        }
+
+        if (!IsUnsupportedError(errno)) {
+            return -1;
+        }
+
+        // The ranges were checked above, so an invalid argument is the file systems refusing the copy
+        SetUnsupported(in.st_dev, out.st_dev, kNativeCopy);
+    }
+
+    result = SpliceCopy(fdIn, offIn, fdOut, offOut, len);
+    if (result >= 0) {
+        errno = savedErrno;
+    }
+
+    return result;
+}
+
+ssize_t CopyEngine::SpliceCopy(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+
+    if (!tPipe.Ensure()) {
+        return -1;
+    }
+
+    size_t total = 0;
+    while (total < len) {
+        size_t chunk = len - total < kPipeSize ? len - total : kPipeSize;
+        ssize_t read = RawSplice(fdIn, offIn, tPipe.Write(), nullptr, chunk, SPLICE_F_MOVE);
+        if (read <= 0) {
+            if (read < 0 && total == 0) {
+                return -1;
+            }
+
+            break;
+        }
+
+        size_t pending = (size_t)read;
+        while (pending > 0) {
+            ssize_t written = RawSplice(tPipe.Read(), nullptr, fdOut, offOut, pending, SPLICE_F_MOVE);
+            if (written <= 0) {
+                int error = written == 0 ? EIO : errno;
+
+                // What is left in the pipe was read from the input but never written: put the input back where the output
+                // stopped, and start over with an empty pipe next time
+                if (offIn != nullptr) {
+                    *offIn -= (loff_t)pending;
+                }
+                else {
+                    RawSeek(fdIn, -(off_t)pending, SEEK_CUR);
+                }
+
+                tPipe.Close();
+                if (total == 0) {
+                    errno = error;
+                    return -1;
+                }
+
+                return (ssize_t)total;
+            }
+
+            pending -= (size_t)written;
+            total += (size_t)written;
+        }
+
+        // A short read means the input ended (or, for a pipe or a socket, that more data would block)
+        if ((size_t)read < chunk) {
+            break;
+        }
+    }
+
+    return (ssize_t)total;
+}
+
+ssize_t CopyEngine::Clone(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, off_t size) {
+    if (syscall(SYS_ioctl, fdOut, FICLONE, fdIn) != 0) {
+        return -1;
+    }
+
+    // Like copy_file_range, the offsets that were not given are the file offsets
+    if (offIn != nullptr) {
+        *offIn += size;
+    }
+    else {
+        RawSeek(fdIn, size, SEEK_CUR);
+    }
+
+    if (offOut != nullptr) {
+        *offOut += size;
+    }
+    else {
+        RawSeek(fdOut, size, SEEK_CUR);
+    }
+
+    return (ssize_t)size;
+}
+
+bool CopyEngine::IsUnsupported(dev_t in, dev_t out, Method method) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (int i = 0; i < pairCount_; i++) {
+        if (pairs_[i].in == in && pairs_[i].out == out) {
+            return (pairs_[i].unsupported & method) != 0;
+        }
+    }
+
+    return false;
+}
+
+void CopyEngine::SetUnsupported(dev_t in, dev_t out, Method method) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (int i = 0; i < pairCount_; i++) {
+        if (pairs_[i].in == in && pairs_[i].out == out) {
+            pairs_[i].unsupported |= method;
+            return;
+        }
+    }
+
+    DevicePair &pair = pairs_[nextPair_];
+    pair.in = in;
+    pair.out = out;
+    pair.unsupported = method;
+    nextPair_ = (nextPair_ + 1) % kMaxDevicePairs;
+    if (pairCount_ < kMaxDevicePairs) {
+        pairCount_++;
+    }
+}
+
+void CopyEngine::ResetAfterFork() {
+    // What was learned about the devices still holds
+    ResetLock(mtx_);
+
+    // The parent may be splicing through the same pipe
+    tPipe.Close();
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,94 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_COPY_ENGINE_H
+#define BUILDXL_SANDBOX_LINUX_COPY_ENGINE_H
+
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Implements copy_file_range for the interposed function, which can't simply forward it: copy_file_range may fail with EXDEV
+ * (or EINVAL) between file systems that user space sees as the same one (e.g., the layers of an overlayfs mounted on FUSE).
+ *
+ * A copy tries, in order:
+ *   - cloning the file (FICLONE), when a whole file is copied into an empty one: a reflink on btrfs or XFS
+ *   - the real copy_file_range, which copies in the kernel (and reflinks on file systems that support it)
+ *   - splicing through a pipe, looping until the requested length is copied or the input ends
+ * The first two fail the same way for every copy between the same pair of devices, so such failures are remembered per pair,
+ * and later copies go straight to what works. The pipe is kept per thread: it is created on the first copy that needs it.
+ *
+ * All file system operations go through raw syscalls, so the engine is safe to use from within interposed functions.
+ */
+class CopyEngine : public PostForkResettable {
+public:
+    // Size requested for the per-thread pipe, which bounds how much one splice round trip moves
+    static const size_t kPipeSize = 1024 * 1024;
+
+    // Device pairs for which failures are remembered (the oldest one is forgotten first)
+    static const int kMaxDevicePairs = 16;
+
+    CopyEngine() = default;
+    CopyEngine(const CopyEngine&) = delete;
+    CopyEngine& operator = (const CopyEngine&) = delete;
+
+    /**
+     * Same contract as copy_file_range(2): returns the number of bytes copied (0 at the end of the input), or -1 and sets errno.
+     * errno is preserved on success.
+     */
+    ssize_t CopyFileRange(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, size_t len, unsigned int flags);
+
+    /**
+     * The fallback alone: copies through the pipe of the calling thread. Same contract as CopyFileRange.
+     */
+    static ssize_t SpliceCopy(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, size_t len);
+
+    /**
+     * Whether the real copy_file_range (or FICLONE) was found not to work between the given devices.
+     */
+    bool IsNativeCopyUnsupported(dev_t in, dev_t out) { return IsUnsupported(in, out, kNativeCopy); }
+    bool IsCloneUnsupported(dev_t in, dev_t out) { return IsUnsupported(in, out, kClone); }
+
+    /**
+     * Must be called in a forked child before it does anything else: the pipe of the thread that forked is shared
+     * with the parent, and the lock may have been held by another thread of the parent.
+     */
+    void ResetAfterFork() override;
+
+private:
+    typedef enum Method : uint8_t {
+        kClone = 1,
+        kNativeCopy = 2
+    } Method;
+
+    typedef struct DevicePair {
+        dev_t in;
+        dev_t out;
+        // Methods (bit mask) that failed between these devices
+        uint8_t unsupported;
+    } DevicePair;
+
+    bool IsUnsupported(dev_t in, dev_t out, Method method);
+    void SetUnsupported(dev_t in, dev_t out, Method method);
+
+    // Clones a whole file. Returns the size of the file, or -1 and sets errno.
+    static ssize_t Clone(int fdIn, loff_t *offIn, int fdOut, loff_t *offOut, off_t size);
+
+    std::mutex mtx_;
+    DevicePair pairs_[kMaxDevicePairs] = {};
+    int pairCount_ = 0;
+    int nextPair_ = 0;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_COPY_ENGINE_H
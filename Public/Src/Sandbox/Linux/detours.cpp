@@ -22,6 +22,8 @@
 #include <sys/sysmacros.h>
 #include <sys/fcntl.h>
 #include <sys/xattr.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 #include "bxl_observer.hpp"
 #include "observer_utilities.hpp"
@@ -162,6 +164,10 @@ INTERPOSE(void, _exit, int status)({
         /* pid */           getpid(),
         /* error */         0,
         /* src_path */      bxl->GetProgramPath());
+    bxl->report_outputs_closed_at_exit(/* flushStreams */ false);
+    bxl->report_io_volumes();
+    bxl->report_input_prefetch_statistics();
+    bxl->save_resolution_snapshot();
     bxl->CreateAndReportAccess("_exit", event, /*check_cache*/ false);
     bxl->real__exit(status);
 })
@@ -205,8 +211,40 @@ static int ret_fd(int fd, BxlObserver *bxl)
     return fd;
 }
 
+static int ret_opened_fd(int fd, const char *path, int oflag, BxlObserver *bxl)
+{
+    // a file opened for writing may be an output whose content can be hashed as it is written,
+    // and whose closing can be reported
+    bxl->output_hashes().Track(fd, path, oflag);
+    bxl->track_output_open(fd, path, oflag);
+    return ret_fd(fd, bxl);
+}
+
+// Closes a file descriptor, reporting it as closed if it was the last one open for writing on an output.
+// If closing fails the output is not reported (and not tracked anymore), since it may still be open.
+template<typename CloseFunction>
+static result_t<int> close_output_fd(int fd, BxlObserver *bxl, CloseFunction closeFunction)
+{
+    buildxl::linux::OutputCloseTracker::ReleasedOutput released;
+    bool lastWriter = bxl->output_closes().Release(fd, released);
+    result_t<int> result = closeFunction();
+    if (lastWriter && result.get() != -1)
+    {
+        bxl->report_output_closed(released);
+    }
+
+    return result;
+}
+
 INTERPOSE(pid_t, fork, void)({
+    int processTreeSlot = bxl->ReserveChildInProcessTree();
+    bxl->output_closes().StopTrackingShared();
     result_t<pid_t> childPid = bxl->fwd_fork();
+    bxl->CompleteChildInProcessTree(processTreeSlot, childPid.get());
+    if (childPid.get() == 0)
+    {
+        buildxl::linux::RunPostForkResets();
+    }
 
     HandleForkOrCloneReporting(__func__, bxl, childPid.get());
 
@@ -220,13 +258,37 @@ INTERPOSE(pid_t, vfork, void)({
     // including returning from the interpose callback.
     // On the other hand, vfork is almost obsolete at this point and has been removed from the POSIX.1-2008 already.
     // Modern Linux distributions should be able to call fork directly with none or minimal perf differences. 
+    int processTreeSlot = bxl->ReserveChildInProcessTree();
+    bxl->output_closes().StopTrackingShared();
     result_t<pid_t> childPid = bxl->fwd_fork();
+    bxl->CompleteChildInProcessTree(processTreeSlot, childPid.get());
+    if (childPid.get() == 0)
+    {
+        buildxl::linux::RunPostForkResets();
+    }
 
     HandleForkOrCloneReporting(__func__, bxl, childPid.get());
 
     return childPid.restore();
 })
 
+// Where the child of clone starts when it gets its own copy of this process: it runs fn instead of returning from the interposer,
+// so the state of the observer is reset on its way there, like in a forked child
+typedef struct CloneChildStart
+{
+    int (*fn)(void *);
+    void *arg;
+} CloneChildStart;
+
+static int clone_child_start(void *arg)
+{
+    buildxl::linux::RunPostForkResets();
+
+    // A copy of the parent's, made when the child was created
+    CloneChildStart *start = (CloneChildStart *)arg;
+    return start->fn(start->arg);
+}
+
 INTERPOSE(int, clone, int (*fn)(void *), void *child_stack, int flags, void *arg, ... /* pid_t *ptid, void *newtls, pid_t *ctid */ )({
     va_list args;
     va_start(args, arg);
@@ -235,9 +297,26 @@ INTERPOSE(int, clone, int (*fn)(void *), void *child_stack, int flags, void *arg
     pid_t *ctid = va_arg(args, pid_t*);
     va_end(args);
 
-    result_t<int> result = bxl->fwd_clone(fn, child_stack, flags, arg, ptid, newtls, ctid);
+    // We don't want to track or report any process creation if clone was asked to create a new thread (and not a new process).
+    // Observe the child runs 'fn' and never returns here, so it is up to the parent to claim the reserved slot.
+    int processTreeSlot = (flags & CLONE_THREAD) ? -1 : bxl->ReserveChildInProcessTree();
+    if (!(flags & CLONE_THREAD))
+    {
+        // The child may write the outputs through the descriptors it shares with this process
+        bxl->output_closes().StopTrackingShared();
+    }
+
+    // A child that shares the memory of this process (CLONE_VM) shares the state of the observer with it, like a thread would,
+    // and resetting a child that shares its descriptors (CLONE_FILES) would close some that this process still uses
+    CloneChildStart start;
+    start.fn = fn;
+    start.arg = arg;
+    bool resetChild = !(flags & (CLONE_THREAD | CLONE_VM | CLONE_FILES));
+    result_t<int> result = resetChild
+        ? bxl->fwd_clone(clone_child_start, child_stack, flags, &start, ptid, newtls, ctid)
+        : bxl->fwd_clone(fn, child_stack, flags, arg, ptid, newtls, ctid);
+    bxl->CompleteChildInProcessTree(processTreeSlot, result.get());
     
-    // We don't want to report any process creation if clone was asked to create a new thread (and not a new process)
     if (!(flags & CLONE_THREAD))
     {
         HandleForkOrCloneReporting(__func__, bxl, result.get());
@@ -270,10 +349,38 @@ static int handle_exec_with_ptrace(int fd, char *const argv[], char *const envp[
     handle_exec_with_ptrace(resolvedPath, argv, envp, bxl);
 }
 
+// Executables the FAM lists as unmonitored run without the sandbox: the exec is reported here, since
+// the new image doesn't load the sandbox and won't report itself.
+static int handle_unmonitored_exec(const char *syscallName, const char *file, char *const argv[], char *const envp[], BxlObserver *bxl)
+{
+    result_t<int> result = bxl->fwd_execve(file, argv, bxl->prepare_unmonitored_exec(syscallName, file, argv, envp));
+
+    // This will only execute if exec failed
+    bxl->unmonitored_exec_failed(syscallName, argv[0], file, result.get_errno());
+    return result.restore();
+}
+
+static int handle_unmonitored_exec(const char *syscallName, int fd, const char *file, char *const argv[], char *const envp[], BxlObserver *bxl)
+{
+    result_t<int> result = bxl->fwd_fexecve(fd, argv, bxl->prepare_unmonitored_exec(syscallName, file, argv, envp));
+
+    // This will only execute if exec failed
+    bxl->unmonitored_exec_failed(syscallName, argv[0], file, result.get_errno());
+    return result.restore();
+}
+
 INTERPOSE(int, fexecve, int fd, char *const argv[], char *const envp[])({
+    bxl->prepare_for_exec();
+
     // exec* functions start a new instance of the sandbox and therefore the process creation report
     // is sent on __init__
 
+    std::string file = bxl->fd_to_path(fd);
+    if (bxl->IsUnmonitoredExecutable(file.c_str()))
+    {
+        return handle_unmonitored_exec(__func__, fd, file.c_str(), argv, envp, bxl);
+    }
+
     if (bxl->check_and_report_process_requires_ptrace(fd))
     {
         return handle_exec_with_ptrace(fd, argv, bxl->ensureEnvs(envp), bxl);
@@ -292,9 +399,16 @@ INTERPOSE(int, fexecve, int fd, char *const argv[], char *const envp[])({
 })
 
 INTERPOSE(int, execv, const char *file, char *const argv[])({
+    bxl->prepare_for_exec();
+
     // exec* functions start a new instance of the sandbox and therefore the process creation report
     // is sent on __init__
 
+    if (bxl->IsUnmonitoredExecutable(file))
+    {
+        return handle_unmonitored_exec(__func__, file, argv, environ, bxl);
+    }
+
     if (bxl->check_and_report_process_requires_ptrace(file))
     {
         return handle_exec_with_ptrace(file, argv, bxl->ensureEnvs(environ), bxl);
@@ -309,9 +423,16 @@ INTERPOSE(int, execv, const char *file, char *const argv[])({
 })
 
 INTERPOSE(int, execve, const char *file, char *const argv[], char *const envp[])({
+    bxl->prepare_for_exec();
+
     // exec* functions start a new instance of the sandbox and therefore the process creation report
     // is sent on __init__
 
+    if (bxl->IsUnmonitoredExecutable(file))
+    {
+        return handle_unmonitored_exec(__func__, file, argv, envp, bxl);
+    }
+
     if (bxl->check_and_report_process_requires_ptrace(file))
     {
         return handle_exec_with_ptrace(file, argv, bxl->ensureEnvs(envp), bxl);
@@ -326,6 +447,8 @@ INTERPOSE(int, execve, const char *file, char *const argv[], char *const envp[])
 })
 
 INTERPOSE(int, execvp, const char *file, char *const argv[])({
+    bxl->prepare_for_exec();
+
     // exec* functions start a new instance of the sandbox and therefore the process creation report
     // is sent on __init__
 
@@ -335,6 +458,11 @@ INTERPOSE(int, execvp, const char *file, char *const argv[])({
 
     if (path_resolution_result)
     {
+        if (bxl->IsUnmonitoredExecutable(pathname.c_str()))
+        {
+            return handle_unmonitored_exec(__func__, pathname.c_str(), argv, environ, bxl);
+        }
+
         if (bxl->check_and_report_process_requires_ptrace(pathname.c_str()))
         {
             return handle_exec_with_ptrace(pathname.c_str(), argv, bxl->ensureEnvs(environ), bxl);
@@ -355,6 +483,8 @@ INTERPOSE(int, execvp, const char *file, char *const argv[])({
 })
 
 INTERPOSE(int, execvpe, const char *file, char *const argv[], char *const envp[])({
+    bxl->prepare_for_exec();
+
     // exec* functions start a new instance of the sandbox and therefore the process creation report
     // is sent on __init__
 
@@ -365,6 +495,11 @@ INTERPOSE(int, execvpe, const char *file, char *const argv[], char *const envp[]
     // If the path couldn't be resolved, then the exec will likely fail anyways
     if (path_resolution_result)
     {
+        if (bxl->IsUnmonitoredExecutable(pathname.c_str()))
+        {
+            return handle_unmonitored_exec(__func__, pathname.c_str(), argv, envp, bxl);
+        }
+
         if (bxl->check_and_report_process_requires_ptrace(pathname.c_str()))
         {
             return handle_exec_with_ptrace(pathname.c_str(), argv, bxl->ensureEnvs(envp), bxl);
@@ -385,6 +520,8 @@ INTERPOSE(int, execvpe, const char *file, char *const argv[], char *const envp[]
 })
 
 INTERPOSE(int, execl, const char *pathname, const char *arg, ...)({
+    bxl->prepare_for_exec();
+
     va_list args;
     va_start(args, arg);
     ptrdiff_t argc = get_variadic_argc(args);
@@ -400,6 +537,11 @@ INTERPOSE(int, execl, const char *pathname, const char *arg, ...)({
     parse_variadic_args(arg, argc, args, argv);
     va_end(args);
 
+    if (bxl->IsUnmonitoredExecutable(pathname))
+    {
+        return handle_unmonitored_exec(__func__, pathname, (char **)argv, environ, bxl);
+    }
+
     if (bxl->check_and_report_process_requires_ptrace(pathname))
     {
         return handle_exec_with_ptrace(pathname, (char **)argv, bxl->ensureEnvs(environ), bxl);
@@ -411,6 +553,8 @@ INTERPOSE(int, execl, const char *pathname, const char *arg, ...)({
 })
 
 INTERPOSE(int, execlp, const char *file, const char *arg, ...)({
+    bxl->prepare_for_exec();
+
     va_list args;
     va_start(args, arg);
     ptrdiff_t argc = get_variadic_argc(args);
@@ -432,6 +576,11 @@ INTERPOSE(int, execlp, const char *file, const char *arg, ...)({
 
     if (path_resolution_result)
     {
+        if (bxl->IsUnmonitoredExecutable(pathname.c_str()))
+        {
+            return handle_unmonitored_exec(__func__, pathname.c_str(), (char **)argv, environ, bxl);
+        }
+
         if (bxl->check_and_report_process_requires_ptrace(pathname.c_str()))
         {
             return handle_exec_with_ptrace(pathname.c_str(), (char **)argv, bxl->ensureEnvs(environ), bxl);
@@ -450,6 +599,8 @@ INTERPOSE(int, execlp, const char *file, const char *arg, ...)({
 })
 
 INTERPOSE(int, execle, const char *pathname, const char *arg, ...)({
+    bxl->prepare_for_exec();
+
     va_list args;
     va_start(args, arg);
     ptrdiff_t argc = get_variadic_argc(args);
@@ -467,6 +618,11 @@ INTERPOSE(int, execle, const char *pathname, const char *arg, ...)({
     envp = va_arg(args, char **);
     va_end(args);
 
+    if (bxl->IsUnmonitoredExecutable(pathname))
+    {
+        return handle_unmonitored_exec(__func__, pathname, (char **)argv, envp, bxl);
+    }
+
     if (bxl->check_and_report_process_requires_ptrace(pathname))
     {
         return handle_exec_with_ptrace(pathname, (char **)argv, bxl->ensureEnvs(envp), bxl);
@@ -678,6 +834,24 @@ static es_event_type_t get_event_from_open_mode(const char *mode) {
     return ES_EVENT_TYPE_NOTIFY_OPEN;
 }
 
+// Streams opened for writing may be outputs whose closing can be reported
+static FILE* ret_opened_stream(FILE *f, const char *pathname, const char *mode, BxlObserver *bxl)
+{
+    if (f)
+    {
+        bxl->reset_fd_table_entry(fileno(f));
+        // freopen may be given no path, to just change the mode of the stream
+        if (bxl->output_closes().IsEnabled() && pathname != nullptr && get_event_from_open_mode(mode) == ES_EVENT_TYPE_NOTIFY_WRITE)
+        {
+            char pathBuf[PATH_MAX];
+            bxl->normalize_path(pathname, pathBuf);
+            bxl->track_output_open(fileno(f), pathBuf, O_WRONLY);
+        }
+    }
+
+    return f;
+}
+
 INTERPOSE(FILE*, fdopen, int fd, const char *mode)({
     AccessReportGroup report;
     auto event = buildxl::linux::SandboxEvent::FileDescriptorSandboxEvent(
@@ -686,6 +860,8 @@ INTERPOSE(FILE*, fdopen, int fd, const char *mode)({
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
+    // Writes through the stream don't go through the interposed functions
+    bxl->output_hashes().Invalidate(fd);
     return bxl->check_fwd_and_report_fdopen(report, check, (FILE*)NULL, fd, mode);
 })
 
@@ -698,8 +874,7 @@ INTERPOSE(FILE*, fopen, const char *pathname, const char *mode)({
         /* src_path */      pathname);
     auto check = bxl->CreateAccess(__func__, event, report);
     FILE *f = bxl->check_fwd_and_report_fopen(report, check, (FILE*)NULL, pathname, mode);
-    if (f) { bxl->reset_fd_table_entry(fileno(f)); }
-    return f;
+    return ret_opened_stream(f, pathname, mode, bxl);
 })
 
 INTERPOSE(FILE*, fopen64, const char *pathname, const char *mode)({
@@ -711,8 +886,7 @@ INTERPOSE(FILE*, fopen64, const char *pathname, const char *mode)({
         /* src_path */      pathname);
     auto check = bxl->CreateAccess(__func__, event, report);
     FILE *f = bxl->check_fwd_and_report_fopen64(report, check, (FILE*)NULL, pathname, mode);
-    if (f) { bxl->reset_fd_table_entry(fileno(f)); }
-    return f;
+    return ret_opened_stream(f, pathname, mode, bxl);
 })
 
 INTERPOSE(FILE*, freopen, const char *pathname, const char *mode, FILE *stream)({
@@ -723,9 +897,12 @@ INTERPOSE(FILE*, freopen, const char *pathname, const char *mode, FILE *stream)(
         /* error */         0,
         /* src_path */      pathname);
     auto check = bxl->CreateAccess(__func__, event, report);
+    // The file the stream was open on is closed first (unless only the mode of the stream changes)
+    buildxl::linux::OutputCloseTracker::ReleasedOutput released;
+    bool lastWriter = pathname != nullptr && bxl->output_closes().Release(fileno(stream), released);
     FILE *f = bxl->check_fwd_and_report_freopen(report, check, (FILE*)NULL, pathname, mode, stream);
-    if (f) { bxl->reset_fd_table_entry(fileno(f)); }
-    return f;
+    if (f && lastWriter) { bxl->report_output_closed(released); }
+    return ret_opened_stream(f, pathname, mode, bxl);
 })
 
 INTERPOSE(FILE*, freopen64, const char *pathname, const char *mode, FILE *stream)({
@@ -736,9 +913,12 @@ INTERPOSE(FILE*, freopen64, const char *pathname, const char *mode, FILE *stream
         /* error */         0,
         /* src_path */      pathname);
     auto check = bxl->CreateAccess(__func__, event, report);
+    // The file the stream was open on is closed first (unless only the mode of the stream changes)
+    buildxl::linux::OutputCloseTracker::ReleasedOutput released;
+    bool lastWriter = pathname != nullptr && bxl->output_closes().Release(fileno(stream), released);
     FILE *f = bxl->check_fwd_and_report_freopen64(report, check, (FILE*)NULL, pathname, mode, stream);
-    if (f) { bxl->reset_fd_table_entry(fileno(f)); }
-    return f;
+    if (f && lastWriter) { bxl->report_output_closed(released); }
+    return ret_opened_stream(f, pathname, mode, bxl);
 })
 
 INTERPOSE(size_t, fread, void *ptr, size_t size, size_t nmemb, FILE *stream)({
@@ -756,7 +936,10 @@ INTERPOSE(size_t, fread, void *ptr, size_t size, size_t nmemb, FILE *stream)({
         /* error */         0,
         /* src_fd */        stream_fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_fread(report, check, (size_t)0, ptr, size, nmemb, stream);
+    uint64_t start = bxl->io_volumes().Start();
+    size_t result = bxl->check_fwd_and_report_fread(report, check, (size_t)0, ptr, size, nmemb, stream);
+    bxl->io_volumes().Add(stream_fd, buildxl::linux::IoVolumeTracker::kRead, (ssize_t)(result * size), start);
+    return result;
 })
 
 INTERPOSE(size_t, fwrite, const void *ptr, size_t size, size_t nmemb, FILE *stream)({
@@ -774,7 +957,10 @@ INTERPOSE(size_t, fwrite, const void *ptr, size_t size, size_t nmemb, FILE *stre
         /* error */         0,
         /* src_fd */        stream_fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_fwrite(report, check, (size_t)0, ptr, size, nmemb, stream);
+    uint64_t start = bxl->io_volumes().Start();
+    size_t result = bxl->check_fwd_and_report_fwrite(report, check, (size_t)0, ptr, size, nmemb, stream);
+    bxl->io_volumes().Add(stream_fd, buildxl::linux::IoVolumeTracker::kWrite, (ssize_t)(result * size), start);
+    return result;
 })
 
 INTERPOSE(int, fputc, int c, FILE *stream)({
@@ -879,9 +1065,9 @@ INTERPOSE(int, faccessat, int dirfd, const char *pathname, int mode, int flags)(
 // report "Create" if path does not exist and O_CREAT or O_TRUNC is specified
 // report "Write" if path exists and O_CREAT or O_TRUNC is specified (because this truncates the file regardless of its content)
 // otherwise, report "Read"
-static AccessCheckResult CreateFileOpen(BxlObserver *bxl, string &pathStr, int oflag, AccessReportGroup &report)
+static AccessCheckResult CreateFileOpen(BxlObserver *bxl, const char *path, int oflag, AccessReportGroup &report)
 {
-    mode_t pathMode = bxl->get_mode(pathStr.c_str());
+    mode_t pathMode = bxl->get_mode(path);
     bool pathExists = pathMode != 0;
     bool isCreate = !pathExists && (oflag & (O_CREAT|O_TRUNC));
     bool hasWriteAccess = ((oflag & O_ACCMODE) == O_WRONLY) || ((oflag & O_ACCMODE) == O_RDWR);
@@ -890,7 +1076,7 @@ static AccessCheckResult CreateFileOpen(BxlObserver *bxl, string &pathStr, int o
         /* event_type */    isCreate ? ES_EVENT_TYPE_NOTIFY_CREATE : isWrite ? ES_EVENT_TYPE_NOTIFY_WRITE : ES_EVENT_TYPE_NOTIFY_OPEN,
         /* pid */           getpid(),
         /* error */         0,
-        /* src_path */      pathStr.c_str());
+        /* src_path */      path);
     
     event.SetMode(pathMode);
 
@@ -909,10 +1095,11 @@ INTERPOSE(int, open, const char *path, int oflag, ...)({
     mode_t mode = va_arg(args, mode_t);
     va_end(args);
 
-    std::string pathStr = bxl->normalize_path(path);
+    char pathBuf[PATH_MAX];
+    bxl->normalize_path(path, pathBuf);
     AccessReportGroup report;
-    AccessCheckResult check = CreateFileOpen(bxl, pathStr, oflag, report);
-    return ret_fd(bxl->check_fwd_and_report_open(report, check, ERROR_RETURN_VALUE, path, oflag, mode), bxl);
+    AccessCheckResult check = CreateFileOpen(bxl, pathBuf, oflag, report);
+    return ret_opened_fd(bxl->check_fwd_and_report_open(report, check, ERROR_RETURN_VALUE, path, oflag, mode), pathBuf, oflag, bxl);
 })
 
 INTERPOSE(int, open64, const char *path, int oflag, ...)({
@@ -921,10 +1108,11 @@ INTERPOSE(int, open64, const char *path, int oflag, ...)({
     mode_t mode = va_arg(args, mode_t);
     va_end(args);
 
-    std::string pathStr = bxl->normalize_path(path);
+    char pathBuf[PATH_MAX];
+    bxl->normalize_path(path, pathBuf);
     AccessReportGroup report;
-    AccessCheckResult check = CreateFileOpen(bxl, pathStr, oflag, report);
-    return ret_fd(bxl->check_fwd_and_report_open64(report, check, ERROR_RETURN_VALUE, path, oflag, mode), bxl);
+    AccessCheckResult check = CreateFileOpen(bxl, pathBuf, oflag, report);
+    return ret_opened_fd(bxl->check_fwd_and_report_open64(report, check, ERROR_RETURN_VALUE, path, oflag, mode), pathBuf, oflag, bxl);
 })
 
 INTERPOSE(int, openat, int dirfd, const char *pathname, int flags, ...)({
@@ -933,10 +1121,11 @@ INTERPOSE(int, openat, int dirfd, const char *pathname, int flags, ...)({
     mode_t mode = va_arg(args, mode_t);
     va_end(args);
 
-    std::string pathStr = bxl->normalize_path_at(dirfd, pathname);
+    char pathBuf[PATH_MAX];
+    bxl->normalize_path_at(dirfd, pathname, pathBuf);
     AccessReportGroup report;
-    AccessCheckResult check = CreateFileOpen(bxl, pathStr, flags, report);
-    return ret_fd(bxl->check_fwd_and_report_openat(report, check, ERROR_RETURN_VALUE, dirfd, pathname, flags, mode), bxl);
+    AccessCheckResult check = CreateFileOpen(bxl, pathBuf, flags, report);
+    return ret_opened_fd(bxl->check_fwd_and_report_openat(report, check, ERROR_RETURN_VALUE, dirfd, pathname, flags, mode), pathBuf, flags, bxl);
 })
 
 INTERPOSE(int, openat64, int dirfd, const char *pathname, int flags, ...)({
@@ -945,16 +1134,62 @@ INTERPOSE(int, openat64, int dirfd, const char *pathname, int flags, ...)({
     mode_t mode = va_arg(args, mode_t);
     va_end(args);
 
-    std::string pathStr = bxl->normalize_path_at(dirfd, pathname);
+    char pathBuf[PATH_MAX];
+    bxl->normalize_path_at(dirfd, pathname, pathBuf);
     AccessReportGroup report;
-    AccessCheckResult check = CreateFileOpen(bxl, pathStr, flags, report);
-    return ret_fd(bxl->check_fwd_and_report_openat(report, check, ERROR_RETURN_VALUE, dirfd, pathname, flags, mode), bxl);
+    AccessCheckResult check = CreateFileOpen(bxl, pathBuf, flags, report);
+    return ret_opened_fd(bxl->check_fwd_and_report_openat(report, check, ERROR_RETURN_VALUE, dirfd, pathname, flags, mode), pathBuf, flags, bxl);
 })
 
 INTERPOSE(int, creat, const char *pathname, mode_t mode)({
     return open(pathname, O_CREAT | O_WRONLY | O_TRUNC, mode);
 })
 
+// Reads are not reported (the file was reported when it was opened): they are only interposed to account for the bytes
+// read when I/O accounting was requested. Otherwise they go straight to the real function before doing anything else, which
+// makes an interposed read as fast as a direct one (see TestReadOverhead in UnitTests/interposition_benchmark.cpp)
+#define FORWARD_UNLESS_ACCOUNTING_IO(name, ...)                     \
+    BxlObserver *observer = BxlObserver::GetInstance();             \
+    if (!observer->io_volumes().IsEnabled())                        \
+    {                                                               \
+        return observer->real_##name(__VA_ARGS__);                  \
+    }
+
+INTERPOSE_SOMETIMES(ssize_t, read, FORWARD_UNLESS_ACCOUNTING_IO(read, fd, buf, count), int fd, void *buf, size_t count)({
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->real_read(fd, buf, count);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    return result;
+})
+
+INTERPOSE_SOMETIMES(ssize_t, pread, FORWARD_UNLESS_ACCOUNTING_IO(pread, fd, buf, count, offset), int fd, void *buf, size_t count, off_t offset)({
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->real_pread(fd, buf, count, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    return result;
+})
+
+INTERPOSE_SOMETIMES(ssize_t, pread64, FORWARD_UNLESS_ACCOUNTING_IO(pread64, fd, buf, count, offset), int fd, void *buf, size_t count, off_t offset)({
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->real_pread64(fd, buf, count, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    return result;
+})
+
+INTERPOSE_SOMETIMES(ssize_t, readv, FORWARD_UNLESS_ACCOUNTING_IO(readv, fd, iov, iovcnt), int fd, const struct iovec *iov, int iovcnt)({
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->real_readv(fd, iov, iovcnt);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    return result;
+})
+
+INTERPOSE_SOMETIMES(ssize_t, preadv, FORWARD_UNLESS_ACCOUNTING_IO(preadv, fd, iov, iovcnt, offset), int fd, const struct iovec *iov, int iovcnt, off_t offset)({
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->real_preadv(fd, iov, iovcnt, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    return result;
+})
+
 INTERPOSE(ssize_t, write, int fd, const void *buf, size_t bufsiz)({
     AccessReportGroup report;
     auto event = buildxl::linux::SandboxEvent::FileDescriptorSandboxEvent(
@@ -963,7 +1198,11 @@ INTERPOSE(ssize_t, write, int fd, const void *buf, size_t bufsiz)({
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_write(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, bufsiz);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_write(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, bufsiz);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    bxl->output_hashes().Write(fd, buf, result);
+    return result;
 })
 
 INTERPOSE(ssize_t, pwrite, int fd, const void *buf, size_t count, off_t offset)({
@@ -974,7 +1213,11 @@ INTERPOSE(ssize_t, pwrite, int fd, const void *buf, size_t count, off_t offset)(
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_pwrite(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, count, offset);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_pwrite(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, count, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    bxl->output_hashes().PositionalWrite(fd, offset, buf, result);
+    return result;
 })
 
 INTERPOSE(ssize_t, writev, int fd, const struct iovec *iov, int iovcnt)({
@@ -985,7 +1228,11 @@ INTERPOSE(ssize_t, writev, int fd, const struct iovec *iov, int iovcnt)({
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_writev(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_writev(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    bxl->output_hashes().Writev(fd, iov, iovcnt, result);
+    return result;
 })
 
 INTERPOSE(ssize_t, pwritev, int fd, const struct iovec *iov, int iovcnt, off_t offset)({
@@ -996,7 +1243,11 @@ INTERPOSE(ssize_t, pwritev, int fd, const struct iovec *iov, int iovcnt, off_t o
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_pwritev(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt, offset);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_pwritev(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    bxl->output_hashes().PositionalWritev(fd, offset, iov, iovcnt, result);
+    return result;
 })
 
 INTERPOSE(ssize_t, pwritev2, int fd, const struct iovec *iov, int iovcnt, off_t offset, int flags)({
@@ -1007,7 +1258,12 @@ INTERPOSE(ssize_t, pwritev2, int fd, const struct iovec *iov, int iovcnt, off_t
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_pwritev2(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt, offset, flags);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_pwritev2(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, iov, iovcnt, offset, flags);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    // An offset of -1 means the current file offset, like writev
+    bxl->output_hashes().PositionalWritev(fd, offset, iov, iovcnt, result);
+    return result;
 })
 
 INTERPOSE(ssize_t, pwrite64, int fd, const void *buf, size_t count, off_t offset)({
@@ -1018,7 +1274,11 @@ INTERPOSE(ssize_t, pwrite64, int fd, const void *buf, size_t count, off_t offset
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_pwrite64(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, count, offset);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_pwrite64(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, buf, count, offset);
+    bxl->io_volumes().Add(fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    bxl->output_hashes().PositionalWrite(fd, offset, buf, result);
+    return result;
 })
 
 INTERPOSE(int, remove, const char *pathname)({
@@ -1041,6 +1301,7 @@ INTERPOSE(int, truncate, const char *path, off_t length)({
         /* error */         0,
         /* src_path */      path);
     auto check = bxl->CreateAccess(__func__, event, report);
+    bxl->output_hashes().InvalidatePath(path);
     return bxl->check_fwd_and_report_truncate(report, check, (ssize_t)ERROR_RETURN_VALUE, path, length);
 })
 
@@ -1052,6 +1313,7 @@ INTERPOSE(int, ftruncate, int fd, off_t length)({
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
+    bxl->output_hashes().Invalidate(fd);
     return bxl->check_fwd_and_report_ftruncate(report, check, (ssize_t)ERROR_RETURN_VALUE, fd, length);
 })
 
@@ -1110,7 +1372,7 @@ static AccessCheckResult handle_renameat(BxlObserver *bxl, int olddirfd, const c
                 // Access check for the destination file
                 fileOrDirectory.replace(0, oldStr.length(), newStr);
                 AccessReportGroup targetReport;
-                check = AccessCheckResult::Combine(check, CreateFileOpen(bxl, fileOrDirectory, O_CREAT | O_WRONLY, targetReport));
+                check = AccessCheckResult::Combine(check, CreateFileOpen(bxl, fileOrDirectory.c_str(), O_CREAT | O_WRONLY, targetReport));
                 accessesToReport.emplace_back(targetReport);
 
                 // If access is denied to any of the files in the enumeration, we can break the loop right away here because check_and_fwd_renameat will also fail
@@ -1146,7 +1408,7 @@ static AccessCheckResult handle_renameat(BxlObserver *bxl, int olddirfd, const c
         check = bxl->CreateAccess(__func__, event, sourceReport);
         accessesToReport.emplace_back(sourceReport);
         AccessReportGroup destReport;
-        check = AccessCheckResult::Combine(check, CreateFileOpen(bxl, newStr, O_CREAT | O_WRONLY, destReport));
+        check = AccessCheckResult::Combine(check, CreateFileOpen(bxl, newStr.c_str(), O_CREAT | O_WRONLY, destReport));
         accessesToReport.emplace_back(destReport);
     }
 
@@ -1336,68 +1598,18 @@ INTERPOSE(ssize_t, readlinkat, int fd, const char *path, char *buf, size_t bufsi
 INTERPOSE(char *, realpath, const char *path, char *resolved_path)({
     // realpath is a glibc wrapper around readlink, however glibc calls an internal readlink that 
     // is different from the wrapper we interpose, so it is necessary to interpose realpath directly,
-    // and we need to simulate and report any symlink resolutions that happen in the call. 
+    // and we need to report any symlink resolutions that happen in the call. 
     // It would be wrong to report a readlink on the full path or on intermediate paths
     // that are not actually symlinks, because the intention of the caller of 'realpath' 
     // is not to actually resolve a "known" symlink, but rather canonicalize a path that might or might
     // not contain intermediate symlinks (and the implementation of the function itself only calls readlink on actual symlinks).
     // So we should only report readlinks on the intermediate paths that actually end up being symlinks.
-    // We optimize by only doing this "realpath simulation" if the resolved path that is returned is different
-    // than the original path. 
+    // Instead of calling glibc and then walking the path again to find those symlinks, the sandbox computes the result itself
+    // and reports the symlinks (and a probe on the resulting path) as it goes.
     // NOTE: Since this isn't a write operation, it shouldn't be an issue that we can't block this call.
     // NOTE: There's no need for a corresponding interception in the PTrace sandbox, as this is not a syscall,
     //       (the function will call the readlink syscall which we do intercept).
-    char *result = bxl->fwd_realpath(path, resolved_path).restore();
-    
-    if (path == nullptr) 
-    {
-        // This should have failed, nothing to do here
-        return result;
-    }
-
-    // We should report a probe on the path passed to realpath:
-    // if the full path is a symlink, we will report a readlink in the logic below,
-    // but when it's not, we must count this as a probe because realpath will
-    // indicate to the caller if this path was absent or not. 
-    auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-        /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
-        /* pid */           getpid(),
-        /* error */         0,
-        /* src_path */      path);
-    event.SetRequiredPathResolution(buildxl::linux::RequiredPathResolution::kResolveNoFollow);
-    bxl->CreateAndReportAccess(__func__, event);
-
-    if (result == nullptr)
-    {
-        // realpath returned an error, but the original path is not null
-        // Let's try to report the intermediate symlinks anyway ourselves, because
-        // technically they could have been probed before any failure.
-        bxl->report_intermediate_symlinks(path, getpid());
-        return result;
-    }
-
-    // realpath succeeded. Let's report the intermediate symlinks if the result is
-    // different than the original path.
-    if (strcmp(path, result) != 0)
-    {
-        BXL_LOG_DEBUG(bxl, "[realpath] Resolving intermediate symlinks for '%s'", path);
-        bxl->report_intermediate_symlinks(path, getpid());
-
-        // Report a probe on the returned path, as the success of this function
-        // indicates to the caller that the path exists. 
-        auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
-            /* event_type */    ES_EVENT_TYPE_NOTIFY_STAT,
-            /* pid */           getpid(),
-            /* error */         0,
-            /* src_path */      result);
-        bxl->CreateAndReportAccess(__func__, event);
-    }
-    else
-    {
-        BXL_LOG_DEBUG(bxl, "[realpath] Skipping sandbox symlink resolution for path '%s'", path);
-    }
-
-    return result;
+    return bxl->realpath_and_report(path, resolved_path);
 })
 
 INTERPOSE(DIR*, opendir, const char *name)({
@@ -1581,6 +1793,7 @@ INTERPOSE(int, vdprintf, int fd, const char *fmt, va_list args)({
         /* error */         0,
         /* src_fd */        fd);
     auto check = bxl->CreateAccess(__func__, event, report);
+    bxl->output_hashes().Invalidate(fd);
     return bxl->fwd_and_report_vdprintf(report, -1, fd, fmt, args).restore();
 })
 
@@ -1723,7 +1936,13 @@ INTERPOSE(ssize_t, sendfile, int out_fd, int in_fd, off_t *offset, size_t count)
         /* error */         0,
         /* src_fd */        out_fd);
     auto check = bxl->CreateAccess(__func__, event, report);
-    return bxl->check_fwd_and_report_sendfile(report, check, (ssize_t)ERROR_RETURN_VALUE, out_fd, in_fd, offset, count);
+    bxl->output_hashes().Invalidate(out_fd);
+    uint64_t start = bxl->io_volumes().Start();
+    ssize_t result = bxl->check_fwd_and_report_sendfile(report, check, (ssize_t)ERROR_RETURN_VALUE, out_fd, in_fd, offset, count);
+    // Both files take part in the whole transfer, so the time counts for both
+    bxl->io_volumes().Add(in_fd, buildxl::linux::IoVolumeTracker::kRead, result, start);
+    bxl->io_volumes().Add(out_fd, buildxl::linux::IoVolumeTracker::kWrite, result, start);
+    return result;
 })
 
 INTERPOSE(ssize_t, sendfile64, int out_fd, int in_fd, off_t *offset, size_t count)({
@@ -1738,102 +1957,44 @@ INTERPOSE(ssize_t, copy_file_range, int fd_in, loff_t *off_in, int fd_out, loff_
         /* error */         0,
         /* src_fd */        fd_out);
     auto check = bxl->CreateAccess(__func__, event, report);
-    ssize_t result;
-    if (bxl->should_deny(check)) {
-        errno = EPERM;
-        result = (ssize_t)ERROR_RETURN_VALUE;
-        goto exit;
-    }
-
-    // TODO: Remove the following workaround when the kernel bug is fixed.
-    //
-    // Due to (possibly) kernel bug, copy_file_range does no longer work when the file descriptors are not mounted on the same
-    // filesystems, despite what is said in the manual https://man7.org/linux/man-pages/man2/copy_file_range.2.html.
-    // This bug breaks AnyBuild virtual filesystem (VFS) because the source file will be in the read-only (lower) layer of overlayfs, and this
-    // layer is mounted on AnyBuild FUSE, and the target file will be in the writable (upper) layer of overlayfs.
-    //
-    // In the commented code below, we try to check if the file descriptors are mounted on the same filesystem, and if so, we simply call
-    // copy_file_range. On the user space, the descriptors are mounted on the same filesystem. However, when copy_file_range is called,
-    // and the call goes into the kernel space, those descriptors are identified from different filesystems, and so the call will fail with EXDEV.
-    //
-    // ------------------------------------------------------------------------------------------
-    // struct stat st_in;
-    // if (fstat(fd_in, &st_in) == -1)
-    //     return (ssize_t)ERROR_RETURN_VALUE;
-    // struct stat st_out;
-    // if (fstat(fd_out, &st_out) == -1)
-    //     return (ssize_t)ERROR_RETURN_VALUE;
-    // errno = 0;
-    // if ((uintmax_t)major(st_in.st_dev) == (uintmax_t)major(st_out.st_dev)
-    //     && (uintmax_t)minor(st_in.st_dev) == (uintmax_t)minor(st_out.st_dev))
-    //     return bxl->fwd_copy_file_range(fd_in, off_in, fd_out, off_out, len, flags).restore();
-    // ------------------------------------------------------------------------------------------
-
-    // The code below implements copy_file_range using splice(2). The idea is the content is first
-    // copied to the pipe and then transferred to the target.
-
-    // Check for flags.
-    if (flags != 0) {
-        errno = EINVAL;
-        result = (ssize_t)ERROR_RETURN_VALUE;
-        goto exit;
-    }
-
-    // Check for overlapped range.
-    if (fd_in == fd_out) {
-        off64_t start_off_in = off_in == NULL ? lseek(fd_in, 0, SEEK_CUR) : *off_in;
-        off64_t end_off_in = start_off_in + len;
-        off64_t start_off_out = off_out == NULL ? lseek(fd_out, 0, SEEK_CUR) : *off_out;
-        off64_t end_off_out = start_off_out + len;
-        if ((start_off_in <= end_off_out && end_off_in >= start_off_out)
-            || (start_off_out <= end_off_in && end_off_out >= start_off_in)) {
-                errno = EINVAL;
-                result = (ssize_t)ERROR_RETURN_VALUE;
-                goto exit;
-            }
-    }
-
-    errno = 0;
-
-    // Creates a pipe.
-    int pipefd[2];
-    result = pipe(pipefd);
-    if (result < 0)
-        goto exit;
-
-    // Copy from input to pipe.
-    result = splice(fd_in, off_in, pipefd[1], NULL, len, 0);
-    if (result < 0)
-        goto exit;
-
-    // Copy from pipe to output.
-    result = splice(pipefd[0], NULL, fd_out, off_out, result, 0);
-
-exit:
-    close(pipefd[0]);
-    close(pipefd[1]);
-    report.SetErrno(result == -1? errno : 0);
+    bxl->output_hashes().Invalidate(fd_out);
+    uint64_t start = bxl->io_volumes().Start();
+
+    // The copy is not simply forwarded: copy_file_range may fail with EXDEV between file systems that look like the same one from
+    // user space (e.g., the layers of an overlayfs mounted on a FUSE file system), which the copy engine handles by falling back
+    // to splicing.
+    result_t<ssize_t> result = bxl->should_deny(check)
+        ? result_t<ssize_t>((ssize_t)ERROR_RETURN_VALUE, EPERM)
+        : result_t<ssize_t>(bxl->copy_engine().CopyFileRange(fd_in, off_in, fd_out, off_out, len, flags));
+
+    bxl->io_volumes().Add(fd_in, buildxl::linux::IoVolumeTracker::kRead, result.get(), start);
+    bxl->io_volumes().Add(fd_out, buildxl::linux::IoVolumeTracker::kWrite, result.get(), start);
+    report.SetErrno(result.get() == -1 ? result.get_errno() : 0);
     bxl->SendReport(report);
-    
-    return result;
+
+    return result.restore();
 })
 
 INTERPOSE(int, name_to_handle_at, int dirfd, const char *pathname, struct file_handle *handle, int *mount_id, int flags)({
     int oflags = (flags & AT_SYMLINK_FOLLOW) ? 0 : O_NOFOLLOW;
     string pathStr = bxl->normalize_path_at(dirfd, pathname, oflags);
     AccessReportGroup report;
-    auto check = CreateFileOpen(bxl, pathStr, oflags, report);
+    auto check = CreateFileOpen(bxl, pathStr.c_str(), oflags, report);
     return ret_fd(bxl->check_fwd_and_report_name_to_handle_at(report, check, ERROR_RETURN_VALUE, dirfd, pathname, handle, mount_id, flags), bxl);
 })
 
 INTERPOSE(int, close, int fd) ({ 
+    bxl->fold_io_volume(fd);
+    bxl->report_output_hash(fd);
     bxl->reset_fd_table_entry(fd);
-    return bxl->fwd_close(fd).restore();
+    return close_output_fd(fd, bxl, [&]() { return bxl->fwd_close(fd); }).restore();
 })
 
 INTERPOSE(int, fclose, FILE *f) ({
+    bxl->fold_io_volume(fileno(f));
     bxl->reset_fd_table_entry(fileno(f));
-    return bxl->fwd_fclose(f).restore();
+    // The content of the stream is only final once it was flushed by fclose
+    return close_output_fd(fileno(f), bxl, [&]() { return bxl->fwd_fclose(f); }).restore();
 })
 
 INTERPOSE(int, closedir, DIR *dirp) ({ 
@@ -1842,7 +2003,11 @@ INTERPOSE(int, closedir, DIR *dirp) ({
 })
 
 INTERPOSE(int, dup, int fd) ({ 
-    return ret_fd(bxl->real_dup(fd), bxl);    
+    // Writes through the duplicate would go unnoticed
+    bxl->output_hashes().Invalidate(fd);
+    int newfd = ret_fd(bxl->real_dup(fd), bxl);
+    bxl->output_closes().Duplicate(fd, newfd);
+    return newfd;
     // Sometimes useful (for debugging) to interpose without access checking:
     // return bxl->fwd_dup(fd).restore();     
 })
@@ -1851,8 +2016,25 @@ INTERPOSE(int, dup2, int oldfd, int newfd)({
     // If the file descriptor newfd was previously open, it is closed
     // before being reused; the close is performed silently, so we should reset the fd table.
     bxl->reset_fd_table_entry(newfd);
+    bxl->output_hashes().Invalidate(newfd);
+    bxl->output_hashes().Invalidate(oldfd);
+
+    if (oldfd == newfd)
+    {
+        return bxl->real_dup2(oldfd, newfd);
+    }
 
-    return bxl->real_dup2(oldfd, newfd); 
+    // newfd is silently closed first, which may close an output
+    bxl->fold_io_volume(newfd);
+    return close_output_fd(newfd, bxl, [&]() {
+        result_t<int> result(bxl->real_dup2(oldfd, newfd));
+        if (result.get() != -1)
+        {
+            bxl->output_closes().Duplicate(oldfd, newfd);
+        }
+
+        return result;
+    }).restore();
     // Sometimes useful (for debugging) to interpose without access checking:
     // return bxl->fwd_dup2(oldfd, newfd).restore();  
 })
@@ -1861,14 +2043,69 @@ INTERPOSE(int, dup3, int oldfd, int newfd, int flags)({
     // If the file descriptor newfd was previously open, it is closed
     // before being reused; the close is performed silently, so we should reset the fd table.
     bxl->reset_fd_table_entry(newfd);
+    bxl->output_hashes().Invalidate(newfd);
+    bxl->output_hashes().Invalidate(oldfd);
+
+    // newfd is silently closed first, which may close an output
+    bxl->fold_io_volume(newfd);
+    return close_output_fd(newfd, bxl, [&]() {
+        result_t<int> result(bxl->real_dup3(oldfd, newfd, flags));
+        if (result.get() != -1)
+        {
+            bxl->output_closes().Duplicate(oldfd, newfd);
+        }
 
-    return bxl->real_dup3(oldfd, newfd, flags); 
+        return result;
+    }).restore();
     // Sometimes useful (for debugging) to interpose without access checking:
     //return bxl->fwd_dup3(oldfd, newfd).restore();  
 })
 
+// mmap is not an access we report: it is only interposed so that outputs mapped for sharing stop being hashed as they are written
+// (writes through the mapping can't be seen). The sandbox maps some of its own files, possibly while holding its own locks,
+// so this bypasses the usual interposition (which may log) and goes straight to the system call.
+DLL_EXPORT void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    if (fd >= 0 && (flags & MAP_SHARED) != 0)
+    {
+        BxlObserver::GetInstance()->output_hashes().Invalidate(fd);
+    }
+
+    return (void *)syscall(SYS_mmap, addr, length, prot, flags, fd, offset);
+}
+
+DLL_EXPORT void *mmap64(void *addr, size_t length, int prot, int flags, int fd, off64_t offset)
+{
+    return mmap(addr, length, prot, flags, fd, offset);
+}
+
+// Not an interposed function: lets benchmarks running under the sandbox (see UnitTests/interposition_benchmark.cpp)
+// look at the access cache of their own process
+DLL_EXPORT void bxl_get_access_cache_statistics(uint64_t *lookups, uint64_t *hits, uint64_t *busy)
+{
+    BxlObserver::GetInstance()->GetCacheStatistics(*lookups, *hits, *busy);
+}
+
+// Not an interposed function: called by the audit module (libBxlAudit.so, see audit_module.cpp) for the libraries the dynamic
+// loader tried and mapped, which it opens without going through libc
+DLL_EXPORT void bxl_report_library_access(const char *path, int loaded)
+{
+    BxlObserver::GetInstance()->report_library_access(path, loaded != 0);
+}
+
+// Not an interposed function: called by the audit module when it could not keep every library access the loader made before
+// the sandbox was attached
+DLL_EXPORT void bxl_report_library_accesses_dropped(int count)
+{
+    BxlObserver::GetInstance()->report_library_accesses_dropped(count);
+}
+
 static void report_exit(int exitCode, void *args)
 {
+    BxlObserver::GetInstance()->report_outputs_closed_at_exit(/* flushStreams */ true);
+    BxlObserver::GetInstance()->report_io_volumes();
+    BxlObserver::GetInstance()->report_input_prefetch_statistics();
+    BxlObserver::GetInstance()->save_resolution_snapshot();
     BxlObserver::GetInstance()->SendExitReport();
 }
 
@@ -1880,6 +2117,10 @@ void __attribute__ ((constructor)) _bxl_linux_sandbox_init(void)
 
     BxlObserver::GetInstance()->Init();
 
+    // Processes forked by an interposed process are already in the process tree, this adds the root process
+    // (and any process created in a way we don't interpose)
+    BxlObserver::GetInstance()->RegisterInProcessTree();
+
     // report that a new process has been created 
     auto event = buildxl::linux::SandboxEvent::AbsolutePathSandboxEvent(
         /* event_type */    ES_EVENT_TYPE_NOTIFY_EXEC,
@@ -1889,6 +2130,12 @@ void __attribute__ ((constructor)) _bxl_linux_sandbox_init(void)
     
     BxlObserver::GetInstance()->CreateAndReportAccess("__init__", event, /* check_cache */ false);
     BxlObserver::GetInstance()->report_exec_args(getpid());
+
+    // The root process publishes the resolution snapshot before it gets a chance to start any child
+    BxlObserver::GetInstance()->load_resolution_snapshot();
+
+    // Warm up the inputs of the pip in the background while the tool starts up
+    BxlObserver::GetInstance()->start_input_prefetch();
 }
 
 // ==========================
@@ -1931,6 +2178,8 @@ INTERPOSE(int, fstatfs64, int fd, struct statfs64 *buf)({
 /* ============ old/obsolete/unavailable ==========================
 
 INTERPOSE(int, execveat, int dirfd, const char *pathname, char *const argv[], char *const envp[], int flags)({
+    bxl->prepare_for_exec();
+
     int oflags = (flags & AT_SYMLINK_NOFOLLOW) ? O_NOFOLLOW : 0;
     string exe_path = bxl->normalize_path_at(dirfd, pathname, oflags);
     // ... report exec
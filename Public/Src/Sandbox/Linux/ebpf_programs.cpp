@@ -0,0 +1,467 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "ebpf_programs.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace buildxl {
+namespace linux {
+
+// probe_read_user_str is only available to GPL compatible programs
+static const char kLicense[] = "Dual MIT/GPL";
+
+// Registers of the eBPF calling convention: r0 is the return value, r1-r5 the arguments (clobbered by calls), r6-r9 are preserved
+// by calls and r10 is the read-only frame pointer
+enum {
+    R0 = 0, R1, R2, R3, R4, R5, R6, R7, R8, R9, R10
+};
+
+// Offsets of the records, as seen by the programs
+static const int16_t kKindOffset = offsetof(EbpfRecord, kind);
+static const int16_t kReservedOffset = offsetof(EbpfRecord, reserved);
+static const int16_t kPidTgidOffset = offsetof(EbpfRecord, pid_tgid);
+static const int16_t kSyscallOffset = offsetof(EbpfRecord, syscall);
+static const int16_t kValueOffset = offsetof(EbpfRecord, value);
+static const int16_t kArgsOffset = offsetof(EbpfSyscallEntry, args);
+static const int16_t kPathOffset = offsetof(EbpfSyscallEntry, path);
+static const int16_t kSecondPathOffset = offsetof(EbpfSyscallEntry, second_path);
+
+bool ParseTracepointField(const std::string &format, const char *name, TracepointField &field) {
+    size_t line = 0;
+    while (line < format.size()) {
+        size_t lineEnd = format.find('\n', line);
+        if (lineEnd == std::string::npos) {
+            lineEnd = format.size();
+        }
+
+        // e.g., "\tfield:unsigned long args[6];\toffset:16;\tsize:48;\tsigned:0;"
+        size_t declaration = format.find("field:", line);
+        if (declaration != std::string::npos && declaration < lineEnd) {
+            declaration += strlen("field:");
+            size_t declarationEnd = format.find(';', declaration);
+            if (declarationEnd != std::string::npos && declarationEnd < lineEnd) {
+                // The name is the last identifier of the declaration, before any array size
+                size_t nameEnd = format.find('[', declaration);
+                if (nameEnd == std::string::npos || nameEnd > declarationEnd) {
+                    nameEnd = declarationEnd;
+                }
+
+                size_t nameStart = format.find_last_of(" \t*", nameEnd - 1);
+                nameStart = nameStart == std::string::npos || nameStart < declaration ? declaration : nameStart + 1;
+
+                size_t offset = format.find("offset:", declarationEnd);
+                size_t size = format.find("size:", declarationEnd);
+                if (format.compare(nameStart, nameEnd - nameStart, name) == 0
+                    && offset != std::string::npos && offset < lineEnd
+                    && size != std::string::npos && size < lineEnd) {
+                    field.offset = (uint32_t)strtoul(format.c_str() + offset + strlen("offset:"), nullptr, 10);
+                    field.size = (uint32_t)strtoul(format.c_str() + size + strlen("size:"), nullptr, 10);
+                    return true;
+                }
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+
+    return false;
+}
+
+long ParseTracepointId(const std::string &format) {
+    size_t id = format.find("ID:");
+    if (id == std::string::npos) {
+        return -1;
+    }
+
+    char *end;
+    long value = strtol(format.c_str() + id + strlen("ID:"), &end, 10);
+    return end == format.c_str() + id + strlen("ID:") ? -1 : value;
+}
+
+bool EbpfAssembler::Finish(std::vector<struct bpf_insn> &program) const {
+    program = instructions_;
+    for (const auto &jump : jumps_) {
+        auto label = labels_.find(jump.second);
+        if (label == labels_.end()) {
+            return false;
+        }
+
+        // Jumps are relative to the next instruction
+        program[jump.first].off = (int16_t)((long)label->second - (long)jump.first - 1);
+    }
+
+    return true;
+}
+
+static std::vector<struct bpf_insn> Finish(const EbpfAssembler &assembler) {
+    std::vector<struct bpf_insn> program;
+    if (!assembler.Finish(program)) {
+        program.clear();
+    }
+
+    return program;
+}
+
+// r7 = bpf_get_current_pid_tgid(), and jumps to 'out' unless the current thread is in the tree. Leaves the thread id at r10 - 4.
+static void EmitTreeFilter(EbpfAssembler &assembler, const EbpfMaps &maps, const char *out) {
+    assembler.Call(BPF_FUNC_get_current_pid_tgid);
+    assembler.MovReg(R7, R0);
+    assembler.Store(BPF_W, R10, -4, R7);
+    assembler.LoadMapFd(R1, maps.tree);
+    assembler.MovReg(R2, R10);
+    assembler.AddImm(R2, -4);
+    assembler.Call(BPF_FUNC_map_lookup_elem);
+    assembler.JumpIfImm(BPF_JEQ, R0, 0, out);
+}
+
+// r9 = configuration of the syscall at 'idOffset' of the context at r6, and jumps to 'out' unless it is traced. Leaves the syscall
+// number at r10 - 8.
+static void EmitSyscallFilter(EbpfAssembler &assembler, const EbpfMaps &maps, uint32_t idOffset, const char *out) {
+    assembler.Load(BPF_DW, R1, R6, (int16_t)idOffset);
+    assembler.JumpIfImm(BPF_JGT, R1, kEbpfMaxSyscalls - 1, out);
+    assembler.Store(BPF_W, R10, -8, R1);
+    assembler.LoadMapFd(R1, maps.syscalls);
+    assembler.MovReg(R2, R10);
+    assembler.AddImm(R2, -8);
+    assembler.Call(BPF_FUNC_map_lookup_elem);
+    assembler.JumpIfImm(BPF_JEQ, R0, 0, out);
+    assembler.Load(BPF_W, R9, R0, 0);
+    assembler.MovReg(R1, R9);
+    assembler.RshImm(R1, 31);
+    assembler.JumpIfImm(BPF_JEQ, R1, 0, out);
+}
+
+// r8 = a record of 'size' bytes reserved in the ring buffer, with its header filled. Counts a drop and jumps to 'out' if the ring
+// buffer is full.
+static void EmitReserve(EbpfAssembler &assembler, const EbpfMaps &maps, uint32_t size, EbpfRecordKind kind, const std::string &out) {
+    std::string reserved = out + "_reserved_" + std::to_string(size);
+    assembler.LoadMapFd(R1, maps.events);
+    assembler.MovImm(R2, (int32_t)size);
+    assembler.MovImm(R3, 0);
+    assembler.Call(BPF_FUNC_ringbuf_reserve);
+    assembler.JumpIfImm(BPF_JNE, R0, 0, reserved);
+
+    assembler.StoreImm(BPF_W, R10, -12, 0);
+    assembler.LoadMapFd(R1, maps.drops);
+    assembler.MovReg(R2, R10);
+    assembler.AddImm(R2, -12);
+    assembler.Call(BPF_FUNC_map_lookup_elem);
+    assembler.JumpIfImm(BPF_JEQ, R0, 0, out);
+    assembler.MovImm(R1, 1);
+    assembler.AtomicAdd(BPF_DW, R0, 0, R1);
+    assembler.Jump(out);
+
+    assembler.Bind(reserved);
+    assembler.MovReg(R8, R0);
+    assembler.StoreImm(BPF_W, R8, kKindOffset, kind);
+    assembler.StoreImm(BPF_W, R8, kReservedOffset, 0);
+    assembler.Store(BPF_DW, R8, kPidTgidOffset, R7);
+    assembler.StoreImm(BPF_DW, R8, kSyscallOffset, -1);
+    assembler.StoreImm(BPF_DW, R8, kValueOffset, 0);
+}
+
+static void EmitSubmit(EbpfAssembler &assembler) {
+    assembler.MovReg(R1, R8);
+    assembler.MovImm(R2, 0);
+    assembler.Call(BPF_FUNC_ringbuf_submit);
+}
+
+// Copies the path the syscall argument selected by 'shift' of the configuration at r9 points to, to 'pathOffset' of the record at r8
+static void EmitReadPath(EbpfAssembler &assembler, int shift, int16_t pathOffset, const std::string &prefix) {
+    assembler.StoreImm(BPF_B, R8, pathOffset, 0);
+    assembler.MovReg(R1, R9);
+    assembler.RshImm(R1, shift);
+    assembler.AndImm(R1, 0xf);
+
+    // The verifier needs every argument offset to be a constant
+    for (int arg = 1; arg <= 6; arg++) {
+        assembler.JumpIfImm(BPF_JEQ, R1, arg, prefix + std::to_string(arg));
+    }
+
+    assembler.Jump(prefix + "done");
+    for (int arg = 1; arg <= 6; arg++) {
+        assembler.Bind(prefix + std::to_string(arg));
+        assembler.Load(BPF_DW, R3, R8, (int16_t)(kArgsOffset + 8 * (arg - 1)));
+        assembler.Jump(prefix + "read");
+    }
+
+    assembler.Bind(prefix + "read");
+    assembler.MovReg(R1, R8);
+    assembler.AddImm(R1, pathOffset);
+    assembler.MovImm(R2, kEbpfMaxPath);
+    assembler.Call(BPF_FUNC_probe_read_user_str);
+    assembler.Bind(prefix + "done");
+}
+
+// Writes the entry of the syscall at r6 (context) and r9 (configuration), with or without its paths
+static void EmitSyscallEntry(EbpfAssembler &assembler, const EbpfTracepointLayout &layout, const EbpfMaps &maps, bool withPaths) {
+    EmitReserve(assembler, maps, withPaths ? sizeof(EbpfSyscallEntry) : kEbpfSyscallEntryWithoutPathsSize, kEbpfSyscallEnter, "out");
+    assembler.Load(BPF_W, R1, R10, -8);
+    assembler.Store(BPF_DW, R8, kSyscallOffset, R1);
+    for (int arg = 0; arg < 6; arg++) {
+        assembler.Load(BPF_DW, R1, R6, (int16_t)(layout.enter_args + 8 * arg));
+        assembler.Store(BPF_DW, R8, (int16_t)(kArgsOffset + 8 * arg), R1);
+    }
+
+    if (withPaths) {
+        EmitReadPath(assembler, 0, kPathOffset, "path_");
+        EmitReadPath(assembler, 4, kSecondPathOffset, "second_path_");
+    }
+
+    EmitSubmit(assembler);
+    assembler.Jump("out");
+}
+
+std::vector<struct bpf_insn> BuildSyscallEnterProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps) {
+    EbpfAssembler assembler;
+    assembler.MovReg(R6, R1);
+    EmitTreeFilter(assembler, maps, "out");
+    EmitSyscallFilter(assembler, maps, layout.enter_id, "out");
+
+    // The size of a record must be known by the verifier, so syscalls with and without paths take different branches
+    assembler.MovReg(R1, R9);
+    assembler.AndImm(R1, 0xff);
+    assembler.JumpIfImm(BPF_JEQ, R1, 0, "without_paths");
+    EmitSyscallEntry(assembler, layout, maps, /* withPaths */ true);
+    assembler.Bind("without_paths");
+    EmitSyscallEntry(assembler, layout, maps, /* withPaths */ false);
+
+    assembler.Bind("out");
+    assembler.MovImm(R0, 0);
+    assembler.Exit();
+    return Finish(assembler);
+}
+
+std::vector<struct bpf_insn> BuildSyscallExitProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps) {
+    EbpfAssembler assembler;
+    assembler.MovReg(R6, R1);
+    EmitTreeFilter(assembler, maps, "out");
+    EmitSyscallFilter(assembler, maps, layout.exit_id, "out");
+
+    EmitReserve(assembler, maps, sizeof(EbpfRecord), kEbpfSyscallExit, "out");
+    assembler.Load(BPF_W, R1, R10, -8);
+    assembler.Store(BPF_DW, R8, kSyscallOffset, R1);
+    assembler.Load(BPF_DW, R1, R6, (int16_t)layout.exit_ret);
+    assembler.Store(BPF_DW, R8, kValueOffset, R1);
+    EmitSubmit(assembler);
+
+    assembler.Bind("out");
+    assembler.MovImm(R0, 0);
+    assembler.Exit();
+    return Finish(assembler);
+}
+
+std::vector<struct bpf_insn> BuildProcessForkProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps) {
+    // The tracepoint fires in the context of the parent, for new processes and new threads alike
+    EbpfAssembler assembler;
+    assembler.MovReg(R6, R1);
+    EmitTreeFilter(assembler, maps, "out");
+
+    // tree[child] = parent
+    assembler.Load(BPF_W, R9, R6, (int16_t)layout.fork_child_pid);
+    assembler.Store(BPF_W, R10, -8, R9);
+    assembler.LoadMapFd(R1, maps.tree);
+    assembler.MovReg(R2, R10);
+    assembler.AddImm(R2, -8);
+    assembler.MovReg(R3, R10);
+    assembler.AddImm(R3, -4);
+    assembler.MovImm(R4, BPF_ANY);
+    assembler.Call(BPF_FUNC_map_update_elem);
+
+    EmitReserve(assembler, maps, sizeof(EbpfRecord), kEbpfFork, "out");
+    assembler.Store(BPF_DW, R8, kValueOffset, R9);
+    EmitSubmit(assembler);
+
+    assembler.Bind("out");
+    assembler.MovImm(R0, 0);
+    assembler.Exit();
+    return Finish(assembler);
+}
+
+std::vector<struct bpf_insn> BuildProcessExitProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps) {
+    // The tracepoint fires in the context of the thread that exits
+    EbpfAssembler assembler;
+    assembler.MovReg(R6, R1);
+    EmitTreeFilter(assembler, maps, "out");
+
+    assembler.LoadMapFd(R1, maps.tree);
+    assembler.MovReg(R2, R10);
+    assembler.AddImm(R2, -4);
+    assembler.Call(BPF_FUNC_map_delete_elem);
+
+    EmitReserve(assembler, maps, sizeof(EbpfRecord), kEbpfExit, "out");
+    assembler.Load(BPF_W, R1, R10, -4);
+    assembler.Store(BPF_DW, R8, kValueOffset, R1);
+    EmitSubmit(assembler);
+
+    assembler.Bind("out");
+    assembler.MovImm(R0, 0);
+    assembler.Exit();
+    return Finish(assembler);
+}
+
+static long Bpf(int command, union bpf_attr *attributes) {
+    return syscall(__NR_bpf, command, attributes, sizeof(*attributes));
+}
+
+int CreateEbpfMap(uint32_t type, uint32_t keySize, uint32_t valueSize, uint32_t maxEntries) {
+    union bpf_attr attributes = {};
+    attributes.map_type = type;
+    attributes.key_size = keySize;
+    attributes.value_size = valueSize;
+    attributes.max_entries = maxEntries;
+    attributes.map_flags = 0;
+    return (int)Bpf(BPF_MAP_CREATE, &attributes);
+}
+
+int LoadEbpfProgram(const std::vector<struct bpf_insn> &program, std::string *log) {
+    if (program.empty()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    union bpf_attr attributes = {};
+    attributes.prog_type = BPF_PROG_TYPE_TRACEPOINT;
+    attributes.insns = (uint64_t)(uintptr_t)program.data();
+    attributes.insn_cnt = (uint32_t)program.size();
+    attributes.license = (uint64_t)(uintptr_t)kLicense;
+    int fd = (int)Bpf(BPF_PROG_LOAD, &attributes);
+    if (fd >= 0 || log == nullptr) {
+        return fd;
+    }
+
+    // Load it again to get the reason it was rejected
+    int error = errno;
+    std::string buffer(1024 * 1024, '\0');
+    attributes.log_level = 1;
+    attributes.log_buf = (uint64_t)(uintptr_t)&buffer[0];
+    attributes.log_size = (uint32_t)buffer.size();
+    fd = (int)Bpf(BPF_PROG_LOAD, &attributes);
+    if (fd >= 0) {
+        return fd;
+    }
+
+    log->assign(buffer.c_str());
+    errno = error;
+    return -1;
+}
+
+int UpdateEbpfMap(int mapFd, const void *key, const void *value) {
+    union bpf_attr attributes = {};
+    attributes.map_fd = mapFd;
+    attributes.key = (uint64_t)(uintptr_t)key;
+    attributes.value = (uint64_t)(uintptr_t)value;
+    attributes.flags = BPF_ANY;
+    return (int)Bpf(BPF_MAP_UPDATE_ELEM, &attributes);
+}
+
+int LookupEbpfMap(int mapFd, const void *key, void *value) {
+    union bpf_attr attributes = {};
+    attributes.map_fd = mapFd;
+    attributes.key = (uint64_t)(uintptr_t)key;
+    attributes.value = (uint64_t)(uintptr_t)value;
+    return (int)Bpf(BPF_MAP_LOOKUP_ELEM, &attributes);
+}
+
+std::string ReadTracepointFormat(const std::string &tracefs, const char *category, const char *name) {
+    std::string path = tracefs + "/events/" + category + "/" + name + "/format";
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::string();
+    }
+
+    std::string format;
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        format.append(buffer, length);
+    }
+
+    close(fd);
+    return format;
+}
+
+std::string FindTracefs() {
+    for (const char *tracefs : { "/sys/kernel/tracing", "/sys/kernel/debug/tracing" }) {
+        std::string events = std::string(tracefs) + "/events";
+        if (access(events.c_str(), R_OK) == 0) {
+            return tracefs;
+        }
+    }
+
+    return std::string();
+}
+
+int AttachEbpfProgram(const std::string &tracefs, const char *category, const char *name, int programFd) {
+    long id = ParseTracepointId(ReadTracepointFormat(tracefs, category, name));
+    if (id < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    struct perf_event_attr attributes = {};
+    attributes.type = PERF_TYPE_TRACEPOINT;
+    attributes.size = sizeof(attributes);
+    attributes.config = (uint64_t)id;
+    attributes.sample_period = 1;
+    attributes.wakeup_events = 1;
+
+    // Programs attached to a tracepoint run on every CPU, whichever CPU the perf event is opened on
+    int perfFd = (int)syscall(__NR_perf_event_open, &attributes, /* pid */ -1, /* cpu */ 0, /* group_fd */ -1, PERF_FLAG_FD_CLOEXEC);
+    if (perfFd < 0) {
+        return -1;
+    }
+
+    if (ioctl(perfFd, PERF_EVENT_IOC_SET_BPF, programFd) != 0 || ioctl(perfFd, PERF_EVENT_IOC_ENABLE, 0) != 0) {
+        int error = errno;
+        close(perfFd);
+        errno = error;
+        return -1;
+    }
+
+    return perfFd;
+}
+
+EbpfRingBuffer::~EbpfRingBuffer() {
+    if (consumer_pos_ != nullptr) {
+        munmap(consumer_pos_, page_size_);
+    }
+
+    if (producer_pos_ != nullptr) {
+        munmap(producer_pos_, page_size_ + 2 * size_);
+    }
+}
+
+bool EbpfRingBuffer::Initialize(int mapFd, size_t size) {
+    page_size_ = (size_t)sysconf(_SC_PAGESIZE);
+    size_ = size;
+
+    // The consumer position is the only page user space writes to
+    void *consumer = mmap(nullptr, page_size_, PROT_READ | PROT_WRITE, MAP_SHARED, mapFd, 0);
+    if (consumer == MAP_FAILED) {
+        return false;
+    }
+
+    void *producer = mmap(nullptr, page_size_ + 2 * size_, PROT_READ, MAP_SHARED, mapFd, (off_t)page_size_);
+    if (producer == MAP_FAILED) {
+        munmap(consumer, page_size_);
+        return false;
+    }
+
+    consumer_pos_ = (uint64_t *)consumer;
+    producer_pos_ = (uint64_t *)producer;
+    data_ = (const char *)producer + page_size_;
+    return true;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,259 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_EBPF_PROGRAMS_H
+#define BUILDXL_SANDBOX_LINUX_EBPF_PROGRAMS_H
+
+#include <linux/bpf.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace buildxl {
+namespace linux {
+
+// Longest path copied out of a process (PATH_MAX)
+static const size_t kEbpfMaxPath = 4096;
+
+// Syscall numbers above this are never traced
+static const uint32_t kEbpfMaxSyscalls = 512;
+
+typedef enum EbpfRecordKind {
+    // A traced syscall was made: an EbpfSyscallEntry
+    kEbpfSyscallEnter = 1,
+    // A traced syscall returned: 'value' is what it returned
+    kEbpfSyscallExit = 2,
+    // A process (or thread) of the tree created another one: 'value' is its pid
+    kEbpfFork = 3,
+    // A process (or thread) of the tree exited: 'value' is its pid
+    kEbpfExit = 4
+} EbpfRecordKind;
+
+/**
+ * Every record the programs write to the ring buffer starts with this.
+ */
+typedef struct EbpfRecord {
+    uint32_t kind;
+    uint32_t reserved;
+    // bpf_get_current_pid_tgid: the thread group (i.e., process) id in the upper 32 bits, the thread id in the lower ones
+    uint64_t pid_tgid;
+    int64_t syscall;
+    int64_t value;
+} EbpfRecord;
+
+typedef struct EbpfSyscallEntry {
+    EbpfRecord record;
+    uint64_t args[6];
+    char path[kEbpfMaxPath];
+    char second_path[kEbpfMaxPath];
+} EbpfSyscallEntry;
+
+// Entries of syscalls without a path argument stop after the arguments
+static const size_t kEbpfSyscallEntryWithoutPathsSize = offsetof(EbpfSyscallEntry, path);
+
+/**
+ * What the programs do with a syscall (the value of the syscalls map): whether it is traced, and which of its arguments (1-based)
+ * are paths to copy out of the process.
+ */
+constexpr uint32_t EncodeEbpfSyscall(int pathArg, int secondPathArg) {
+    return 0x80000000u | (uint32_t)pathArg | ((uint32_t)secondPathArg << 4);
+}
+
+/**
+ * A field of a tracepoint, as described by its format file in tracefs.
+ */
+typedef struct TracepointField {
+    uint32_t offset;
+    uint32_t size;
+} TracepointField;
+
+/**
+ * Finds a field in the content of a tracepoint format file. Tracepoint layouts change between kernel versions (e.g., the command
+ * names of sched_process_fork), so the programs are built with the offsets of the running kernel.
+ */
+bool ParseTracepointField(const std::string &format, const char *name, TracepointField &field);
+
+/**
+ * The id of a tracepoint in the content of its format file, or -1.
+ */
+long ParseTracepointId(const std::string &format);
+
+/**
+ * Builds eBPF programs one instruction at a time, with named labels as jump targets.
+ */
+class EbpfAssembler {
+public:
+    void Emit(struct bpf_insn instruction) { instructions_.push_back(instruction); }
+
+    void MovImm(int dst, int32_t imm) { Emit(Instruction(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm)); }
+    void MovReg(int dst, int src) { Emit(Instruction(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0)); }
+    void AddImm(int dst, int32_t imm) { Emit(Instruction(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm)); }
+    void AndImm(int dst, int32_t imm) { Emit(Instruction(BPF_ALU64 | BPF_AND | BPF_K, dst, 0, 0, imm)); }
+    void RshImm(int dst, int32_t imm) { Emit(Instruction(BPF_ALU64 | BPF_RSH | BPF_K, dst, 0, 0, imm)); }
+
+    // size is BPF_B, BPF_H, BPF_W or BPF_DW
+    void Load(int size, int dst, int src, int16_t off) { Emit(Instruction(BPF_LDX | BPF_MEM | size, dst, src, off, 0)); }
+    void Store(int size, int dst, int16_t off, int src) { Emit(Instruction(BPF_STX | BPF_MEM | size, dst, src, off, 0)); }
+    void StoreImm(int size, int dst, int16_t off, int32_t imm) { Emit(Instruction(BPF_ST | BPF_MEM | size, dst, 0, off, imm)); }
+    void AtomicAdd(int size, int dst, int16_t off, int src) { Emit(Instruction(BPF_STX | BPF_XADD | size, dst, src, off, 0)); }
+
+    void LoadMapFd(int dst, int mapFd) {
+        Emit(Instruction(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, mapFd));
+        Emit(Instruction(0, 0, 0, 0, 0));
+    }
+
+    void Call(int helper) { Emit(Instruction(BPF_JMP | BPF_CALL, 0, 0, 0, helper)); }
+    void Exit() { Emit(Instruction(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)); }
+
+    void Jump(const std::string &label) { JumpTo(BPF_JMP | BPF_JA, 0, 0, label); }
+    // op is a BPF_JMP operation (e.g., BPF_JEQ) comparing a register with an immediate
+    void JumpIfImm(int op, int reg, int32_t imm, const std::string &label) { JumpTo(BPF_JMP | op | BPF_K, reg, imm, label); }
+
+    void Bind(const std::string &label) { labels_[label] = instructions_.size(); }
+
+    /**
+     * Resolves the jumps. Returns false if a jump targets a label that was never bound.
+     */
+    bool Finish(std::vector<struct bpf_insn> &program) const;
+
+private:
+    static struct bpf_insn Instruction(uint8_t code, int dst, int src, int16_t off, int32_t imm) {
+        struct bpf_insn instruction = {};
+        instruction.code = code;
+        instruction.dst_reg = dst;
+        instruction.src_reg = src;
+        instruction.off = off;
+        instruction.imm = imm;
+        return instruction;
+    }
+
+    void JumpTo(uint8_t code, int reg, int32_t imm, const std::string &label) {
+        jumps_.emplace_back(instructions_.size(), label);
+        Emit(Instruction(code, reg, 0, 0, imm));
+    }
+
+    std::vector<struct bpf_insn> instructions_;
+    std::unordered_map<std::string, size_t> labels_;
+    // Jump instruction -> label it targets
+    std::vector<std::pair<size_t, std::string>> jumps_;
+};
+
+/**
+ * Where the programs find what they need in their tracepoint contexts (see ParseTracepointField).
+ */
+typedef struct EbpfTracepointLayout {
+    // raw_syscalls/sys_enter
+    uint32_t enter_id;
+    uint32_t enter_args;
+    // raw_syscalls/sys_exit
+    uint32_t exit_id;
+    uint32_t exit_ret;
+    // sched/sched_process_fork
+    uint32_t fork_child_pid;
+} EbpfTracepointLayout;
+
+typedef struct EbpfMaps {
+    // Hash of the pids of the process tree (threads included)
+    int tree;
+    // Array of EncodeEbpfSyscall values, indexed by syscall number
+    int syscalls;
+    // Ring buffer of records
+    int events;
+    // Array with a single counter of the records that were dropped because the ring buffer was full
+    int drops;
+} EbpfMaps;
+
+/**
+ * The programs, each meant to be attached to its tracepoint. They only write records for the processes in the tree map.
+ */
+std::vector<struct bpf_insn> BuildSyscallEnterProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps);
+std::vector<struct bpf_insn> BuildSyscallExitProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps);
+std::vector<struct bpf_insn> BuildProcessForkProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps);
+std::vector<struct bpf_insn> BuildProcessExitProgram(const EbpfTracepointLayout &layout, const EbpfMaps &maps);
+
+/**
+ * Thin wrappers around the bpf syscall. They return -1 and set errno on failure. 'log', if given, receives the verifier log of a
+ * program that was rejected.
+ */
+int CreateEbpfMap(uint32_t type, uint32_t keySize, uint32_t valueSize, uint32_t maxEntries);
+int LoadEbpfProgram(const std::vector<struct bpf_insn> &program, std::string *log = nullptr);
+int UpdateEbpfMap(int mapFd, const void *key, const void *value);
+int LookupEbpfMap(int mapFd, const void *key, void *value);
+
+/**
+ * Attaches a program to a tracepoint (e.g., "raw_syscalls", "sys_enter"). Returns the perf event that keeps it attached.
+ */
+int AttachEbpfProgram(const std::string &tracefs, const char *category, const char *name, int programFd);
+
+/**
+ * Reads the content of a tracepoint format file. Returns an empty string if the tracepoint doesn't exist.
+ */
+std::string ReadTracepointFormat(const std::string &tracefs, const char *category, const char *name);
+
+/**
+ * The mount point of tracefs, or an empty string if it is not mounted.
+ */
+std::string FindTracefs();
+
+/**
+ * Consumes the records of a BPF_MAP_TYPE_RINGBUF map, which is mapped in the address space of this process.
+ */
+class EbpfRingBuffer {
+public:
+    EbpfRingBuffer() = default;
+    EbpfRingBuffer(const EbpfRingBuffer&) = delete;
+    EbpfRingBuffer& operator = (const EbpfRingBuffer&) = delete;
+    ~EbpfRingBuffer();
+
+    /**
+     * Maps the ring buffer. 'size' is the max_entries the map was created with.
+     */
+    bool Initialize(int mapFd, size_t size);
+
+    /**
+     * Calls 'callback(data, length)' for each record submitted so far, in the order they were reserved. Returns the number of records.
+     */
+    template <typename Callback>
+    size_t Consume(Callback callback) {
+        size_t consumed = 0;
+        uint64_t consumer = __atomic_load_n(consumer_pos_, __ATOMIC_ACQUIRE);
+        uint64_t producer = __atomic_load_n(producer_pos_, __ATOMIC_ACQUIRE);
+        while (consumer < producer) {
+            const uint32_t *header = (const uint32_t *)(data_ + (consumer & (size_ - 1)));
+            uint32_t length = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+            if (length & BPF_RINGBUF_BUSY_BIT) {
+                // Still being written: the producer signals the ring buffer once it is submitted
+                break;
+            }
+
+            bool discarded = (length & BPF_RINGBUF_DISCARD_BIT) != 0;
+            length &= ~(BPF_RINGBUF_BUSY_BIT | BPF_RINGBUF_DISCARD_BIT);
+            if (!discarded) {
+                callback((const char *)header + BPF_RINGBUF_HDR_SZ, (size_t)length);
+                consumed++;
+            }
+
+            consumer += (length + BPF_RINGBUF_HDR_SZ + 7) & ~7ull;
+            __atomic_store_n(consumer_pos_, consumer, __ATOMIC_RELEASE);
+            producer = __atomic_load_n(producer_pos_, __ATOMIC_ACQUIRE);
+        }
+
+        return consumed;
+    }
+
+private:
+    size_t size_ = 0;
+    size_t page_size_ = 0;
+    uint64_t *consumer_pos_ = nullptr;
+    uint64_t *producer_pos_ = nullptr;
+    // The data pages are mapped twice in a row, so a record that wraps around is contiguous
+    const char *data_ = nullptr;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_EBPF_PROGRAMS_H
@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "fanotify_events.hpp"
+
+#include <fcntl.h>
+#include <linux/fanotify.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Older headers don't have the FAN_RENAME records
+#ifndef FAN_EVENT_INFO_TYPE_OLD_DFID_NAME
+#define FAN_EVENT_INFO_TYPE_OLD_DFID_NAME 10
+#endif
+#ifndef FAN_EVENT_INFO_TYPE_NEW_DFID_NAME
+#define FAN_EVENT_INFO_TYPE_NEW_DFID_NAME 12
+#endif
+
+namespace buildxl {
+namespace linux {
+
+// struct file_handle: a 32-bit size of the handle bytes and a 32-bit type, followed by the handle bytes
+static const size_t kFileHandleHeaderSize = 2 * sizeof(uint32_t);
+
+// Parses a DFID_NAME-like info record. Returns false if it is malformed.
+static bool ParseName(const char *record, size_t length, FanotifyName &name) {
+    const size_t fixed = sizeof(struct fanotify_event_info_fid);
+    if (length < fixed + kFileHandleHeaderSize) {
+        return false;
+    }
+
+    const struct fanotify_event_info_fid *fid = (const struct fanotify_event_info_fid *)record;
+    memcpy(&name.fsid, &fid->fsid, sizeof(name.fsid));
+
+    uint32_t handleBytes;
+    memcpy(&handleBytes, record + fixed, sizeof(handleBytes));
+    size_t handleSize = kFileHandleHeaderSize + handleBytes;
+    if (fixed + handleSize > length) {
+        return false;
+    }
+
+    name.handle.assign(record + fixed, handleSize);
+
+    // The name is null terminated, and the record is padded to a multiple of 4 bytes
+    const char *start = record + fixed + handleSize;
+    const char *end = (const char *)memchr(start, '\0', length - fixed - handleSize);
+    name.name.assign(start, end == nullptr ? record + length : end);
+    return true;
+}
+
+size_t ParseFanotifyEvents(const char *buffer, size_t length, std::vector<FanotifyRecord> &records) {
+    size_t appended = 0;
+    size_t offset = 0;
+    while (offset + sizeof(struct fanotify_event_metadata) <= length) {
+        const struct fanotify_event_metadata *metadata = (const struct fanotify_event_metadata *)(buffer + offset);
+        if (metadata->vers != FANOTIFY_METADATA_VERSION
+            || metadata->event_len < metadata->metadata_len
+            || metadata->metadata_len < sizeof(struct fanotify_event_metadata)
+            || offset + metadata->event_len > length) {
+            break;
+        }
+
+        FanotifyRecord record = {};
+        record.pid = metadata->pid;
+        record.mask = metadata->mask;
+        bool hasName = false;
+        bool malformed = false;
+
+        size_t infoOffset = offset + metadata->metadata_len;
+        size_t eventEnd = offset + metadata->event_len;
+        while (infoOffset + sizeof(struct fanotify_event_info_header) <= eventEnd) {
+            const struct fanotify_event_info_header *header = (const struct fanotify_event_info_header *)(buffer + infoOffset);
+            if (header->len < sizeof(struct fanotify_event_info_header) || infoOffset + header->len > eventEnd) {
+                malformed = true;
+                break;
+            }
+
+            switch (header->info_type) {
+                case FAN_EVENT_INFO_TYPE_DFID_NAME:
+                case FAN_EVENT_INFO_TYPE_DFID:
+                case FAN_EVENT_INFO_TYPE_OLD_DFID_NAME:
+                    malformed = !ParseName(buffer + infoOffset, header->len, record.path);
+                    hasName = !malformed;
+                    break;
+                case FAN_EVENT_INFO_TYPE_NEW_DFID_NAME:
+                    malformed = !ParseName(buffer + infoOffset, header->len, record.new_path);
+                    break;
+                default:
+                    // Other records (e.g., pidfds) are not requested
+                    break;
+            }
+
+            if (malformed) {
+                break;
+            }
+
+            infoOffset += header->len;
+        }
+
+        if (malformed) {
+            break;
+        }
+
+        if (hasName) {
+            records.push_back(std::move(record));
+            appended++;
+        }
+
+        offset = eventEnd;
+    }
+
+    return appended;
+}
+
+pid_t ProcessTreeFilter::ReadParent(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    char content[512];
+    ssize_t length = read(fd, content, sizeof(content) - 1);
+    close(fd);
+    if (length <= 0) {
+        return -1;
+    }
+
+    content[length] = '\0';
+
+    // <pid> (<comm>) <state> <ppid> ...: the command can contain anything, including parentheses, so look for the last one
+    const char *commEnd = strrchr(content, ')');
+    if (commEnd == nullptr || strlen(commEnd) < 5) {
+        return -1;
+    }
+
+    char *end;
+    long parent = strtol(commEnd + 4, &end, 10);
+    return end == commEnd + 4 ? -1 : (pid_t)parent;
+}
+
+} // namespace linux
+} // namespace buildxl
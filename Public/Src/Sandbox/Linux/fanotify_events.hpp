@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_FANOTIFY_EVENTS_H
+#define BUILDXL_SANDBOX_LINUX_FANOTIFY_EVENTS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * A directory entry as reported by fanotify with FAN_REPORT_DFID_NAME: the file system, a handle of the directory (a struct file_handle
+ * that can be passed to open_by_handle_at, header included) and the name of the entry in it. The name is empty (or ".") when the event
+ * is about the directory itself.
+ */
+typedef struct FanotifyName {
+    uint64_t fsid;
+    std::string handle;
+    std::string name;
+} FanotifyName;
+
+/**
+ * One fanotify event. The kernel merges events on the same object from the same process that are still queued, so 'mask' may
+ * have several event bits set. For FAN_RENAME, 'path' is the old entry and 'new_path' the new one.
+ */
+typedef struct FanotifyRecord {
+    pid_t pid;
+    uint64_t mask;
+    FanotifyName path;
+    FanotifyName new_path;
+} FanotifyRecord;
+
+/**
+ * Parses the events in a buffer filled by a read() of a fanotify descriptor initialized with FAN_REPORT_DFID_NAME, appending
+ * them to 'records'. Events without a directory entry (e.g., overflow events) are skipped. Parsing stops at the first malformed
+ * event. Returns the number of events appended.
+ */
+size_t ParseFanotifyEvents(const char *buffer, size_t length, std::vector<FanotifyRecord> &records);
+
+/**
+ * The processes of a pip, as seen from outside of it: fanotify reports every process on the file system, and a process belongs to
+ * the pip if the root of the pip is one of its ancestors.
+ *
+ * Parents are looked up with the given function only for processes the filter hasn't decided on yet, so after the first event of a
+ * process, filtering it costs a hash lookup. A process whose parent can't be found anymore (it exited before its first event was
+ * read) is considered outside of the pip.
+ */
+class ProcessTreeFilter {
+public:
+    // Outsiders are forgotten past this, so a pid reused by a process of the pip after a wraparound is eventually looked up again
+    static const size_t kMaxOutsiders = 4096;
+
+    explicit ProcessTreeFilter(pid_t root) { members_[root] = 0; }
+
+    /**
+     * Whether the given process belongs to the pip. 'parent_of' returns the parent of a process, or a value <= 0 if it is not
+     * known. Processes that were just found to belong to the pip are appended to 'joined', if given, ancestors first.
+     */
+    template <typename ParentOf>
+    bool Contains(pid_t pid, ParentOf parent_of, std::vector<pid_t> *joined = nullptr) {
+        std::vector<pid_t> chain;
+        pid_t current = pid;
+        bool member = false;
+        while (true) {
+            if (members_.find(current) != members_.end()) {
+                member = true;
+                break;
+            }
+
+            if (current <= 1 || outsiders_.find(current) != outsiders_.end()) {
+                break;
+            }
+
+            chain.push_back(current);
+            current = parent_of(current);
+        }
+
+        if (!member && outsiders_.size() + chain.size() > kMaxOutsiders) {
+            outsiders_.clear();
+        }
+
+        // 'current' is the closest ancestor that belongs to the pip, if any
+        for (auto process = chain.rbegin(); process != chain.rend(); process++) {
+            if (member) {
+                members_[*process] = current;
+                current = *process;
+                if (joined != nullptr) {
+                    joined->push_back(*process);
+                }
+            } else {
+                outsiders_.insert(*process);
+            }
+        }
+
+        return member;
+    }
+
+    /**
+     * The parent of a process of the pip (0 for the root).
+     */
+    pid_t ParentOf(pid_t pid) const {
+        auto member = members_.find(pid);
+        return member == members_.end() ? 0 : member->second;
+    }
+
+    /**
+     * Forgets a process of the pip that exited, so its pid can be reused by a process that is not.
+     */
+    void Remove(pid_t pid) { members_.erase(pid); }
+
+    bool IsEmpty() const { return members_.empty(); }
+
+    /**
+     * The parent of the given process according to /proc, or -1 if it exited.
+     */
+    static pid_t ReadParent(pid_t pid);
+
+private:
+    // Process -> parent
+    std::unordered_map<pid_t, pid_t> members_;
+    std::unordered_set<pid_t> outsiders_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_FANOTIFY_EVENTS_H
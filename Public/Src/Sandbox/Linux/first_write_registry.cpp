@@ -0,0 +1,138 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "first_write_registry.hpp"
+
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace buildxl {
+namespace linux {
+
+static const size_t kHeaderSize = 64;
+
+static size_t MappingSize() {
+    return kHeaderSize + FirstWriteRegistry::kSlotCount * 16 + FirstWriteRegistry::kArenaSize;
+}
+
+bool FirstWriteRegistry::Initialize(const char *fam_path) {
+    static_assert(sizeof(Header) <= kHeaderSize, "Registry header does not fit");
+    static_assert(sizeof(Slot) == 16, "Unexpected registry slot size");
+
+    void *mapping = MapPipSharedFile(fam_path, kFileSuffix, MappingSize(), kMagic);
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    header_ = (Header *)mapping;
+    slots_ = (Slot *)((char *)mapping + kHeaderSize);
+    arena_ = (char *)mapping + kHeaderSize + kSlotCount * sizeof(Slot);
+    return true;
+}
+
+FirstWriteRegistration FirstWriteRegistry::TryRegister(const char *path, size_t length) {
+    if (header_ == nullptr || length >= kArenaSize) {
+        return kRegistryUnavailable;
+    }
+
+    uint64_t hash = Hash(path, length);
+    uint32_t index = (uint32_t)hash & (kSlotCount - 1);
+
+    for (uint32_t probes = 0; probes < kSlotCount; probes++, index = (index + 1) & (kSlotCount - 1)) {
+        Slot& slot = slots_[index];
+        uint64_t current = slot.hash.load(std::memory_order_acquire);
+
+        if (current == 0) {
+            if (slot.hash.compare_exchange_strong(current, hash, std::memory_order_acq_rel)) {
+                // We own the slot: publish the path so other processes can verify hash matches against it
+                uint32_t start = header_->arena_used.fetch_add((uint32_t)length, std::memory_order_relaxed);
+                uint32_t offset = kNoArenaOffset;
+                if ((size_t)start + length <= kArenaSize) {
+                    memcpy(arena_ + start, path, length);
+                    offset = start + 1;
+                }
+
+                slot.path_length = (uint32_t)length;
+                slot.path_offset.store(offset, std::memory_order_release);
+                return kFirstWrite;
+            }
+            // Someone else claimed the slot first, 'current' now holds their hash
+        }
+
+        if (current == hash) {
+            if (!WaitForPublication(slot)) {
+                return kRegistryUnavailable;
+            }
+
+            if (Matches(slot, path, length)) {
+                return kAlreadyRegistered;
+            }
+        }
+    }
+
+    // The table is full
+    return kRegistryUnavailable;
+}
+
+bool FirstWriteRegistry::IsRegistered(const char *path, size_t length) const {
+    if (header_ == nullptr || length >= kArenaSize) {
+        return false;
+    }
+
+    uint64_t hash = Hash(path, length);
+    uint32_t index = (uint32_t)hash & (kSlotCount - 1);
+
+    for (uint32_t probes = 0; probes < kSlotCount; probes++, index = (index + 1) & (kSlotCount - 1)) {
+        const Slot& slot = slots_[index];
+        uint64_t current = slot.hash.load(std::memory_order_acquire);
+
+        if (current == 0) {
+            // Registrations never skip a free slot, so the path is not in the table
+            return false;
+        }
+
+        if (current == hash && WaitForPublication(slot) && Matches(slot, path, length)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FirstWriteRegistry::WaitForPublication(const Slot& slot) {
+    int waits = 0;
+    while (slot.path_offset.load(std::memory_order_acquire) == 0) {
+        if (++waits > kMaxPublicationWaits) {
+            return false;
+        }
+        sched_yield();
+    }
+
+    return true;
+}
+
+bool FirstWriteRegistry::Matches(const Slot& slot, const char *path, size_t length) const {
+    uint32_t offset = slot.path_offset.load(std::memory_order_acquire);
+    if (offset == kNoArenaOffset) {
+        // The arena was exhausted when this entry was registered, so a 64-bit hash match is all we have
+        return true;
+    }
+
+    return slot.path_length == length && memcmp(arena_ + offset - 1, path, length) == 0;
+}
+
+uint64_t FirstWriteRegistry::Hash(const char *path, size_t length) {
+    // FNV-1a. 0 is reserved for free slots.
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)path[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash == 0 ? 1 : hash;
+}
+
+} // namespace linux
+} // namespace buildxl
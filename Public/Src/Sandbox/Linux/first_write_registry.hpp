@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_FIRST_WRITE_REGISTRY_H
+#define BUILDXL_SANDBOX_LINUX_FIRST_WRITE_REGISTRY_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "pip_shared_file.hpp"
+
+namespace buildxl {
+namespace linux {
+
+typedef enum FirstWriteRegistration {
+    // The path was registered by this call: this is the first write check for the path in the pip
+    kFirstWrite,
+
+    // Some process in the pip already registered the path
+    kAlreadyRegistered,
+
+    // The registry could not decide (not initialized, full, or an entry never got published).
+    // Callers should fall back to a per-process check.
+    kRegistryUnavailable
+} FirstWriteRegistration;
+
+/**
+ * Pip-wide registry of paths that were checked for allowed writes.
+ *
+ * The registry lives in a file-backed shared mapping next to the FAM, so every process in the pip (including the ptrace runner)
+ * shares it. A path is registered by atomically claiming a slot keyed by its 64-bit hash in an open addressing table,
+ * and then publishing a copy of the path in an append-only arena. Other processes finding the same hash compare against
+ * the arena copy, so hash collisions never cause a path to be skipped.
+ *
+ * All operations are lock-free. The registry never blocks a process for long: if a slot claimed by another process is not published
+ * in time (e.g., that process was killed in the middle of a registration), the call returns kRegistryUnavailable.
+ */
+class FirstWriteRegistry {
+public:
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    static constexpr const char *kFileSuffix = ".writes";
+
+    // The mapping is intentionally never unmapped: accesses can still be checked from exit handlers
+    // that run after static destructors, and the kernel releases the mapping on exit anyway.
+    FirstWriteRegistry() : header_(nullptr), slots_(nullptr), arena_(nullptr) { }
+    FirstWriteRegistry(const FirstWriteRegistry&) = delete;
+    FirstWriteRegistry& operator = (const FirstWriteRegistry&) = delete;
+
+    /**
+     * Maps the registry associated with the given FAM, creating it if this is the first process of the pip that needs it.
+     * A registry left behind by a previous run (i.e., created for a different FAM file) is replaced.
+     * Returns false if the registry is not available, in which case TryRegister always returns kRegistryUnavailable.
+     */
+    bool Initialize(const char *fam_path);
+
+    bool IsInitialized() const { return header_ != nullptr; }
+
+    /**
+     * Registers the given path, returning whether this was the first registration for the path in the whole pip.
+     */
+    FirstWriteRegistration TryRegister(const char *path, size_t length);
+
+    /**
+     * Whether some process in the pip already registered the given path. Never claims a slot: a false return just means the path
+     * was not registered at the time of the call (or that the registry could not tell).
+     */
+    bool IsRegistered(const char *path, size_t length) const;
+
+    // Layout constants, exposed for tests
+    static const uint32_t kSlotCount = 64 * 1024;
+    static const uint32_t kArenaSize = 8 * 1024 * 1024;
+
+private:
+    struct Header {
+        PipSharedHeader shared;
+        std::atomic<uint32_t> arena_used;
+    };
+
+    struct Slot {
+        // 0 means the slot is free
+        std::atomic<uint64_t> hash;
+        // Offset of the path in the arena, plus one. 0 means the slot is claimed but not yet published.
+        std::atomic<uint32_t> path_offset;
+        uint32_t path_length;
+    };
+
+    static const uint64_t kMagic = 0x4258'4c46'5752'0001ull;
+    // The arena offset published when the arena is exhausted: the entry can only be matched by hash
+    static const uint32_t kNoArenaOffset = UINT32_MAX;
+
+    static uint64_t Hash(const char *path, size_t length);
+    static bool WaitForPublication(const Slot& slot);
+    bool Matches(const Slot& slot, const char *path, size_t length) const;
+
+    Header *header_;
+    Slot *slots_;
+    char *arena_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_FIRST_WRITE_REGISTRY_H
@@ -0,0 +1,56 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_FIXED_PATH_H
+#define BUILDXL_SANDBOX_LINUX_FIXED_PATH_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include <string_view>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * A path stored inline, in a fixed-capacity buffer of PATH_MAX bytes.
+ *
+ * Used instead of std::string for paths that live on the interposition hot path (e.g., the paths of a SandboxEvent),
+ * so that handling an access never touches the heap. Paths longer than PATH_MAX - 1 bytes are truncated, which matches
+ * what the kernel accepts anyway.
+ */
+class FixedPath {
+public:
+    FixedPath() : length_(0) { path_[0] = '\0'; }
+    explicit FixedPath(const char *path) { Assign(path); }
+
+    FixedPath(const FixedPath& other) { Assign(other); }
+    FixedPath& operator = (const FixedPath& other) { if (this != &other) { Assign(other); } return *this; }
+
+    void Assign(const char *path) {
+        length_ = path == nullptr ? 0 : strnlen(path, PATH_MAX - 1);
+        // memmove: the path might point into this very buffer
+        memmove(path_, path == nullptr ? "" : path, length_);
+        path_[length_] = '\0';
+    }
+
+    const char *c_str() const { return path_; }
+    size_t length() const { return length_; }
+    bool empty() const { return length_ == 0; }
+    char operator [] (size_t index) const { return path_[index]; }
+    operator std::string_view() const { return std::string_view(path_, length_); }
+
+private:
+    void Assign(const FixedPath& other) {
+        length_ = other.length_;
+        memcpy(path_, other.path_, length_ + 1);
+    }
+
+    size_t length_;
+    char path_[PATH_MAX];
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_FIXED_PATH_H
@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "input_prefetcher.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+// A list is produced by the engine for a single pip: anything larger than this is not worth reading
+static const off_t kMaxListSize = 64 * 1024 * 1024;
+
+static uint64_t MonotonicTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool ReadList(const char *list_path, std::string& content) {
+    int fd = RawOpen(list_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (RawFstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > kMaxListSize) {
+        RawClose(fd);
+        return false;
+    }
+
+    content.resize(st.st_size);
+    size_t total = 0;
+    while (total < content.size()) {
+        ssize_t n = RawRead(fd, &content[total], content.size() - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            break;
+        }
+
+        total += n;
+    }
+
+    content.resize(total);
+    RawClose(fd);
+    return true;
+}
+
+std::vector<std::string> InputPrefetcher::ParseList(const std::string& content) {
+    std::vector<std::string> paths;
+    size_t start = 0;
+    while (start < content.length()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos) {
+            end = content.length();
+        }
+
+        size_t length = end - start;
+        if (length > 0 && content[end - 1] == '\r') {
+            length--;
+        }
+
+        if (length > 0 && content[start] == '/') {
+            paths.emplace_back(content, start, length);
+        }
+
+        start = end + 1;
+    }
+
+    return paths;
+}
+
+bool InputPrefetcher::Start(const char *list_path) {
+    std::string content;
+    if (started_ || !ReadList(list_path, content)) {
+        return false;
+    }
+
+    list_path_.assign(list_path);
+    state_->paths = ParseList(content);
+
+    // Signals sent to the process must keep being handled by the threads of the tool
+    sigset_t all_signals, previous_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+
+    pthread_t thread;
+    int result = pthread_create(&thread, nullptr, PrefetchThread, state_);
+    pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+    if (result != 0) {
+        return false;
+    }
+
+    // Nobody waits for the thread: it is abandoned if the process exits before it is done
+    pthread_detach(thread);
+    started_ = true;
+    return true;
+}
+
+void *InputPrefetcher::PrefetchThread(void *state) {
+    State *prefetch_state = (State *)state;
+    Prefetch(prefetch_state, prefetch_state->paths);
+    return nullptr;
+}
+
+void InputPrefetcher::Prefetch(const std::vector<std::string>& paths) {
+    Prefetch(state_, paths);
+}
+
+void InputPrefetcher::Prefetch(State *state, const std::vector<std::string>& paths) {
+    uint64_t start = MonotonicTimeNs();
+    state->listed = paths.size();
+
+    for (const auto& path : paths) {
+        if (state->stopping.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        struct stat st;
+        int fd = RawOpen(path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+        if (fd < 0 || RawFstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            state->missing++;
+        }
+        else if (RawFadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0) {
+            state->prefetched++;
+            state->bytes += st.st_size;
+        }
+
+        if (fd >= 0) {
+            RawClose(fd);
+        }
+
+        state->elapsed_ns.store(MonotonicTimeNs() - start, std::memory_order_relaxed);
+    }
+
+    state->completed = true;
+}
+
+PrefetchStatistics InputPrefetcher::Stop() {
+    state_->stopping = true;
+    return GetStatistics();
+}
+
+PrefetchStatistics InputPrefetcher::GetStatistics() const {
+    PrefetchStatistics statistics;
+    statistics.listed = state_->listed.load();
+    statistics.prefetched = state_->prefetched.load();
+    statistics.missing = state_->missing.load();
+    statistics.bytes = state_->bytes.load();
+    statistics.elapsed_ns = state_->elapsed_ns.load();
+    statistics.completed = state_->completed.load();
+    return statistics;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_INPUT_PREFETCHER_H
+#define BUILDXL_SANDBOX_LINUX_INPUT_PREFETCHER_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace buildxl {
+namespace linux {
+
+typedef struct PrefetchStatistics {
+    // Paths in the list
+    uint64_t listed;
+    // Files the kernel was asked to read ahead
+    uint64_t prefetched;
+    // Paths that don't exist anymore or are not regular files
+    uint64_t missing;
+    // Total size of the prefetched files
+    uint64_t bytes;
+    // Time spent going through the list so far
+    uint64_t elapsed_ns;
+    // Whether the whole list was gone through
+    bool completed;
+} PrefetchStatistics;
+
+/**
+ * Warms up the page cache with the inputs a pip read on a previous run, while the tool starts up.
+ *
+ * The list of inputs is a file with one absolute path per line, in the order the pip accessed them. A background thread
+ * asks the kernel to read ahead each file in that order (posix_fadvise(WILLNEED)), so reads that are about to happen don't stall
+ * on cold storage. Prefetching is only a hint: it never changes what the pip sees, and it is never reported as an access.
+ *
+ * The thread only uses raw syscalls, so none of its file system operations go through the interposed functions.
+ */
+class InputPrefetcher {
+public:
+    // The state the background thread works on is intentionally never freed: the thread is abandoned when the process exits,
+    // possibly after static destructors ran.
+    InputPrefetcher() : state_(new State()) { }
+    InputPrefetcher(const InputPrefetcher&) = delete;
+    InputPrefetcher& operator = (const InputPrefetcher&) = delete;
+
+    /**
+     * Loads the list and starts prefetching in the background. Returns false if the list can't be read or the thread can't be started.
+     */
+    bool Start(const char *list_path);
+
+    bool IsStarted() const { return started_; }
+
+    const std::string& GetListPath() const { return list_path_; }
+
+    // Statistics so far
+    PrefetchStatistics GetStatistics() const;
+
+    /**
+     * Stops prefetching (e.g., because the process is exiting) and returns the statistics so far.
+     */
+    PrefetchStatistics Stop();
+
+    /**
+     * Splits the content of a list into paths, skipping empty lines and anything that is not an absolute path. Exposed for tests.
+     */
+    static std::vector<std::string> ParseList(const std::string& content);
+
+    /**
+     * Prefetches the given paths in order, on the calling thread. Exposed for tests.
+     */
+    void Prefetch(const std::vector<std::string>& paths);
+
+private:
+    struct State {
+        std::vector<std::string> paths;
+        std::atomic<bool> stopping { false };
+        std::atomic<uint64_t> listed { 0 };
+        std::atomic<uint64_t> prefetched { 0 };
+        std::atomic<uint64_t> missing { 0 };
+        std::atomic<uint64_t> bytes { 0 };
+        std::atomic<uint64_t> elapsed_ns { 0 };
+        std::atomic<bool> completed { false };
+    };
+
+    static void *PrefetchThread(void *state);
+    static void Prefetch(State *state, const std::vector<std::string>& paths);
+
+    bool started_ = false;
+    std::string list_path_;
+    State *state_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_INPUT_PREFETCHER_H
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "io_volume_tracker.hpp"
+
+#include <new>
+
+namespace buildxl {
+namespace linux {
+
+void IoVolumeTracker::Enable() {
+    if (!IsEnabled()) {
+        counters_.reset(new DescriptorCounters[kMaxFd]);
+    }
+}
+
+bool IoVolumeTracker::Take(int fd, IoVolume &volume) {
+    if (!IsEnabled() || fd < 0 || fd >= kMaxFd) {
+        return false;
+    }
+
+    Counters &read = counters_[fd].directions[kRead];
+    Counters &write = counters_[fd].directions[kWrite];
+
+    // Cheap check first: most descriptors that get closed were never read or written (e.g., directories)
+    if (read.calls.load(std::memory_order_relaxed) == 0 && write.calls.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    volume.reads = read.calls.exchange(0, std::memory_order_relaxed);
+    volume.bytes_read = read.bytes.exchange(0, std::memory_order_relaxed);
+    volume.read_ns = read.ns.exchange(0, std::memory_order_relaxed);
+    volume.writes = write.calls.exchange(0, std::memory_order_relaxed);
+    volume.bytes_written = write.bytes.exchange(0, std::memory_order_relaxed);
+    volume.write_ns = write.ns.exchange(0, std::memory_order_relaxed);
+
+    return volume.reads > 0 || volume.writes > 0;
+}
+
+void IoVolumeTracker::TakeAll(std::vector<std::pair<int, IoVolume>> &volumes) {
+    for (int fd = 0; IsEnabled() && fd < kMaxFd; fd++) {
+        IoVolume volume;
+        if (Take(fd, volume)) {
+            volumes.emplace_back(fd, volume);
+        }
+    }
+}
+
+void IoVolumeTracker::Fold(const std::string &path, const IoVolume &volume) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    auto inserted = summary_.emplace(path, volume);
+    if (inserted.second) {
+        return;
+    }
+
+    IoVolume &total = inserted.first->second;
+    total.bytes_read += volume.bytes_read;
+    total.bytes_written += volume.bytes_written;
+    total.reads += volume.reads;
+    total.writes += volume.writes;
+    total.read_ns += volume.read_ns;
+    total.write_ns += volume.write_ns;
+}
+
+void IoVolumeTracker::Drain(std::vector<std::pair<std::string, IoVolume>> &summary) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    summary.reserve(summary.size() + summary_.size());
+    for (auto &entry : summary_) {
+        summary.emplace_back(entry.first, entry.second);
+    }
+
+    summary_.clear();
+}
+
+void IoVolumeTracker::ResetAfterFork() {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    // Another thread of the parent may have been halfway through an update of the summary: start over with a fresh one.
+    // The old summary is leaked on purpose.
+    ResetLock(mtx_);
+    new (&summary_) std::unordered_map<std::string, IoVolume>();
+
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        for (Counters &counters : counters_[fd].directions) {
+            counters.bytes.store(0, std::memory_order_relaxed);
+            counters.calls.store(0, std::memory_order_relaxed);
+            counters.ns.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_IO_VOLUME_TRACKER_H
+#define BUILDXL_SANDBOX_LINUX_IO_VOLUME_TRACKER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * How much a process read from and wrote to a file, and how long it spent doing so.
+ */
+typedef struct IoVolume {
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t reads;
+    uint64_t writes;
+    // Time spent in the forwarded calls, in nanoseconds
+    uint64_t read_ns;
+    uint64_t write_ns;
+} IoVolume;
+
+/**
+ * Accounts for the bytes a process reads and writes through each of its file descriptors, so the engine can tell which files
+ * a pip spends its I/O on.
+ *
+ * Every read or write adds to the counters of its descriptor, without taking any lock. When a descriptor is closed its counters
+ * are folded into a summary per path, and the summary is reported (once per path) when the process exits or execs. Descriptors
+ * beyond kMaxFd are not accounted for.
+ *
+ * The counters are only allocated once the tracker is enabled: a disabled tracker costs a null check per call.
+ */
+class IoVolumeTracker : public PostForkResettable {
+public:
+    // Descriptors beyond this are not tracked (same bound as the observer's fd table)
+    static const int kMaxFd = 1024;
+
+    typedef enum Direction {
+        kRead = 0,
+        kWrite = 1
+    } Direction;
+
+    IoVolumeTracker() = default;
+    IoVolumeTracker(const IoVolumeTracker&) = delete;
+    IoVolumeTracker& operator = (const IoVolumeTracker&) = delete;
+
+    void Enable();
+    bool IsEnabled() const { return counters_ != nullptr; }
+
+    /**
+     * Start time of a call to account for with Add. Doesn't read the clock when the tracker is disabled.
+     */
+    uint64_t Start() const { return IsEnabled() ? Now() : 0; }
+
+    /**
+     * Accounts for a read or a write through a descriptor. 'result' is what the call returned: failed calls are counted,
+     * but only the bytes actually transferred are.
+     */
+    void Add(int fd, Direction direction, ssize_t result, uint64_t start) {
+        if (!IsEnabled() || fd < 0 || fd >= kMaxFd) {
+            return;
+        }
+
+        Counters &counters = counters_[fd].directions[direction];
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        counters.ns.fetch_add(Now() - start, std::memory_order_relaxed);
+        if (result > 0) {
+            counters.bytes.fetch_add((uint64_t)result, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Resets the counters of a descriptor that is about to be closed (or replaced). Returns true and fills 'volume' if
+     * anything was read or written through it.
+     */
+    bool Take(int fd, IoVolume &volume);
+
+    /**
+     * Resets the counters of every descriptor, for a process that is about to exit or exec. Returns the descriptors that
+     * were read or written.
+     */
+    void TakeAll(std::vector<std::pair<int, IoVolume>> &volumes);
+
+    // Adds the volume of a descriptor to the summary of the file it was open on
+    void Fold(const std::string &path, const IoVolume &volume);
+
+    // Takes the summary, leaving it empty
+    void Drain(std::vector<std::pair<std::string, IoVolume>> &summary);
+
+    /**
+     * Drops all the state inherited from the parent process. Must be called in a forked child before it does anything else:
+     * what the parent read and wrote is reported by the parent.
+     */
+    void ResetAfterFork() override;
+
+    /**
+     * Timing a call takes a reading before it (Start) and one after it (Add). CLOCK_MONOTONIC is the cheapest clock that can
+     * time a single read: it is served by the vDSO, without a syscall. CLOCK_MONOTONIC_COARSE only moves once per scheduler
+     * tick (1 to 4 ms), so almost every call would take 0, and the TSC is neither portable nor calibrated. The readings are
+     * only taken when the tracker is enabled.
+     */
+    static uint64_t Now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> bytes { 0 };
+        std::atomic<uint64_t> calls { 0 };
+        std::atomic<uint64_t> ns { 0 };
+    };
+
+    // Threads usually do I/O on different descriptors: keep each descriptor on its own cache line
+    struct alignas(64) DescriptorCounters {
+        Counters directions[2];
+    };
+
+    std::unique_ptr<DescriptorCounters[]> counters_;
+    std::mutex mtx_;
+    std::unordered_map<std::string, IoVolume> summary_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_IO_VOLUME_TRACKER_H
@@ -0,0 +1,124 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "library_audit.hpp"
+
+#include <string.h>
+
+namespace buildxl {
+namespace linux {
+
+// FNV-1a, never 0 (which marks a free slot)
+static uint64_t HashPath(const char *path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char *c = path; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 1099511628211ull;
+    }
+
+    return hash == 0 ? 1 : hash;
+}
+
+void LibraryAudit::Searched(const char *path) {
+    // Names without a slash are what the loader searches for (e.g., a DT_NEEDED entry), not paths it tries
+    if (path == nullptr || strchr(path, '/') == nullptr) {
+        return;
+    }
+
+    // Trying another path means the one it was trying didn't work out
+    ResolvePending(nullptr);
+
+    size_t length = strlen(path);
+    if (length < sizeof(pending_)) {
+        memcpy(pending_, path, length + 1);
+    }
+}
+
+void LibraryAudit::Opened(const char *path) {
+    ResolvePending(path);
+
+    // Objects that are not files (the main program reports an empty name, the vDSO a name without a slash) are not accesses
+    if (path != nullptr && strchr(path, '/') != nullptr) {
+        Report(path, /* loaded */ true);
+    }
+}
+
+void LibraryAudit::Consistent() {
+    ResolvePending(nullptr);
+}
+
+void LibraryAudit::Attach(Sink sink) {
+    sink_ = sink;
+    for (size_t offset = 0; offset < bufferLength_; ) {
+        bool loaded = buffer_[offset] != 0;
+        const char *path = &buffer_[offset + 1];
+        sink_(path, loaded ? 1 : 0);
+        offset += strlen(path) + 2;
+    }
+
+    bufferLength_ = 0;
+}
+
+void LibraryAudit::ResolvePending(const char *opened) {
+    if (pending_[0] == '\0') {
+        return;
+    }
+
+    // A path that was tried and then mapped is reported as mapped
+    if (opened == nullptr || strcmp(opened, pending_) != 0) {
+        Report(pending_, /* loaded */ false);
+    }
+
+    pending_[0] = '\0';
+}
+
+void LibraryAudit::Report(const char *path, bool loaded) {
+    if (!FirstTime(path)) {
+        return;
+    }
+
+    if (sink_ != nullptr) {
+        sink_(path, loaded ? 1 : 0);
+        return;
+    }
+
+    size_t length = strlen(path);
+    if (bufferLength_ + length + 2 > kBufferSize) {
+        dropped_++;
+        return;
+    }
+
+    buffer_[bufferLength_] = loaded ? 1 : 0;
+    memcpy(&buffer_[bufferLength_ + 1], path, length + 1);
+    bufferLength_ += length + 2;
+}
+
+bool LibraryAudit::FirstTime(const char *path) {
+    if (seenCount_ >= kMaxPaths) {
+        return true;
+    }
+
+    // The table is twice the number of paths it holds, so there is always a free slot
+    const size_t slots = sizeof(seen_) / sizeof(seen_[0]);
+    uint64_t hash = HashPath(path);
+    for (size_t i = hash % slots; ; i = (i + 1) % slots) {
+        if (seen_[i].hash == hash && strcmp(&seenPaths_[seen_[i].offset], path) == 0) {
+            return false;
+        }
+
+        if (seen_[i].hash == 0) {
+            size_t length = strlen(path);
+            if (seenPathsLength_ + length + 1 > kSeenPathsSize) {
+                return true;
+            }
+
+            memcpy(&seenPaths_[seenPathsLength_], path, length + 1);
+            seen_[i] = { hash, seenPathsLength_ };
+            seenPathsLength_ += length + 1;
+            seenCount_++;
+            return true;
+        }
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
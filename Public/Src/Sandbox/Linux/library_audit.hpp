@@ -0,0 +1,98 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_LIBRARY_AUDIT_H
+#define BUILDXL_SANDBOX_LINUX_LIBRARY_AUDIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * What the audit module (libBxlAudit.so, see audit_module.cpp) learns from the dynamic loader, turned into library accesses.
+ *
+ * The loader opens the libraries it maps itself, without going through libc, so the sandbox can't see those opens. Through the
+ * rtld-audit interface, it tells the audit module about every path it tries for a library (la_objsearch) and about every library
+ * it maps (la_objopen). A path that was tried but not mapped was not found (or could not be loaded), which only becomes known when
+ * the loader moves on: to the next path, to mapping something else, or to the end of the load.
+ *
+ * The audit module runs in a link namespace of its own, which is set up before libDetours.so is even relocated: accesses are
+ * kept until the sandbox is ready to take them (Attach), then handed to it as they happen. Each path is handed over once per
+ * process. Nothing here allocates or depends on libstdc++: loading it must stay cheap.
+ *
+ * Not thread safe: the loader calls the audit module while holding its own lock.
+ */
+class LibraryAudit {
+public:
+    // Receives a library path, and whether the loader mapped it (as opposed to only trying it)
+    typedef void (*Sink)(const char *path, int loaded);
+
+    // Paths seen once per process (any path seen after that is handed over, possibly again)
+    static const int kMaxPaths = 4096;
+
+    // Room for the paths seen (a path that doesn't fit is handed over every time it is seen)
+    static const size_t kSeenPathsSize = 256 * 1024;
+
+    // Room for the accesses kept until the sandbox is attached (the ones that don't fit are dropped)
+    static const size_t kBufferSize = 64 * 1024;
+
+    LibraryAudit() = default;
+    LibraryAudit(const LibraryAudit&) = delete;
+    LibraryAudit& operator = (const LibraryAudit&) = delete;
+
+    // la_objsearch: the loader is about to try the given path
+    void Searched(const char *path);
+
+    // la_objopen: the loader mapped the given path
+    void Opened(const char *path);
+
+    // la_activity(LA_ACT_CONSISTENT): the loader is done loading
+    void Consistent();
+
+    // Hands the kept accesses over to the sink, and every later one as it happens
+    void Attach(Sink sink);
+
+    bool IsAttached() const { return sink_ != nullptr; }
+
+    // Accesses that were dropped because they did not fit while no sink was attached. The sandbox fails the process when there
+    // are any (see audit_module.cpp): it can't tell which libraries they were.
+    int Dropped() const { return dropped_; }
+
+private:
+    void Report(const char *path, bool loaded);
+    void ResolvePending(const char *opened);
+
+    // Returns true if the path was not seen before (and remembers it). Paths with the same hash are told apart by comparing them.
+    bool FirstTime(const char *path);
+
+    Sink sink_ = nullptr;
+
+    // The path the loader is trying (empty if none)
+    char pending_[4096] = { 0 };
+
+    // A path seen: its hash (0 for a free slot) and where it is in seenPaths_
+    struct SeenPath {
+        uint64_t hash;
+        size_t offset;
+    };
+
+    // Paths seen, by hash (open addressing)
+    SeenPath seen_[kMaxPaths * 2] = { };
+    int seenCount_ = 0;
+
+    // The paths seen, each null terminated
+    char seenPaths_[kSeenPathsSize];
+    size_t seenPathsLength_ = 0;
+
+    // Kept accesses: a byte for whether the path was loaded, then the path, null terminated
+    char buffer_[kBufferSize];
+    size_t bufferLength_ = 0;
+    int dropped_ = 0;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_LIBRARY_AUDIT_H
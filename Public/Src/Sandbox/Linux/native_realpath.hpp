@@ -0,0 +1,84 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_NATIVE_REALPATH_H
+#define BUILDXL_SANDBOX_LINUX_NATIVE_REALPATH_H
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "path_canonicalizer.hpp"
+#include "symlink_free_check.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * The core of realpath(3): resolves an absolute path in place with the same results (and errno values) glibc produces,
+ * but in a single walk where every symlink goes through 'read_link' (see CanonicalizePath), so callers can report them.
+ *
+ *     bool is_directory(const char *prefix)
+ *
+ * is called for existing components that are not symlinks and are followed by more of the path.
+ *
+ * Returns 0 on success. Otherwise returns the errno realpath would fail with; for ENOENT, ENOTDIR, EACCES and the like
+ * 'failed_path' (PATH_MAX bytes) gets the prefix that failed to resolve. Except for ENOTDIR, that is also what glibc leaves
+ * in the caller's buffer.
+ * When the path does not go through any symlink and the kernel can confirm it, no component is checked one by one.
+ */
+template <typename ReadLink, typename IsDirectory>
+int ResolveRealPath(char *path, char *failed_path, ReadLink read_link, IsDirectory is_directory) {
+    failed_path[0] = '\0';
+
+    bool exists = false;
+    if (ResolvesWithoutSymlinks(path, /* follow_final_symlink */ true, &exists)) {
+        // Every component but maybe the last one exists and none is a symlink: a lexical pass is all we need
+        CanonicalizePath(path, /* follow_final_symlink */ true, [](const char *, bool, char *, size_t) { return (ssize_t)-1; });
+        if (!exists) {
+            strcpy(failed_path, path);
+            return ENOENT;
+        }
+
+        return 0;
+    }
+
+    // Resolution stops at the first component that doesn't resolve, which is where glibc stops as well
+    int error = 0;
+    auto read_link_or_stop = [&](const char *prefix, bool is_final, char *target, size_t target_size) {
+        ssize_t length = read_link(prefix, target, target_size);
+        if (length != -1) {
+            return length;
+        }
+
+        // EINVAL: the prefix exists and is not a symlink. If the path goes on, it has to be a directory.
+        if (errno == EINVAL) {
+            if (is_final || is_directory(prefix)) {
+                return (ssize_t)-1;
+            }
+
+            errno = ENOTDIR;
+        }
+
+        error = errno;
+        strcpy(failed_path, prefix);
+        return kStopCanonicalization;
+    };
+
+    switch (CanonicalizePath(path, /* follow_final_symlink */ true, read_link_or_stop)) {
+        case kCanonicalized:
+        case kStopped:
+            return error;
+        case kSymlinkLoop:
+            return ELOOP;
+        case kNameTooLong:
+        default:
+            return ENAMETOOLONG;
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_NATIVE_REALPATH_H
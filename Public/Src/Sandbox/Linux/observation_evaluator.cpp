@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <iostream>
+
+#include "bxl_observer.hpp"
+#include "report_line.hpp"
+
+// Builds back the observation a report line carries. Returns false if the line is malformed or isn't an observation.
+static bool ParseObservation(BxlObserver *bxl, const char *line, AccessReport &observation)
+{
+    buildxl::linux::ParsedReport parsed;
+    if (!buildxl::linux::ParseReportLine(line, bxl->IsReportingTimestamps(), parsed) || parsed.operation != FileOperation::kOpObservation)
+    {
+        return false;
+    }
+
+    observation =
+    {
+        .operation          = FileOperation::kOpObservation,
+        .pid                = parsed.pid,
+        .rootPid            = 0,
+        .requestedAccess    = parsed.requested_access,
+        .status             = parsed.status,
+        .reportExplicitly   = 0,
+        .error              = parsed.error,
+        .pipId              = 0,
+        .path               = {0},
+        .stats              = {0},
+        .isDirectory        = parsed.is_directory,
+        .shouldReport       = true,
+    };
+
+    strlcpy(observation.path, parsed.path.c_str(), sizeof(observation.path));
+    observation.stats.creationTime = parsed.timestamp;
+    return true;
+}
+
+/**
+ * Replays a recorded stream of accesses through both in-process evaluation and observe-only mode, against the FAM of the pip.
+ * Each line of the stream is '<es_event_type_t>|<errno>|<absolute path>'. Observations go through a report line, as they do on
+ * their way to the evaluator, before being evaluated. Every access whose reports differ is written to stderr.
+ *
+ * Returns the number of accesses whose reports differ.
+ */
+static int Replay(BxlObserver *bxl, FILE *stream)
+{
+    int replayed = 0, observed = 0, mismatches = 0;
+    char line[PATH_MAX + 64];
+    while (fgets(line, sizeof(line), stream) != nullptr)
+    {
+        line[strcspn(line, "\n")] = '\0';
+
+        char *path = nullptr;
+        unsigned long eventType = strtoul(line, &path, 10);
+        if (*path != '|')
+        {
+            std::cerr << "Malformed access: " << line << std::endl;
+            _exit(-1);
+        }
+
+        unsigned long error = strtoul(path + 1, &path, 10);
+        if (*path != '|' || path[1] != '/')
+        {
+            std::cerr << "Malformed access: " << line << std::endl;
+            _exit(-1);
+        }
+
+        AccessReportGroup inProcess, observeOnly;
+        bxl->ReplayAccess((es_event_type_t)eventType, (uint)error, path + 1, inProcess, observeOnly);
+        replayed++;
+
+        if (observeOnly.firstReport.shouldReport && observeOnly.firstReport.operation == FileOperation::kOpObservation)
+        {
+            AccessReport observation;
+            if (!ParseObservation(bxl, bxl->RenderReports(observeOnly).c_str(), observation))
+            {
+                std::cerr << "Malformed observation for: " << line << std::endl;
+                _exit(-1);
+            }
+
+            observeOnly = AccessReportGroup();
+            bxl->EvaluateObservation(observation, observeOnly);
+            observed++;
+        }
+
+        std::string expected = bxl->RenderReports(inProcess);
+        std::string actual = bxl->RenderReports(observeOnly);
+        if (expected != actual)
+        {
+            std::cerr << "Mismatch for " << line << std::endl << "in-process:" << std::endl << expected << "observe-only:" << std::endl << actual;
+            mismatches++;
+        }
+    }
+
+    std::cout << "Replayed " << replayed << " accesses (" << observed << " evaluated out of process), " << mismatches << " mismatches" << std::endl;
+    return mismatches;
+}
+
+/**
+ * Evaluates the policy for the accesses observed by the processes of a pip running in observe-only mode (EnableLinuxSandboxObserveOnly in the FAM).
+ *
+ * BuildXL launches one evaluator per pip with the FAM path in its environment, so the FAM is parsed once for the whole pip
+ * instead of once per process. The evaluator reads observations from stdin, one report line at a time (as received by the
+ * managed side from the reports FIFO), evaluates them with the same code the interposer would have used (see BxlObserver::EvaluateObservation)
+ * and sends the resulting reports over the reports FIFO, like any other process of the pip would.
+ *
+ * The evaluator exits when stdin is closed, once all the reports for the observations it read are sent.
+ *
+ * With '--replay <stream>' it sends nothing: it checks both evaluations agree on a recorded stream instead (see Replay) and exits with 1 if they don't.
+ */
+int main(int argc, char **argv)
+{
+    BxlObserver *bxl = BxlObserver::GetInstance();
+    bxl->Init();
+
+    // The managed side merges the report logs of the pip before it drains the evaluator, so a logged evaluation would never
+    // be read: the evaluator reports over the FIFO, which the managed side reads until the evaluator is done
+    bxl->DisableReportLogs();
+
+    if (argc == 3 && strcmp(argv[1], "--replay") == 0)
+    {
+        FILE *stream = fopen(argv[2], "r");
+        if (stream == nullptr)
+        {
+            std::cerr << "Can't open '" << argv[2] << "': " << strerror(errno) << std::endl;
+            _exit(-1);
+        }
+
+        _exit(Replay(bxl, stream) == 0 ? 0 : 1);
+    }
+
+    AccessReport observation;
+    char line[PIPE_BUF];
+    while (fgets(line, sizeof(line), stdin) != nullptr)
+    {
+        if (!ParseObservation(bxl, line, observation))
+        {
+            std::cerr << "Malformed observation: " << line << std::endl;
+            _exit(-1);
+        }
+
+        AccessReportGroup reports;
+        bxl->EvaluateObservation(observation, reports);
+        bxl->SendReport(reports);
+    }
+
+    _exit(0);
+}
@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "output_close_tracker.hpp"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+static bool IsTrackable(int fd) {
+    return fd >= 0 && fd < OutputCloseTracker::kMaxFd;
+}
+
+bool OutputCloseTracker::Track(int fd, const char *path) {
+    if (!enabled_ || !IsTrackable(fd)) {
+        return false;
+    }
+
+    struct stat st;
+    if (RawFstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // Whatever was tracked for this descriptor was closed in a way we didn't see
+    Drop(fd);
+
+    auto existing = std::find_if(open_.begin(), open_.end(), [&](const std::shared_ptr<OpenOutput> &file) {
+        return file->device == st.st_dev && file->inode == st.st_ino;
+    });
+
+    if (existing != open_.end()) {
+        files_[fd] = *existing;
+    }
+    else {
+        std::shared_ptr<OpenOutput> file(new OpenOutput());
+        file->path.assign(path);
+        file->device = st.st_dev;
+        file->inode = st.st_ino;
+        file->descriptors = 0;
+        open_.push_back(file);
+        files_[fd] = file;
+    }
+
+    files_[fd]->descriptors++;
+    return closed_.erase(path) > 0;
+}
+
+void OutputCloseTracker::Duplicate(int oldfd, int newfd) {
+    if (!enabled_ || !IsTrackable(newfd) || oldfd == newfd) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // newfd was silently closed, which the caller reported already
+    Drop(newfd);
+
+    if (IsTrackable(oldfd) && files_[oldfd] != nullptr) {
+        files_[newfd] = files_[oldfd];
+        files_[newfd]->descriptors++;
+    }
+}
+
+bool OutputCloseTracker::Release(int fd, ReleasedOutput &released) {
+    if (!enabled_ || !IsTrackable(fd)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::shared_ptr<OpenOutput> file = files_[fd];
+    if (file == nullptr) {
+        return false;
+    }
+
+    Drop(fd);
+    if (file->descriptors > 0) {
+        return false;
+    }
+
+    released.path = file->path;
+    released.device = file->device;
+    released.inode = file->inode;
+    return true;
+}
+
+void OutputCloseTracker::ReleaseAll(std::vector<ReleasedOutput> &released) {
+    if (!enabled_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto &file : open_) {
+        released.push_back({ file->path, file->device, file->inode });
+    }
+
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        files_[fd].reset();
+    }
+
+    open_.clear();
+}
+
+bool OutputCloseTracker::Finalize(const ReleasedOutput &released, ClosedOutput &closed) {
+    struct stat st;
+    if (RawStat(released.path.c_str(), &st) != 0 || st.st_dev != released.device || st.st_ino != released.inode) {
+        return false;
+    }
+
+    closed.path = released.path;
+    closed.size = st.st_size;
+    closed.mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    closed_.insert(released.path);
+    return true;
+}
+
+void OutputCloseTracker::StopTrackingShared() {
+    if (!enabled_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        files_[fd].reset();
+    }
+
+    open_.clear();
+}
+
+void OutputCloseTracker::ResetAfterFork() {
+    ResetLock(mtx_);
+
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        files_[fd].reset();
+    }
+
+    open_.clear();
+}
+
+void OutputCloseTracker::Drop(int fd) {
+    std::shared_ptr<OpenOutput> file = std::move(files_[fd]);
+    if (file == nullptr || --file->descriptors > 0) {
+        return;
+    }
+
+    open_.erase(std::remove(open_.begin(), open_.end(), file), open_.end());
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_OUTPUT_CLOSE_TRACKER_H
+#define BUILDXL_SANDBOX_LINUX_OUTPUT_CLOSE_TRACKER_H
+
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unordered_set>
+#include <vector>
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * An output that is no longer open for writing in this process.
+ */
+typedef struct ClosedOutput {
+    std::string path;
+    off_t size;
+    // st_mtim of the file after it was closed, in nanoseconds
+    int64_t mtime_ns;
+} ClosedOutput;
+
+/**
+ * Keeps track of the descriptors a process has open for writing on its outputs, so the engine can be told as soon as
+ * an output is done being written instead of when the whole pip exits.
+ *
+ * A file counts as closed when the last descriptor this process had open for writing on it goes away: descriptors duplicated
+ * from a tracked one and independent opens of the same file (matched by identity) all count. A notification must be final for
+ * the process, so anything that could let the file be written after the notification without going through the tracker stops
+ * tracking the file altogether (e.g., descriptors shared with a forked child). Missing a notification is always safe: the engine
+ * processes the outputs it wasn't notified about when the pip exits, as usual.
+ *
+ * Paths that were reported as closed are remembered, so reopening one of them for writing can be reported as well.
+ *
+ * Closing is done in two steps: Release, right before the descriptor is closed, and Finalize, right after it was closed, which
+ * reads the final size and modification time of the file (only if the path still refers to the same file).
+ * All file system operations go through raw syscalls, so the tracker is safe to use from within interposed functions.
+ */
+class OutputCloseTracker : public PostForkResettable {
+public:
+    // Descriptors beyond this are not tracked (same bound as the observer's fd table)
+    static const int kMaxFd = 1024;
+
+    // The file that was open on a descriptor that was just released
+    typedef struct ReleasedOutput {
+        std::string path;
+        dev_t device;
+        ino_t inode;
+    } ReleasedOutput;
+
+    OutputCloseTracker() = default;
+    OutputCloseTracker(const OutputCloseTracker&) = delete;
+    OutputCloseTracker& operator = (const OutputCloseTracker&) = delete;
+
+    void Enable() { enabled_ = true; }
+    bool IsEnabled() const { return enabled_; }
+
+    /**
+     * Starts tracking a descriptor that was just opened for writing on an output. Returns true if the path was reported
+     * as closed before, i.e., the output is being reopened for writing.
+     */
+    bool Track(int fd, const char *path);
+
+    // A descriptor was duplicated (dup, dup2, dup3, F_DUPFD): the file stays open until both are closed
+    void Duplicate(int oldfd, int newfd);
+
+    /**
+     * Stops tracking a descriptor that is about to be closed (close, fclose, or a dup2 over it). Returns true if it was the last
+     * descriptor open for writing on its file, in which case the file should be finalized once the descriptor is actually closed.
+     */
+    bool Release(int fd, ReleasedOutput &released);
+
+    /**
+     * Releases every descriptor still open for writing, for a process that is about to exit.
+     */
+    void ReleaseAll(std::vector<ReleasedOutput> &released);
+
+    /**
+     * Gets the final size and modification time of a released file. Returns false if the path doesn't refer to that file anymore
+     * (e.g., it was renamed or deleted). Otherwise, the path is remembered as closed.
+     */
+    bool Finalize(const ReleasedOutput &released, ClosedOutput &closed);
+
+    /**
+     * Must be called in the parent right before it forks: the child inherits the descriptors, so the files they refer to may be
+     * written after this process closes them.
+     */
+    void StopTrackingShared();
+
+    /**
+     * Must be called in a forked child before it does anything else: another thread of the parent may have been in the middle of
+     * an update when it forked. Closed paths are kept: reopening them in the child still needs to be reported.
+     */
+    void ResetAfterFork() override;
+
+private:
+    struct OpenOutput {
+        std::string path;
+        dev_t device;
+        ino_t inode;
+        // Number of tracked descriptors open on this file
+        int descriptors;
+    };
+
+    // Must be called with the lock held
+    void Drop(int fd);
+
+    bool enabled_ = false;
+    std::mutex mtx_;
+    std::shared_ptr<OpenOutput> files_[kMaxFd];
+    // Files with at least one tracked descriptor, so independent opens of the same file are counted together. A process
+    // rarely has more than a handful of outputs open at a time.
+    std::vector<std::shared_ptr<OpenOutput>> open_;
+    std::unordered_set<std::string> closed_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_OUTPUT_CLOSE_TRACKER_H
@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "output_hash_tracker.hpp"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+// Tracking is a side effect of the interposed call: it must never change the errno the caller sees
+class ErrnoPreserver {
+public:
+    ErrnoPreserver() : errno_(errno) { }
+    ~ErrnoPreserver() { errno = errno_; }
+
+private:
+    int errno_;
+};
+
+static bool IsTrackable(int fd) {
+    return fd >= 0 && fd < OutputHashTracker::kMaxFd;
+}
+
+bool OutputHashTracker::Initialize(const char *hash_type) {
+    if (CreateContentHasher(hash_type) == nullptr) {
+        return false;
+    }
+
+    hash_type_.assign(hash_type);
+    return true;
+}
+
+void OutputHashTracker::Track(int fd, const char *path, int flags) {
+    int access_mode = flags & O_ACCMODE;
+    if (!IsEnabled() || !IsTrackable(fd) || (access_mode != O_WRONLY && access_mode != O_RDWR)) {
+        return;
+    }
+
+    ErrnoPreserver preserver;
+    struct stat st;
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // Whatever was tracked for this descriptor was closed in a way we didn't see
+    Drop(fd);
+
+    if (RawFstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size != 0) {
+        return;
+    }
+
+    std::unique_ptr<TrackedFile> file(new TrackedFile());
+    file->path.assign(path);
+    file->hasher = CreateContentHasher(hash_type_.c_str());
+    file->size = 0;
+    file->device = st.st_dev;
+    file->inode = st.st_ino;
+    file->mtime = st.st_mtim;
+
+    files_[fd] = std::move(file);
+    tracked_count_++;
+}
+
+void OutputHashTracker::Write(int fd, const void *buf, ssize_t written) {
+    struct iovec iov = { const_cast<void *>(buf), written > 0 ? (size_t)written : 0 };
+    Writev(fd, &iov, 1, written);
+}
+
+void OutputHashTracker::PositionalWrite(int fd, off_t offset, const void *buf, ssize_t written) {
+    struct iovec iov = { const_cast<void *>(buf), written > 0 ? (size_t)written : 0 };
+    PositionalWritev(fd, offset, &iov, 1, written);
+}
+
+void OutputHashTracker::Writev(int fd, const struct iovec *iov, int iovcnt, ssize_t written) {
+    // A sequential write lands wherever the previous one ended, which is the only offset PositionalWritev accepts
+    PositionalWritev(fd, -1, iov, iovcnt, written);
+}
+
+void OutputHashTracker::PositionalWritev(int fd, off_t offset, const struct iovec *iov, int iovcnt, ssize_t written) {
+    if (written <= 0 || !IsTrackable(fd) || !HasTrackedFiles()) {
+        return;
+    }
+
+    ErrnoPreserver preserver;
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    TrackedFile *file = files_[fd].get();
+    if (file == nullptr) {
+        return;
+    }
+
+    if (offset != -1 && offset != file->size) {
+        Drop(fd);
+        return;
+    }
+
+    // Short writes only consume a prefix of the buffers
+    size_t remaining = (size_t)written;
+    for (int i = 0; i < iovcnt && remaining > 0; i++) {
+        size_t length = std::min(remaining, iov[i].iov_len);
+        file->hasher->Update(iov[i].iov_base, length);
+        remaining -= length;
+    }
+
+    file->size += written;
+
+    struct stat st;
+    if (!Verify(fd, *file, st)) {
+        Drop(fd);
+        return;
+    }
+
+    file->mtime = st.st_mtim;
+}
+
+void OutputHashTracker::Invalidate(int fd) {
+    if (!IsTrackable(fd) || !HasTrackedFiles()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    Drop(fd);
+}
+
+void OutputHashTracker::InvalidatePath(const char *path) {
+    if (!HasTrackedFiles()) {
+        return;
+    }
+
+    // Files are matched by identity, so any path to a tracked file (e.g., through a symlink) invalidates it
+    ErrnoPreserver preserver;
+    struct stat st;
+    if (RawStat(path, &st) != 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        if (files_[fd] != nullptr && files_[fd]->device == st.st_dev && files_[fd]->inode == st.st_ino) {
+            Drop(fd);
+        }
+    }
+}
+
+bool OutputHashTracker::Complete(int fd, OutputHash &output) {
+    if (!IsTrackable(fd) || !HasTrackedFiles()) {
+        return false;
+    }
+
+    ErrnoPreserver preserver;
+    std::unique_ptr<TrackedFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (files_[fd] == nullptr) {
+            return false;
+        }
+
+        file = std::move(files_[fd]);
+        tracked_count_--;
+    }
+
+    // The file must not have changed since the last write we saw
+    struct stat st;
+    if (!Verify(fd, *file, st)
+        || st.st_mtim.tv_sec != file->mtime.tv_sec
+        || st.st_mtim.tv_nsec != file->mtime.tv_nsec) {
+        return false;
+    }
+
+    output.path = std::move(file->path);
+    output.size = file->size;
+    output.mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    output.hash = std::string(file->hasher->Name()) + ":" + file->hasher->Finish();
+    return true;
+}
+
+void OutputHashTracker::ResetAfterFork() {
+    ResetLock(mtx_);
+
+    for (int fd = 0; fd < kMaxFd; fd++) {
+        files_[fd].reset();
+    }
+
+    tracked_count_ = 0;
+}
+
+bool OutputHashTracker::Verify(int fd, const TrackedFile &file, struct stat &st) const {
+    return RawFstat(fd, &st) == 0
+        && st.st_dev == file.device
+        && st.st_ino == file.inode
+        && st.st_size == file.size;
+}
+
+void OutputHashTracker::Drop(int fd) {
+    if (files_[fd] != nullptr) {
+        files_[fd].reset();
+        tracked_count_--;
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
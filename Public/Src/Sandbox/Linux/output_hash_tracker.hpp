@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_OUTPUT_HASH_TRACKER_H
+#define BUILDXL_SANDBOX_LINUX_OUTPUT_HASH_TRACKER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "content_hasher.hpp"
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * The content hash of a file, computed while it was written.
+ */
+typedef struct OutputHash {
+    std::string path;
+    off_t size;
+    // st_mtim of the file when it was closed, in nanoseconds
+    int64_t mtime_ns;
+    // <hash type>:<hex>, as the engine renders content hashes (e.g., VSO0:1E57...00)
+    std::string hash;
+} OutputHash;
+
+/**
+ * Streams the content of the files a process writes through a content hasher, so their hash is known when they are closed
+ * and the engine doesn't need to read them back.
+ *
+ * A file is tracked from the moment it is opened for writing, if it is an empty regular file at that point. Its hash stays valid
+ * only while the process writes it strictly sequentially, from the start and through the tracked file descriptor. After every write
+ * the file is checked to be exactly as long as what was hashed, and to still be the same file, which catches seeks, gaps, overwrites
+ * that grow the file and writes that extend it from elsewhere. Anything else that can change the content behind the hasher's back
+ * (positional writes at other offsets, truncation, shared mappings, duplicated descriptors, sendfile/copy_file_range into the file,
+ * buffered streams on top of the descriptor) must be reported with Invalidate. When the file is closed, its size and modification time
+ * must still match what was observed after the last write.
+ *
+ * All file system operations go through raw syscalls, so the tracker is safe to use from within interposed functions.
+ * All methods preserve errno.
+ */
+class OutputHashTracker : public PostForkResettable {
+public:
+    // Descriptors beyond this are not tracked (same bound as the observer's fd table)
+    static const int kMaxFd = 1024;
+
+    OutputHashTracker() = default;
+    OutputHashTracker(const OutputHashTracker&) = delete;
+    OutputHashTracker& operator = (const OutputHashTracker&) = delete;
+
+    /**
+     * Enables the tracker for the given hash type. Returns false (and leaves the tracker disabled) if the hash type is not supported.
+     */
+    bool Initialize(const char *hash_type);
+
+    bool IsEnabled() const { return !hash_type_.empty(); }
+
+    // Starts tracking a file descriptor that was just opened with the given flags. Does nothing unless it was opened for writing
+    // and refers to an empty regular file.
+    void Track(int fd, const char *path, int flags);
+
+    // Sequential writes (write, writev): written is the return value of the write
+    void Write(int fd, const void *buf, ssize_t written);
+    void Writev(int fd, const struct iovec *iov, int iovcnt, ssize_t written);
+
+    // Positional writes (pwrite, pwritev): they only keep the hash valid if they append right where the previous write ended
+    void PositionalWrite(int fd, off_t offset, const void *buf, ssize_t written);
+    void PositionalWritev(int fd, off_t offset, const struct iovec *iov, int iovcnt, ssize_t written);
+
+    // Stops tracking a file descriptor without producing a hash
+    void Invalidate(int fd);
+
+    // Stops tracking any file descriptor for the file at the given path (e.g., when the file is truncated by path)
+    void InvalidatePath(const char *path);
+
+    /**
+     * Stops tracking a file descriptor that is about to be closed. Returns true and fills the hash if its content is known.
+     */
+    bool Complete(int fd, OutputHash &output);
+
+    /**
+     * Drops all the state inherited from the parent process. Must be called in a forked child before it does anything else:
+     * the parent may have been in the middle of an update when it forked.
+     */
+    void ResetAfterFork() override;
+
+private:
+    struct TrackedFile {
+        std::string path;
+        std::unique_ptr<ContentHasher> hasher;
+        off_t size;
+        dev_t device;
+        ino_t inode;
+        struct timespec mtime;
+    };
+
+    // Checks that the descriptor still refers to the tracked file, and that the file is exactly as long as what was hashed
+    bool Verify(int fd, const TrackedFile &file, struct stat &st) const;
+
+    // Must be called with the lock held
+    void Drop(int fd);
+
+    bool HasTrackedFiles() const { return tracked_count_.load(std::memory_order_relaxed) > 0; }
+
+    std::string hash_type_;
+    std::mutex mtx_;
+    std::unique_ptr<TrackedFile> files_[kMaxFd];
+    std::atomic<int> tracked_count_ { 0 };
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_OUTPUT_HASH_TRACKER_H
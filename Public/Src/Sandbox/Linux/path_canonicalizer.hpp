@@ -0,0 +1,188 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_PATH_CANONICALIZER_H
+#define BUILDXL_SANDBOX_LINUX_PATH_CANONICALIZER_H
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+namespace buildxl {
+namespace linux {
+
+typedef enum CanonicalizationResult {
+    // The path was fully canonicalized
+    kCanonicalized,
+
+    // Too many symlinks were followed, or the same symlink was reached twice with the same remaining path (a loop).
+    // The path is canonicalized lexically from that point on, without following any more symlinks.
+    kSymlinkLoop,
+
+    // The canonical path (or some intermediate expansion of a symlink) does not fit in PATH_MAX. The path is left untouched.
+    kNameTooLong,
+
+    // The hook asked to stop (see kStopCanonicalization). The path is left untouched.
+    kStopped
+} CanonicalizationResult;
+
+// Value a read_link hook returns to stop the canonicalization (e.g., when a component turns out not to exist and the caller needs it to)
+static const ssize_t kStopCanonicalization = -2;
+
+// Same bound the kernel uses before failing a path lookup with ELOOP
+static const int kMaxSymlinksFollowed = 40;
+
+namespace internal {
+
+inline uint64_t HashBytes(uint64_t hash, const char *data, size_t length) {
+    // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Removes the last component of a path held in 'path' (no trailing slash, the root being the empty string)
+inline void PopComponent(const char *path, size_t& length) {
+    const void *slash = memrchr(path, '/', length);
+    length = slash == nullptr ? 0 : (const char *)slash - path;
+}
+
+} // namespace internal
+
+/**
+ * Canonicalizes an absolute path in place: removes '.', '..' and repeated slashes and expands symlinks, in a single forward pass.
+ *
+ * The resolved prefix is built in a stack buffer, with component boundaries found with memchr. Every component is checked
+ * for being a symlink by calling 'read_link' on the resolved prefix that ends with it (the last component is only checked if
+ * follow_final_symlink is set, or if the path ends with a slash):
+ *
+ *     ssize_t read_link(const char *prefix, bool is_final, char *target, size_t target_size)
+ *
+ * which must behave as readlink(2): return the length of the target (not null terminated) or -1 if the prefix is not a symlink.
+ * It can also return kStopCanonicalization to give up. 'is_final' tells whether this is the last component of the path, i.e.,
+ * whether the rest of the path needs the prefix to be a directory. This is the hook where callers report the symlinks they go through.
+ * Since '..' is applied to the resolved prefix, the result is the physical path (as with realpath(3)), except that components
+ * do not need to exist.
+ *
+ * Nothing is allocated. Symlink loops are detected with a fixed-capacity set of (symlink, remaining path) hashes.
+ */
+template <typename ReadLink>
+CanonicalizationResult CanonicalizePath(char *path, bool follow_final_symlink, ReadLink read_link) {
+    // What is left to process
+    char pending[PATH_MAX];
+    size_t pending_length = strnlen(path, PATH_MAX);
+    if (pending_length >= PATH_MAX) {
+        return kNameTooLong;
+    }
+    memcpy(pending, path, pending_length);
+
+    // The canonical prefix processed so far, without a trailing slash: the root is the empty string
+    char resolved[PATH_MAX];
+    size_t resolved_length = 0;
+    resolved[0] = '\0';
+
+    char target[PATH_MAX];
+    uint64_t visited[kMaxSymlinksFollowed];
+    int visited_count = 0;
+    bool follow_symlinks = true;
+    CanonicalizationResult result = kCanonicalized;
+
+    size_t position = 0;
+    while (position < pending_length) {
+        if (pending[position] == '/') {
+            position++;
+            continue;
+        }
+
+        const char *start = pending + position;
+        const char *slash = (const char *)memchr(start, '/', pending_length - position);
+        size_t component_length = slash == nullptr ? pending_length - position : slash - start;
+        position += component_length;
+
+        if (component_length == 1 && start[0] == '.') {
+            continue;
+        }
+
+        if (component_length == 2 && start[0] == '.' && start[1] == '.') {
+            internal::PopComponent(resolved, resolved_length);
+            resolved[resolved_length] = '\0';
+            continue;
+        }
+
+        if (resolved_length + 1 + component_length >= PATH_MAX) {
+            return kNameTooLong;
+        }
+
+        size_t parent_length = resolved_length;
+        resolved[resolved_length++] = '/';
+        memcpy(resolved + resolved_length, start, component_length);
+        resolved_length += component_length;
+        resolved[resolved_length] = '\0';
+
+        bool is_final = position == pending_length;
+        if (!follow_symlinks || (is_final && !follow_final_symlink)) {
+            continue;
+        }
+
+        ssize_t target_length = read_link(resolved, is_final, target, PATH_MAX);
+        if (target_length == kStopCanonicalization) {
+            return kStopped;
+        }
+
+        if (target_length < 0) {
+            continue;
+        }
+
+        if (target_length == 0 || target_length >= PATH_MAX) {
+            // Not something we can follow: keep the symlink itself as part of the path
+            continue;
+        }
+
+        // Reaching the same symlink with the same remaining path again means we are in a loop
+        uint64_t state = internal::HashBytes(internal::HashBytes(14695981039346656037ull, resolved, resolved_length), pending + position, pending_length - position);
+        bool loop = visited_count == kMaxSymlinksFollowed;
+        for (int i = 0; i < visited_count && !loop; i++) {
+            loop = visited[i] == state;
+        }
+
+        if (loop) {
+            follow_symlinks = false;
+            result = kSymlinkLoop;
+            continue;
+        }
+        visited[visited_count++] = state;
+
+        // The rest of the path now goes after the symlink target
+        size_t rest_length = pending_length - position;
+        if ((size_t)target_length + rest_length >= PATH_MAX) {
+            return kNameTooLong;
+        }
+
+        memcpy(target + target_length, pending + position, rest_length);
+        pending_length = target_length + rest_length;
+        memcpy(pending, target, pending_length);
+        position = 0;
+
+        // An absolute target restarts from the root, a relative one replaces the symlink
+        resolved_length = target[0] == '/' ? 0 : parent_length;
+        resolved[resolved_length] = '\0';
+    }
+
+    if (resolved_length == 0) {
+        resolved[resolved_length++] = '/';
+    }
+
+    memcpy(path, resolved, resolved_length);
+    path[resolved_length] = '\0';
+    return result;
+}
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_PATH_CANONICALIZER_H
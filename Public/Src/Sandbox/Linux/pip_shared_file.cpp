@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "pip_shared_file.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+// Maps the file behind fd. Sets stale if the file belongs to a previous run.
+static void *Map(int fd, bool created, size_t size, uint64_t magic, const struct stat& fam_stat, bool& stale) {
+    if (created) {
+        if (RawFtruncate(fd, size) != 0) {
+            return nullptr;
+        }
+    }
+    else {
+        // The creator might not have sized the file yet
+        struct stat file_stat;
+        int waits = 0;
+        while (RawFstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size < size) {
+            if (++waits > kMaxPublicationWaits) {
+                return nullptr;
+            }
+            sched_yield();
+        }
+    }
+
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+
+    PipSharedHeader *header = (PipSharedHeader *)mapping;
+    uint64_t fam_mtime_ns = (uint64_t)fam_stat.st_mtim.tv_sec * 1000000000ull + fam_stat.st_mtim.tv_nsec;
+
+    if (created) {
+        header->fam_inode = fam_stat.st_ino;
+        header->fam_mtime_ns = fam_mtime_ns;
+        header->magic.store(magic, std::memory_order_release);
+        return mapping;
+    }
+
+    int waits = 0;
+    while (header->magic.load(std::memory_order_acquire) != magic) {
+        if (++waits > kMaxPublicationWaits) {
+            munmap(mapping, size);
+            return nullptr;
+        }
+        sched_yield();
+    }
+
+    if (header->fam_inode != fam_stat.st_ino || header->fam_mtime_ns != fam_mtime_ns) {
+        // Left behind by a previous run
+        stale = true;
+        munmap(mapping, size);
+        return nullptr;
+    }
+
+    return mapping;
+}
+
+void *MapPipSharedFile(const char *fam_path, const char *suffix, size_t size, uint64_t magic) {
+    struct stat fam_stat;
+    if (RawStat(fam_path, &fam_stat) != 0) {
+        return nullptr;
+    }
+
+    char path[PATH_MAX];
+    if (snprintf(path, PATH_MAX, "%s%s", fam_path, suffix) >= PATH_MAX) {
+        return nullptr;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool created = true;
+        int fd = RawOpen(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd == -1) {
+            if (errno != EEXIST) {
+                return nullptr;
+            }
+
+            created = false;
+            fd = RawOpen(path, O_RDWR | O_CLOEXEC);
+            if (fd == -1) {
+                return nullptr;
+            }
+        }
+
+        bool stale = false;
+        void *mapping = Map(fd, created, size, magic, fam_stat, stale);
+        RawClose(fd);
+        if (mapping != nullptr || !stale) {
+            return mapping;
+        }
+
+        RawUnlink(path);
+    }
+
+    return nullptr;
+}
+
+} // namespace linux
+} // namespace buildxl
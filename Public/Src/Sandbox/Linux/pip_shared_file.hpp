@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_PIP_SHARED_FILE_H
+#define BUILDXL_SANDBOX_LINUX_PIP_SHARED_FILE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * The header a pip-wide shared file starts with (see MapPipSharedFile). Structures that live in such a file put it first.
+ */
+typedef struct PipSharedHeader {
+    std::atomic<uint64_t> magic;
+    // Identity of the FAM the file was created for
+    uint64_t fam_inode;
+    uint64_t fam_mtime_ns;
+} PipSharedHeader;
+
+// Bound on the number of times a process yields while waiting for another process to publish something in a pip-wide shared file
+static const int kMaxPublicationWaits = 1000;
+
+/**
+ * Maps (read-write, shared) a file that all the processes of a pip use to coordinate: '<fam_path><suffix>', created by whichever
+ * process of the pip gets there first. Returns the mapping, 'size' bytes long and starting with a PipSharedHeader, or nullptr.
+ *
+ * The creator sizes the file, which is sparse and zero filled, stamps the header with the identity of the FAM and publishes 'magic'
+ * last: whatever follows the header must be valid when zeroed. The other processes wait for the size and the magic, and check the
+ * stamp. A file left behind by a previous run (for another FAM) is unlinked and created again, but only once: if we race with
+ * another process doing the same, we would rather give up (and let the caller fall back to per-process behavior) than keep replacing
+ * each other's files.
+ *
+ * All file system operations go through raw syscalls, so this is safe to call from within interposed functions.
+ */
+void *MapPipSharedFile(const char *fam_path, const char *suffix, size_t size, uint64_t magic);
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_PIP_SHARED_FILE_H
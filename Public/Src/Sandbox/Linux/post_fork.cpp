@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+// Components are registered while the observer is constructed, before the process gets a chance to fork
+static PostForkResettable *g_components[kMaxPostForkResets];
+static int g_count = 0;
+
+bool RegisterPostForkReset(PostForkResettable *component) {
+    if (g_count == kMaxPostForkResets) {
+        return false;
+    }
+
+    g_components[g_count++] = component;
+    return true;
+}
+
+void RunPostForkResets() {
+    for (int i = 0; i < g_count; i++) {
+        g_components[i]->ResetAfterFork();
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
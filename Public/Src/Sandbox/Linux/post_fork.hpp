@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_POST_FORK_H
+#define BUILDXL_SANDBOX_LINUX_POST_FORK_H
+
+#include <mutex>
+#include <new>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * State that a child process can't take over from its parent as it is: the child of a fork (or of a clone that gets its own copy of
+ * the address space) starts with a single thread, while other threads of the parent may have been in the middle of an update, or
+ * holding a lock that nobody will ever release in the child.
+ *
+ * Components holding such state register with RegisterPostForkReset, and the fork, vfork and clone interposers reset all of them
+ * in the child (see RunPostForkResets) before it does anything else.
+ */
+class PostForkResettable {
+public:
+    virtual void ResetAfterFork() = 0;
+
+protected:
+    ~PostForkResettable() = default;
+
+    // The child is single threaded: a lock another thread of the parent held when it forked is replaced by a fresh one
+    static void ResetLock(std::mutex &mtx) { new (&mtx) std::mutex(); }
+};
+
+// Registered components beyond this are not reset (the observer registers a handful of them, once)
+static const int kMaxPostForkResets = 16;
+
+/**
+ * Registers a component to reset in the children of this process, for as long as the process lives: components are registered
+ * by the observer (a process-wide singleton) when it is constructed. Not thread safe. Returns false if there is no room left.
+ */
+bool RegisterPostForkReset(PostForkResettable *component);
+
+/**
+ * Resets every registered component, in registration order. Must only be called in the child, right after it was created.
+ */
+void RunPostForkResets();
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_POST_FORK_H
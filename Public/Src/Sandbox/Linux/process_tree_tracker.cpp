@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "process_tree_tracker.hpp"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+static const size_t kHeaderSize = 64;
+
+static size_t MappingSize() {
+    return kHeaderSize + ProcessTreeTracker::kSlotCount * sizeof(int32_t);
+}
+
+bool ProcessTreeTracker::Initialize(const char *fam_path) {
+    static_assert(sizeof(Header) <= kHeaderSize, "Tracker header does not fit");
+    static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "Unexpected tracker slot size");
+
+    void *mapping = MapPipSharedFile(fam_path, kFileSuffix, MappingSize(), kMagic);
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    header_ = (Header *)mapping;
+    slots_ = (std::atomic<int32_t> *)((char *)mapping + kHeaderSize);
+    return true;
+}
+
+void ProcessTreeTracker::Register(pid_t pid) {
+    if (IsDisabled()) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < kSlotCount; i++) {
+        if (slots_[i].load(std::memory_order_acquire) == pid) {
+            return;
+        }
+    }
+
+    if (Claim(pid) == -1) {
+        Disable();
+    }
+}
+
+int ProcessTreeTracker::ReserveChild() {
+    if (IsDisabled()) {
+        return -1;
+    }
+
+    int slot = Claim(kReservedSlot);
+    if (slot == -1) {
+        Disable();
+    }
+
+    return slot;
+}
+
+void ProcessTreeTracker::CompleteChild(int slot, pid_t fork_result) {
+    if (header_ == nullptr || slot < 0) {
+        return;
+    }
+
+    if (fork_result == -1) {
+        ReleaseSlot(slot, kReservedSlot);
+        return;
+    }
+
+    // In the child, the fork returns 0
+    int32_t expected = kReservedSlot;
+    slots_[slot].compare_exchange_strong(expected, fork_result == 0 ? getpid() : fork_result, std::memory_order_acq_rel);
+}
+
+bool ProcessTreeTracker::Release(pid_t pid, bool sweep_all) {
+    if (IsDisabled()) {
+        return false;
+    }
+
+    bool completed = false;
+    for (uint32_t i = 0; i < kSlotCount; i++) {
+        if (slots_[i].load(std::memory_order_acquire) == pid) {
+            completed = ReleaseSlot(i, pid);
+            break;
+        }
+    }
+
+    if (!completed && (sweep_all || header_->live.load(std::memory_order_acquire) <= kMaxSweptProcesses)) {
+        uint32_t next_slot = 0;
+        do {
+            completed = SweepDeadProcesses(next_slot);
+        } while (!completed && sweep_all && next_slot < kSlotCount);
+    }
+
+    return completed && !IsDisabled();
+}
+
+void ProcessTreeTracker::Disable() {
+    if (header_ != nullptr) {
+        header_->disabled.store(1, std::memory_order_release);
+    }
+}
+
+int ProcessTreeTracker::Claim(int32_t value) {
+    // Count first, so the tree is never seen as complete while a slot is being claimed
+    header_->live.fetch_add(1, std::memory_order_acq_rel);
+
+    uint32_t start = value > 0 ? (uint32_t)value % kSlotCount : 0;
+    for (uint32_t probes = 0; probes < kSlotCount; probes++) {
+        uint32_t i = (start + probes) % kSlotCount;
+        int32_t expected = kFreeSlot;
+        if (slots_[i].load(std::memory_order_relaxed) == kFreeSlot
+            && slots_[i].compare_exchange_strong(expected, value, std::memory_order_acq_rel)) {
+            return (int)i;
+        }
+    }
+
+    // Full. The count stays up, so the tree is never completed from here on.
+    return -1;
+}
+
+bool ProcessTreeTracker::ReleaseSlot(int slot, int32_t expected) {
+    if (!slots_[slot].compare_exchange_strong(expected, kFreeSlot, std::memory_order_acq_rel)) {
+        // Someone else released it
+        return false;
+    }
+
+    return header_->live.fetch_sub(1, std::memory_order_acq_rel) == 1;
+}
+
+bool ProcessTreeTracker::SweepDeadProcesses(uint32_t& next_slot) {
+    pid_t pids[kMaxSweptProcesses];
+    int slots[kMaxSweptProcesses];
+    int count = 0;
+    for (; next_slot < kSlotCount && count < kMaxSweptProcesses; next_slot++) {
+        int32_t pid = slots_[next_slot].load(std::memory_order_acquire);
+        if (pid > 0 && pid != getpid()) {
+            pids[count] = pid;
+            slots[count++] = next_slot;
+        }
+    }
+
+    if (count == 0) {
+        return false;
+    }
+
+    int epoll_fd = (int)syscall(SYS_epoll_create1, EPOLL_CLOEXEC);
+    if (epoll_fd == -1) {
+        return false;
+    }
+
+    bool completed = false;
+    int pidfds[kMaxSweptProcesses];
+    for (int i = 0; i < count; i++) {
+        pidfds[i] = RawPidfdOpen(pids[i]);
+        if (pidfds[i] == -1) {
+            // ESRCH: the process is gone (and already reaped). Anything else (e.g., ENOSYS on kernels older than 5.3) means we can't tell.
+            if (errno == ESRCH) {
+                completed |= ReleaseSlot(slots[i], pids[i]);
+            }
+            continue;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u32 = i;
+        syscall(SYS_epoll_ctl, epoll_fd, EPOLL_CTL_ADD, pidfds[i], &event);
+    }
+
+    // A pidfd is readable once its process exits, even if it wasn't reaped yet. Never wait: we are on the way out of a process.
+    struct epoll_event ready[kMaxSweptProcesses];
+    int ready_count = (int)syscall(SYS_epoll_pwait, epoll_fd, ready, kMaxSweptProcesses, 0, nullptr, 0);
+    for (int i = 0; i < ready_count; i++) {
+        int index = ready[i].data.u32;
+        completed |= ReleaseSlot(slots[index], pids[index]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (pidfds[i] != -1) {
+            RawClose(pidfds[i]);
+        }
+    }
+    RawClose(epoll_fd);
+
+    return completed;
+}
+
+} // namespace linux
+} // namespace buildxl
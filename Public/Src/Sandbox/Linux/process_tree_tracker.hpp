@@ -0,0 +1,122 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_PROCESS_TREE_TRACKER_H
+#define BUILDXL_SANDBOX_LINUX_PROCESS_TREE_TRACKER_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "pip_shared_file.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Pip-wide set of live processes, used to tell when the whole process tree of a pip is done.
+ *
+ * The set lives in a file-backed shared mapping next to the FAM, so every interposed process of the pip shares it. The parent
+ * reserves a slot for a child before forking it, so the count can't drop to zero while a child is being created, and the slot is
+ * claimed with the child pid right after the fork. A process releases its slot when it exits. Whoever releases the last slot
+ * completes the tree.
+ *
+ * Processes that die without running exit handlers (e.g., SIGKILL) never release their slots. To catch those, a process that
+ * exits while only a few others are left checks them with pidfd_open + epoll and releases the slots of the ones that are gone.
+ * The root process of the pip checks all of them when it exits, however many are left. There is no periodic sweep: processes
+ * that die after the last sweep keep the tree open until the managed side finds them dead (see CheckActiveProcesses in
+ * SandboxConnectionLinuxDetours.cs), so this only ever delays the completion of the tree.
+ *
+ * All operations are lock-free. Processes that start without going through an interposed fork (e.g., the root process, or
+ * processes created by posix_spawn) register themselves when the sandbox is loaded.
+ */
+class ProcessTreeTracker {
+public:
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    static constexpr const char *kFileSuffix = ".tree";
+
+    // The mapping is intentionally never unmapped: processes release their slots from exit handlers
+    // that may run after static destructors, and the kernel releases the mapping on exit anyway.
+    ProcessTreeTracker() : header_(nullptr), slots_(nullptr) { }
+    ProcessTreeTracker(const ProcessTreeTracker&) = delete;
+    ProcessTreeTracker& operator = (const ProcessTreeTracker&) = delete;
+
+    /**
+     * Maps the tracker associated with the given FAM, creating it if this is the first process of the pip that needs it.
+     * A tracker left behind by a previous run (i.e., created for a different FAM file) is replaced.
+     */
+    bool Initialize(const char *fam_path);
+
+    bool IsInitialized() const { return header_ != nullptr; }
+
+    /**
+     * Adds the given process to the tree, unless it already has a slot (e.g., it was forked by an interposed process and then exec'd).
+     */
+    void Register(pid_t pid);
+
+    /**
+     * Reserves a slot for a child that is about to be forked. Returns the slot, or -1 if there is no slot for it (in which case
+     * the tracker is disabled: the tree can't be tracked anymore).
+     */
+    int ReserveChild();
+
+    /**
+     * Claims the slot reserved by ReserveChild. Called both by the parent and by the child after the fork, with the result of the fork:
+     * whichever runs first claims the slot with the child pid. A failed fork (-1) gives the slot back.
+     */
+    void CompleteChild(int slot, pid_t fork_result);
+
+    /**
+     * Removes the given process from the tree. Returns true if this completed the tree: no tracked process is left alive.
+     * Dead processes are swept if only a few are left, or regardless of their number if 'sweep_all' is set.
+     * Calling it more than once for the same process is harmless.
+     */
+    bool Release(pid_t pid, bool sweep_all = false);
+
+    /**
+     * Stops tracking the tree for good, for all processes of the pip. Used when part of the tree can't be tracked
+     * (e.g., processes that run under ptrace), so the tree is never reported as complete too early.
+     */
+    void Disable();
+
+    bool IsDisabled() const { return header_ == nullptr || header_->disabled.load(std::memory_order_acquire) != 0; }
+
+    // Number of tracked processes, exposed for tests
+    int LiveCount() const { return header_ == nullptr ? 0 : header_->live.load(std::memory_order_acquire); }
+
+    // Layout constants, exposed for tests
+    static const uint32_t kSlotCount = 4096;
+
+    // Dead processes are only looked for when this many processes (or fewer) are left: a tree with many live processes is not about
+    // to complete, and this keeps exits cheap in big trees. Also the number of processes checked at once by a sweep.
+    static const int kMaxSweptProcesses = 64;
+
+private:
+    struct Header {
+        PipSharedHeader shared;
+        std::atomic<int32_t> live;
+        std::atomic<uint32_t> disabled;
+    };
+
+    // A slot holds the pid of a live process, kFreeSlot or kReservedSlot
+    static const int32_t kFreeSlot = 0;
+    static const int32_t kReservedSlot = -1;
+
+    static const uint64_t kMagic = 0x4258'4c50'5452'0001ull;
+
+    int Claim(int32_t value);
+    bool ReleaseSlot(int slot, int32_t expected);
+    // Releases the slots of processes that are gone, checking up to kMaxSweptProcesses of them starting at 'next_slot', which is
+    // advanced past the last slot looked at. Returns true if that completed the tree.
+    bool SweepDeadProcesses(uint32_t& next_slot);
+
+    Header *header_;
+    std::atomic<int32_t> *slots_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_PROCESS_TREE_TRACKER_H
@@ -2,6 +2,8 @@
 // Licensed under the MIT License.
 
 #include "PTraceSandbox.hpp"
+#include "EbpfSandbox.hpp"
+#include "FanotifySandbox.hpp"
 
 bool verifyargs(BxlObserver *bxl, pid_t traceepid, std::string exe)
 {
@@ -73,6 +75,37 @@ int main(int argc, char **argv)
 
     semaphoreName.append(std::to_string(traceepid));
 
+    // A marker left behind by a runner that died before the tracee saw it must not make this tracee skip the seccomp filter
+    sem_unlink((semaphoreName + PTraceSandbox::kUntracedSemaphoreSuffix).c_str());
+
+    // Statically linked processes can be observed with eBPF or fanotify instead when the pip opts in and the backend is available to
+    // the runner. Otherwise (e.g., the runner lacks the capabilities, or the kernel is too old) the process is ptraced as usual.
+    const char *ebpfBackend = getenv(BxlEnvEbpfBackend);
+    if (ebpfBackend != NULL && strcmp(ebpfBackend, "1") == 0)
+    {
+        EbpfSandbox ebpf(bxl);
+        if (ebpf.Initialize())
+        {
+            ebpf.ObserveProcessTree(traceepid, exe, semaphoreName);
+            _exit(0);
+        }
+
+        BXL_LOG_DEBUG(bxl, "[eBPF] eBPF is not available, falling back to ptrace for PID '%d'", traceepid);
+    }
+
+    const char *fanotifyBackend = getenv(BxlEnvFanotifyBackend);
+    if (fanotifyBackend != NULL && strcmp(fanotifyBackend, "1") == 0)
+    {
+        FanotifySandbox fanotify(bxl);
+        if (fanotify.Initialize())
+        {
+            fanotify.ObserveProcessTree(traceepid, exe, semaphoreName);
+            _exit(0);
+        }
+
+        BXL_LOG_DEBUG(bxl, "[Fanotify] fanotify is not available, falling back to ptrace for PID '%d'", traceepid);
+    }
+
     sandbox.AttachToProcess(traceepid, exe, semaphoreName);
 
     _exit(0);
@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_RAW_SYSCALLS_H
+#define BUILDXL_SANDBOX_LINUX_RAW_SYSCALLS_H
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * File system operations for code that runs from within interposed functions (the observer and its trackers).
+ *
+ * They go straight to the kernel, so they are never interposed (and reported as accesses of the pip) themselves,
+ * whatever libc function the sandbox happens to interpose. Like the syscalls, they return -1 and set errno on failure.
+ */
+
+inline int RawOpen(const char *path, int flags, mode_t mode = 0) { return (int)syscall(SYS_openat, AT_FDCWD, path, flags, mode); }
+inline int RawClose(int fd) { return (int)syscall(SYS_close, fd); }
+inline ssize_t RawRead(int fd, void *buf, size_t count) { return (ssize_t)syscall(SYS_read, fd, buf, count); }
+inline ssize_t RawWrite(int fd, const void *buf, size_t count) { return (ssize_t)syscall(SYS_write, fd, buf, count); }
+inline off_t RawSeek(int fd, off_t offset, int whence) { return (off_t)syscall(SYS_lseek, fd, offset, whence); }
+inline int RawFstat(int fd, struct stat *buf) { return (int)syscall(SYS_fstat, fd, buf); }
+inline int RawStat(const char *path, struct stat *buf) { return (int)syscall(SYS_newfstatat, AT_FDCWD, path, buf, 0); }
+inline int RawLstat(const char *path, struct stat *buf) { return (int)syscall(SYS_newfstatat, AT_FDCWD, path, buf, AT_SYMLINK_NOFOLLOW); }
+inline int RawFtruncate(int fd, off_t length) { return (int)syscall(SYS_ftruncate, fd, length); }
+inline int RawUnlink(const char *path) { return (int)syscall(SYS_unlinkat, AT_FDCWD, path, 0); }
+inline int RawRename(const char *from, const char *to) { return (int)syscall(SYS_renameat, AT_FDCWD, from, AT_FDCWD, to); }
+inline int RawFadvise(int fd, off_t offset, off_t length, int advice) { return (int)syscall(SYS_fadvise64, fd, offset, length, advice); }
+inline ssize_t RawSplice(int fd_in, loff_t *off_in, int fd_out, loff_t *off_out, size_t length, unsigned int flags) {
+    return (ssize_t)syscall(SYS_splice, fd_in, off_in, fd_out, off_out, length, flags);
+}
+inline int RawPidfdOpen(pid_t pid) { return (int)syscall(SYS_pidfd_open, pid, 0); }
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_RAW_SYSCALLS_H
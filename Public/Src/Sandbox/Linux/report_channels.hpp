@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_REPORT_CHANNELS_H
+#define BUILDXL_SANDBOX_LINUX_REPORT_CHANNELS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+namespace buildxl {
+namespace linux {
+
+// Upper bound on the number of report channels a pip can use.
+static const int kMaxReportChannels = 16;
+
+/**
+ * Clamps the number of report channels the FAM advertises for the pip to [1, kMaxReportChannels].
+ * A single channel is the original single FIFO behavior.
+ */
+inline int ClampReportChannelCount(uint32_t count) {
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    if (count < 1) {
+        return 1;
+    }
+
+    return count > (uint32_t)kMaxReportChannels ? kMaxReportChannels : (int)count;
+}
+
+/**
+ * Selects the report channel for the given pid.
+ *
+ * A process always reports on the same channel, so reports coming from a single process keep their relative order.
+ * Pids are hashed (multiplicative hashing) so that sequential pids, which is what a process tree usually gets,
+ * are spread over all channels.
+ */
+inline int SelectReportChannel(pid_t pid, int channel_count) {
+    if (channel_count <= 1) {
+        return 0;
+    }
+
+    uint32_t hash = (uint32_t)pid * 2654435769u;
+    return (int)(((uint64_t)hash * (uint64_t)channel_count) >> 32);
+}
+
+/**
+ * Writes the path of the given channel into buffer.
+ * Channel 0 is the reports path from the manifest, channel N > 0 is '<reports path>.N'.
+ * Returns false if the path does not fit in the buffer.
+ */
+inline bool GetReportChannelPath(const char *reports_path, int channel, char *buffer, size_t buffer_size) {
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    int written = channel == 0
+        ? snprintf(buffer, buffer_size, "%s", reports_path)
+        : snprintf(buffer, buffer_size, "%s.%d", reports_path, channel);
+
+    return written >= 0 && (size_t)written < buffer_size;
+}
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_REPORT_CHANNELS_H
@@ -0,0 +1,171 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+#include "report_lag_analysis.hpp"
+
+using buildxl::linux::ParseTimedReport;
+using buildxl::linux::ReportLagAnalysis;
+using buildxl::linux::ReportTiming;
+
+/**
+ * Computes end-to-end report lag distributions for the Linux sandbox.
+ *
+ * The sandbox must run with EnableLinuxSandboxReportTimestamps set in the FAM, so every report carries the CLOCK_MONOTONIC time
+ * at which the access was observed and a per-pid sequence number (see BxlObserver::BuildReport). This tool stands in for the
+ * managed reader: it drains the reports FIFO, timestamps every report on arrival and computes the lag as the difference
+ * between both. Received reports can be saved to a capture file ('<arrival>|<report>' per line) and analyzed again later.
+ *
+ * Usage:
+ *   report_lag -f <reports fifo> [-w <capture file>] [-t <idle timeout in seconds>]
+ *   report_lag -r <capture file>
+ */
+
+static uint64_t MonotonicTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int Replay(const char *capture_path) {
+    FILE *capture = fopen(capture_path, "r");
+    if (capture == nullptr) {
+        fprintf(stderr, "Could not open capture '%s': %s\n", capture_path, strerror(errno));
+        return 1;
+    }
+
+    ReportLagAnalysis analysis;
+    char *line = nullptr;
+    size_t line_size = 0;
+    while (getline(&line, &line_size, capture) != -1) {
+        char *report = nullptr;
+        uint64_t arrival = strtoull(line, &report, 10);
+        ReportTiming timing;
+        if (report == nullptr || *report != '|' || !ParseTimedReport(report + 1, arrival, timing)) {
+            analysis.AddMalformed();
+            continue;
+        }
+
+        analysis.Add(timing);
+    }
+
+    free(line);
+    fclose(capture);
+    analysis.Print(stdout);
+    return 0;
+}
+
+static int Capture(const char *fifo_path, const char *capture_path, int idle_timeout_seconds) {
+    // Writers open and close the FIFO for every report, so open it read-write to avoid seeing EOF in between reports.
+    int fd = open(fifo_path, O_RDWR);
+    if (fd == -1) {
+        fprintf(stderr, "Could not open reports FIFO '%s': %s\n", fifo_path, strerror(errno));
+        return 1;
+    }
+
+    FILE *capture = nullptr;
+    if (capture_path != nullptr) {
+        capture = fopen(capture_path, "w");
+        if (capture == nullptr) {
+            fprintf(stderr, "Could not open capture '%s': %s\n", capture_path, strerror(errno));
+            close(fd);
+            return 1;
+        }
+    }
+
+    ReportLagAnalysis analysis;
+    std::string pending;
+    char buffer[64 * 1024];
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    // Stop once no reports arrived for the idle timeout
+    while (poll(&pfd, 1, idle_timeout_seconds * 1000) > 0) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        uint64_t arrival = MonotonicTimeNs();
+        if (n <= 0) {
+            break;
+        }
+
+        pending.append(buffer, n);
+        size_t offset = 0;
+        while (pending.size() - offset >= sizeof(uint)) {
+            uint length = *(const uint*)(pending.data() + offset);
+            if (pending.size() - offset - sizeof(uint) < length) {
+                break;
+            }
+
+            std::string report(pending.data() + offset + sizeof(uint), length);
+            offset += sizeof(uint) + length;
+
+            ReportTiming timing;
+            if (!ParseTimedReport(report, arrival, timing)) {
+                analysis.AddMalformed();
+                continue;
+            }
+
+            analysis.Add(timing);
+            if (capture != nullptr) {
+                // Reports already end with a new line
+                fprintf(capture, "%lu|%s", (unsigned long)arrival, report.c_str());
+            }
+        }
+        pending.erase(0, offset);
+    }
+
+    if (capture != nullptr) {
+        fclose(capture);
+    }
+    close(fd);
+
+    analysis.Print(stdout);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *fifo_path = nullptr;
+    const char *capture_path = nullptr;
+    const char *replay_path = nullptr;
+    int idle_timeout_seconds = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:w:r:t:")) != -1) {
+        switch (opt) {
+            case 'f':
+                fifo_path = optarg;
+                break;
+            case 'w':
+                capture_path = optarg;
+                break;
+            case 'r':
+                replay_path = optarg;
+                break;
+            case 't':
+                idle_timeout_seconds = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s -f <reports fifo> [-w <capture file>] [-t <idle timeout>] | -r <capture file>\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (replay_path != nullptr) {
+        return Replay(replay_path);
+    }
+
+    if (fifo_path == nullptr) {
+        fprintf(stderr, "Usage: %s -f <reports fifo> [-w <capture file>] [-t <idle timeout>] | -r <capture file>\n", argv[0]);
+        return 1;
+    }
+
+    return Capture(fifo_path, capture_path, idle_timeout_seconds);
+}
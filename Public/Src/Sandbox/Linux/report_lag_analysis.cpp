@@ -0,0 +1,82 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "report_lag_analysis.hpp"
+#include "report_line.hpp"
+
+#include <algorithm>
+
+namespace buildxl {
+namespace linux {
+
+bool ParseTimedReport(std::string_view report, uint64_t arrival, ReportTiming& timing) {
+    ParsedReport parsed;
+    if (!ParseReportLine(report, /* has_timestamps */ true, parsed)) {
+        return false;
+    }
+
+    timing.pid = parsed.pid;
+    timing.operation = parsed.operation;
+    timing.observed = parsed.timestamp;
+    timing.arrival = arrival;
+    timing.sequence_number = parsed.sequence_number;
+    return true;
+}
+
+void ReportLagAnalysis::Add(const ReportTiming& timing) {
+    uint64_t lag = timing.arrival > timing.observed ? timing.arrival - timing.observed : 0;
+    all_.push_back(lag);
+    by_operation_[timing.operation].push_back(lag);
+
+    // Reports about the same pid are expected to arrive in the order they were sent
+    auto it = last_sequence_number_.find(timing.pid);
+    if (it != last_sequence_number_.end() && timing.sequence_number != 0 && timing.sequence_number <= it->second) {
+        reordered_++;
+    }
+
+    last_sequence_number_[timing.pid] = timing.sequence_number;
+}
+
+uint64_t ReportLagAnalysis::LagPercentile(double percentile) {
+    return Percentile(all_, percentile);
+}
+
+uint64_t ReportLagAnalysis::LagPercentile(int operation, double percentile) {
+    auto it = by_operation_.find(operation);
+    return it == by_operation_.end() ? 0 : Percentile(it->second, percentile);
+}
+
+uint64_t ReportLagAnalysis::Percentile(std::vector<uint64_t>& lags, double percentile) {
+    if (lags.empty()) {
+        return 0;
+    }
+
+    std::sort(lags.begin(), lags.end());
+    size_t index = (size_t)(percentile / 100.0 * (lags.size() - 1));
+    return lags[index];
+}
+
+void ReportLagAnalysis::PrintDistribution(FILE *out, const char *name, std::vector<uint64_t>& lags) {
+    fprintf(out, "%-24s count: %8zu  min: %9.1f  p50: %9.1f  p90: %9.1f  p99: %9.1f  p99.9: %9.1f  max: %9.1f (us)\n",
+        name,
+        lags.size(),
+        Percentile(lags, 0) / 1000.0,
+        Percentile(lags, 50) / 1000.0,
+        Percentile(lags, 90) / 1000.0,
+        Percentile(lags, 99) / 1000.0,
+        Percentile(lags, 99.9) / 1000.0,
+        Percentile(lags, 100) / 1000.0);
+}
+
+void ReportLagAnalysis::Print(FILE *out) {
+    fprintf(out, "Reports: %zu, processes: %zu, reordered: %zu, malformed: %zu\n", Count(), Processes(), reordered_, malformed_);
+    PrintDistribution(out, "all", all_);
+    for (auto& entry : by_operation_) {
+        char name[32];
+        snprintf(name, sizeof(name), "operation %d", entry.first);
+        PrintDistribution(out, name, entry.second);
+    }
+}
+
+} // namespace linux
+} // namespace buildxl
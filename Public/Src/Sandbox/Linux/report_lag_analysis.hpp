@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_REPORT_LAG_ANALYSIS_H
+#define BUILDXL_SANDBOX_LINUX_REPORT_LAG_ANALYSIS_H
+
+#include <map>
+#include <stdint.h>
+#include <stdio.h>
+#include <string_view>
+#include <sys/types.h>
+#include <unordered_map>
+#include <vector>
+
+namespace buildxl {
+namespace linux {
+
+typedef struct ReportTiming {
+    pid_t pid;
+    int operation;
+    // CLOCK_MONOTONIC time at which the sandbox observed the access
+    uint64_t observed;
+    // CLOCK_MONOTONIC time at which the report was read from the FIFO
+    uint64_t arrival;
+    uint64_t sequence_number;
+} ReportTiming;
+
+/**
+ * Parses a report sent while EnableLinuxSandboxReportTimestamps is set in the FAM. Returns false if the report is malformed.
+ */
+bool ParseTimedReport(std::string_view report, uint64_t arrival, ReportTiming& timing);
+
+/**
+ * Lag distributions and reordering counts over a set of timestamped reports (see report_lag.cpp).
+ */
+class ReportLagAnalysis {
+public:
+    void Add(const ReportTiming& timing);
+    void AddMalformed() { malformed_++; }
+
+    size_t Count() const { return all_.size(); }
+    size_t Processes() const { return last_sequence_number_.size(); }
+    size_t Malformed() const { return malformed_; }
+
+    /**
+     * Reports about a pid that arrived with a sequence number not greater than the previous one for the same pid.
+     * A sequence number of 0 starts a new sequence: the pid exec'ed and a new sandbox instance is reporting on its behalf.
+     */
+    size_t Reordered() const { return reordered_; }
+
+    /**
+     * Lag at the given percentile (in [0, 100]) over all reports, or over the reports for the given operation.
+     */
+    uint64_t LagPercentile(double percentile);
+    uint64_t LagPercentile(int operation, double percentile);
+
+    void Print(FILE *out);
+
+private:
+    static uint64_t Percentile(std::vector<uint64_t>& lags, double percentile);
+    static void PrintDistribution(FILE *out, const char *name, std::vector<uint64_t>& lags);
+
+    std::vector<uint64_t> all_;
+    std::map<int, std::vector<uint64_t>> by_operation_;
+    std::unordered_map<pid_t, uint64_t> last_sequence_number_;
+    size_t reordered_ = 0;
+    size_t malformed_ = 0;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_REPORT_LAG_ANALYSIS_H
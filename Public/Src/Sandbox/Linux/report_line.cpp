@@ -0,0 +1,90 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "report_line.hpp"
+
+#include <errno.h>
+#include <stdlib.h>
+
+namespace buildxl {
+namespace linux {
+
+// Consumes the next '|' separated field of the line. Returns false if there is no separator left.
+static bool NextField(std::string_view& line, std::string_view& field) {
+    size_t separator = line.find('|');
+    if (separator == std::string_view::npos) {
+        return false;
+    }
+
+    field = line.substr(0, separator);
+    line.remove_prefix(separator + 1);
+    return true;
+}
+
+static bool NextNumber(std::string_view& line, uint64_t& value) {
+    std::string_view field;
+    if (!NextField(line, field) || field.empty() || field.length() > 20) {
+        return false;
+    }
+
+    // Fields are not null terminated, so copy them before handing them to strtoull
+    char buffer[24];
+    field.copy(buffer, field.length());
+    buffer[field.length()] = '\0';
+
+    // Negative numbers are valid: the fields are printed with %d
+    const char *start = buffer[0] == '-' ? buffer + 1 : buffer;
+    char *end = nullptr;
+    errno = 0;
+    uint64_t parsed = strtoull(start, &end, 10);
+    if (end == start || *end != '\0' || errno != 0) {
+        return false;
+    }
+
+    value = buffer[0] == '-' ? (uint64_t)(-(int64_t)parsed) : parsed;
+    return true;
+}
+
+bool ParseReportLine(std::string_view line, bool has_timestamps, ParsedReport& report) {
+    if (!line.empty() && line.back() == '\n') {
+        line.remove_suffix(1);
+    }
+
+    // CODESYNC: BxlObserver::BuildReport
+    std::string_view progname;
+    uint64_t pid, requested_access, status, report_explicitly, error, operation, is_directory, unexpected;
+    if (!NextField(line, progname)
+        || !NextNumber(line, pid)
+        || !NextNumber(line, requested_access)
+        || !NextNumber(line, status)
+        || !NextNumber(line, report_explicitly)
+        || !NextNumber(line, error)
+        || !NextNumber(line, operation)
+        || !NextNumber(line, is_directory)
+        || !NextNumber(line, unexpected)) {
+        return false;
+    }
+
+    uint64_t timestamp = 0, sequence_number = 0;
+    if (has_timestamps && (!NextNumber(line, timestamp) || !NextNumber(line, sequence_number))) {
+        return false;
+    }
+
+    report.progname.assign(progname);
+    report.pid = (pid_t)pid;
+    report.requested_access = (uint32_t)requested_access;
+    report.status = (uint32_t)status;
+    report.report_explicitly = (uint32_t)report_explicitly;
+    report.error = (uint32_t)error;
+    report.operation = (int)operation;
+    report.is_directory = (uint32_t)is_directory;
+    report.unexpected = (uint32_t)unexpected;
+    report.timestamp = timestamp;
+    report.sequence_number = sequence_number;
+    report.path.assign(line);
+
+    return true;
+}
+
+} // namespace linux
+} // namespace buildxl
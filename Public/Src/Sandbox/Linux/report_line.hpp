@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_REPORT_LINE_H
+#define BUILDXL_SANDBOX_LINUX_REPORT_LINE_H
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * A report as it travels over the reports FIFO, parsed back into its fields.
+ */
+typedef struct ParsedReport {
+    std::string progname;
+    pid_t pid;
+    uint32_t requested_access;
+    uint32_t status;
+    uint32_t report_explicitly;
+    uint32_t error;
+    int operation;
+    uint32_t is_directory;
+    uint32_t unexpected;
+    // Only present when EnableLinuxSandboxReportTimestamps is set in the FAM
+    uint64_t timestamp;
+    uint64_t sequence_number;
+    std::string path;
+} ParsedReport;
+
+/**
+ * Parses a report line, as built by BxlObserver::BuildReport. The trailing newline is optional.
+ *
+ * The path is always the last field and is taken verbatim (it may contain '|'), so whether the line carries
+ * timestamps has to be known upfront. Returns false if the line is malformed.
+ */
+bool ParseReportLine(std::string_view line, bool has_timestamps, ParsedReport& report);
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_REPORT_LINE_H
@@ -0,0 +1,332 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "report_log.hpp"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <queue>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unordered_map>
+#include "OpNames.hpp"
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+// CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+static const char kLogExtension[] = ".log";
+
+static const uint64_t kLogMagic = 0x4258'4c52'4c4f'4701ull;
+static const uint64_t kTrailerMagic = 0x4258'4c53'4541'4c44ull;
+
+// Length of the record that holds the trailer
+static const uint32_t kTrailerLength = UINT32_MAX;
+
+struct ReportLogHeader {
+    uint64_t magic;
+    pid_t pid;
+    pid_t parent_pid;
+    uint64_t start_time;
+    // Bytes reserved so far in the data section
+    std::atomic<uint64_t> write_offset;
+    std::atomic<uint64_t> record_count;
+};
+
+typedef struct RecordHeader {
+    // Stored last: 0 means the record was reserved but not (fully) written
+    std::atomic<uint32_t> length;
+    uint32_t checksum;
+    uint64_t timestamp;
+    int32_t pid;
+    int32_t operation;
+} RecordHeader;
+
+typedef struct Trailer {
+    uint64_t magic;
+    uint64_t record_count;
+} Trailer;
+
+static const size_t kHeaderSize = 64;
+static const size_t kTrailerSize = sizeof(RecordHeader) + sizeof(Trailer);
+
+static inline size_t Align8(size_t size) { return (size + 7) & ~(size_t)7; }
+
+static uint64_t MonotonicTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t Checksum(const char *data, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+bool ReportLogWriter::Open(const char *directory) {
+    static_assert(sizeof(ReportLogHeader) <= kHeaderSize, "Log header does not fit");
+
+    uint64_t start_time = MonotonicTimeNs();
+    char path[PATH_MAX];
+    // The start time disambiguates logs of the same pid: a process that exec's keeps its pid but gets a new log
+    if (snprintf(path, PATH_MAX, "%s/%d-%lu%s", directory, getpid(), (unsigned long)start_time, kLogExtension) >= PATH_MAX) {
+        return false;
+    }
+
+    // Called from the reporting path, so use raw syscalls that won't be interposed
+    int fd = RawOpen(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+
+    void *mapping = MAP_FAILED;
+    if (RawFtruncate(fd, kCapacity) == 0) {
+        mapping = mmap(nullptr, kCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    RawClose(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    ReportLogHeader *header = (ReportLogHeader *)mapping;
+    header->pid = getpid();
+    header->parent_pid = getppid();
+    header->start_time = start_time;
+    header->write_offset.store(0, std::memory_order_relaxed);
+    header->record_count.store(0, std::memory_order_relaxed);
+    header->magic = kLogMagic;
+
+    header_ = header;
+    sealed_.store(false, std::memory_order_relaxed);
+    owner_.store(getpid(), std::memory_order_release);
+    return true;
+}
+
+bool ReportLogWriter::Append(const char *message, uint32_t length, pid_t pid, int operation) {
+    if (!IsOpenForCurrentProcess() || sealed_.load(std::memory_order_relaxed) || length == 0 || length == kTrailerLength) {
+        return false;
+    }
+
+    uint64_t size = Align8(sizeof(RecordHeader) + length);
+    uint64_t offset = header_->write_offset.fetch_add(size, std::memory_order_relaxed);
+
+    // Always leave room for the trailer
+    if (kHeaderSize + offset + size + kTrailerSize > kCapacity) {
+        return false;
+    }
+
+    char *data = (char *)header_ + kHeaderSize + offset;
+    RecordHeader *record = (RecordHeader *)data;
+    memcpy(data + sizeof(RecordHeader), message, length);
+    record->checksum = Checksum(message, length);
+    record->timestamp = MonotonicTimeNs();
+    record->pid = pid;
+    record->operation = operation;
+    record->length.store(length, std::memory_order_release);
+
+    header_->record_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ReportLogWriter::Seal() {
+    if (!IsOpenForCurrentProcess() || sealed_.exchange(true)) {
+        return false;
+    }
+
+    uint64_t offset = header_->write_offset.fetch_add(kTrailerSize, std::memory_order_relaxed);
+    if (kHeaderSize + offset + kTrailerSize > kCapacity) {
+        return false;
+    }
+
+    char *data = (char *)header_ + kHeaderSize + offset;
+    RecordHeader *record = (RecordHeader *)data;
+    Trailer *trailer = (Trailer *)(data + sizeof(RecordHeader));
+    trailer->magic = kTrailerMagic;
+    trailer->record_count = header_->record_count.load(std::memory_order_relaxed);
+    record->checksum = Checksum((const char *)trailer, sizeof(Trailer));
+    record->timestamp = MonotonicTimeNs();
+    record->pid = header_->pid;
+    record->operation = -1;
+    record->length.store(kTrailerLength, std::memory_order_release);
+
+    return true;
+}
+
+bool ReadReportLog(const char *path, ReportLogContents& contents) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < kHeaderSize) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const char *base = (const char *)mapping;
+    const ReportLogHeader *header = (const ReportLogHeader *)base;
+    if (header->magic != kLogMagic) {
+        munmap(mapping, size);
+        return false;
+    }
+
+    contents.pid = header->pid;
+    contents.parent_pid = header->parent_pid;
+    contents.start_time = header->start_time;
+    contents.sealed = false;
+    contents.truncated = false;
+    contents.records.clear();
+
+    size_t offset = kHeaderSize;
+    while (offset + sizeof(RecordHeader) <= size) {
+        const RecordHeader *record = (const RecordHeader *)(base + offset);
+        uint32_t length = record->length.load(std::memory_order_acquire);
+        if (length == 0) {
+            // Either the end of the log, or a record that was reserved and never committed. Without a trailer we can't tell
+            // how many records were supposed to be there, so we stop here.
+            break;
+        }
+
+        const char *payload = base + offset + sizeof(RecordHeader);
+        if (length == kTrailerLength) {
+            if (offset + kTrailerSize <= size) {
+                const Trailer *trailer = (const Trailer *)payload;
+                contents.sealed = trailer->magic == kTrailerMagic
+                    && record->checksum == Checksum(payload, sizeof(Trailer))
+                    && trailer->record_count == contents.records.size();
+            }
+            break;
+        }
+
+        if (offset + sizeof(RecordHeader) + length > size || record->checksum != Checksum(payload, length)) {
+            contents.truncated = true;
+            break;
+        }
+
+        contents.records.push_back({ record->timestamp, record->pid, record->operation, std::string(payload, length) });
+        offset += Align8(sizeof(RecordHeader) + length);
+    }
+
+    // If more space was reserved than what we could recover, some record was never fully written (the process crashed in the middle of an append)
+    if (!contents.sealed && offset - kHeaderSize < header->write_offset.load(std::memory_order_acquire)) {
+        contents.truncated = true;
+    }
+
+    munmap(mapping, size);
+    return true;
+}
+
+// Synthesizes an exit report for a process whose log ended without one, taking the program name from its last report.
+static ReportLogRecord SynthesizeExitReport(const ReportLogContents& log) {
+    std::string progname = "";
+    if (!log.records.empty()) {
+        const std::string& last = log.records.back().message;
+        progname = last.substr(0, last.find('|'));
+    }
+
+    // CODESYNC: BxlObserver::BuildReport
+    char message[PATH_MAX];
+    snprintf(message, sizeof(message), "%s|%d|%d|%d|%d|%d|%d|%d|%d|%s\n",
+        progname.c_str(), log.pid, 0, /* FileAccessStatus_Allowed */ 1, 0, 0, (int)kOpProcessExit, 0, 0, "");
+
+    uint64_t timestamp = log.records.empty() ? log.start_time : log.records.back().timestamp;
+    return { timestamp, log.pid, (int)kOpProcessExit, message };
+}
+
+bool MergeReportLogs(const char *directory, std::vector<ReportLogRecord>& merged, bool include_process_lifetime) {
+    DIR *dir = opendir(directory);
+    if (dir == nullptr) {
+        return false;
+    }
+
+    std::vector<ReportLogContents> logs;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        size_t name_length = strlen(entry->d_name);
+        size_t extension_length = sizeof(kLogExtension) - 1;
+        if (name_length <= extension_length || strcmp(entry->d_name + name_length - extension_length, kLogExtension) != 0) {
+            continue;
+        }
+
+        std::string path = std::string(directory) + "/" + entry->d_name;
+        ReportLogContents contents;
+        if (ReadReportLog(path.c_str(), contents)) {
+            logs.push_back(std::move(contents));
+        }
+    }
+    closedir(dir);
+
+    // Find the last log of every pid: only that one is expected to have an exit report
+    std::unordered_map<pid_t, size_t> last_log_for_pid;
+    for (size_t i = 0; i < logs.size(); i++) {
+        auto it = last_log_for_pid.find(logs[i].pid);
+        if (it == last_log_for_pid.end() || logs[it->second].start_time < logs[i].start_time) {
+            last_log_for_pid[logs[i].pid] = i;
+        }
+    }
+
+    for (const auto& entry : last_log_for_pid) {
+        ReportLogContents& log = logs[entry.second];
+        bool has_exit = std::any_of(log.records.begin(), log.records.end(), [&log](const ReportLogRecord& r) {
+            return r.operation == kOpProcessExit && r.pid == log.pid;
+        });
+
+        if (!has_exit) {
+            log.records.push_back(SynthesizeExitReport(log));
+        }
+    }
+
+    // K-way merge: records of each log keep their order, logs are interleaved by time
+    typedef std::pair<uint64_t, std::pair<size_t, size_t>> Cursor; // timestamp, (log, record)
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> cursors;
+    for (size_t i = 0; i < logs.size(); i++) {
+        if (!logs[i].records.empty()) {
+            cursors.push({ logs[i].records[0].timestamp, { i, 0 } });
+        }
+    }
+
+    merged.clear();
+    while (!cursors.empty()) {
+        Cursor cursor = cursors.top();
+        cursors.pop();
+
+        size_t log = cursor.second.first;
+        size_t record = cursor.second.second;
+        int operation = logs[log].records[record].operation;
+        if (include_process_lifetime || (operation != kOpProcessStart && operation != kOpProcessExit)) {
+            merged.push_back(std::move(logs[log].records[record]));
+        }
+
+        if (record + 1 < logs[log].records.size()) {
+            // Never go back in time within a log, so a thread that appended late can't reorder the rest of the log
+            uint64_t next = std::max(cursor.first, logs[log].records[record + 1].timestamp);
+            cursors.push({ next, { log, record + 1 } });
+        }
+    }
+
+    return true;
+}
+
+} // namespace linux
+} // namespace buildxl
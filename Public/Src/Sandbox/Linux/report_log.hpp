@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_REPORT_LOG_H
+#define BUILDXL_SANDBOX_LINUX_REPORT_LOG_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+namespace buildxl {
+namespace linux {
+
+struct ReportLogHeader;
+
+/**
+ * Per-process append-only report log.
+ *
+ * As an alternative to streaming reports over the reports FIFO, every process of a pip can append its reports to its own
+ * memory mapped log file under a pip-wide directory (the FAM path with kDirectorySuffix, enabled by EnableLinuxSandboxReportLogs in the FAM).
+ * There is no cross-process contention and no blocking on a reader: threads of
+ * the same process reserve space with a single atomic add on the log header and then copy their record in place.
+ * Each record is committed by storing its length last, so a reader never sees a torn record as valid.
+ *
+ * When the process exits or execs, the log is sealed with a trailer (an exec'ed image starts a new log). Logs without a trailer belong
+ * to processes that crashed. Their content is recovered up to the first record that was not fully committed.
+ * Sealing does not shrink the file: the log stays sparse, and the whole directory is deleted by the managed side once the pip is done.
+ *
+ * Once the process tree of the pip is done, the managed side merges the logs into the report stream (see MergeReportLogs and report_log_merge.cpp).
+ */
+class ReportLogWriter {
+public:
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    static constexpr const char *kDirectorySuffix = ".logs";
+
+    ReportLogWriter() : header_(nullptr), owner_(0), sealed_(false) { }
+    ReportLogWriter(const ReportLogWriter&) = delete;
+    ReportLogWriter& operator = (const ReportLogWriter&) = delete;
+
+    /**
+     * Creates the log for the current process in the given directory.
+     * A log inherited from a parent process (through fork) is abandoned, not closed: it still belongs to the parent.
+     */
+    bool Open(const char *directory);
+
+    /**
+     * Appends a report. 'message' is the serialized report line and 'pid' the process the report is about.
+     * Returns false if the log is not open, sealed or full, in which case the caller should use a different transport.
+     */
+    bool Append(const char *message, uint32_t length, pid_t pid, int operation);
+
+    /**
+     * Writes the trailer. No more reports can be appended after the log is sealed.
+     */
+    bool Seal();
+
+    // Whether the log is open and owned by the current process
+    bool IsOpenForCurrentProcess() const { return owner_.load(std::memory_order_acquire) == getpid(); }
+
+    // Maximum size of a log file. The file is sparse, so this only reserves address space.
+    static const uint64_t kCapacity = 256ull * 1024 * 1024;
+
+private:
+    ReportLogHeader *header_;
+    // Published after header_ so other threads never see a half opened log
+    std::atomic<pid_t> owner_;
+    std::atomic<bool> sealed_;
+};
+
+/**
+ * A report recovered from a log.
+ */
+typedef struct ReportLogRecord {
+    uint64_t timestamp;
+    pid_t pid;
+    int operation;
+    std::string message;
+} ReportLogRecord;
+
+/**
+ * Contents of a log file, as recovered by ReadReportLog.
+ */
+typedef struct ReportLogContents {
+    pid_t pid;
+    pid_t parent_pid;
+    uint64_t start_time;
+    // Whether the log had a valid trailer
+    bool sealed;
+    // Whether recovery stopped at a record that was not fully written (only possible for logs that are not sealed)
+    bool truncated;
+    std::vector<ReportLogRecord> records;
+} ReportLogContents;
+
+/**
+ * Reads a log file, recovering all records up to the trailer, or up to the first record that was not fully committed.
+ * Returns false if the file is not a report log.
+ */
+bool ReadReportLog(const char *path, ReportLogContents& contents);
+
+/**
+ * Merges all logs in the given directory into a single ordered report stream.
+ *
+ * The records of a given process are kept in the order in which they were appended, and records of different processes
+ * are interleaved by the time at which they were appended. Because a process only starts appending after it is created,
+ * and because the exit report is the last record of a process, this ordering preserves process start/exit causality.
+ * Logs of the same pid (a process that exec'ed) are chained by creation time. If the last log for a pid has no exit report
+ * (the process crashed), one is synthesized so the consumer doesn't wait for it forever.
+ *
+ * When 'include_process_lifetime' is false, process start and exit reports (including synthesized ones) are left out of the result.
+ * This is the case when the merged stream is fed back to the managed side: the sandbox already sent those over the reports FIFO.
+ */
+bool MergeReportLogs(const char *directory, std::vector<ReportLogRecord>& merged, bool include_process_lifetime = true);
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_REPORT_LOG_H
@@ -0,0 +1,133 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "report_log.hpp"
+
+/**
+ * Merges the per-process report logs of a pip into a single report stream.
+ *
+ * The sandbox writes report logs when EnableLinuxSandboxReportLogs is set in the FAM (see ReportLogWriter). Once all processes
+ * of the pip are done, this tool merges the logs in that directory (see MergeReportLogs) and writes the result using the same
+ * framing as the reports FIFO (a uint length prefix followed by the report line), so it can be consumed by the regular report parser.
+ *
+ * The managed side runs it with '-s' once the process tree of the pip is done and processes the merged stream from stdout, as if it had
+ * arrived over the reports FIFO. Process start and exit reports are left out since the sandbox already sent those over the FIFO.
+ * Every report is written with a single write call, so reports are never interleaved with other writers if the output is a FIFO.
+ *
+ * Usage:
+ *   report_log_merge -d <report log directory> [-o <output file>] [-s]
+ */
+
+using namespace buildxl::linux;
+
+static const char kUsage[] = "Usage: %s -d <report log directory> [-o <output file>] [-s]\n";
+
+static bool WriteAll(int fd, const char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buffer, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (written <= 0) {
+            return false;
+        }
+
+        buffer += written;
+        length -= written;
+    }
+
+    return true;
+}
+
+static void PrintSummary(const char *directory, size_t record_count) {
+    size_t logs = 0, sealed = 0, truncated = 0;
+
+    DIR *dir = opendir(directory);
+    struct dirent *entry;
+    while (dir != nullptr && (entry = readdir(dir)) != nullptr) {
+        std::string path = std::string(directory) + "/" + entry->d_name;
+        ReportLogContents contents;
+        if (ReadReportLog(path.c_str(), contents)) {
+            logs++;
+            sealed += contents.sealed ? 1 : 0;
+            truncated += contents.truncated ? 1 : 0;
+        }
+    }
+
+    if (dir != nullptr) {
+        closedir(dir);
+    }
+
+    fprintf(stderr, "Merged %zu reports from %zu logs (%zu sealed, %zu truncated)\n", record_count, logs, sealed, truncated);
+}
+
+int main(int argc, char **argv) {
+    const char *directory = nullptr;
+    const char *output_path = nullptr;
+    bool include_process_lifetime = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "d:o:s")) != -1) {
+        switch (opt) {
+            case 'd':
+                directory = optarg;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 's':
+                include_process_lifetime = false;
+                break;
+            default:
+                fprintf(stderr, kUsage, argv[0]);
+                return 1;
+        }
+    }
+
+    if (directory == nullptr) {
+        fprintf(stderr, kUsage, argv[0]);
+        return 1;
+    }
+
+    std::vector<ReportLogRecord> merged;
+    if (!MergeReportLogs(directory, merged, include_process_lifetime)) {
+        fprintf(stderr, "Could not read report logs from '%s'\n", directory);
+        return 1;
+    }
+
+    // O_CREAT and O_TRUNC are no-ops when the output is a FIFO
+    int output = output_path == nullptr ? STDOUT_FILENO : open(output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output == -1) {
+        fprintf(stderr, "Could not open '%s' for writing\n", output_path);
+        return 1;
+    }
+
+    // CODESYNC: BxlObserver::SendReport
+    std::string frame;
+    for (const ReportLogRecord& record : merged) {
+        uint32_t length = (uint32_t)record.message.length();
+        frame.assign((const char *)&length, sizeof(length));
+        frame.append(record.message);
+        if (!WriteAll(output, frame.data(), frame.length())) {
+            fprintf(stderr, "Could not write merged reports; errno: %d\n", errno);
+            return 1;
+        }
+    }
+
+    if (output != STDOUT_FILENO) {
+        close(output);
+    }
+
+    PrintSummary(directory, merged.size());
+    return 0;
+}
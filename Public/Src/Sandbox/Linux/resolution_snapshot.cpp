@@ -0,0 +1,281 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "resolution_snapshot.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+static const char kMagic[] = "BXLSNAP1 ";
+static const off_t kMaxFileSize = 64 * 1024 * 1024;
+
+static int64_t CtimeNs(const struct stat &st) {
+    return (int64_t)st.st_ctim.tv_sec * 1000000000 + st.st_ctim.tv_nsec;
+}
+
+static bool ReadFile(const char *path, std::string &content) {
+    int fd = RawOpen(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (RawFstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > kMaxFileSize) {
+        RawClose(fd);
+        return false;
+    }
+
+    content.resize(st.st_size);
+    size_t total = 0;
+    while (total < content.size()) {
+        ssize_t n = RawRead(fd, &content[total], content.size() - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            break;
+        }
+
+        total += n;
+    }
+
+    content.resize(total);
+    RawClose(fd);
+    return true;
+}
+
+static bool WriteAll(int fd, const std::string &content) {
+    size_t total = 0;
+    while (total < content.length()) {
+        ssize_t n = RawWrite(fd, content.data() + total, content.length() - total);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n <= 0) {
+            return false;
+        }
+
+        total += n;
+    }
+
+    return true;
+}
+
+// Replaces the file at 'path' with the given content, so readers see either the previous file or the whole new one
+static bool ReplaceFile(const char *path, const std::string &content) {
+    std::string temp_path = std::string(path) + "." + std::to_string(getpid()) + ".tmp";
+    int fd = RawOpen(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool written = WriteAll(fd, content);
+    RawClose(fd);
+    if (!written || RawRename(temp_path.c_str(), path) != 0) {
+        RawUnlink(temp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// One line per entry: "<D|L> <device> <inode> <ctime_ns> <path length>\t<path><target>\n"
+static void AppendEntry(std::string &content, const std::string &path, const ResolutionEntry &entry) {
+    char header[128];
+    snprintf(header, sizeof(header), "%c %llu %llu %lld %zu\t",
+        entry.is_symlink ? 'L' : 'D',
+        (unsigned long long)entry.device,
+        (unsigned long long)entry.inode,
+        (long long)entry.ctime_ns,
+        path.length());
+
+    content.append(header);
+    content.append(path);
+    content.append(entry.target);
+    content.push_back('\n');
+}
+
+// Parses entries up to the end of the content. Malformed lines (e.g., a log line cut short by a process that was killed) are skipped.
+static void ParseEntries(const std::string &content, size_t start, std::unordered_map<std::string, ResolutionEntry> &entries) {
+    while (start < content.length() && entries.size() < ResolutionSnapshot::kMaxEntries) {
+        size_t end = content.find('\n', start);
+        if (end == std::string::npos) {
+            return;
+        }
+
+        char kind;
+        unsigned long long device, inode;
+        long long ctime_ns;
+        size_t path_length;
+        int consumed = 0;
+        std::string line(content, start, end - start);
+        start = end + 1;
+
+        if (sscanf(line.c_str(), "%c %llu %llu %lld %zu\t%n", &kind, &device, &inode, &ctime_ns, &path_length, &consumed) != 5
+            || consumed == 0
+            || (kind != 'D' && kind != 'L')
+            || path_length == 0
+            || consumed + path_length > line.length()
+            || line[consumed] != '/') {
+            continue;
+        }
+
+        ResolutionEntry entry;
+        entry.is_symlink = kind == 'L';
+        entry.device = (dev_t)device;
+        entry.inode = (ino_t)inode;
+        entry.ctime_ns = ctime_ns;
+        entry.target.assign(line, consumed + path_length, std::string::npos);
+        if (entry.is_symlink == entry.target.empty()) {
+            continue;
+        }
+
+        entries[line.substr(consumed, path_length)] = std::move(entry);
+    }
+}
+
+std::string ResolutionSnapshot::Serialize(const std::string &tag, const std::unordered_map<std::string, ResolutionEntry> &entries) {
+    std::string content(kMagic);
+    content.append(tag);
+    content.push_back('\n');
+
+    for (const auto &entry : entries) {
+        AppendEntry(content, entry.first, entry.second);
+    }
+
+    return content;
+}
+
+bool ResolutionSnapshot::Deserialize(const std::string &content, const std::string &tag, std::unordered_map<std::string, ResolutionEntry> &entries) {
+    std::string header = std::string(kMagic) + tag + "\n";
+    if (content.compare(0, header.length(), header) != 0) {
+        return false;
+    }
+
+    ParseEntries(content, header.length(), entries);
+    return true;
+}
+
+bool ResolutionSnapshot::Describe(const char *path, struct stat &st) {
+    return RawLstat(path, &st) == 0;
+}
+
+size_t ResolutionSnapshot::LoadAndValidate(const char *path) {
+    std::string content;
+    std::unordered_map<std::string, ResolutionEntry> saved;
+    if (!ReadFile(path, content) || !Deserialize(content, /* tag */ "", saved)) {
+        return 0;
+    }
+
+    for (auto &entry : saved) {
+        struct stat st;
+        if (!Describe(entry.first.c_str(), st)
+            || st.st_dev != entry.second.device
+            || st.st_ino != entry.second.inode) {
+            continue;
+        }
+
+        bool still_valid = entry.second.is_symlink
+            ? S_ISLNK(st.st_mode) && CtimeNs(st) == entry.second.ctime_ns
+            : S_ISDIR(st.st_mode);
+
+        if (still_valid) {
+            entries_.insert(std::move(entry));
+        }
+    }
+
+    return entries_.size();
+}
+
+bool ResolutionSnapshot::Load(const char *path, const std::string &tag) {
+    std::string content;
+    return ReadFile(path, content) && Deserialize(content, tag, entries_);
+}
+
+bool ResolutionSnapshot::Publish(const char *path, const std::string &tag) const {
+    return ReplaceFile(path, Serialize(tag, entries_));
+}
+
+const ResolutionEntry *ResolutionSnapshot::Find(const char *path) const {
+    if (entries_.empty()) {
+        return nullptr;
+    }
+
+    auto entry = entries_.find(path);
+    return entry == entries_.end() ? nullptr : &entry->second;
+}
+
+void ResolutionSnapshot::Record(const char *log_path, const char *path, const struct stat &before, const char *target, ssize_t length) {
+    bool is_symlink = length >= 0;
+    if ((is_symlink ? !S_ISLNK(before.st_mode) : !S_ISDIR(before.st_mode))
+        || length >= PATH_MAX
+        || (is_symlink && (length == 0 || memchr(target, '\n', length) != nullptr))
+        || strchr(path, '\n') != nullptr) {
+        return;
+    }
+
+    struct stat after;
+    if (!Describe(path, after)
+        || after.st_dev != before.st_dev
+        || after.st_ino != before.st_ino
+        || after.st_mode != before.st_mode
+        || (is_symlink && CtimeNs(after) != CtimeNs(before))) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (recorded_.size() >= kMaxEntries || !recorded_.insert(path).second) {
+        return;
+    }
+
+    ResolutionEntry entry;
+    entry.is_symlink = is_symlink;
+    entry.device = after.st_dev;
+    entry.inode = after.st_ino;
+    entry.ctime_ns = is_symlink ? CtimeNs(after) : 0;
+    if (is_symlink) {
+        entry.target.assign(target, length);
+    }
+
+    std::string line;
+    AppendEntry(line, path, entry);
+
+    // A single append per line: lines from concurrent processes don't interleave
+    int fd = RawOpen(log_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        WriteAll(fd, line);
+        RawClose(fd);
+    }
+}
+
+bool ResolutionSnapshot::Save(const char *path, const char *log_path) const {
+    std::unordered_map<std::string, ResolutionEntry> merged = entries_;
+
+    std::string log;
+    if (ReadFile(log_path, log)) {
+        ParseEntries(log, 0, merged);
+    }
+
+    if (merged.empty()) {
+        return false;
+    }
+
+    return ReplaceFile(path, Serialize(/* tag */ "", merged));
+}
+
+void ResolutionSnapshot::ResetAfterFork() {
+    ResetLock(mtx_);
+}
+
+} // namespace linux
+} // namespace buildxl
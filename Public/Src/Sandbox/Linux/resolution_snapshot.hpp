@@ -0,0 +1,135 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_RESOLUTION_SNAPSHOT_H
+#define BUILDXL_SANDBOX_LINUX_RESOLUTION_SNAPSHOT_H
+
+#include <iterator>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "post_fork.hpp"
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * What path resolution found out about a path prefix on a previous run of the pip: a directory, or a symlink and its target.
+ */
+typedef struct ResolutionEntry {
+    bool is_symlink;
+    dev_t device;
+    ino_t inode;
+    // st_ctim of the symlink, in nanoseconds. A symlink can't be retargeted in place, so a symlink with the same identity
+    // and change time still has the same target. Not used for directories.
+    int64_t ctime_ns;
+    std::string target;
+} ResolutionEntry;
+
+/**
+ * Warm-start data for path resolution, so a pip that is run again doesn't pay for resolving the same symlinked paths
+ * component by component in every one of its processes.
+ *
+ * The engine keeps a snapshot per pip (keyed by the pip fingerprint) in a local cache directory. The root process of the pip
+ * loads it and keeps the entries that still describe the file system: one lstat per entry, checking that directories are
+ * still directories with the same identity, and that symlinks are the same symlinks. Only prefixes the pip is not allowed to
+ * write are kept, so the pip can't invalidate an entry while it runs. The validated entries are then published in a file next
+ * to the FAM, which the rest of the process tree loads as is.
+ *
+ * Every process records the prefixes it had to resolve itself in a shared log next to the FAM. When the root process exits,
+ * the validated entries and the log are merged into the snapshot for the next run.
+ *
+ * The snapshot only ever replaces a readlink syscall with the answer it would have given: callers still report every symlink
+ * they go through. A missing, stale, or corrupt snapshot just means resolving paths the slow way, so correctness never depends on it.
+ * All file system operations go through raw syscalls, so the snapshot is safe to use from within interposed functions.
+ */
+class ResolutionSnapshot : public PostForkResettable {
+public:
+    // CODESYNC: Public/Src/Engine/Processes/SandboxConnectionLinuxDetours.cs
+    static constexpr const char *kFileSuffix = ".snapshot";
+    static constexpr const char *kLogFileSuffix = ".snapshot.log";
+
+    // Snapshots are read into memory by every process of the pip: anything beyond this is not worth loading
+    static const size_t kMaxEntries = 64 * 1024;
+
+    ResolutionSnapshot() = default;
+    ResolutionSnapshot(const ResolutionSnapshot&) = delete;
+    ResolutionSnapshot& operator = (const ResolutionSnapshot&) = delete;
+
+    /**
+     * Loads a snapshot saved by a previous run, keeping the entries that still describe the file system.
+     * Returns the number of entries kept.
+     */
+    size_t LoadAndValidate(const char *path);
+
+    /**
+     * Drops the entries for which 'should_drop' returns true (e.g., prefixes the pip may write). Returns the number of entries left.
+     */
+    template <typename Predicate>
+    size_t DropIf(Predicate should_drop) {
+        for (auto entry = entries_.begin(); entry != entries_.end();) {
+            entry = should_drop(entry->first) ? entries_.erase(entry) : std::next(entry);
+        }
+
+        return entries_.size();
+    }
+
+    /**
+     * Loads a snapshot published by the root process of the pip, without validating it again. 'tag' identifies the pip
+     * (a snapshot published for a different one is ignored). Returns false if there is nothing to load.
+     */
+    bool Load(const char *path, const std::string &tag);
+
+    /**
+     * Writes the loaded entries to the given path, so other processes can Load them with the same tag.
+     */
+    bool Publish(const char *path, const std::string &tag) const;
+
+    const ResolutionEntry *Find(const char *path) const;
+
+    size_t GetEntryCount() const { return entries_.size(); }
+
+    /**
+     * Records a prefix that was just resolved without the snapshot: a directory (length is -1) or a symlink whose target
+     * is the given one. 'before' is what lstat returned for the prefix before it was resolved: the prefix is only appended to
+     * the log if it is still the same file, so a concurrent replacement is never recorded.
+     */
+    void Record(const char *log_path, const char *path, const struct stat &before, const char *target, ssize_t length);
+
+    /**
+     * Saves the loaded entries, plus the ones recorded in the log, as the snapshot for the next run. The snapshot is replaced
+     * atomically, so a concurrent run of the same pip never sees a partial one.
+     */
+    bool Save(const char *path, const char *log_path) const;
+
+    /**
+     * Must be called in a forked child before it does anything else: another thread of the parent may have been in the middle of
+     * a recording when it forked.
+     */
+    void ResetAfterFork() override;
+
+    // Serialization, exposed for tests
+    static std::string Serialize(const std::string &tag, const std::unordered_map<std::string, ResolutionEntry> &entries);
+    static bool Deserialize(const std::string &content, const std::string &tag, std::unordered_map<std::string, ResolutionEntry> &entries);
+
+    // lstat through a raw syscall
+    static bool Describe(const char *path, struct stat &st);
+
+private:
+    std::unordered_map<std::string, ResolutionEntry> entries_;
+
+    std::mutex mtx_;
+    // Prefixes this process already appended to the log
+    std::unordered_set<std::string> recorded_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_RESOLUTION_SNAPSHOT_H
@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "symlink_free_check.hpp"
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#else
+struct open_how {
+    __u64 flags;
+    __u64 mode;
+    __u64 resolve;
+};
+#define RESOLVE_NO_SYMLINKS 0x04
+#endif
+
+#ifndef SYS_openat2
+#define SYS_openat2 437
+#endif
+
+namespace buildxl {
+namespace linux {
+
+// 0: not probed yet, 1: available, -1: not available
+static std::atomic<int> g_openat2_support { 0 };
+
+// openat2 has no libc wrapper on older glibc, and this is called from within interposed functions anyway (see raw_syscalls.hpp)
+static int RawOpenNoSymlinks(const char *path, bool follow_final_symlink) {
+    struct open_how how;
+    memset(&how, 0, sizeof(how));
+    how.flags = O_PATH | O_CLOEXEC | (follow_final_symlink ? 0 : O_NOFOLLOW);
+    how.resolve = RESOLVE_NO_SYMLINKS;
+    return (int)syscall(SYS_openat2, AT_FDCWD, path, &how, sizeof(how));
+}
+
+bool IsSymlinkFreeCheckAvailable() {
+    int support = g_openat2_support.load(std::memory_order_relaxed);
+    if (support == 0) {
+        int fd = RawOpenNoSymlinks("/", /* follow_final_symlink */ true);
+        // ENOSYS on older kernels. A seccomp filter may also fail it with EPERM (or anything else, really).
+        support = fd >= 0 ? 1 : -1;
+        if (fd >= 0) {
+            RawClose(fd);
+        }
+        g_openat2_support.store(support, std::memory_order_relaxed);
+    }
+
+    return support == 1;
+}
+
+bool ResolvesWithoutSymlinks(const char *path, bool follow_final_symlink, bool *exists) {
+    if (path == nullptr || path[0] != '/' || !IsSymlinkFreeCheckAvailable()) {
+        return false;
+    }
+
+    int saved_errno = errno;
+    int fd = RawOpenNoSymlinks(path, follow_final_symlink);
+    if (fd >= 0) {
+        RawClose(fd);
+        if (exists != nullptr) {
+            *exists = true;
+        }
+        return true;
+    }
+
+    // ELOOP means there is a symlink somewhere: the caller has to find it. Other errors, but a missing
+    // final component, mean the kernel couldn't tell.
+    bool resolved = false;
+    if (errno == ENOENT) {
+        // The path doesn't exist. If its parent resolves without symlinks, the missing component is the final one,
+        // which can't be a symlink
+        size_t length = strnlen(path, PATH_MAX);
+        while (length > 1 && path[length - 1] == '/') {
+            length--;
+        }
+
+        const char *last_slash = (const char *)memrchr(path, '/', length);
+        const char *final_component = last_slash + 1;
+        size_t final_length = path + length - final_component;
+        bool final_is_dot = (final_length == 1 && final_component[0] == '.')
+            || (final_length == 2 && final_component[0] == '.' && final_component[1] == '.');
+
+        if (length < PATH_MAX && length > 1 && !final_is_dot) {
+            char parent[PATH_MAX];
+            size_t parent_length = last_slash == path ? 1 : last_slash - path;
+            memcpy(parent, path, parent_length);
+            parent[parent_length] = '\0';
+
+            fd = RawOpenNoSymlinks(parent, /* follow_final_symlink */ true);
+            if (fd >= 0) {
+                RawClose(fd);
+                resolved = true;
+                if (exists != nullptr) {
+                    *exists = false;
+                }
+            }
+        }
+    }
+
+    errno = saved_errno;
+    return resolved;
+}
+
+} // namespace linux
+} // namespace buildxl
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_SYMLINK_FREE_CHECK_H
+#define BUILDXL_SANDBOX_LINUX_SYMLINK_FREE_CHECK_H
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Whether the kernel supports openat2 with RESOLVE_NO_SYMLINKS (Linux 5.6+, and not blocked by a seccomp filter).
+ * Detected once per process: the first call probes the kernel, later calls return the cached answer.
+ */
+bool IsSymlinkFreeCheckAvailable();
+
+/**
+ * Asks the kernel whether the given absolute path resolves without going through any symlink, in a single (or, if the final
+ * component does not exist, two) syscalls. The final component is only considered if follow_final_symlink is set.
+ *
+ * Returns true only when the kernel confirms it. False means a symlink may be involved, the check is not available, or the
+ * kernel couldn't tell (e.g., an intermediate component is missing or can't be searched), so callers must fall back to
+ * checking every component. When it returns true, 'exists' (if given) tells whether the final component exists.
+ */
+bool ResolvesWithoutSymlinks(const char *path, bool follow_final_symlink, bool *exists = nullptr);
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_SYMLINK_FREE_CHECK_H
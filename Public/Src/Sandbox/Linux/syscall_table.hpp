@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_SYSCALL_TABLE_H
+#define BUILDXL_SANDBOX_LINUX_SYSCALL_TABLE_H
+
+namespace buildxl {
+namespace linux {
+
+// What a declarative syscall operates on
+typedef enum SyscallShape {
+    // A file descriptor: the path is looked up in the fd table, and no path is ever read from the tracee
+    kFdSyscall,
+    // A path, relative to the current directory if not absolute: the fd table is never looked up
+    kPathSyscall,
+    // A path relative to a directory descriptor (the *at family)
+    kDirfdPathSyscall
+} SyscallShape;
+
+// How the path of a declarative syscall is resolved
+typedef enum SyscallResolution {
+    kFollowSymlinks,
+    kNoFollowSymlinks,
+    // Follow symlinks unless AT_SYMLINK_NOFOLLOW is passed in the flags argument
+    kNoFollowIfRequested
+} SyscallResolution;
+
+} // namespace linux
+} // namespace buildxl
+
+/**
+ * The syscalls the ptrace sandbox traces. The seccomp filter (which checks them in table order), the dispatch in
+ * PTraceSandbox::HandleSysCallGeneric and the handlers are all generated from these two tables, so a syscall can't be traced
+ * without being handled (or the other way around).
+ *
+ * Declarative syscalls are fully described by their entry:
+ *
+ *     X(name, shape, event, fd_arg, path_arg, flags_arg, resolution)
+ *
+ * 'name' is the kernel name of the syscall (i.e., __NR_<name>), 'shape' is a SyscallShape, 'event' the event that is reported and
+ * 'resolution' a SyscallResolution. Argument indices start at 1; 0 means the syscall doesn't take that argument. 'fd_arg' is the
+ * file descriptor for kFdSyscall and the directory descriptor for kDirfdPathSyscall.
+ *
+ * Custom syscalls need more than a single report (e.g., they wait for the syscall to return, or report two paths), and have a
+ * hand-written PTraceSandbox::Handle<name> handler:
+ *
+ *     X(name, path_arg, second_path_arg)
+ *
+ * 'path_arg' and 'second_path_arg' are the arguments that are paths (0 if there is none), which the eBPF sandbox (see EbpfSandbox)
+ * copies out of the process when the syscall is made.
+ *
+ * NOTE: when adding a syscall here, ensure that a matching unit test for that system call is added to
+ * Public/Src/Sandbox/Linux/UnitTests/TestProcesses/TestProcess/syscalltests.hpp (FOR_EACH_SYSCALL_TEST), which is what
+ * LinuxSandboxConformanceTests runs under every backend, and to Public/Src/Engine/UnitTests/Processes/LinuxSandboxProcessTests.cs
+ */
+#define BXL_DECLARATIVE_SYSCALLS(X) \
+    X(newfstatat,       kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_STAT,      1, 2, 4, kNoFollowIfRequested) \
+    X(statx,            kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_STAT,      1, 2, 3, kNoFollowIfRequested) \
+    X(stat,             kPathSyscall,       ES_EVENT_TYPE_NOTIFY_STAT,      0, 1, 0, kFollowSymlinks) \
+    X(lstat,            kPathSyscall,       ES_EVENT_TYPE_NOTIFY_STAT,      0, 1, 0, kNoFollowSymlinks) \
+    X(fstat,            kFdSyscall,         ES_EVENT_TYPE_NOTIFY_STAT,      1, 0, 0, kFollowSymlinks) \
+    X(access,           kPathSyscall,       ES_EVENT_TYPE_NOTIFY_ACCESS,    0, 1, 0, kFollowSymlinks) \
+    X(faccessat,        kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_ACCESS,    1, 2, 0, kFollowSymlinks) \
+    X(faccessat2,       kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_ACCESS,    1, 2, 4, kNoFollowIfRequested) \
+    X(readlink,         kPathSyscall,       ES_EVENT_TYPE_NOTIFY_READLINK,  0, 1, 0, kNoFollowSymlinks) \
+    X(readlinkat,       kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_READLINK,  1, 2, 0, kNoFollowSymlinks) \
+    X(write,            kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(writev,           kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(pwrite64,         kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(pwritev,          kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(pwritev2,         kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(truncate,         kPathSyscall,       ES_EVENT_TYPE_NOTIFY_WRITE,     0, 1, 0, kFollowSymlinks) \
+    X(ftruncate,        kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(sendfile,         kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     1, 0, 0, kFollowSymlinks) \
+    X(copy_file_range,  kFdSyscall,         ES_EVENT_TYPE_NOTIFY_WRITE,     3, 0, 0, kFollowSymlinks) \
+    X(utime,            kPathSyscall,       ES_EVENT_TYPE_NOTIFY_SETTIME,   0, 1, 0, kFollowSymlinks) \
+    X(utimes,           kPathSyscall,       ES_EVENT_TYPE_NOTIFY_SETTIME,   0, 1, 0, kFollowSymlinks) \
+    X(utimensat,        kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_SETTIME,   1, 2, 0, kFollowSymlinks) \
+    X(futimesat,        kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_SETTIME,   1, 2, 0, kFollowSymlinks) \
+    X(chmod,            kPathSyscall,       ES_EVENT_TYPE_NOTIFY_SETMODE,   0, 1, 0, kFollowSymlinks) \
+    X(fchmod,           kFdSyscall,         ES_EVENT_TYPE_NOTIFY_SETMODE,   1, 0, 0, kFollowSymlinks) \
+    X(fchmodat,         kDirfdPathSyscall,  ES_EVENT_TYPE_NOTIFY_SETMODE,   1, 2, 0, kFollowSymlinks) \
+    X(chown,            kPathSyscall,       ES_EVENT_TYPE_AUTH_SETOWNER,    0, 1, 0, kFollowSymlinks) \
+    X(fchown,           kFdSyscall,         ES_EVENT_TYPE_AUTH_SETOWNER,    1, 0, 0, kFollowSymlinks) \
+    X(lchown,           kPathSyscall,       ES_EVENT_TYPE_AUTH_SETOWNER,    0, 1, 0, kNoFollowSymlinks) \
+    X(fchownat,         kDirfdPathSyscall,  ES_EVENT_TYPE_AUTH_SETOWNER,    1, 2, 5, kNoFollowIfRequested)
+
+// X(name, path_arg, second_path_arg)
+// NOTE: vfork is explicitly not traced, see PTraceSandbox::UpdateTraceeTableForExec for more details
+#define BXL_CUSTOM_SYSCALLS(X) \
+    X(openat,               2, 0) \
+    X(open,                 1, 0) \
+    X(creat,                1, 0) \
+    X(execve,               1, 0) \
+    X(execveat,             2, 0) \
+    X(rmdir,                1, 0) \
+    X(rename,               1, 2) \
+    X(renameat,             2, 4) \
+    X(renameat2,            2, 4) \
+    X(link,                 1, 2) \
+    X(linkat,               2, 4) \
+    X(unlink,               1, 0) \
+    X(unlinkat,             2, 0) \
+    X(symlink,              2, 0) \
+    X(symlinkat,            3, 0) \
+    X(mkdir,                1, 0) \
+    X(mkdirat,              2, 0) \
+    X(mknod,                1, 0) \
+    X(mknodat,              2, 0) \
+    X(name_to_handle_at,    2, 0) \
+    X(fork,                 0, 0) \
+    X(clone,                0, 0) \
+    X(clone3,               0, 0)
+
+#endif // BUILDXL_SANDBOX_LINUX_SYSCALL_TABLE_H
@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#include "unmonitored_executables.hpp"
+#include "content_hasher.hpp"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include "raw_syscalls.hpp"
+
+namespace buildxl {
+namespace linux {
+
+static const size_t kSha256HexLength = 64;
+
+static bool ParseEntry(const char *start, const char *end, std::string &path, std::string &hash) {
+    const char *separator = (const char *)memchr(start, '|', end - start);
+    path.assign(start, separator == nullptr ? end : separator);
+    hash.clear();
+
+    if (separator != nullptr) {
+        for (const char *c = separator + 1; c < end; c++) {
+            if (!isxdigit((unsigned char)*c)) {
+                return false;
+            }
+
+            hash.push_back((char)toupper((unsigned char)*c));
+        }
+
+        if (hash.length() != kSha256HexLength) {
+            return false;
+        }
+    }
+
+    return !path.empty() && path.back() != '/';
+}
+
+size_t UnmonitoredExecutables::Initialize(const char *list) {
+    paths_.clear();
+    names_.clear();
+
+    if (list == nullptr) {
+        return 0;
+    }
+
+    const char *start = list;
+    while (*start != '\0') {
+        const char *end = strchr(start, ';');
+        if (end == nullptr) {
+            end = start + strlen(start);
+        }
+
+        std::string path, hash;
+        if (ParseEntry(start, end, path, hash)) {
+            auto &table = path[0] == '/' ? paths_ : names_;
+            table[path] = hash;
+        }
+
+        start = *end == '\0' ? end : end + 1;
+    }
+
+    return paths_.size() + names_.size();
+}
+
+bool UnmonitoredExecutables::Matches(const char *path) const {
+    if (IsEmpty() || path == nullptr || path[0] != '/') {
+        return false;
+    }
+
+    auto entry = paths_.find(path);
+    if (entry == paths_.end()) {
+        const char *name = strrchr(path, '/') + 1;
+        entry = names_.find(name);
+        if (entry == names_.end()) {
+            return false;
+        }
+    }
+
+    return entry->second.empty() || ContentMatches(path, entry->second);
+}
+
+bool UnmonitoredExecutables::ContentMatches(const char *path, const std::string &hash) {
+    return HashFile(path) == hash;
+}
+
+std::string UnmonitoredExecutables::HashFile(const char *path) {
+    int fd = RawOpen(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return "";
+    }
+
+    auto hasher = CreateContentHasher("SHA256");
+    char buffer[16 * 1024];
+    while (true) {
+        ssize_t n = RawRead(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (n < 0) {
+            RawClose(fd);
+            return "";
+        }
+
+        if (n == 0) {
+            break;
+        }
+
+        hasher->Update(buffer, n);
+    }
+
+    RawClose(fd);
+    return hasher->Finish();
+}
+
+} // namespace linux
+} // namespace buildxl
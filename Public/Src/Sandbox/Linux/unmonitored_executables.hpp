@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+
+#ifndef BUILDXL_SANDBOX_LINUX_UNMONITORED_EXECUTABLES_H
+#define BUILDXL_SANDBOX_LINUX_UNMONITORED_EXECUTABLES_H
+
+#include <stddef.h>
+#include <string>
+#include <unordered_map>
+
+namespace buildxl {
+namespace linux {
+
+/**
+ * Executables that run without the sandbox when they are exec'd (e.g., compiler helpers that only read untracked system locations).
+ *
+ * The list comes from the FAM (LinuxSandboxUnmonitoredExecutables, set by the engine) and is a semicolon-separated value with one entry per executable:
+ *
+ *     <path>[|<SHA256>]
+ *
+ * An absolute path matches that file only, anything else matches any executable with that program name (like
+ * __BUILDXL_PTRACE_FORCED_PROCESSES). An entry with a hash (hex, case insensitive) only matches if the content of the executable
+ * hashes to it, which costs reading the whole executable on every exec that matches the path: leave the hash out for tools
+ * that are exec'd often.
+ *
+ * The list is parsed once when the sandbox is loaded into lookup tables, so an exec of an executable that is not in the list
+ * costs two hash lookups.
+ */
+class UnmonitoredExecutables {
+public:
+    UnmonitoredExecutables() = default;
+    UnmonitoredExecutables(const UnmonitoredExecutables&) = delete;
+    UnmonitoredExecutables& operator = (const UnmonitoredExecutables&) = delete;
+
+    /**
+     * Parses the given list. Malformed entries (e.g., a hash that is not a SHA-256) are ignored. Returns the number of entries.
+     */
+    size_t Initialize(const char *list);
+
+    bool IsEmpty() const { return paths_.empty() && names_.empty(); }
+
+    /**
+     * Whether the executable at the given absolute path runs unmonitored.
+     */
+    bool Matches(const char *path) const;
+
+    /**
+     * SHA-256 of the content of the given file, as uppercase hex. Returns an empty string if the file can't be read.
+     * Exposed for tests.
+     */
+    static std::string HashFile(const char *path);
+
+private:
+    static bool ContentMatches(const char *path, const std::string &hash);
+
+    // Path (or program name) -> required hash, empty if any content matches
+    std::unordered_map<std::string, std::string> paths_;
+    std::unordered_map<std::string, std::string> names_;
+};
+
+} // namespace linux
+} // namespace buildxl
+
+#endif // BUILDXL_SANDBOX_LINUX_UNMONITORED_EXECUTABLES_H
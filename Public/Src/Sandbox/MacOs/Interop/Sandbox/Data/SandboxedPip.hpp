@@ -72,6 +72,18 @@ public:
 
     inline const char* GetInternalDetoursErrorNotificationFile() const { return fam_->GetInternalErrorDumpLocation(); }
 
+    /*! Number of FIFOs the processes of this pip report on (Linux only) */
+    inline const uint32_t GetReportChannelCount() const                { return fam_->GetReportChannelCount(); }
+
+    /*! Executables that run unmonitored when they are exec'd, as a ';' separated list (Linux only) */
+    inline const char* GetUnmonitoredExecutables() const               { return fam_->GetUnmonitoredExecutables(); }
+
+    /*! Inputs the root process prefetches, as the path of a list the engine keeps from a previous run of the pip (Linux only) */
+    inline const char* GetInputPrefetchList() const                    { return fam_->GetInputPrefetchList(); }
+
+    /*! Where the resolved paths a previous run of the pip saw are kept from one run to the next (Linux only) */
+    inline const char* GetResolutionSnapshot() const                   { return fam_->GetResolutionSnapshot(); }
+
     inline const std::string GetManifestTreeString()                   { return fam_->ManifestTreeToString(); }
 
 #pragma mark Process Tree Tracking
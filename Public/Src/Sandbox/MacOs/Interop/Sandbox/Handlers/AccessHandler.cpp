@@ -3,6 +3,13 @@
 
 #include "AccessHandler.hpp"
 
+#if __linux__
+#include "bxl_probes.h"
+#else
+#define BXL_PROBE1(name, a1)
+#define BXL_PROBE2(name, a1, a2)
+#endif
+
 bool AccessHandler::TryInitializeWithTrackedProcess(pid_t pid)
 {
     std::shared_ptr<SandboxedProcess> process = sandbox_->FindTrackedProcess(pid);
@@ -21,7 +28,10 @@ PolicySearchCursor AccessHandler::FindManifestRecord(const char *absolutePath, s
     const char *pathWithoutRootSentinel = absolutePath + 1;
 
     size_t len = pathLength == -1 ? strlen(pathWithoutRootSentinel) : pathLength;
-    return FindFileAccessPolicyInTreeEx(GetPip()->GetManifestRecord(), pathWithoutRootSentinel, len);
+    BXL_PROBE1(policy_search_begin, absolutePath);
+    PolicySearchCursor cursor = FindFileAccessPolicyInTreeEx(GetPip()->GetManifestRecord(), pathWithoutRootSentinel, len);
+    BXL_PROBE2(policy_search_end, absolutePath, cursor.IsValid() ? 1 : 0);
+    return cursor;
 }
 
 void AccessHandler::SetProcessPath(AccessReport *report)
@@ -13,6 +13,14 @@
   macro_to_apply(OpProcessTreeCompleted,                "ProcessTreeCompletedAck")        \
   macro_to_apply(OpFirstAllowWriteCheckInProcess,       "FirstAllowWriteCheckInProcess")  \
   macro_to_apply(OpProcessRequiresPtrace,               "ProcessRequiresPtrace")          \
+  macro_to_apply(OpObservation,                         "Observation")                    \
+  macro_to_apply(OpOutputContentHash,                   "OutputContentHash")              \
+  macro_to_apply(OpOutputClosed,                        "OutputClosed")                   \
+  macro_to_apply(OpOutputReopened,                      "OutputReopened")                 \
+  macro_to_apply(OpInputPrefetchStatistics,             "InputPrefetchStatistics")        \
+  macro_to_apply(OpIoVolume,                            "IoVolume")                       \
+  macro_to_apply(OpAccessSummaryHeld,                   "AccessSummaryHeld")              \
+  macro_to_apply(OpAccessSummaryFlushed,                "AccessSummaryFlushed")           \
   macro_to_apply(OpMacLookup,                           "MAC_LOOKUP")                     \
   macro_to_apply(OpMacReadlink,                         "MAC_READLINK")                   \
   macro_to_apply(OpMacVNodeCloneSource,                 "MAC_VNODE_CLONE_SOURCE")         \
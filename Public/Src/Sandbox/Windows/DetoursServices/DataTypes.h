@@ -109,6 +109,10 @@ inline bool CheckReportAnyAccess(FileAccessManifestFlag flags, bool accessDenied
     m(AlwaysRemoteInjectDetoursFrom32BitProcess,        0x10) \
     m(UnconditionallyEnableLinuxPTraceSandbox,          0x20) \
     m(IgnoreDeviceIoControlGetReparsePoint,             0x40) \
+    m(EnableLinuxSandboxReportTimestamps,               0x80) \
+    m(EnableLinuxSandboxReportLogs,                    0x100) \
+    m(EnableLinuxSandboxObserveOnly,                   0x200) \
+    m(EnableLinuxSandboxAccessSummary,                 0x400) \
 
 enum class FileAccessManifestExtraFlag {
     FOR_ALL_FAM_EXTRA_FLAGS(GEN_FAM_FLAG_ENUM_NAME_VALUE)
@@ -631,6 +635,30 @@ typedef struct ManifestSubstituteProcessExecutionShim_t
 } ManifestSubstituteProcessExecutionShim_t;
 typedef const ManifestSubstituteProcessExecutionShim_t * PCManifestSubstituteProcessExecutionShim;
 
+// ==========================================================================
+// == ManifestLinuxSandbox
+// ==========================================================================
+// Only present in manifests sent to the Linux sandbox, right before the manifest tree.
+// Followed by WriteChars strings: the executables that run unmonitored, separated by ';' (see unmonitored_executables.hpp),
+// the path of the list of inputs to prefetch (see input_prefetcher.hpp), empty if the pip does not prefetch its inputs,
+// and the path of the resolution snapshot (see resolution_snapshot.hpp), empty if the pip does not keep one.
+typedef struct ManifestLinuxSandbox_t
+{
+    GENERATE_TAG("ManifestLinuxSandbox", 0xABCDEF06)
+
+    // Number of FIFOs accesses are reported on
+    uint32_t ReportChannelCount;
+
+    /// GetSize
+    ///
+    /// There are no variable-length members, so the length of this struct can be determined using sizeof.
+    size_t GetSize() const noexcept
+    {
+        return sizeof(ManifestLinuxSandbox_t);
+    }
+} ManifestLinuxSandbox;
+typedef const ManifestLinuxSandbox * PCManifestLinuxSandbox;
+
 // ==========================================================================
 // == ManifestRecord
 // ==========================================================================
@@ -182,19 +182,21 @@ bool PolicyResult::AllowWrite(bool basedOnlyOnPolicy) const {
     // and the write is allowed by policy (for the latter, if the write is denied, there is nothing to override)
     if (!basedOnlyOnPolicy && !IndicateUntracked() && isWriteAllowedByPolicy && OverrideAllowWriteForExistingFiles()) {
 
-        // Let's check if this path was already checked for allow writes in this process. Observe this structure lifespan is the same
-        // as the current process so other child processes won't share it.
-        // But for the current process it will avoid probing the file system over and over for the same path.
-        FilesCheckedForAccess* filesCheckedForWriteAccess = FilesCheckedForAccess::GetInstance();
+        // Let's check if this path was already checked for allow writes. The observer keeps a registry that is shared by all the processes
+        // of the pip, so this avoids probing the file system over and over for the same path across the whole process tree.
+        // If the shared registry is not available, this falls back to a per-process check.
+        BxlObserver* bxl = BxlObserver::GetInstance();
+        mode_t mode = 0;
 
-        if (filesCheckedForWriteAccess->TryRegisterPath(m_canonicalizedPath)) {
+        if (bxl->TryRegisterFirstAllowWriteCheck(m_canonicalizedPath, mode)) {
             // Our ultimate goal is to understand if the path represents a file that was there before the pip started (and therefore blocked for writes).
-            // The existence of the file on disk before the first time the file is written will tell us that. But the problem is that knowing when is the first
-            // time is not trivial: it involves sharing information across child processes.
-            // So what we do is just to emit a special report line with the information of whether the access should be allowed or not, based on existence, from
-            // the perspective of the running process. These special report lines are then processed outside of detours to determine the real first write attempt
+            // The existence of the file on disk before the first time the file is written will tell us that: the path was probed
+            // right before it was registered, so no other process of the pip could have written it yet.
+            // So what we do is just to emit a special report line with the information of whether the access should be allowed or not, based on existence.
+            // With the shared registry there is a single such report per path for the whole pip, otherwise there is one per process and the
+            // report lines are processed outside of detours to determine the real first write attempt.
             // Observe this implies that in this case we never block accesses on detours based on file existence, but generate a DFA on managed code
-            BxlObserver::GetInstance()->report_firstAllowWriteCheck(Path());
+            bxl->report_firstAllowWriteCheck(Path(), mode);
         }
     }
 
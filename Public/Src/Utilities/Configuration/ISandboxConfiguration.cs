@@ -300,6 +300,74 @@ namespace BuildXL.Utilities.Configuration
         /// </remarks>
         public bool UnconditionallyEnableLinuxPTraceSandbox { get; }
 
+        /// <summary>
+        /// Number of FIFOs the Linux sandbox reports accesses on. Defaults to 1.
+        /// </summary>
+        /// <remarks>
+        /// Processes of a pip report on the FIFO selected by their pid, so a pip with many concurrent processes is not bottlenecked on a single
+        /// FIFO reader. Values are clamped to [1, 16].
+        /// </remarks>
+        public int LinuxSandboxReportChannelCount { get; }
+
+        /// <summary>
+        /// When enabled, every report sent by the Linux sandbox carries the time at which the access was observed and a per-process sequence number.
+        /// </summary>
+        /// <remarks>
+        /// Diagnostics mode, used to measure the lag between accesses and their reports. Not intended for production use.
+        /// </remarks>
+        public bool EnableLinuxSandboxReportTimestamps { get; }
+
+        /// <summary>
+        /// When enabled, processes under the Linux sandbox append their file access reports to a per-process log file instead of writing them to the reports FIFO.
+        /// </summary>
+        /// <remarks>
+        /// Processes don't contend on the FIFO nor block on its reader. The logs are merged into the report stream once the process tree of the pip is done,
+        /// so file accesses are only processed at the end of the pip. Process start and exit reports are still sent over the FIFO. Not intended for production use yet.
+        /// </remarks>
+        public bool EnableLinuxSandboxReportLogs { get; }
+
+        /// <summary>
+        /// When enabled, the Linux sandbox sends raw observations for read-only accesses and their policy is evaluated by a per-pip evaluator process.
+        /// </summary>
+        /// <remarks>
+        /// Only honored for pips that don't fail on unexpected file accesses. Not intended for production use yet.
+        /// </remarks>
+        public bool EnableLinuxSandboxObserveOnly { get; }
+
+        /// <summary>
+        /// When enabled, the Linux sandbox collapses the allowed read-only accesses a process makes to a path into a single report.
+        /// </summary>
+        /// <remarks>
+        /// A pip whose processes die before sending their summarized accesses fails, since some of its inputs may be unknown.
+        /// </remarks>
+        public bool EnableLinuxSandboxAccessSummary { get; }
+
+        /// <summary>
+        /// Executables the Linux sandbox lets run unmonitored when they are exec'd: nothing they (or their children) do is reported.
+        /// </summary>
+        /// <remarks>
+        /// Each entry is either an absolute path or a program name, optionally followed by '|' and the SHA256 of the executable,
+        /// in which case the entry only matches an executable with that content.
+        /// </remarks>
+        IReadOnlyList<string> LinuxSandboxUnmonitoredExecutables { get; }
+
+        /// <summary>
+        /// When enabled, the root process of a pip prefetches the files the previous run of the pip read, in the order it read them, while the tool starts up.
+        /// </summary>
+        /// <remarks>
+        /// The list of files is kept per pip under the engine cache directory. Prefetching only warms up the page cache: what a pip reads is reported as usual.
+        /// </remarks>
+        public bool EnableLinuxSandboxInputPrefetch { get; }
+
+        /// <summary>
+        /// When enabled, the sandbox of a pip starts from the paths the previous run of the pip resolved (after checking they still resolve the same way)
+        /// instead of resolving every path from scratch.
+        /// </summary>
+        /// <remarks>
+        /// The snapshot is kept per pip under the engine cache directory. Paths the pip may write are never taken from the snapshot.
+        /// </remarks>
+        public bool EnableLinuxSandboxResolutionSnapshot { get; }
+
         /// <summary>
         /// Ignores DeviceIoControl calls, in particular the case of FSCTL_GET_REPARSE_POINT
         /// </summary>
@@ -51,6 +51,14 @@ namespace BuildXL.Utilities.Configuration.Mutable
             EnableLinuxPTraceSandbox = true;
             AlwaysRemoteInjectDetoursFrom32BitProcess = true;
             UnconditionallyEnableLinuxPTraceSandbox = false;
+            LinuxSandboxReportChannelCount = 1;
+            EnableLinuxSandboxReportTimestamps = false;
+            EnableLinuxSandboxReportLogs = false;
+            EnableLinuxSandboxObserveOnly = false;
+            EnableLinuxSandboxAccessSummary = false;
+            LinuxSandboxUnmonitoredExecutables = new List<string>();
+            EnableLinuxSandboxInputPrefetch = false;
+            EnableLinuxSandboxResolutionSnapshot = false;
             // TODO: flip the default once we have verified this is not a breaking change
             IgnoreDeviceIoControlGetReparsePoint = true;
             ForceAddExecutionPermission = true;
@@ -103,6 +111,14 @@ namespace BuildXL.Utilities.Configuration.Mutable
             EnableLinuxPTraceSandbox = template.EnableLinuxPTraceSandbox;
             AlwaysRemoteInjectDetoursFrom32BitProcess = template.AlwaysRemoteInjectDetoursFrom32BitProcess;
             UnconditionallyEnableLinuxPTraceSandbox = template.UnconditionallyEnableLinuxPTraceSandbox;
+            LinuxSandboxReportChannelCount = template.LinuxSandboxReportChannelCount;
+            EnableLinuxSandboxReportTimestamps = template.EnableLinuxSandboxReportTimestamps;
+            EnableLinuxSandboxReportLogs = template.EnableLinuxSandboxReportLogs;
+            EnableLinuxSandboxObserveOnly = template.EnableLinuxSandboxObserveOnly;
+            EnableLinuxSandboxAccessSummary = template.EnableLinuxSandboxAccessSummary;
+            LinuxSandboxUnmonitoredExecutables = new List<string>(template.LinuxSandboxUnmonitoredExecutables);
+            EnableLinuxSandboxInputPrefetch = template.EnableLinuxSandboxInputPrefetch;
+            EnableLinuxSandboxResolutionSnapshot = template.EnableLinuxSandboxResolutionSnapshot;
             IgnoreDeviceIoControlGetReparsePoint = template.IgnoreDeviceIoControlGetReparsePoint;
             ForceAddExecutionPermission = template.ForceAddExecutionPermission;
         }
@@ -282,6 +298,33 @@ namespace BuildXL.Utilities.Configuration.Mutable
         /// <inheritdoc />
         public bool UnconditionallyEnableLinuxPTraceSandbox { get; set; }
 
+        /// <inheritdoc />
+        public int LinuxSandboxReportChannelCount { get; set; }
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxReportTimestamps { get; set; }
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxReportLogs { get; set; }
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxObserveOnly { get; set; }
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxAccessSummary { get; set; }
+
+        /// <nodoc />
+        public List<string> LinuxSandboxUnmonitoredExecutables { get; set; }
+
+        /// <inheritdoc />
+        IReadOnlyList<string> ISandboxConfiguration.LinuxSandboxUnmonitoredExecutables => LinuxSandboxUnmonitoredExecutables;
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxInputPrefetch { get; set; }
+
+        /// <inheritdoc />
+        public bool EnableLinuxSandboxResolutionSnapshot { get; set; }
+
         /// <inheritdoc/>
         public bool IgnoreDeviceIoControlGetReparsePoint { get; set; }
 